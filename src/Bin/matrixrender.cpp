@@ -0,0 +1,366 @@
+/**
+ * @file matrixrender.cpp
+ * @brief The main function of the headless renderer, which draws the heat
+ * maps of matrices to PNG files without a display.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Data/ColorMap.hpp"
+#include "Data/CSRMatrix.hpp"
+#include "Data/DataStorage.hpp"
+#include "Data/HeatMap.hpp"
+#include "Operations/Raster.hpp"
+#include "Utility/PNGWriter.hpp"
+#include "Utility/String.hpp"
+
+
+using namespace MatrixInspector;
+
+
+
+
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+dim_type const DEFAULT_SIZE = 2048;
+
+// the number of files rendered at once by default, each of which is also
+// counted in parallel
+unsigned const DEFAULT_JOBS = 4;
+
+}
+
+
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+
+struct options_struct
+{
+  dim_type size;
+  unsigned jobs;
+  HeatMap::mode_type mode;
+  ColorMap colorMap;
+  // where to write the images, or next to each matrix if empty
+  std::string directory;
+  std::vector<std::string> files;
+};
+
+
+void usage(
+    char const * const name)
+{
+  std::cerr << "USAGE: " << name << " [options] <matrix> [<matrix> ...]" << \
+      std::endl;
+  std::cerr << std::endl;
+  std::cerr << "Draw the heat map of each matrix to a PNG file of the same " \
+      "name." << std::endl;
+  std::cerr << std::endl;
+  std::cerr << "OPTIONS:" << std::endl;
+  std::cerr << "  -s <pixels>" << std::endl;
+  std::cerr << "    The size of the longer side of each image (default " << \
+      DEFAULT_SIZE << "). An image is never larger than its matrix." << \
+      std::endl;
+  std::cerr << "  -c <heat|viridis|grayscale>" << std::endl;
+  std::cerr << "    The colors of the heat map (default heat)." << std::endl;
+  std::cerr << "  -m <count|sum|max|mean|signed>" << std::endl;
+  std::cerr << "    What each pixel shows of the non-zeros in it: their " \
+      "number, the total," << std::endl;
+  std::cerr << "    largest or average magnitude of their values, or the " \
+      "total of their signed" << std::endl;
+  std::cerr << "    values in diverging colors (default count)." << \
+      std::endl;
+  std::cerr << "  -l" << std::endl;
+  std::cerr << "    Space the colors logarithmically." << std::endl;
+  std::cerr << "  -o <directory>" << std::endl;
+  std::cerr << "    The directory to write the images to (default that of " \
+      "each matrix)." << std::endl;
+  std::cerr << "  -j <jobs>" << std::endl;
+  std::cerr << "    The number of matrices to render at once (default " << \
+      DEFAULT_JOBS << ")." << std::endl;
+}
+
+
+/**
+* @brief Parse a positive number from an argument.
+*
+* @param arg The argument.
+*
+* @return The number.
+*
+* @throws std::runtime_error If the argument is not a positive number.
+*/
+unsigned long parsePositive(
+    std::string const & arg)
+{
+  size_t end = 0;
+  unsigned long num = 0;
+  try {
+    num = std::stoul(arg, &end);
+  } catch (std::exception const &) {
+    end = 0;
+  }
+  if (end == 0 || end != arg.size() || num == 0 || arg[0] == '-') {
+    throw std::runtime_error("Expected a positive number, not '" + arg + \
+        "'.");
+  }
+
+  return num;
+}
+
+
+/**
+* @brief Parse what each pixel shows from an argument.
+*
+* @param arg The argument.
+*
+* @return The mode.
+*
+* @throws std::runtime_error If the argument is not a mode.
+*/
+HeatMap::mode_type parseMode(
+    std::string const & arg)
+{
+  std::string const mode = String::toLower(&arg);
+  if (mode == "count") {
+    return HeatMap::COUNT_MODE;
+  } else if (mode == "sum") {
+    return HeatMap::SUM_MODE;
+  } else if (mode == "max") {
+    return HeatMap::MAX_MODE;
+  } else if (mode == "mean") {
+    return HeatMap::MEAN_MODE;
+  } else if (mode == "signed") {
+    return HeatMap::SIGNED_SUM_MODE;
+  }
+
+  throw std::runtime_error("Unknown mode '" + arg + "'.");
+}
+
+
+/**
+* @brief Parse the command line.
+*
+* @param argc The number of arguments.
+* @param argv The arguments.
+*
+* @return The options.
+*
+* @throws std::runtime_error If the arguments are invalid.
+*/
+options_struct parseArguments(
+    int const argc,
+    char ** const argv)
+{
+  options_struct options{DEFAULT_SIZE, DEFAULT_JOBS, HeatMap::COUNT_MODE, \
+      ColorMap(), "", {}};
+  ColorMap::colormap_type colors = ColorMap::HEAT;
+  ColorMap::scale_type scale = ColorMap::LINEAR_SCALE;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg(argv[i]);
+    bool const hasValue = i + 1 < argc;
+    if (arg == "-l") {
+      scale = ColorMap::LOG_SCALE;
+    } else if (arg == "-s" || arg == "-c" || arg == "-o" || arg == "-j" || \
+        arg == "-m") {
+      if (!hasValue) {
+        throw std::runtime_error("Missing the value of " + arg + ".");
+      }
+      std::string const value(argv[++i]);
+      if (arg == "-s") {
+        options.size = static_cast<dim_type>(std::min<unsigned long>( \
+            parsePositive(value), static_cast<dim_type>(-1)));
+      } else if (arg == "-j") {
+        options.jobs = static_cast<unsigned>(std::min<unsigned long>( \
+            parsePositive(value), 1024));
+      } else if (arg == "-o") {
+        options.directory = value;
+      } else if (arg == "-m") {
+        options.mode = parseMode(value);
+      } else if (String::toLower(&value) == "heat") {
+        colors = ColorMap::HEAT;
+      } else if (String::toLower(&value) == "viridis") {
+        colors = ColorMap::VIRIDIS;
+      } else if (String::toLower(&value) == "grayscale") {
+        colors = ColorMap::GRAYSCALE;
+      } else {
+        throw std::runtime_error("Unknown colors '" + value + "'.");
+      }
+    } else if (arg.size() > 1 && arg[0] == '-') {
+      throw std::runtime_error("Unknown option '" + arg + "'.");
+    } else {
+      options.files.emplace_back(arg);
+    }
+  }
+
+  if (options.files.empty()) {
+    throw std::runtime_error("No matrices given.");
+  }
+
+  options.colorMap = ColorMap(colors, scale);
+
+  return options;
+}
+
+
+/**
+* @brief Get the path of the image of a matrix, which is the name of the
+* matrix with its extension replaced.
+*
+* @param file The path of the matrix.
+* @param directory The directory of the image, or empty for that of the
+* matrix.
+*
+* @return The path of the image.
+*/
+std::string getImagePath(
+    std::string const & file,
+    std::string const & directory)
+{
+  size_t const slash = file.find_last_of('/');
+  size_t const nameStart = slash == std::string::npos ? 0 : slash + 1;
+  size_t const dot = file.find_last_of('.');
+  size_t const nameEnd = dot == std::string::npos || dot < nameStart ? \
+      file.size() : dot;
+
+  std::string const name = file.substr(nameStart, nameEnd - nameStart) + \
+      ".png";
+  if (directory.empty()) {
+    return file.substr(0, nameStart) + name;
+  } else if (directory.back() == '/') {
+    return directory + name;
+  } else {
+    return directory + "/" + name;
+  }
+}
+
+
+/**
+* @brief Load a matrix and draw it to a PNG file, a band of rows at a time.
+*
+* @param file The path of the matrix.
+* @param options The options.
+*
+* @return The path of the image.
+*
+* @throws std::runtime_error If the matrix cannot be read or drawn.
+*/
+std::string render(
+    std::string const & file,
+    options_struct const & options)
+{
+  DataStorage storage;
+  double progress = 0;
+  storage.loadDataset(file.c_str(), &progress);
+
+  CSRMatrix const * const matrix = \
+      dynamic_cast<CSRMatrix const *>(storage.getMatrix());
+  if (matrix == nullptr) {
+    throw std::runtime_error("Only sparse matrices can be drawn.");
+  }
+  if (matrix->getNumRows() == 0 || matrix->getNumColumns() == 0) {
+    throw std::runtime_error("The matrix is empty.");
+  }
+
+  Raster::size_struct const size = Raster::fitSide(matrix->getNumRows(), \
+      matrix->getNumColumns(), options.size);
+
+  std::string const path = getImagePath(file, options.directory);
+  PNGWriter writer(path, size.width, size.height);
+  Raster::render(*matrix, size, options.mode, options.colorMap, \
+      [&](dim_type, dim_type const numRows, uint32_t const * const pixels) {
+    writer.write(pixels, numRows);
+  });
+
+  return path;
+}
+
+
+}
+
+
+
+
+/******************************************************************************
+* MAIN ************************************************************************
+******************************************************************************/
+
+
+int main(
+    int argc,
+    char ** argv)
+{
+  options_struct options{};
+  try {
+    options = parseArguments(argc, argv);
+  } catch (std::exception const & e) {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // each thread takes the next file until none are left, so that a large
+  // matrix does not hold up the small ones behind it
+  std::atomic<size_t> next(0);
+  std::atomic<bool> failed(false);
+  std::mutex outputMutex;
+  unsigned const numThreads = static_cast<unsigned>(std::min<size_t>( \
+      options.jobs, options.files.size()));
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads);
+  for (unsigned tid = 0; tid < numThreads; ++tid) {
+    threads.emplace_back([&]() {
+      size_t idx;
+      while ((idx = next++) < options.files.size()) {
+        std::string const & file = options.files[idx];
+        try {
+          std::string const path = render(file, options);
+          std::lock_guard<std::mutex> lock(outputMutex);
+          std::cout << file << " -> " << path << std::endl;
+        } catch (std::bad_alloc const &) {
+          failed.store(true);
+          std::lock_guard<std::mutex> lock(outputMutex);
+          std::cerr << file << ": Not enough memory to load matrix." << \
+              std::endl;
+        } catch (std::exception const & e) {
+          failed.store(true);
+          std::lock_guard<std::mutex> lock(outputMutex);
+          std::cerr << file << ": " << e.what() << std::endl;
+        }
+      }
+    });
+  }
+
+  for (std::thread & thread : threads) {
+    thread.join();
+  }
+
+  return failed.load() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -11,8 +11,15 @@
 
 #include <limits>
 #include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <utility>
 #include "CSRMatrix.hpp"
 #include "Utility/PrefixSum.hpp"
+#include "Utility/Parallel.hpp"
+#include "Operations/Stats.hpp"
 #include "Utility/Debug.hpp"
 
 
@@ -33,6 +40,103 @@ namespace
 double const INCREMENT = 0.01;
 value_type const EPSILON = std::numeric_limits<value_type>::epsilon();
 
+int const NUM_PROGRESS_STEPS = 50;
+
+// the number of rows checked between checks for cancellation
+dim_type const CANCEL_INTERVAL = 4096;
+
+}
+
+
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+/**
+* @brief A permutation stored as an array, where perm[new] = old. The inverse
+* is only built when it is needed.
+*/
+class ArrayPermutation
+{
+  public:
+    ArrayPermutation(
+        dim_type const * const perm,
+        dim_type const len,
+        bool const invertible) :
+      m_perm(perm),
+      m_inverse()
+    {
+      if (perm != nullptr && invertible) {
+        m_inverse.resize(len);
+        Parallel::forRange(len, \
+            [&](unsigned, size_t const start, size_t const end) {
+          for (size_t i = start; i < end; ++i) {
+            ASSERT_LESS(perm[i],len);
+            m_inverse[perm[i]] = static_cast<dim_type>(i);
+          }
+        });
+      }
+    }
+
+
+    dim_type operator()(
+        dim_type const index) const noexcept
+    {
+      return m_perm[index];
+    }
+
+
+    dim_type inverse(
+        dim_type const index) const noexcept
+    {
+      return m_inverse[index];
+    }
+
+
+  private:
+    dim_type const * m_perm;
+    std::vector<dim_type> m_inverse;
+
+
+    // disable copying
+    ArrayPermutation(
+        ArrayPermutation const & rhs);
+    ArrayPermutation & operator=(
+        ArrayPermutation const & rhs);
+};
+
+
+/**
+* @brief Move a set of degrees along with their rows or columns.
+*
+* @tparam P The permutation type.
+* @param degrees The degrees.
+* @param perm The permutation.
+*
+* @return The permuted degrees.
+*/
+template<typename P>
+std::vector<dim_type> permuteDegrees(
+    std::vector<dim_type> const & degrees,
+    P const & perm)
+{
+  std::vector<dim_type> permuted(degrees.size());
+  Parallel::forRange(degrees.size(), \
+      [&](unsigned, size_t const start, size_t const end) {
+    for (size_t i = start; i < end; ++i) {
+      permuted[i] = degrees[perm(static_cast<dim_type>(i))];
+    }
+  });
+
+  return permuted;
+}
+
 }
 
 
@@ -45,11 +149,13 @@ value_type const EPSILON = std::numeric_limits<value_type>::epsilon();
 CSRMatrix::CSRMatrix(
     dim_type const numRows,
     dim_type const numCols,
-    index_type const numNonZeros) :
+    index_type const numNonZeros,
+    ValueArray::precision_type const precision) :
   SparseMatrix(numRows, numCols, numNonZeros),
   m_offsets(numRows+1),
   m_columns(numNonZeros),
-  m_values(numNonZeros)
+  m_values(numNonZeros, precision),
+  m_halfStorage(false)
 {
   // do nothing
 }
@@ -68,6 +174,187 @@ CSRMatrix::~CSRMatrix()
 ******************************************************************************/
 
 
+bool CSRMatrix::isHalfStorage() const noexcept
+{
+  return m_halfStorage;
+}
+
+
+index_type CSRMatrix::getNumStoredNonZeros() const
+{
+  return m_offsets[getNumRows()];
+}
+
+
+void CSRMatrix::convertToHalfStorage(
+    double * const progress,
+    double const scale)
+{
+  if (m_halfStorage) {
+    // nothing to do
+    if (progress != nullptr) {
+      *progress += scale;
+    }
+    return;
+  }
+
+  if (!isSquare() || (isSymmetrySet() && !isSymmetric())) {
+    throw std::runtime_error("Only symmetric matrices can be stored as a " \
+        "lower triangle.");
+  }
+
+  dim_type const numRows = getNumRows();
+
+  // determine rows per percent
+  dim_type const interval = numRows > 100 ? numRows / 100 : 1; 
+
+  // compact in place, keeping only entries on or below the diagonal
+  index_type nnz = 0;
+  index_type start = m_offsets[0];
+  for (dim_type row = 0; row < numRows; ++row) {
+    index_type const end = m_offsets[row+1];
+    for (index_type idx = start; idx < end; ++idx) {
+      if (m_columns[idx] <= row) {
+        m_columns[nnz] = m_columns[idx];
+        m_values.copy(nnz, m_values, idx);
+        ++nnz;
+      }
+    }
+    start = end;
+    m_offsets[row+1] = nnz;
+
+    if (progress != nullptr && row % interval == 0) {
+      *progress += scale*INCREMENT;
+    }
+  }
+
+  // release the upper triangle's memory
+  m_columns.resize(nnz);
+  m_columns.shrink_to_fit();
+  m_values.resize(nnz);
+  m_values.shrinkToFit();
+
+  m_halfStorage = true;
+
+  setSymmetry(true);
+  setStructuralSymmetry(true);
+}
+
+
+void CSRMatrix::expandToFullStorage(
+    double * const progress,
+    double const scale)
+{
+  if (!m_halfStorage) {
+    // nothing to do
+    if (progress != nullptr) {
+      *progress += scale;
+    }
+    return;
+  }
+
+  dim_type const numRows = getNumRows();
+
+  std::vector<index_type> const oldOffsets(m_offsets); 
+  std::vector<dim_type> const oldColumns(m_columns);
+  ValueArray const oldValues(m_values);
+
+  // count the lower entries of each row, and the mirror of each strictly
+  // lower entry in the row of its column
+  m_offsets.assign(numRows+1,0);
+  for (dim_type row = 0; row < numRows; ++row) {
+    m_offsets[row+1] += oldOffsets[row+1] - oldOffsets[row];
+    for (index_type idx = oldOffsets[row]; idx < oldOffsets[row+1]; ++idx) {
+      dim_type const col = oldColumns[idx];
+      if (col != row) {
+        ++m_offsets[col+1];
+      }
+    }
+  }
+
+  if (progress != nullptr) {
+    *progress += scale*0.3;
+  }
+
+  PrefixSum::inclusive(m_offsets.data()+1,numRows);
+
+  index_type const nnz = m_offsets[numRows];
+  m_columns.resize(nnz);
+  m_values.resize(nnz);
+
+  // each row is filled with its lower entries first, followed by the mirrored
+  // entries in order of their source row, so sorted rows remain sorted
+  std::vector<index_type> upper(numRows);
+  for (dim_type row = 0; row < numRows; ++row) {
+    upper[row] = m_offsets[row] + (oldOffsets[row+1] - oldOffsets[row]);
+  }
+
+  // determine rows per percent
+  dim_type const interval = numRows > 70 ? numRows / 70 : 1; 
+
+  for (dim_type row = 0; row < numRows; ++row) {
+    index_type lower = m_offsets[row];
+    for (index_type idx = oldOffsets[row]; idx < oldOffsets[row+1]; ++idx) {
+      dim_type const col = oldColumns[idx];
+      m_columns[lower] = col;
+      m_values.copy(lower, oldValues, idx);
+      ++lower;
+      if (col != row) {
+        index_type const mirror = upper[col]++;
+        m_columns[mirror] = row;
+        m_values.copy(mirror, oldValues, idx);
+      }
+    }
+
+    if (progress != nullptr && row % interval == 0) {
+      *progress += scale*INCREMENT;
+    }
+  }
+
+  m_halfStorage = false;
+
+  updateNumNonZeros();
+}
+
+
+void CSRMatrix::sortRows()
+{
+  dim_type const numRows = getNumRows();
+
+  unsigned const numThreads = Parallel::getNumThreads(m_offsets[numRows]);
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    dim_type const start = Parallel::getRowChunkStart(m_offsets.data(), \
+        numRows, numThreads, tid);
+    dim_type const end = Parallel::getRowChunkStart(m_offsets.data(), \
+        numRows, numThreads, tid+1);
+
+    std::vector<std::pair<dim_type, value_type>> entries;
+    for (dim_type row = start; row < end; ++row) {
+      index_type const first = m_offsets[row];
+      index_type const last = m_offsets[row+1];
+      if (std::is_sorted(m_columns.data()+first, m_columns.data()+last)) {
+        continue;
+      }
+
+      // values decode and encode to the same bits, so keep their precision
+      entries.clear();
+      for (index_type idx = first; idx < last; ++idx) {
+        entries.emplace_back(m_columns[idx], m_values.get(idx));
+      }
+      std::sort(entries.begin(), entries.end(), \
+          [](std::pair<dim_type, value_type> const & a, \
+              std::pair<dim_type, value_type> const & b) {
+            return a.first < b.first;
+          });
+      for (index_type idx = first; idx < last; ++idx) {
+        m_columns[idx] = entries[idx-first].first;
+        m_values.set(idx, entries[idx-first].second);
+      }
+    }
+  });
+}
+
+
 index_type const * CSRMatrix::getOffsets() const
 {
   return m_offsets.data();
@@ -92,6 +379,48 @@ dim_type * CSRMatrix::getColumns()
 }
 
 
+ValueArray::precision_type CSRMatrix::getValuePrecision() const noexcept
+{
+  return m_values.getPrecision();
+}
+
+
+void CSRMatrix::setValuePrecision(
+    ValueArray::precision_type const precision)
+{
+  if (precision == m_values.getPrecision()) {
+    // nothing is rounded
+    return;
+  }
+
+  m_values.setPrecision(precision);
+
+  // rounding can change any statistic depending on the values, but it does
+  // not move the non-zeros, and it rounds equal values alike, so only the
+  // unequal mirrored values of a structurally symmetric matrix in full
+  // storage can become symmetric
+  bool const recheck = !m_halfStorage && isSymmetrySet() && \
+      !isSymmetric() && isStructurallySymmetric();
+  transformStats(STATS_PRESERVE, STATS_PRESERVE, STATS_INVALIDATE, \
+      STATS_INVALIDATE, recheck ? STATS_INVALIDATE : STATS_PRESERVE);
+  if (recheck) {
+    setStructuralSymmetry(true);
+  }
+}
+
+
+ValueArray const & CSRMatrix::getValueArray() const noexcept
+{
+  return m_values;
+}
+
+
+ValueArray & CSRMatrix::getValueArray() noexcept
+{
+  return m_values;
+}
+
+
 value_type const * CSRMatrix::getValues() const
 {
   return m_values.data();
@@ -111,7 +440,7 @@ void CSRMatrix::transpose(
   dim_type const numRows = getNumRows();
   dim_type const numCols = getNumColumns();
 
-  if (isSymmetric() || numRows == 0 || numCols == 0) {
+  if ((isSymmetrySet() && isSymmetric()) || numRows == 0 || numCols == 0) {
     // nothing to do
     if (progress != nullptr) {
       *progress += scale*1.0;
@@ -120,7 +449,7 @@ void CSRMatrix::transpose(
     assert(m_offsets.size() == numRows+1);
     std::vector<index_type> const oldOffsets(m_offsets); 
     std::vector<dim_type> const oldColumns(m_columns);
-    std::vector<value_type> const oldValues(m_values);
+    ValueArray const oldValues(m_values);
 
     // determine rows per percent
     dim_type interval = numRows > 30 ? numRows / 30 : 1; 
@@ -151,7 +480,7 @@ void CSRMatrix::transpose(
         index_type idx = m_offsets[oldColumns[nz]+1]++;
         assert(idx < m_columns.size());
         m_columns[idx] = row;
-        m_values[idx] = oldValues[nz];
+        m_values.copy(idx, oldValues, nz);
       }
       if (progress != nullptr && row % interval == 0) {
         *progress += scale*INCREMENT;
@@ -164,7 +493,8 @@ void CSRMatrix::transpose(
   setNumColumns(numRows);
   setNumRows(numCols);
 
-  invalidateStats();
+  transformStats(STATS_SWAP, STATS_SWAP, STATS_PRESERVE, STATS_PRESERVE, \
+      STATS_PRESERVE);
 }
 
 
@@ -174,109 +504,34 @@ void CSRMatrix::reorder(
     double * const progress,
     double const scale)
 {
-  dim_type const numRows = getNumRows();
-  dim_type const numCols = getNumColumns();
-
-  assert(m_offsets.size() == numRows+1);
-
-  if (rowPerm) {
-    std::vector<index_type> const oldOffsets(m_offsets); 
-    std::vector<dim_type> const oldColumns(m_columns);
-    std::vector<value_type> const oldValues(m_values);
-
-    // perform a row and possibly a column permutation
-    m_offsets[0] = 0;
-    for (dim_type row = 0; row < numRows; ++row) {
-      dim_type const v = rowPerm[row];
-      ASSERT_LESS(v,numRows);
-      m_offsets[row+1] = m_offsets[row] + (oldOffsets[v+1] - oldOffsets[v]);
-    }
-
-    if (progress != nullptr) {
-      *progress += scale*0.1;
-    }
-    
-    index_type newIdx = 0;
-    if (colPerm) {
-      std::vector<dim_type> rename(numCols);
-      // reverse the colperm
-      for (dim_type col = 0; col < numCols; ++col) {
-        dim_type const v = colPerm[col];
-        ASSERT_LESS(v,numCols);
-        rename[v] = col;
-      }
-
-      if (progress != nullptr) {
-        *progress += scale*0.1;
-      }
-
-      // determine rows per percent
-      dim_type const interval = numRows > 80 ? numRows / 80 : 1; 
-
-      // apply the column perm while filling rowindex and rowvalue arrays
-      for (dim_type row = 0; row < numRows; ++row) {
-        dim_type const v = rowPerm[row];
-        ASSERT_LESS(v,numRows);
-        for (index_type idx = oldOffsets[v]; idx < oldOffsets[v+1]; ++idx) {
-          m_columns[newIdx] = rename[oldColumns[idx]];
-          m_values[newIdx] = oldValues[idx];
-          ++newIdx;
-        }
-        if (progress != nullptr && row % interval == 0) {
-          *progress += scale*INCREMENT;
-        }
-      }
-    } else {
-      // determine rows per percent
-      dim_type const interval = numRows > 90 ? numRows / 90 : 1; 
-
-      // fill rowindex and rowvalue arrays
-      for (dim_type row = 0; row < numRows; ++row) {
-        dim_type const v = rowPerm[row];
-        ASSERT_LESS(v,numRows);
-        for (index_type idx = oldOffsets[v]; idx < oldOffsets[v+1]; ++idx) {
-          m_columns[newIdx] = oldColumns[idx];
-          m_values[newIdx] = oldValues[idx];
-          ++newIdx;
-        }
-        if (progress != nullptr && row % interval == 0) {
-          *progress += scale*INCREMENT;
-        }
-      }
-    }
-  } else if (colPerm) {
-    // perform only a column permutation
-    std::vector<dim_type> const oldColumns(m_columns);
-    std::vector<dim_type> rename(numCols);
-
-    dim_type interval = numCols > 10 ? numRows / 10 : 1; 
+  // the permutations of a non-square matrix differ in length
+  bool const symmetric = isSquare() && \
+      isSymmetricPermutation(rowPerm, colPerm, getNumRows());
+
+  // the new row of an old row is only needed to fold half storage, and the
+  // new column of an old column is needed otherwise
+  bool const half = m_halfStorage && rowPerm != nullptr && symmetric;
+  ArrayPermutation const rows(rowPerm, getNumRows(), half);
+  ArrayPermutation const cols(colPerm, getNumColumns(), !half);
+
+  reorderBy(rowPerm != nullptr ? &rows : nullptr, \
+      colPerm != nullptr ? &cols : nullptr, symmetric, progress, scale);
+}
 
-    // reverse the colperm
-    for (dim_type col = 0; col < numCols; ++col) {
-      dim_type const v = colPerm[col];
-      ASSERT_LESS(v,numCols);
-      rename[v] = col;
 
-      if (progress != nullptr && col % interval == 0) {
-        *progress += scale*INCREMENT;
-      }
-    }
+void CSRMatrix::reorder(
+    FeistelPermutation const * const rowPerm,
+    FeistelPermutation const * const colPerm,
+    double * const progress,
+    double const scale)
+{
+  ASSERT_TRUE((rowPerm == nullptr || rowPerm->size() == getNumRows()));
+  ASSERT_TRUE((colPerm == nullptr || colPerm->size() == getNumColumns()));
 
-    // determine rows per percent
-    interval = numRows > 90 ? numRows / 90 : 1; 
+  bool const symmetric = rowPerm == colPerm || (rowPerm != nullptr && \
+      colPerm != nullptr && *rowPerm == *colPerm);
 
-    // apply the colperm while filling rowindex and rowvalue arrays
-    for (dim_type row = 0; row < numRows; ++row) {
-      for (index_type idx = m_offsets[row]; idx < m_offsets[row+1]; ++idx) {
-        m_columns[idx] = rename[oldColumns[idx]];
-      }
-      if (progress != nullptr && row % interval == 0) {
-        *progress += scale*INCREMENT;
-      }
-    }
-  }
-
-  invalidateStats();
+  reorderBy(rowPerm, colPerm, symmetric, progress, scale);
 }
 
 
@@ -286,85 +541,195 @@ void CSRMatrix::reduce(
     dim_type const * const cols,
     dim_type const numSampleCols,
     double * const progress,
-    double const scale)
+    double scale)
 {
+  // a principal submatrix of a symmetric matrix is symmetric, but any other
+  // submatrix may or may not be
+  bool const principal = (rows == nullptr || numSampleRows == numSampleCols) \
+      && isSymmetricPermutation(rows, cols, numSampleRows);
+  bool const symmetric = principal && isSymmetrySet() && isSymmetric();
+
+  if (m_halfStorage && !principal) {
+    expandToFullStorage(progress, scale*0.2);
+    scale *= 0.8;
+  }
+
+  // a principal submatrix in half storage is reduced as is, as the mapping
+  // of rows and columns preserves which entries are in the lower triangle
+
   dim_type const numRows = getNumRows();
   dim_type const numCols = getNumColumns();
 
-  // copy matrix
-  std::vector<index_type> const oldOffsets(m_offsets); 
-  std::vector<dim_type> const oldColumns(m_columns);
-  std::vector<value_type> const oldValues(m_values);
-
-  dim_type newRows;
-  if (rows != nullptr) {
-    m_offsets.resize(numSampleRows+1);
-    newRows = numSampleRows;
-  } else {
-    newRows = numRows;
-  }
+  dim_type const newRows = rows != nullptr ? numSampleRows : numRows;
+  dim_type const newCols = cols != nullptr ? numSampleCols : numCols;
 
   // set mapping for columns
-  dim_type newCols;
-  std::vector<dim_type> colMap(numCols,NULL_DIM);
+  std::vector<dim_type> colMap;
   if (cols != nullptr) {
-    for (dim_type colIdx = 0; colIdx < numSampleCols; ++colIdx) {
-      colMap[cols[colIdx]] = colIdx;
-    }
-    newCols = numSampleCols;
-  } else {
-    newCols = numCols;
+    colMap.assign(numCols, NULL_DIM);
+    Parallel::forRange(numSampleCols, \
+        [&](unsigned, size_t const start, size_t const end) {
+      for (size_t colIdx = start; colIdx < end; ++colIdx) {
+        ASSERT_LESS(cols[colIdx],numCols);
+        colMap[cols[colIdx]] = static_cast<dim_type>(colIdx);
+      }
+    });
   }
 
-  dim_type const interval = numCols > 100 ? numRows / 100 : 1; 
-  double const increment = scale*INCREMENT;
-
-  // build new matrix
-  index_type nnz = 0;
-  dim_type sampleRowIdx = 0;
-  for (dim_type row = 0; row < numRows; ++row) {
-    if (rows == nullptr || row == rows[sampleRowIdx]) {
-      for (index_type colIdx = oldOffsets[row]; colIdx < oldOffsets[row+1]; \
-          ++colIdx) {
-        dim_type const col = oldColumns[colIdx];
-        if (cols != nullptr) {
-          if (colMap[col] != NULL_DIM) {
-            m_columns[nnz] = colMap[col];
-            m_values[nnz] = oldValues[colIdx];
-            ++nnz;
+  // find the size of each new row, and sum them into offsets
+  std::vector<index_type> offsets(newRows+1);
+  offsets[0] = 0;
+  Parallel::forRange(newRows, \
+      [&](unsigned, size_t const start, size_t const end) {
+    for (size_t newRow = start; newRow < end; ++newRow) {
+      dim_type const row = rows != nullptr ? rows[newRow] : \
+          static_cast<dim_type>(newRow);
+      ASSERT_LESS(row,numRows);
+      if (cols != nullptr) {
+        index_type size = 0;
+        for (index_type idx = m_offsets[row]; idx < m_offsets[row+1]; \
+            ++idx) {
+          if (colMap[m_columns[idx]] != NULL_DIM) {
+            ++size;
           }
-        } else {
-          m_columns[nnz] = col;
-          m_values[nnz] = oldValues[colIdx];
-          ++nnz;
         }
+        offsets[newRow+1] = size;
+      } else {
+        offsets[newRow+1] = m_offsets[row+1] - m_offsets[row];
       }
-      m_offsets[++sampleRowIdx] = nnz;
     }
+  });
+  PrefixSum::inclusive(offsets.data()+1, newRows);
 
-    if (progress != nullptr && row % interval == 0) {
-      *progress += increment;
+  if (progress != nullptr) {
+    *progress += scale*0.2;
+  }
+
+  // the degrees of the new matrix are counted while building it, which in
+  // half storage adds the mirror of each strictly lower entry to the row
+  // lengths
+  dim_type const numCounts = m_halfStorage ? newRows : newCols;
+  std::unique_ptr<std::atomic<dim_type>[]> counts( \
+      new std::atomic<dim_type>[numCounts]);
+  Parallel::forRange(numCounts, \
+      [&](unsigned, size_t const start, size_t const end) {
+    for (size_t i = start; i < end; ++i) {
+      dim_type const init = m_halfStorage ? \
+          static_cast<dim_type>(offsets[i+1] - offsets[i]) : 0;
+      counts[i].store(init, std::memory_order_relaxed);
+    }
+  });
+
+  // each thread fills a run of new rows with about the same number of
+  // non-zeros
+  index_type const nnz = offsets[newRows];
+  std::vector<dim_type> columns(nnz);
+  ValueArray values(nnz, m_values.getPrecision());
+
+  unsigned const numThreads = Parallel::getNumThreads(nnz);
+  double const increment = scale * 0.7 / NUM_PROGRESS_STEPS;
+  int numSteps = 0;
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    dim_type const start = Parallel::getRowChunkStart(offsets.data(), \
+        newRows, numThreads, tid);
+    dim_type const end = Parallel::getRowChunkStart(offsets.data(), \
+        newRows, numThreads, tid+1);
+    dim_type const interval = std::max<dim_type>(1, \
+        (end - start) / NUM_PROGRESS_STEPS);
+
+    for (dim_type newRow = start; newRow < end; ++newRow) {
+      dim_type const row = rows != nullptr ? rows[newRow] : newRow;
+      index_type newIdx = offsets[newRow];
+      for (index_type idx = m_offsets[row]; idx < m_offsets[row+1]; ++idx) {
+        dim_type const col = cols != nullptr ? colMap[m_columns[idx]] : \
+            m_columns[idx];
+        if (col != NULL_DIM) {
+          columns[newIdx] = col;
+          values.copy(newIdx, m_values, idx);
+          ++newIdx;
+          if (!m_halfStorage || col != newRow) {
+            counts[col].fetch_add(1, std::memory_order_relaxed);
+          }
+        }
+      }
+      ASSERT_EQUAL(newIdx,offsets[newRow+1]);
+
+      // only the first thread reports progress
+      if (tid == 0 && progress != nullptr && \
+          (newRow - start) % interval == 0 && \
+          (newRow - start) / interval < NUM_PROGRESS_STEPS) {
+        *progress += increment;
+        ++numSteps;
+      }
     }
+  });
+
+  // the first thread may have had fewer rows than steps
+  if (progress != nullptr) {
+    *progress += increment * (NUM_PROGRESS_STEPS - numSteps);
   }
-  ASSERT_EQUAL(sampleRowIdx,newRows);
+
+  m_offsets.swap(offsets);
+  m_columns.swap(columns);
+  m_values = std::move(values);
 
   // set new dimensions
   setNumRows(newRows);
   setNumColumns(newCols);
   updateNumNonZeros();
 
-  invalidateStats();
+  transformStats(STATS_INVALIDATE, STATS_INVALIDATE, STATS_INVALIDATE, \
+      STATS_INVALIDATE, symmetric ? STATS_PRESERVE : STATS_INVALIDATE);
+
+  // the degrees and their statistics are known from the new matrix
+  std::vector<dim_type> colDegrees(numCounts);
+  Parallel::forRange(numCounts, \
+      [&](unsigned, size_t const start, size_t const end) {
+    for (size_t i = start; i < end; ++i) {
+      colDegrees[i] = counts[i].load(std::memory_order_relaxed);
+    }
+  });
+  std::vector<dim_type> rowDegrees;
+  if (m_halfStorage) {
+    rowDegrees = colDegrees;
+  } else {
+    rowDegrees.resize(newRows);
+    Parallel::forRange(newRows, \
+        [&](unsigned, size_t const start, size_t const end) {
+      for (size_t row = start; row < end; ++row) {
+        rowDegrees[row] = static_cast<dim_type>(m_offsets[row+1] - \
+            m_offsets[row]);
+      }
+    });
+  }
+
+  if (progress != nullptr) {
+    *progress += scale*0.1;
+  }
+
+  setRowStats(Stats::summarizeDegrees(rowDegrees.data(), newRows));
+  setColumnStats(Stats::summarizeDegrees(colDegrees.data(), newCols));
+  setRowDegrees(std::move(rowDegrees));
+  setColumnDegrees(std::move(colDegrees));
 }
 
 
 void CSRMatrix::computeSymmetry(
     double * const progress,
-    double const scale)
+    double const scale,
+    std::atomic<bool> const * const cancel)
 {
   if (!isSquare()) {
     // easy call
     setSymmetry(false);
     setStructuralSymmetry(false);
+  } else if (m_halfStorage) {
+    // symmetric by construction
+    setSymmetry(true);
+    setStructuralSymmetry(true);
+    if (progress != nullptr) {
+      *progress += scale;
+    }
   } else {
     dim_type const numRows = getNumRows();
 
@@ -375,19 +740,19 @@ void CSRMatrix::computeSymmetry(
     for (dim_type row = 0; row < numRows; ++row) {
       for (index_type idx = m_offsets[row]; idx < m_offsets[row+1]; ++idx) {
         dim_type const col = m_columns[idx];
-        value_type const val = m_values[idx];
+        value_type const val = m_values.get(idx);
         index_type const stepIdx = steps[col];
-        if (m_columns[stepIdx] != row && m_values[stepIdx] != 0) {
+        if (m_columns[stepIdx] != row && m_values.get(stepIdx) != 0) {
 
           std::cout << "missing value at: " << row << "," << col << std::endl;
 
           // missing non-zero
           setSymmetry(false);
           return;
-        } else if (m_values[stepIdx] != val) {
+        } else if (m_values.get(stepIdx) != val) {
 
           std::cout << "mismatch values at: " << row << "," << col << \
-              " : " << val << "," << m_values[stepIdx] << std::endl;
+              " : " << val << "," << m_values.get(stepIdx) << std::endl;
 
           // not matching values 
           setSymmetry(false);
@@ -405,9 +770,14 @@ void CSRMatrix::computeSymmetry(
     dim_type interval = numRows > 30 ? numRows / 30 : 1; 
 
     for (dim_type row = 0; row < numRows; ++row) {
+      if (row % CANCEL_INTERVAL == 0 && cancel != nullptr && \
+          cancel->load(std::memory_order_relaxed)) {
+        return;
+      }
+
       for (index_type idx = m_offsets[row]; idx < m_offsets[row+1]; ++idx) {
         dim_type const col = m_columns[idx];
-        value_type const val = m_values[idx];
+        value_type const val = m_values.get(idx);
         index_type idx2;
         for (idx2 = m_offsets[col]; idx2 < m_offsets[col+1]; \
             ++idx2) {
@@ -425,7 +795,7 @@ void CSRMatrix::computeSymmetry(
             *progress += ((numRows - row)/30) * scale * INCREMENT;
           }
           goto END;
-        } else if (std::abs(m_values[idx2] - val) > tolerance) {
+        } else if (std::abs(m_values.get(idx2) - val) > tolerance) {
           // keep searching for structural symmetry
           numerical = false;
         }
@@ -452,8 +822,200 @@ void CSRMatrix::computeSymmetry(
 
 void CSRMatrix::updateNumNonZeros()
 {
-  ASSERT_EQUAL(getNumRows()+1,m_offsets.size());
-  setNumNonZeros(m_offsets[getNumRows()]);
+  dim_type const numRows = getNumRows();
+
+  ASSERT_EQUAL(numRows+1,m_offsets.size());
+
+  if (m_halfStorage) {
+    // every off-diagonal entry is stored once for two non-zeros
+    index_type numDiagonal = 0;
+    for (dim_type row = 0; row < numRows; ++row) {
+      for (index_type idx = m_offsets[row]; idx < m_offsets[row+1]; ++idx) {
+        if (m_columns[idx] == row) {
+          ++numDiagonal;
+        }
+      }
+    }
+    setNumNonZeros((2*m_offsets[numRows]) - numDiagonal);
+  } else {
+    setNumNonZeros(m_offsets[numRows]);
+  }
+}
+
+
+
+
+/******************************************************************************
+* PRIVATE FUNCTIONS ***********************************************************
+******************************************************************************/
+
+
+template<typename R, typename C>
+void CSRMatrix::reorderBy(
+    R const * const rowPerm,
+    C const * const colPerm,
+    bool const symmetric,
+    double * const progress,
+    double scale)
+{
+  dim_type const numRows = getNumRows();
+
+  assert(m_offsets.size() == numRows+1);
+
+  // the row and column sizes are only moved around by a permutation, and a
+  // symmetric permutation keeps a symmetric matrix symmetric (and a
+  // non-symmetric one non-symmetric)
+  stats_transform_type const symmetry = !isSquare() || symmetric ? \
+      STATS_PRESERVE : STATS_INVALIDATE;
+
+  if (m_halfStorage && rowPerm != nullptr && symmetric) {
+    reorderHalf(*rowPerm, progress, scale);
+  } else {
+    if (m_halfStorage) {
+      // this permutation breaks symmetry
+      expandToFullStorage(progress, scale*0.2);
+      scale *= 0.8;
+    }
+
+    if (rowPerm != nullptr) {
+      std::vector<index_type> const oldOffsets(m_offsets); 
+      std::vector<dim_type> const oldColumns(m_columns);
+      ValueArray const oldValues(m_values);
+
+      // find the size of each new row, and sum them into offsets
+      m_offsets[0] = 0;
+      Parallel::forRange(numRows, \
+          [&](unsigned, size_t const start, size_t const end) {
+        for (size_t row = start; row < end; ++row) {
+          dim_type const v = static_cast<dim_type>( \
+              (*rowPerm)(static_cast<dim_type>(row)));
+          ASSERT_LESS(v,numRows);
+          m_offsets[row+1] = oldOffsets[v+1] - oldOffsets[v];
+        }
+      });
+      PrefixSum::inclusive(m_offsets.data()+1, numRows);
+
+      if (progress != nullptr) {
+        *progress += scale*0.1;
+      }
+
+      // each thread fills a run of new rows with about the same number of
+      // non-zeros, applying the column permutation as it goes
+      unsigned const numThreads = Parallel::getNumThreads(m_offsets[numRows]);
+      double const increment = scale * 0.9 / NUM_PROGRESS_STEPS;
+      Parallel::run(numThreads, [&](unsigned const tid) {
+        dim_type const start = Parallel::getRowChunkStart(m_offsets.data(), \
+            numRows, numThreads, tid);
+        dim_type const end = Parallel::getRowChunkStart(m_offsets.data(), \
+            numRows, numThreads, tid+1);
+        dim_type const interval = std::max<dim_type>(1, \
+            (end - start) / NUM_PROGRESS_STEPS);
+
+        for (dim_type row = start; row < end; ++row) {
+          dim_type const v = static_cast<dim_type>((*rowPerm)(row));
+          index_type newIdx = m_offsets[row];
+          for (index_type idx = oldOffsets[v]; idx < oldOffsets[v+1]; ++idx) {
+            dim_type const col = oldColumns[idx];
+            m_columns[newIdx] = colPerm != nullptr ? \
+                static_cast<dim_type>(colPerm->inverse(col)) : col;
+            m_values.copy(newIdx, oldValues, idx);
+            ++newIdx;
+          }
+
+          // only the first thread reports progress
+          if (tid == 0 && progress != nullptr && \
+              (row - start) % interval == 0 && \
+              (row - start) / interval < NUM_PROGRESS_STEPS) {
+            *progress += increment;
+          }
+        }
+      });
+    } else if (colPerm != nullptr) {
+      // only rename the columns, which can be done in place
+      Parallel::forRange(m_offsets[numRows], \
+          [&](unsigned, size_t const start, size_t const end) {
+        for (size_t idx = start; idx < end; ++idx) {
+          m_columns[idx] = static_cast<dim_type>( \
+              colPerm->inverse(m_columns[idx]));
+        }
+      });
+
+      if (progress != nullptr) {
+        *progress += scale;
+      }
+    }
+
+    // renamed columns are out of order
+    if (colPerm != nullptr) {
+      sortRows();
+    }
+  }
+
+  // the cached degrees move with their rows and columns
+  if (rowPerm != nullptr && isRowDegreesSet()) {
+    setRowDegrees(permuteDegrees(getRowDegrees(), *rowPerm));
+  }
+  if (colPerm != nullptr && isColumnDegreesSet()) {
+    setColumnDegrees(permuteDegrees(getColumnDegrees(), *colPerm));
+  }
+
+  transformStats(STATS_PRESERVE, STATS_PRESERVE, STATS_INVALIDATE, \
+      STATS_PRESERVE, symmetry);
+}
+
+
+template<typename P>
+void CSRMatrix::reorderHalf(
+    P const & perm,
+    double * const progress,
+    double const scale)
+{
+  dim_type const numRows = getNumRows();
+
+  std::vector<index_type> const oldOffsets(m_offsets); 
+  std::vector<dim_type> const oldColumns(m_columns);
+  ValueArray const oldValues(m_values);
+
+  // an entry (i,j) moves to (perm.inverse(i),perm.inverse(j)), which is then
+  // folded back into the lower triangle
+  m_offsets.assign(numRows+1,0);
+  for (dim_type row = 0; row < numRows; ++row) {
+    dim_type const newRow = static_cast<dim_type>(perm.inverse(row));
+    for (index_type idx = oldOffsets[row]; idx < oldOffsets[row+1]; ++idx) {
+      dim_type const newCol = static_cast<dim_type>( \
+          perm.inverse(oldColumns[idx]));
+      ++m_offsets[std::max(newRow,newCol)+1];
+    }
+  }
+
+  if (progress != nullptr) {
+    *progress += scale*0.3;
+  }
+
+  PrefixSum::exclusive(m_offsets.data()+1,numRows);
+
+  // determine rows per percent
+  dim_type const interval = numRows > 70 ? numRows / 70 : 1; 
+
+  for (dim_type row = 0; row < numRows; ++row) {
+    dim_type const newRow = static_cast<dim_type>(perm.inverse(row));
+    for (index_type idx = oldOffsets[row]; idx < oldOffsets[row+1]; ++idx) {
+      dim_type const newCol = static_cast<dim_type>( \
+          perm.inverse(oldColumns[idx]));
+      index_type const newIdx = m_offsets[std::max(newRow,newCol)+1]++;
+      m_columns[newIdx] = std::min(newRow,newCol);
+      m_values.copy(newIdx, oldValues, idx);
+    }
+
+    if (progress != nullptr && row % interval == 0) {
+      *progress += scale*INCREMENT;
+    }
+  }
+
+  ASSERT_EQUAL(m_offsets[numRows],oldOffsets[numRows]);
+
+  // the entries of each row come from rows in their old order
+  sortRows();
 }
 
 
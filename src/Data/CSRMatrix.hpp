@@ -16,7 +16,9 @@
 
 
 #include "SparseMatrix.hpp"
+#include "ValueArray.hpp"
 #include "Types.hpp"
+#include "Utility/FeistelPermutation.hpp"
 #include <vector>
 
 
@@ -30,17 +32,24 @@ class CSRMatrix :
   public SparseMatrix
 {
   public:
+    using Matrix::transpose;
+    using Matrix::reorder;
+    using Matrix::computeSymmetry;
+
+
     /**
     * @brief Create a new CSR matrix.
     *
     * @param numRows The number of rows.
     * @param numCols The number of columns.
     * @param numNonZeros The number of non-zeros.
+    * @param precision The precision to store the values at.
     */
     CSRMatrix(
         dim_type numRows,
         dim_type numCols,
-        index_type numNonZeros);
+        index_type numNonZeros,
+        ValueArray::precision_type precision = ValueArray::FULL_PRECISION);
 
 
     /**
@@ -75,9 +84,27 @@ class CSRMatrix :
         double scale) override;
 
 
+    /**
+    * @brief Re-order the matrix by permutations computed on demand, rather
+    * than stored as arrays.
+    *
+    * @param rowPerm The row permutation, mapping new rows to old rows (may be
+    * null).
+    * @param colPerm The column permutation, mapping new columns to old
+    * columns (may be null).
+    * @param progress The progress indicator to update.
+    * @param scale The fraction of the total progress to be updated.
+    */
+    void reorder(
+        FeistelPermutation const * rowPerm,
+        FeistelPermutation const * colPerm,
+        double * progress,
+        double scale);
+
+
     /**
      * @brief Reduce the size of the matix down to the specified set of rows and
-     * columns.
+     * columns. The new matrix is built in parallel.
      *
      * @param rows The set of rows to reduce it to. Must be in ascending order.
      * @param numRows The number of rows in the set.
@@ -101,10 +128,67 @@ class CSRMatrix :
     *
     * @param progress The progress of the task.
     * @param scale The fraction of the task this operation completes.
+    * @param cancel The flag which, once set, stops the check without setting
+    * the symmetry (may be null).
     */
     void computeSymmetry(
         double * progress,
-        double scale) override;
+        double scale,
+        std::atomic<bool> const * cancel) override;
+
+
+    /**
+    * @brief Check if only the lower triangle of this (symmetric) matrix is
+    * stored. In this mode the offsets, columns, and values only describe the
+    * entries on or below the diagonal, and each off-diagonal entry implies
+    * its mirror.
+    *
+    * @return True if the matrix is in half storage.
+    */
+    bool isHalfStorage() const noexcept;
+
+
+    /**
+    * @brief Get the number of non-zeros physically stored in the matrix. This
+    * differs from getNumNonZeros() only when in half storage.
+    *
+    * @return The number of stored non-zeros.
+    */
+    index_type getNumStoredNonZeros() const;
+
+
+    /**
+    * @brief Convert a symmetric matrix to store only its lower triangle. The
+    * caller must know the matrix to be symmetric (e.g., its file declared it
+    * so), and the matrix will be marked as symmetric.
+    *
+    * @param progress The progress indicator to update.
+    * @param scale The fraction of the total progress to be updated.
+    */
+    void convertToHalfStorage(
+        double * progress = nullptr,
+        double scale = 1.0);
+
+
+    /**
+    * @brief Expand a matrix in half storage back to full storage. This is
+    * done automatically by any operation which would break symmetry.
+    *
+    * @param progress The progress indicator to update.
+    * @param scale The fraction of the total progress to be updated.
+    */
+    void expandToFullStorage(
+        double * progress = nullptr,
+        double scale = 1.0);
+
+
+    /**
+    * @brief Sort the entries of each row by column, in parallel. Rows which
+    * are already sorted are only checked. Loading and reordering leave the
+    * rows sorted, so that the entries in a range of columns can be found by
+    * binary search.
+    */
+    void sortRows();
 
 
     /**
@@ -139,14 +223,52 @@ class CSRMatrix :
 
 
     /**
-    * @brief Get the non-zero values in the matrix.
+    * @brief Get the precision the non-zero values are stored at.
+    *
+    * @return The precision.
+    */
+    ValueArray::precision_type getValuePrecision() const noexcept;
+
+
+    /**
+    * @brief Change the precision the non-zero values are stored at. Reducing
+    * the precision is lossy.
+    *
+    * @param precision The new precision.
+    */
+    void setValuePrecision(
+        ValueArray::precision_type precision);
+
+
+    /**
+    * @brief Get the non-zero values in the matrix, at whatever precision
+    * they are stored.
+    *
+    * @return The values.
+    */
+    ValueArray const & getValueArray() const noexcept;
+
+
+    /**
+    * @brief Get the non-zero values in the matrix, at whatever precision
+    * they are stored, so that they can be set one at a time.
+    *
+    * @return The values.
+    */
+    ValueArray & getValueArray() noexcept;
+
+
+    /**
+    * @brief Get the non-zero values in the matrix. Only available when the
+    * values are stored at full precision.
     *
     * @return The values.
     */
     value_type const * getValues() const;
 
     /**
-    * @brief Get the non-zero values in the matrix.
+    * @brief Get the non-zero values in the matrix. Only available when the
+    * values are stored at full precision.
     *
     * @return The values.
     */
@@ -160,7 +282,46 @@ class CSRMatrix :
   private:
     std::vector<index_type> m_offsets;
     std::vector<dim_type> m_columns;
-    std::vector<value_type> m_values;
+    ValueArray m_values;
+    bool m_halfStorage;
+
+
+    /**
+    * @brief Re-order the matrix in parallel. The permutations map each new
+    * index to its old index with operator(), and each old index to its new
+    * index with inverse().
+    *
+    * @tparam R The row permutation type.
+    * @tparam C The column permutation type.
+    * @param rowPerm The row permutation (may be null).
+    * @param colPerm The column permutation (may be null).
+    * @param symmetric Whether the row and column permutations are the same.
+    * @param progress The progress indicator to update.
+    * @param scale The fraction of the total progress to be updated.
+    */
+    template<typename R, typename C>
+    void reorderBy(
+        R const * rowPerm,
+        C const * colPerm,
+        bool symmetric,
+        double * progress,
+        double scale);
+
+
+    /**
+    * @brief Apply the same permutation to the rows and columns of a matrix in
+    * half storage, keeping it in half storage.
+    *
+    * @tparam P The permutation type.
+    * @param perm The permutation.
+    * @param progress The progress indicator to update.
+    * @param scale The fraction of the total progress to be updated.
+    */
+    template<typename P>
+    void reorderHalf(
+        P const & perm,
+        double * progress,
+        double scale);
     
 };
 
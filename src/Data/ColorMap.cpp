@@ -0,0 +1,404 @@
+/**
+ * @file ColorMap.cpp
+ * @brief Implementation of the ColorMap class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "ColorMap.hpp"
+#include "HeatMap.hpp"
+#include "Utility/Parallel.hpp"
+#include "Utility/Debug.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+// the number of colors sampled from each map, which is enough that
+// neighboring colors cannot be told apart
+size_t const TABLE_SIZE = 4096;
+
+float const MAX_INDEX = static_cast<float>(TABLE_SIZE - 1);
+
+// colors evenly spaced along viridis, between which it is interpolated
+size_t const NUM_VIRIDIS_COLORS = 11;
+unsigned char const VIRIDIS_COLORS[NUM_VIRIDIS_COLORS][3] = {
+  {68, 1, 84},
+  {72, 37, 118},
+  {65, 68, 135},
+  {53, 96, 141},
+  {42, 120, 142},
+  {33, 144, 140},
+  {34, 168, 132},
+  {67, 191, 113},
+  {122, 209, 81},
+  {187, 223, 39},
+  {253, 231, 37}
+};
+
+// colors evenly spaced along red and blue, reversed so that negative values
+// are blue, between which it is interpolated
+size_t const NUM_DIVERGING_COLORS = 11;
+unsigned char const DIVERGING_COLORS[NUM_DIVERGING_COLORS][3] = {
+  {5, 48, 97},
+  {33, 102, 172},
+  {67, 147, 195},
+  {146, 197, 222},
+  {209, 229, 240},
+  {247, 247, 247},
+  {253, 219, 199},
+  {244, 165, 130},
+  {214, 96, 77},
+  {178, 24, 43},
+  {103, 0, 31}
+};
+
+// the bits of a float of 1.0
+int32_t const ONE_BITS = 127 << 23;
+
+float const MANTISSA_SCALE = 1.0f / static_cast<float>(1 << 23);
+
+}
+
+
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+
+inline uint32_t toRGBA(
+    unsigned const red,
+    unsigned const green,
+    unsigned const blue) noexcept
+{
+  return (blue << 16) | (green << 8) | red;
+}
+
+
+/**
+* @brief Get the color at a point along evenly spaced colors, interpolated
+* between the two nearest.
+*
+* @param colors The colors.
+* @param numColors The number of colors.
+* @param val The point, in the range [0, 1].
+*
+* @return The color.
+*/
+uint32_t interpolate(
+    unsigned char const (* const colors)[3],
+    size_t const numColors,
+    float const val)
+{
+  float const pos = val * (numColors - 1);
+  size_t const low = std::min(static_cast<size_t>(pos), numColors - 2);
+  float const frac = pos - low;
+  unsigned channels[3];
+  for (int c = 0; c < 3; ++c) {
+    channels[c] = static_cast<unsigned>(std::lround( \
+        (colors[low][c] * (1.0f - frac)) + (colors[low+1][c] * frac)));
+  }
+
+  return toRGBA(channels[0], channels[1], channels[2]);
+}
+
+
+/**
+* @brief Sample the colors of a map.
+*
+* @param type The map.
+*
+* @return The colors.
+*/
+std::vector<uint32_t> buildTable(
+    ColorMap::colormap_type const type)
+{
+  std::vector<uint32_t> table(TABLE_SIZE);
+  for (size_t i = 0; i < TABLE_SIZE; ++i) {
+    float const val = static_cast<float>(i) / MAX_INDEX;
+    switch (type) {
+      case ColorMap::VIRIDIS:
+        table[i] = interpolate(VIRIDIS_COLORS, NUM_VIRIDIS_COLORS, val);
+        break;
+      case ColorMap::DIVERGING:
+        table[i] = interpolate(DIVERGING_COLORS, NUM_DIVERGING_COLORS, val);
+        break;
+      case ColorMap::GRAYSCALE: {
+        unsigned const level = static_cast<unsigned>(std::lround(val * 255));
+        table[i] = toRGBA(level, level, level);
+        break;
+      }
+      default:
+        table[i] = HeatMap::floatToRGBA(val);
+    }
+  }
+
+  return table;
+}
+
+
+/**
+* @brief Get the sampled colors of a map, which are built on first use.
+*
+* @param type The map.
+*
+* @return The colors.
+*/
+uint32_t const * getTable(
+    ColorMap::colormap_type const type)
+{
+  static std::vector<uint32_t> const heat = buildTable(ColorMap::HEAT);
+  static std::vector<uint32_t> const viridis = buildTable(ColorMap::VIRIDIS);
+  static std::vector<uint32_t> const grayscale = \
+      buildTable(ColorMap::GRAYSCALE);
+  static std::vector<uint32_t> const diverging = \
+      buildTable(ColorMap::DIVERGING);
+
+  switch (type) {
+    case ColorMap::VIRIDIS:
+      return viridis.data();
+    case ColorMap::GRAYSCALE:
+      return grayscale.data();
+    case ColorMap::DIVERGING:
+      return diverging.data();
+    default:
+      return heat.data();
+  }
+}
+
+
+/**
+* @brief Approximate the base two logarithm of a value of at least one, by
+* reading its bits as a fixed point number. The approximation is exact at
+* powers of two, linear in between, and increasing.
+*
+* @param val The value.
+*
+* @return The approximate logarithm.
+*/
+inline float approxLog2(
+    float const val) noexcept
+{
+  int32_t bits;
+  std::memcpy(&bits, &val, sizeof(bits));
+  return static_cast<float>(static_cast<int64_t>(bits) - ONE_BITS) * \
+      MANTISSA_SCALE;
+}
+
+
+/**
+* @brief Convert a range of values to colors.
+*
+* @param values The values.
+* @param num The number of values.
+* @param min The smallest value.
+* @param factor The scale from the (logarithm of the) value above the minimum
+* to the range [0, 1].
+* @param log Whether or not to take the logarithm.
+* @param table The colors.
+* @param colors The colors of each value (output).
+*/
+inline void convertScalar(
+    value_type const * const values,
+    size_t const num,
+    float const min,
+    float const factor,
+    bool const log,
+    uint32_t const * const table,
+    uint32_t * const colors) noexcept
+{
+  for (size_t i = 0; i < num; ++i) {
+    float t = values[i] - min;
+    if (log) {
+      t = approxLog2(1.0f + t);
+    }
+    t *= factor;
+    // nans are clamped to zero
+    t = t > 0.0f ? t : 0.0f;
+    t = t < 1.0f ? t : 1.0f;
+    colors[i] = table[static_cast<int32_t>((t * MAX_INDEX) + 0.5f)];
+  }
+}
+
+
+#if defined(__AVX2__)
+
+inline void convert(
+    value_type const * const values,
+    size_t const num,
+    float const min,
+    float const factor,
+    bool const log,
+    uint32_t const * const table,
+    uint32_t * const colors) noexcept
+{
+  __m256 const vmin = _mm256_set1_ps(min);
+  __m256 const vfactor = _mm256_set1_ps(factor);
+  __m256 const one = _mm256_set1_ps(1.0f);
+  __m256 const zero = _mm256_setzero_ps();
+  __m256 const maxIndex = _mm256_set1_ps(MAX_INDEX);
+  __m256 const half = _mm256_set1_ps(0.5f);
+  __m256i const oneBits = _mm256_set1_epi32(ONE_BITS);
+  __m256 const mantissaScale = _mm256_set1_ps(MANTISSA_SCALE);
+  int const * const entries = reinterpret_cast<int const *>(table);
+
+  size_t i;
+  for (i = 0; i + 8 <= num; i += 8) {
+    __m256 t = _mm256_sub_ps(_mm256_loadu_ps(values+i), vmin);
+    if (log) {
+      __m256i const bits = _mm256_castps_si256(_mm256_add_ps(one, t));
+      t = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(bits, oneBits)), \
+          mantissaScale);
+    }
+    t = _mm256_mul_ps(t, vfactor);
+    // max returns its second operand for nans, clamping them to zero
+    t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+    __m256i const idx = _mm256_cvttps_epi32(_mm256_add_ps( \
+        _mm256_mul_ps(t, maxIndex), half));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(colors+i), \
+        _mm256_i32gather_epi32(entries, idx, 4));
+  }
+
+  convertScalar(values+i, num-i, min, factor, log, table, colors+i);
+}
+
+#else
+
+inline void convert(
+    value_type const * const values,
+    size_t const num,
+    float const min,
+    float const factor,
+    bool const log,
+    uint32_t const * const table,
+    uint32_t * const colors) noexcept
+{
+  convertScalar(values, num, min, factor, log, table, colors);
+}
+
+#endif
+
+
+}
+
+
+
+
+/******************************************************************************
+* CONSTRUCTORS / DESTRUCTOR ***************************************************
+******************************************************************************/
+
+
+ColorMap::ColorMap(
+    colormap_type const type,
+    scale_type const scale) :
+  m_type(type),
+  m_scale(scale),
+  m_table(getTable(type))
+{
+  // do nothing
+}
+
+
+
+
+/******************************************************************************
+* PUBLIC FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+ColorMap::colormap_type ColorMap::getType() const noexcept
+{
+  return m_type;
+}
+
+
+ColorMap::scale_type ColorMap::getScale() const noexcept
+{
+  return m_scale;
+}
+
+
+uint32_t ColorMap::getColor(
+    float val) const noexcept
+{
+  val = val > 0.0f ? val : 0.0f;
+  val = val < 1.0f ? val : 1.0f;
+  return m_table[static_cast<int32_t>((val * MAX_INDEX) + 0.5f)];
+}
+
+
+void ColorMap::apply(
+    value_type const * const values,
+    size_t const numValues,
+    value_type min,
+    value_type max,
+    uint32_t * const colors) const
+{
+  // zero is the middle of a diverging map
+  if (m_type == DIVERGING) {
+    value_type const bound = std::max(std::fabs(min), std::fabs(max));
+    min = -bound;
+    max = bound;
+  }
+
+  float const range = max - min;
+  if (!(range > 0)) {
+    uint32_t const color = getColor(0.5f);
+    Parallel::forRange(numValues, [&](unsigned, size_t const start, \
+        size_t const end) {
+      std::fill(colors+start, colors+end, color);
+    });
+    return;
+  }
+
+  // a range too small to change the logarithm is shown linearly
+  bool log = m_scale == LOG_SCALE && m_type != DIVERGING;
+  float factor = 1.0f / range;
+  if (log) {
+    float const logRange = approxLog2(1.0f + range);
+    if (logRange > 0) {
+      factor = 1.0f / logRange;
+    } else {
+      log = false;
+    }
+  }
+
+  Parallel::forRange(numValues, [&](unsigned, size_t const start, \
+      size_t const end) {
+    convert(values+start, end-start, min, factor, log, \
+        m_table, colors+start);
+  });
+}
+
+
+
+}
@@ -0,0 +1,135 @@
+/**
+ * @file ColorMap.hpp
+ * @brief The ColorMap class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_COLORMAP_HPP
+#define MATRIXINSPECTOR_COLORMAP_HPP
+
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include "Types.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/**
+* @brief Converts values to colors, in the format of HeatMap::floatToRGBA(),
+* through a table of colors sampled from the map.
+*/
+class ColorMap
+{
+  public:
+    enum colormap_type {
+      // blue through green and red to white
+      HEAT,
+      // perceptually uniform dark blue through green to yellow
+      VIRIDIS,
+      // black to white
+      GRAYSCALE,
+      // blue through white to red, centered on zero, for signed values
+      DIVERGING
+    };
+
+
+    enum scale_type {
+      // colors are evenly spaced in value
+      LINEAR_SCALE,
+      // colors are evenly spaced in the logarithm of the value above the
+      // minimum, which shows the sparse parts of skewed heat maps
+      LOG_SCALE
+    };
+
+
+    /**
+    * @brief Create a new color map.
+    *
+    * @param type The colors.
+    * @param scale How values are spaced between the colors.
+    */
+    ColorMap(
+        colormap_type type = HEAT,
+        scale_type scale = LINEAR_SCALE);
+
+
+    /**
+    * @brief Get the colors of the map.
+    *
+    * @return The colors.
+    */
+    colormap_type getType() const noexcept;
+
+
+    /**
+    * @brief Get how values are spaced between the colors.
+    *
+    * @return The scale.
+    */
+    scale_type getScale() const noexcept;
+
+
+    /**
+    * @brief Get the color of a value which has been normalized to the range
+    * [0, 1], which ignores the scale.
+    *
+    * @param val The normalized value.
+    *
+    * @return The color.
+    */
+    uint32_t getColor(
+        float val) const noexcept;
+
+
+    /**
+    * @brief Normalize values by their range, scale them, and convert them to
+    * colors in a single pass. If the range is empty, all values are given the
+    * middle color, as HeatMap::normalize() does. A diverging map widens the
+    * range to be centered on zero, and is always linear, so that zero is
+    * its middle color.
+    *
+    * @param values The values.
+    * @param numValues The number of values.
+    * @param min The smallest value.
+    * @param max The largest value.
+    * @param colors The colors (output).
+    */
+    void apply(
+        value_type const * values,
+        size_t numValues,
+        value_type min,
+        value_type max,
+        uint32_t * colors) const;
+
+
+  private:
+    colormap_type m_type;
+    scale_type m_scale;
+    uint32_t const * m_table;
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
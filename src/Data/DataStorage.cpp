@@ -7,12 +7,18 @@
  */
 
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
+#include <utility>
 #include <wildriver.h>
 #include "Types.hpp"
 #include "DataStorage.hpp"
 #include "Data/CSRMatrix.hpp"
+#include "Data/TripletReader.hpp"
+#include "Operations/Sample.hpp"
+#include "Utility/PrefixSum.hpp"
+#include "Utility/Random.hpp"
 #include "Utility/Timer.hpp"
 
 
@@ -21,6 +27,76 @@ namespace MatrixInspector
 {
 
 
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+/**
+* @brief Number a set of kept indices in order.
+*
+* @param kept The kept indices, in ascending order.
+* @param num The total number of indices.
+*
+* @return The new number of each index, or NULL_DIM if it is not kept.
+*/
+std::vector<dim_type> numberKept(
+    std::vector<dim_type> const & kept,
+    dim_type const num)
+{
+  std::vector<dim_type> map(num, NULL_DIM);
+  for (size_t i = 0; i < kept.size(); ++i) {
+    map[kept[i]] = static_cast<dim_type>(i);
+  }
+
+  return map;
+}
+
+
+/**
+* @brief Select the indices with degrees within a range.
+*
+* @param degrees The degrees.
+* @param minSize The minimum degree.
+* @param maxSize The maximum degree.
+*
+* @return The selected indices, in ascending order.
+*/
+std::vector<dim_type> selectThreshold(
+    std::vector<dim_type> const & degrees,
+    dim_type const minSize,
+    dim_type const maxSize)
+{
+  std::vector<dim_type> kept;
+  for (size_t i = 0; i < degrees.size(); ++i) {
+    if (degrees[i] >= minSize && degrees[i] <= maxSize) {
+      kept.emplace_back(static_cast<dim_type>(i));
+    }
+  }
+
+  return kept;
+}
+
+
+std::vector<dim_type> selectAll(
+    dim_type const num)
+{
+  std::vector<dim_type> kept(num);
+  for (dim_type i = 0; i < num; ++i) {
+    kept[i] = i;
+  }
+
+  return kept;
+}
+
+}
+
+
+
+
 /******************************************************************************
 * PUBLIC STATIC FUNCTIONS *****************************************************
 ******************************************************************************/
@@ -76,8 +152,18 @@ DataStorage::~DataStorage()
 
 void DataStorage::loadDataset(
     char const * const path,
-    double * const progress)
+    double * const progress,
+    ValueArray::precision_type const precision)
 {
+  // wildriver expands symmetric files and reads values at full precision,
+  // so files which can be streamed are instead, keeping only the lower
+  // triangle and encoding the values as they are read
+  if (TripletReader::isSupported(path)) {
+    load_options_struct const options{LOAD_ALL, 0, 0, false, 0, 0, 0};
+    streamDataset(path, options, progress, precision);
+    return;
+  }
+
   Timer tmr;
 
   tmr.start();
@@ -100,18 +186,70 @@ void DataStorage::loadDataset(
     throw std::runtime_error("Failed to load dataset.");
   }
 
+  mat->sortRows();
+
+  // the reader only produces full precision values, so these formats are
+  // held at full precision while loading
+  mat->setValuePrecision(precision);
+
   tmr.stop();
 
   std::cout << "Loading took: " << tmr.poll() << "s" << std::endl;
 }
 
 
+void DataStorage::loadDataset(
+    char const * const path,
+    load_options_struct const & options,
+    double * const progress,
+    ValueArray::precision_type const precision)
+{
+  if (options.type == LOAD_ALL) {
+    loadDataset(path, progress, precision);
+    return;
+  }
+
+  if (!TripletReader::isSupported(path)) {
+    // other formats can only be read whole
+    loadDataset(path, progress, precision);
+
+    Matrix * const mat = m_matrix.get();
+    switch (options.type) {
+      case LOAD_RANDOM:
+        Sample::random(mat, \
+            std::min(options.numSampleRows, mat->getNumRows()), \
+            std::min(options.numSampleCols, mat->getNumColumns()), \
+            options.symmetric);
+        break;
+      case LOAD_THRESHOLD_ROWS:
+        Sample::thresholdRows(mat, options.minSize, options.maxSize);
+        break;
+      default:
+        Sample::thresholdColumns(mat, options.minSize, options.maxSize);
+    }
+    return;
+  }
+
+  streamDataset(path, options, progress, precision);
+}
+
+
 void DataStorage::saveDataset(
     char const * const path,
     double * const progress)
 {
   CSRMatrix const * csr;
   if ((csr = dynamic_cast<CSRMatrix const *>(m_matrix.get())) != nullptr) {
+    // writers expect both triangles at full precision
+    std::unique_ptr<CSRMatrix> full;
+    if (csr->isHalfStorage() || \
+        csr->getValuePrecision() != ValueArray::FULL_PRECISION) {
+      full.reset(new CSRMatrix(*csr));
+      full->expandToFullStorage();
+      full->setValuePrecision(ValueArray::FULL_PRECISION);
+      csr = full.get();
+    }
+
     wildriver_matrix_handle * handle = \
         wildriver_open_matrix(path,WILDRIVER_OUT);
 
@@ -152,5 +290,165 @@ Matrix * DataStorage::getMatrix()
 
 
 
+/******************************************************************************
+* PRIVATE FUNCTIONS ***********************************************************
+******************************************************************************/
+
+
+void DataStorage::streamDataset(
+    char const * const path,
+    load_options_struct const & options,
+    double * const progress,
+    ValueArray::precision_type const precision)
+{
+  Timer tmr;
+
+  tmr.start();
+
+  TripletReader reader(path);
+
+  // random samples and whole matrices only need the dimensions, which edge
+  // lists don't declare
+  bool const needDegrees = (options.type != LOAD_RANDOM && \
+      options.type != LOAD_ALL) || !reader.hasDimensions();
+  double const degreeScale = needDegrees ? 1.0/3.0 : 0.0;
+
+  std::vector<dim_type> rowDegrees;
+  std::vector<dim_type> colDegrees;
+  if (needDegrees) {
+    reader.forEachEntry(true, false, progress, degreeScale, \
+        [&](dim_type const row, dim_type const col, value_type) {
+          if (row >= rowDegrees.size()) {
+            rowDegrees.resize(row+1, 0);
+          }
+          if (col >= colDegrees.size()) {
+            colDegrees.resize(col+1, 0);
+          }
+          ++rowDegrees[row];
+          ++colDegrees[col];
+        });
+  }
+
+  dim_type const numRows = reader.getNumRows();
+  dim_type const numCols = reader.getNumColumns();
+  rowDegrees.resize(numRows, 0);
+  colDegrees.resize(numCols, 0);
+
+  // choose the rows and columns to keep, in ascending order
+  std::vector<dim_type> rows;
+  std::vector<dim_type> cols;
+  switch (options.type) {
+    case LOAD_ALL:
+      rows = selectAll(numRows);
+      cols = selectAll(numCols);
+      break;
+    case LOAD_RANDOM: {
+      Random rng(options.seed);
+      rows.resize(std::min(options.numSampleRows, numRows));
+      if (options.symmetric) {
+        if (numRows != numCols) {
+          throw std::runtime_error("Cannot do symmetric sampling on " \
+              "non-square matrix");
+        }
+        rng.sortedSample(rows.data(), numRows, rows.size());
+        cols = rows;
+      } else {
+        cols.resize(std::min(options.numSampleCols, numCols));
+        rng.sortedSample(rows.data(), numRows, rows.size());
+        rng.sortedSample(cols.data(), numCols, cols.size());
+      }
+      break;
+    }
+    case LOAD_THRESHOLD_ROWS:
+      rows = selectThreshold(rowDegrees, options.minSize, options.maxSize);
+      cols = selectAll(numCols);
+      break;
+    default:
+      rows = selectAll(numRows);
+      cols = selectThreshold(colDegrees, options.minSize, options.maxSize);
+  }
+
+  std::vector<dim_type> const rowMap = numberKept(rows, numRows);
+  std::vector<dim_type> const colMap = numberKept(cols, numCols);
+
+  dim_type const numNewRows = static_cast<dim_type>(rows.size());
+  dim_type const numNewCols = static_cast<dim_type>(cols.size());
+
+  // a symmetric file keeps only one triangle when the same rows and columns
+  // are kept, as it would when loaded whole
+  bool const half = reader.getSymmetry() == TripletReader::SYMMETRIC && \
+      rows == cols;
+
+  // the number of kept entries in each kept row is only known from the
+  // degrees when every column is kept
+  bool const needCounts = !needDegrees || half || numNewCols != numCols;
+  double const passScale = (1.0 - degreeScale) / (needCounts ? 2.0 : 1.0);
+
+  std::vector<index_type> offsets(numNewRows+1, 0);
+  if (needCounts) {
+    reader.forEachEntry(!half, false, progress, passScale, \
+        [&](dim_type row, dim_type col, value_type) {
+          if (half && col > row) {
+            std::swap(row, col);
+          }
+          dim_type const newRow = rowMap[row];
+          if (newRow != NULL_DIM && colMap[col] != NULL_DIM) {
+            ++offsets[newRow+1];
+          }
+        });
+  } else {
+    for (dim_type row = 0; row < numNewRows; ++row) {
+      offsets[row+1] = rowDegrees[rows[row]];
+    }
+  }
+  PrefixSum::inclusive(offsets.data(), offsets.size());
+
+  // release everything but the maps before allocating the matrix
+  std::vector<dim_type>().swap(rowDegrees);
+  std::vector<dim_type>().swap(colDegrees);
+  std::vector<dim_type>().swap(rows);
+  std::vector<dim_type>().swap(cols);
+
+  m_matrix.reset(new CSRMatrix(numNewRows, numNewCols, offsets.back(), \
+      precision));
+  CSRMatrix * const mat = dynamic_cast<CSRMatrix*>(m_matrix.get());
+
+  std::copy(offsets.begin(), offsets.end(), mat->getOffsets());
+  offsets.pop_back();
+
+  // values are encoded as they are read, so they are never all held at full
+  // precision
+  dim_type * const columns = mat->getColumns();
+  ValueArray & values = mat->getValueArray();
+  reader.forEachEntry(!half, true, progress, passScale, \
+      [&](dim_type row, dim_type col, value_type const value) {
+        if (half && col > row) {
+          std::swap(row, col);
+        }
+        dim_type const newRow = rowMap[row];
+        dim_type const newCol = colMap[col];
+        if (newRow != NULL_DIM && newCol != NULL_DIM) {
+          index_type const idx = offsets[newRow]++;
+          columns[idx] = newCol;
+          values.set(idx, value);
+        }
+      });
+
+  // files are usually sorted already, in which case this only checks
+  mat->sortRows();
+
+  if (half) {
+    // every entry is already on or below the diagonal
+    mat->convertToHalfStorage();
+  }
+
+  tmr.stop();
+
+  std::cout << "Loading took: " << tmr.poll() << "s" << std::endl;
+}
+
+
+
+
 
 }
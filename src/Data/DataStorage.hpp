@@ -15,9 +15,11 @@
 
 
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include "Matrix.hpp"
+#include "ValueArray.hpp"
 
 
 
@@ -29,6 +31,37 @@ namespace MatrixInspector
 class DataStorage
 {
   public:
+    enum load_sample_type {
+      // load every entry
+      LOAD_ALL,
+      // load a random set of rows and columns
+      LOAD_RANDOM,
+      // load the rows with a number of non-zeros within a range
+      LOAD_THRESHOLD_ROWS,
+      // load the columns with a number of non-zeros within a range
+      LOAD_THRESHOLD_COLUMNS
+    };
+
+
+    /**
+    * @brief The reduction to apply to a matrix while it is being read.
+    * Degrees are those of the full matrix, including the entries implied by
+    * symmetric files.
+    */
+    struct load_options_struct {
+      load_sample_type type;
+      // random: the number of rows and columns (limited to the size of the
+      // matrix), and whether to keep the same set of both
+      dim_type numSampleRows;
+      dim_type numSampleCols;
+      bool symmetric;
+      uint64_t seed;
+      // threshold: the range of non-zeros to keep
+      dim_type minSize;
+      dim_type maxSize;
+    };
+
+
     /**
     * @brief Load a vector from disk.
     *
@@ -53,14 +86,41 @@ class DataStorage
 
 
     /**
-    * @brief Load a new dataset into memory.
+    * @brief Load a new dataset into memory. Files which can be streamed
+    * (see TripletReader) are read in two passes, keeping only the lower
+    * triangle of symmetric files and encoding the values as they are read,
+    * so that neither the full matrix nor its values at full precision are
+    * ever held. Other files are read whole at full precision by wildriver,
+    * and only then reduced to the precision.
     *
     * @param path The path of the dataset.
     * @param progress The progess variable.
+    * @param precision The precision to store the values of the matrix at.
     */
     void loadDataset(
         char const * path,
-        double * progress);
+        double * progress,
+        ValueArray::precision_type precision = ValueArray::FULL_PRECISION);
+
+
+    /**
+    * @brief Load a reduced dataset into memory. Files which can be streamed
+    * (see TripletReader) are read in passes: the first counts degrees and
+    * chooses the rows and columns to keep, and the last keeps only their
+    * entries, renumbered as they are read. Only the reduced matrix is
+    * allocated. Other files are loaded whole and then reduced, and random
+    * samples of them do not follow the seed.
+    *
+    * @param path The path of the dataset.
+    * @param options The reduction to apply.
+    * @param progress The progess variable.
+    * @param precision The precision to store the values of the matrix at.
+    */
+    void loadDataset(
+        char const * path,
+        load_options_struct const & options,
+        double * progress,
+        ValueArray::precision_type precision = ValueArray::FULL_PRECISION);
 
 
     /**
@@ -94,6 +154,24 @@ class DataStorage
     std::unique_ptr<Matrix> m_matrix;
 
 
+    /**
+    * @brief Load a dataset which TripletReader supports in passes over its
+    * entries, keeping only those chosen by the options. Symmetric files are
+    * kept in half storage when the same rows and columns are kept, without
+    * expanding them first.
+    *
+    * @param path The path of the dataset.
+    * @param options The reduction to apply.
+    * @param progress The progess variable.
+    * @param precision The precision to store the values of the matrix at.
+    */
+    void streamDataset(
+        char const * path,
+        load_options_struct const & options,
+        double * progress,
+        ValueArray::precision_type precision);
+
+
 };
 
 
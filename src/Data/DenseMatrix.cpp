@@ -27,6 +27,9 @@ namespace
 
 double const INCREMENT = 0.01;
 
+// the number of rows checked between checks for cancellation
+dim_type const CANCEL_INTERVAL = 1024;
+
 }
 
 
@@ -65,7 +68,7 @@ void DenseMatrix::transpose(
   dim_type const numRows = getNumRows();
   dim_type const numCols = getNumColumns();
 
-  if (isSymmetric() || (numRows == 1 || numCols == 1)) {
+  if ((isSymmetrySet() && isSymmetric()) || (numRows == 1 || numCols == 1)) {
     // do nothing for these cases
   } else if (isSquare()) {
     dim_type const interval = numRows > 100 ? numRows / 100 : 1;
@@ -113,6 +116,8 @@ void DenseMatrix::transpose(
   // update dimensions
   setNumRows(numCols);
   setNumColumns(numRows);
+  transformStats(STATS_SWAP, STATS_SWAP, STATS_PRESERVE, STATS_PRESERVE, \
+      STATS_PRESERVE);
 }
 
 
@@ -145,6 +150,12 @@ void DenseMatrix::reorder(
       *progress += increment;
     }
   }
+
+  // only a symmetric permutation is guaranteed to preserve symmetry
+  transformStats(STATS_PRESERVE, STATS_PRESERVE, STATS_INVALIDATE, \
+      STATS_PRESERVE, !isSquare() || \
+      isSymmetricPermutation(rowPerm, colPerm, numRows) ? \
+      STATS_PRESERVE : STATS_INVALIDATE);
 }
 
 
@@ -190,12 +201,15 @@ void DenseMatrix::reduce(
   // update dimensions
   setNumRows(numRows);
   setNumColumns(numCols);
+  transformStats(STATS_INVALIDATE, STATS_INVALIDATE, STATS_INVALIDATE, \
+      STATS_INVALIDATE, STATS_INVALIDATE);
 }
 
 
 void DenseMatrix::computeSymmetry(
     double * const progress,
-    double const scale)
+    double const scale,
+    std::atomic<bool> const * const cancel)
 {
   dim_type const numRows = getNumRows();
   dim_type const numCols = getNumColumns();
@@ -207,6 +221,11 @@ void DenseMatrix::computeSymmetry(
     setSymmetry(false);
   } else {
     for (dim_type row = 0; row < numRows; ++row) {
+      if (row % CANCEL_INTERVAL == 0 && cancel != nullptr && \
+          cancel->load(std::memory_order_relaxed)) {
+        return;
+      }
+
       for (dim_type col = 0; col < row; ++ col) {
         if (m_values[(row*numCols)+col] != m_values[(col*numRows)+row]) {
           // missing non-zero
@@ -61,7 +61,8 @@ class DenseMatrix :
 
     void computeSymmetry(
         double * progress,
-        double scale) override;
+        double scale,
+        std::atomic<bool> const * cancel) override;
 
 
   private:
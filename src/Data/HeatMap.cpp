@@ -9,7 +9,16 @@
 
 
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 #include "HeatMap.hpp"
+#include "CSRMatrix.hpp"
+#include "Utility/Parallel.hpp"
+#include "Utility/Debug.hpp"
 
 
 
@@ -18,6 +27,947 @@ namespace MatrixInspector
 {
 
 
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+// the number of rows counted between checks for cancellation
+dim_type const CANCEL_INTERVAL = 4096;
+
+}
+
+
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+
+/**
+* @brief Get the pixel a row or column falls in.
+*
+* @param index The row or column.
+* @param scale The number of pixels per row or column.
+*
+* @return The pixel.
+*/
+inline dim_type toPixel(
+    dim_type const index,
+    float const scale) noexcept
+{
+  return static_cast<dim_type>(index * scale);
+}
+
+
+/**
+* @brief Get the first row or column in a range which falls in a pixel or one
+* after it.
+*
+* @param first The start of the range.
+* @param last The end of the range.
+* @param scale The number of pixels per row or column.
+* @param pixel The pixel.
+*
+* @return The row or column, or the end of the range if none do.
+*/
+dim_type getFirstIndex(
+    dim_type first,
+    dim_type last,
+    float const scale,
+    dim_type const pixel) noexcept
+{
+  // the pixel of each row never decreases
+  while (first < last) {
+    dim_type const mid = first + ((last - first) / 2);
+    if (toPixel(mid, scale) < pixel) {
+      first = mid + 1;
+    } else {
+      last = mid;
+    }
+  }
+
+  return first;
+}
+
+
+/**
+* @brief Get the first row of a band of a range of rows with about the same
+* number of non-zeros as the others, moved back to the first row of its pixel
+* row.
+*
+* @param offsets The row offsets.
+* @param rowStart The first row of the range, which starts a pixel row.
+* @param rowEnd The end of the range.
+* @param scale The number of pixels per row.
+* @param numBands The number of bands.
+* @param band The band.
+*
+* @return The first row.
+*/
+dim_type getBandStart(
+    index_type const * const offsets,
+    dim_type const rowStart,
+    dim_type const rowEnd,
+    float const scale,
+    unsigned const numBands,
+    unsigned const band)
+{
+  dim_type const row = rowStart + Parallel::getRowChunkStart( \
+      offsets+rowStart, rowEnd-rowStart, numBands, band);
+  if (row == rowEnd) {
+    return rowEnd;
+  }
+
+  return getFirstIndex(rowStart, row, scale, toPixel(row, scale));
+}
+
+
+/**
+* @brief Get the first row of a part of a lower triangle split such that each
+* part has about the same area.
+*
+* @param size The number of rows of the triangle.
+* @param numParts The number of parts.
+* @param part The part.
+*
+* @return The first row.
+*/
+dim_type getTriangleStart(
+    dim_type const size,
+    unsigned const numParts,
+    unsigned const part)
+{
+  if (part >= numParts) {
+    return size;
+  }
+
+  return static_cast<dim_type>(size * std::sqrt( \
+      static_cast<double>(part) / numParts));
+}
+
+
+/**
+* @brief How the values of the non-zeros in each pixel are combined.
+*/
+enum bin_type {
+  COUNT_BIN,
+  SUM_BIN,
+  MAX_BIN
+};
+
+
+/**
+* @brief Bins the non-zeros by their number alone.
+*/
+struct count_bin_struct
+{
+  static constexpr bool WEIGHTED = false;
+
+  template<typename T>
+  static T combine(
+      T const a,
+      T const b) noexcept
+  {
+    return a + b;
+  }
+
+  // a pixel on the diagonal holds its lower triangle and the transpose of
+  // it, which counted the diagonal entries twice
+  template<typename T>
+  static T unmirror(
+      T const bin,
+      T const diagonal) noexcept
+  {
+    return (2*bin) - diagonal;
+  }
+};
+
+
+/**
+* @brief Bins the total of the values of the non-zeros.
+*/
+struct sum_bin_struct : public count_bin_struct
+{
+  static constexpr bool WEIGHTED = true;
+};
+
+
+/**
+* @brief Bins the largest of the values of the non-zeros.
+*/
+struct max_bin_struct
+{
+  static constexpr bool WEIGHTED = true;
+
+  template<typename T>
+  static T combine(
+      T const a,
+      T const b) noexcept
+  {
+    return a > b ? a : b;
+  }
+
+  template<typename T>
+  static T unmirror(
+      T const bin,
+      T) noexcept
+  {
+    return bin;
+  }
+};
+
+
+/**
+* @brief Reads the values of runs of non-zeros as their magnitudes, or as they
+* are, with non-finite values as zero so that they are left out. Values
+* stored at reduced precision are decoded first.
+*/
+struct weight_reader_struct
+{
+  ValueArray const * values;
+  bool magnitude;
+  std::vector<value_type> buffer;
+
+  value_type const * read(
+      index_type const start,
+      index_type const num)
+  {
+    if (buffer.size() < num) {
+      buffer.resize(num);
+    }
+    value_type * const out = buffer.data();
+    value_type const * in = out;
+    if (values->getPrecision() == ValueArray::FULL_PRECISION) {
+      in = values->data() + start;
+    } else {
+      values->decode(start, num, out);
+    }
+
+    // a plain loop, which the compiler can vectorize
+    value_type const inf = std::numeric_limits<value_type>::infinity();
+    for (index_type i = 0; i < num; ++i) {
+      value_type const val = in[i];
+      value_type const mag = std::fabs(val);
+      out[i] = mag < inf ? (magnitude ? mag : val) : 0.0f;
+    }
+
+    return out;
+  }
+};
+
+
+/**
+* @brief Where the non-zeros of a matrix are binned: a band of the pixel rows
+* of its heat map.
+*/
+struct bin_target_struct
+{
+  CSRMatrix const * matrix;
+  // the number of pixels per row and column
+  float scale;
+  // the pixel row of the top of the band
+  dim_type firstLine;
+  dim_type width;
+  index_type * counts;
+  // the total or largest value of each pixel, unless counting
+  double * sums;
+};
+
+
+/**
+* @brief Get how a mode combines the values of the non-zeros in each pixel.
+*
+* @param mode The mode.
+*
+* @return How the values are combined.
+*/
+bin_type getBinType(
+    HeatMap::mode_type const mode) noexcept
+{
+  switch (mode) {
+    case HeatMap::COUNT_MODE:
+      return COUNT_BIN;
+    case HeatMap::MAX_MODE:
+      return MAX_BIN;
+    default:
+      return SUM_BIN;
+  }
+}
+
+
+/**
+* @brief Bin the non-zeros of every stride-th row of a range, skipping those
+* binned already at a coarser stride.
+*
+* @tparam BIN How the values are combined.
+* @param target Where the non-zeros are binned.
+* @param magnitude Whether the magnitudes of the values are binned.
+* @param first The first row, a multiple of the stride.
+* @param end The end of the rows.
+* @param stride The stride of the rows.
+* @param counted The stride of the rows binned already, or zero if none.
+* @param cancel The flag which, once set, stops the binning.
+* @param diagonal The number of entries on the diagonal of each pixel row,
+* to add to, or null if not needed.
+* @param diagonalSums The bins of the values on the diagonal of each pixel
+* row, to add to, or null if not needed.
+*/
+template<typename BIN>
+void binRows(
+    bin_target_struct const & target,
+    bool const magnitude,
+    dim_type const first,
+    dim_type const end,
+    dim_type const stride,
+    dim_type const counted,
+    std::atomic<bool> const * const cancel,
+    index_type * const diagonal,
+    double * const diagonalSums)
+{
+  index_type const * const offsets = target.matrix->getOffsets();
+  dim_type const * const columns = target.matrix->getColumns();
+  float const scale = target.scale;
+  weight_reader_struct reader{&target.matrix->getValueArray(), magnitude, {}};
+
+  dim_type num = 0;
+  for (uint64_t row = first; row < end; row += stride, ++num) {
+    if (num % CANCEL_INTERVAL == 0 && cancel != nullptr && \
+        cancel->load(std::memory_order_relaxed)) {
+      break;
+    }
+    if (counted != 0 && row % counted == 0) {
+      continue;
+    }
+    dim_type const y = toPixel(row, scale) - target.firstLine;
+    size_t const line = static_cast<size_t>(y) * target.width;
+    index_type const rowStart = offsets[row];
+    index_type const rowEnd = offsets[row+1];
+    value_type const * const weights = BIN::WEIGHTED ? \
+        reader.read(rowStart, rowEnd - rowStart) : nullptr;
+    for (index_type idx = rowStart; idx < rowEnd; ++idx) {
+      dim_type const column = columns[idx];
+      size_t const pixel = line + toPixel(column, scale);
+      ++target.counts[pixel];
+      if (BIN::WEIGHTED) {
+        target.sums[pixel] = BIN::combine(target.sums[pixel], \
+            static_cast<double>(weights[idx - rowStart]));
+      }
+      if (diagonal != nullptr && column == row) {
+        ++diagonal[y];
+        if (BIN::WEIGHTED) {
+          diagonalSums[y] = BIN::combine(diagonalSums[y], \
+              static_cast<double>(weights[idx - rowStart]));
+        }
+      }
+    }
+  }
+}
+
+
+/**
+* @brief Bin the non-zeros of a range of rows transposed, for those which
+* fall in a range of columns, skipping the diagonal. The entries of each row
+* in the columns are found by binary search over its sorted columns.
+*
+* @tparam BIN How the values are combined.
+* @param target Where the non-zeros are binned, whose band the columns are.
+* @param magnitude Whether the magnitudes of the values are binned.
+* @param rowStart The first row.
+* @param rowEnd The end of the rows.
+* @param colStart The first column.
+* @param colEnd The end of the columns.
+*/
+template<typename BIN>
+void binTransposed(
+    bin_target_struct const & target,
+    bool const magnitude,
+    dim_type const rowStart,
+    dim_type const rowEnd,
+    dim_type const colStart,
+    dim_type const colEnd)
+{
+  index_type const * const offsets = target.matrix->getOffsets();
+  dim_type const * const columns = target.matrix->getColumns();
+  float const scale = target.scale;
+  weight_reader_struct reader{&target.matrix->getValueArray(), magnitude, {}};
+
+  for (dim_type row = rowStart; row < rowEnd; ++row) {
+    dim_type const x = toPixel(row, scale);
+    dim_type const * const first = std::lower_bound(columns+offsets[row], \
+        columns+offsets[row+1], colStart);
+    dim_type const * const last = std::lower_bound(first, \
+        columns+offsets[row+1], colEnd);
+    index_type const firstIdx = first - columns;
+    value_type const * const weights = BIN::WEIGHTED && first < last ? \
+        reader.read(firstIdx, last - first) : nullptr;
+    for (dim_type const * col = first; col < last; ++col) {
+      if (*col != row) {
+        dim_type const y = toPixel(*col, scale) - target.firstLine;
+        size_t const pixel = (static_cast<size_t>(y) * target.width) + x;
+        ++target.counts[pixel];
+        if (BIN::WEIGHTED) {
+          target.sums[pixel] = BIN::combine(target.sums[pixel], \
+              static_cast<double>(weights[(col - columns) - firstIdx]));
+        }
+      }
+    }
+  }
+}
+
+
+/**
+* @brief Bin the non-zeros of every stride-th row of a range, as set by how
+* the values are combined.
+*
+* @param bin How the values are combined.
+* @param target Where the non-zeros are binned.
+* @param magnitude Whether the magnitudes of the values are binned.
+* @param first The first row, a multiple of the stride.
+* @param end The end of the rows.
+* @param stride The stride of the rows.
+* @param counted The stride of the rows binned already, or zero if none.
+* @param cancel The flag which, once set, stops the binning.
+* @param diagonal The number of entries on the diagonal of each pixel row,
+* to add to, or null if not needed.
+* @param diagonalSums The bins of the values on the diagonal of each pixel
+* row, to add to, or null if not needed.
+*/
+void binRows(
+    bin_type const bin,
+    bin_target_struct const & target,
+    bool const magnitude,
+    dim_type const first,
+    dim_type const end,
+    dim_type const stride,
+    dim_type const counted,
+    std::atomic<bool> const * const cancel,
+    index_type * const diagonal,
+    double * const diagonalSums)
+{
+  switch (bin) {
+    case COUNT_BIN:
+      binRows<count_bin_struct>(target, magnitude, first, end, stride, \
+          counted, cancel, diagonal, diagonalSums);
+      break;
+    case MAX_BIN:
+      binRows<max_bin_struct>(target, magnitude, first, end, stride, \
+          counted, cancel, diagonal, diagonalSums);
+      break;
+    default:
+      binRows<sum_bin_struct>(target, magnitude, first, end, stride, \
+          counted, cancel, diagonal, diagonalSums);
+  }
+}
+
+
+/**
+* @brief Bin the non-zeros of a range of rows transposed, as set by how the
+* values are combined.
+*
+* @param bin How the values are combined.
+* @param target Where the non-zeros are binned, whose band the columns are.
+* @param magnitude Whether the magnitudes of the values are binned.
+* @param rowStart The first row.
+* @param rowEnd The end of the rows.
+* @param colStart The first column.
+* @param colEnd The end of the columns.
+*/
+void binTransposed(
+    bin_type const bin,
+    bin_target_struct const & target,
+    bool const magnitude,
+    dim_type const rowStart,
+    dim_type const rowEnd,
+    dim_type const colStart,
+    dim_type const colEnd)
+{
+  switch (bin) {
+    case COUNT_BIN:
+      binTransposed<count_bin_struct>(target, magnitude, rowStart, rowEnd, \
+          colStart, colEnd);
+      break;
+    case MAX_BIN:
+      binTransposed<max_bin_struct>(target, magnitude, rowStart, rowEnd, \
+          colStart, colEnd);
+      break;
+    default:
+      binTransposed<sum_bin_struct>(target, magnitude, rowStart, rowEnd, \
+          colStart, colEnd);
+  }
+}
+
+
+/**
+* @brief Fold the bins of a square heat map of a lower triangle onto their
+* mirror images, such that each pair of transposed pixels holds both, and
+* take out the entries on the diagonal which were counted twice.
+*
+* @tparam BIN How the bins are combined.
+* @tparam T The type of the bins.
+* @param bins The bins (input and output).
+* @param size The width and height of the heat map.
+* @param diagonal The bins of the entries on the diagonal of each pixel row.
+*/
+template<typename BIN, typename T>
+void foldTriangle(
+    T * const bins,
+    dim_type const size,
+    T const * const diagonal)
+{
+  unsigned const numThreads = Parallel::getNumThreads( \
+      static_cast<size_t>(size) * size);
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    // each pair of transposed pixels belongs to the row of the lower one
+    dim_type const start = getTriangleStart(size, numThreads, tid);
+    dim_type const end = getTriangleStart(size, numThreads, tid+1);
+    for (dim_type y = start; y < end; ++y) {
+      T * const line = bins + (static_cast<size_t>(y) * size);
+      for (dim_type x = 0; x < y; ++x) {
+        T & upper = bins[(static_cast<size_t>(x) * size) + y];
+        T const both = BIN::combine(line[x], upper);
+        line[x] = both;
+        upper = both;
+      }
+      line[y] = BIN::unmirror(line[y], diagonal[y]);
+    }
+  });
+}
+
+
+/**
+* @brief Fold the bins of a sample of the lower triangle of a matrix onto
+* their mirror images.
+*
+* @param bin How the values were combined.
+* @param size The width and height of the heat map.
+* @param sample The sample, whose entries on the diagonal are taken out.
+* @param counts The counts of the sample (input and output).
+* @param sums The bins of the values of the sample, unless counting (input
+* and output).
+*/
+void foldBins(
+    bin_type const bin,
+    dim_type const size,
+    HeatMap::sample_struct const & sample,
+    index_type * const counts,
+    double * const sums)
+{
+  foldTriangle<count_bin_struct>(counts, size, sample.diagonal.data());
+  if (bin == MAX_BIN) {
+    foldTriangle<max_bin_struct>(sums, size, sample.diagonalSums.data());
+  } else if (bin == SUM_BIN) {
+    foldTriangle<sum_bin_struct>(sums, size, sample.diagonalSums.data());
+  }
+}
+
+
+/**
+* @brief Bin the entries of a block of a matrix in pixels of 2^shift rows
+* and columns. The rows are split between threads in runs of whole pixels,
+* so that no two threads bin in the same pixel, even when transposed.
+*
+* @tparam BIN How the values are combined.
+* @param matrix The matrix.
+* @param magnitude Whether the magnitudes of the values are binned.
+* @param rowStart The first row of the block.
+* @param rowEnd The end of the rows of the block.
+* @param colStart The first column of the block.
+* @param colEnd The end of the columns of the block.
+* @param shift The base two logarithm of the rows and columns per pixel.
+* @param transpose Whether each entry (i,j) is binned at (j,i), skipping the
+* diagonal.
+* @param width The width of the bins.
+* @param counts The counts to add to.
+* @param sums The bins of the values to add to, unless counting.
+*/
+template<typename BIN>
+void binBlock(
+    CSRMatrix const & matrix,
+    bool const magnitude,
+    dim_type const rowStart,
+    dim_type const rowEnd,
+    dim_type const colStart,
+    dim_type const colEnd,
+    unsigned const shift,
+    bool const transpose,
+    dim_type const width,
+    index_type * const counts,
+    double * const sums)
+{
+  if (rowStart >= rowEnd || colStart >= colEnd) {
+    return;
+  }
+
+  index_type const * const offsets = matrix.getOffsets();
+  dim_type const * const columns = matrix.getColumns();
+  dim_type const numRows = rowEnd - rowStart;
+  index_type const * const blockOffsets = offsets + rowStart;
+  unsigned const numThreads = Parallel::getNumThreads( \
+      blockOffsets[numRows] - blockOffsets[0]);
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    weight_reader_struct reader{&matrix.getValueArray(), magnitude, {}};
+
+    // round the parts down to whole pixels
+    dim_type const start = (Parallel::getRowChunkStart(blockOffsets, \
+        numRows, numThreads, tid) >> shift) << shift;
+    dim_type const end = tid + 1 == numThreads ? numRows : \
+        (Parallel::getRowChunkStart(blockOffsets, numRows, numThreads, \
+        tid+1) >> shift) << shift;
+    for (dim_type local = start; local < end; ++local) {
+      dim_type const row = rowStart + local;
+      dim_type const line = local >> shift;
+      dim_type const * const first = std::lower_bound(columns+offsets[row], \
+          columns+offsets[row+1], colStart);
+      dim_type const * const last = std::lower_bound(first, \
+          columns+offsets[row+1], colEnd);
+      index_type const firstIdx = first - columns;
+      value_type const * const weights = BIN::WEIGHTED && first < last ? \
+          reader.read(firstIdx, last - first) : nullptr;
+      for (dim_type const * col = first; col < last; ++col) {
+        dim_type const pixel = (*col - colStart) >> shift;
+        size_t idx;
+        if (!transpose) {
+          idx = (static_cast<size_t>(line) * width) + pixel;
+        } else if (*col != row) {
+          idx = (static_cast<size_t>(pixel) * width) + line;
+        } else {
+          continue;
+        }
+        ++counts[idx];
+        if (BIN::WEIGHTED) {
+          sums[idx] = BIN::combine(sums[idx], \
+              static_cast<double>(weights[(col - columns) - firstIdx]));
+        }
+      }
+    }
+  });
+}
+
+
+/**
+* @brief Bin the entries of a block of a matrix, as set by how the values are
+* combined.
+*
+* @param bin How the values are combined.
+* @param matrix The matrix.
+* @param magnitude Whether the magnitudes of the values are binned.
+* @param rowStart The first row of the block.
+* @param rowEnd The end of the rows of the block.
+* @param colStart The first column of the block.
+* @param colEnd The end of the columns of the block.
+* @param shift The base two logarithm of the rows and columns per pixel.
+* @param transpose Whether each entry (i,j) is binned at (j,i), skipping the
+* diagonal.
+* @param width The width of the bins.
+* @param counts The counts to add to.
+* @param sums The bins of the values to add to, unless counting.
+*/
+void binBlock(
+    bin_type const bin,
+    CSRMatrix const & matrix,
+    bool const magnitude,
+    dim_type const rowStart,
+    dim_type const rowEnd,
+    dim_type const colStart,
+    dim_type const colEnd,
+    unsigned const shift,
+    bool const transpose,
+    dim_type const width,
+    index_type * const counts,
+    double * const sums)
+{
+  switch (bin) {
+    case COUNT_BIN:
+      binBlock<count_bin_struct>(matrix, magnitude, rowStart, rowEnd, \
+          colStart, colEnd, shift, transpose, width, counts, sums);
+      break;
+    case MAX_BIN:
+      binBlock<max_bin_struct>(matrix, magnitude, rowStart, rowEnd, \
+          colStart, colEnd, shift, transpose, width, counts, sums);
+      break;
+    default:
+      binBlock<sum_bin_struct>(matrix, magnitude, rowStart, rowEnd, \
+          colStart, colEnd, shift, transpose, width, counts, sums);
+  }
+}
+
+
+/**
+* @brief Adds pixels, when pooling.
+*/
+struct sum_op_struct
+{
+  template<typename T>
+  static T apply(
+      T const a,
+      T const b) noexcept
+  {
+    return a + b;
+  }
+
+  #if defined(__AVX2__)
+  static __m256 apply(
+      __m256 const a,
+      __m256 const b) noexcept
+  {
+    return _mm256_add_ps(a, b);
+  }
+  #endif
+};
+
+
+/**
+* @brief Takes the larger of pixels, when pooling.
+*/
+struct max_op_struct
+{
+  template<typename T>
+  static T apply(
+      T const a,
+      T const b) noexcept
+  {
+    return a > b ? a : b;
+  }
+
+  #if defined(__AVX2__)
+  static __m256 apply(
+      __m256 const a,
+      __m256 const b) noexcept
+  {
+    return _mm256_max_ps(a, b);
+  }
+  #endif
+};
+
+
+/**
+* @brief Takes the pixel of the larger magnitude, when pooling signed pixels.
+*/
+struct magnitude_op_struct
+{
+  static value_type apply(
+      value_type const a,
+      value_type const b) noexcept
+  {
+    return std::fabs(b) > std::fabs(a) ? b : a;
+  }
+
+  #if defined(__AVX2__)
+  static __m256 apply(
+      __m256 const a,
+      __m256 const b) noexcept
+  {
+    // clear the sign bits to compare magnitudes
+    __m256 const sign = _mm256_set1_ps(-0.0f);
+    __m256 const larger = _mm256_cmp_ps(_mm256_andnot_ps(sign, b), \
+        _mm256_andnot_ps(sign, a), _CMP_GT_OQ);
+    return _mm256_blendv_ps(a, b, larger);
+  }
+  #endif
+};
+
+
+/**
+* @brief Pool the leading pairs of a row of values eight at a time.
+*
+* @tparam OP The pooling operation.
+* @param row The row.
+* @param outWidth The number of pairs.
+* @param out The pooled pixels (output).
+*
+* @return The number of pairs pooled.
+*/
+template<typename OP>
+dim_type poolVectorPairs(
+    value_type const * const row,
+    dim_type const outWidth,
+    value_type * const out) noexcept
+{
+  dim_type x = 0;
+  #if defined(__AVX2__)
+  // split eight pairs into their first and second pixels, which the
+  // shuffle leaves interleaved by lane, and the permute puts back in order
+  for (; x + 8 <= outWidth; x += 8) {
+    __m256 const low = _mm256_loadu_ps(row + (2*x));
+    __m256 const high = _mm256_loadu_ps(row + (2*x) + 8);
+    __m256 const firsts = _mm256_shuffle_ps(low, high, _MM_SHUFFLE(2,0,2,0));
+    __m256 const seconds = _mm256_shuffle_ps(low, high, \
+        _MM_SHUFFLE(3,1,3,1));
+    __m256 const pooled = OP::apply(firsts, seconds);
+    _mm256_storeu_ps(out + x, _mm256_castpd_ps(_mm256_permute4x64_pd( \
+        _mm256_castps_pd(pooled), _MM_SHUFFLE(3,1,2,0))));
+  }
+  #else
+  (void)row;
+  (void)outWidth;
+  (void)out;
+  #endif
+  return x;
+}
+
+
+/**
+* @brief Counts have no vector path, so none of their pairs are pooled here.
+*
+* @tparam OP The pooling operation.
+*
+* @return Zero.
+*/
+template<typename OP>
+dim_type poolVectorPairs(
+    index_type const *,
+    dim_type,
+    index_type *) noexcept
+{
+  return 0;
+}
+
+
+/**
+* @brief Pool the adjacent pairs of a row of pixels. If the row has an odd
+* number of pixels, the last is pooled into the last pair.
+*
+* @tparam OP The pooling operation.
+* @tparam T The type of pixel.
+* @param row The row.
+* @param width The number of pixels in the row.
+* @param out The pooled pixels (output).
+*/
+template<typename OP, typename T>
+void poolPairs(
+    T const * const row,
+    dim_type const width,
+    T * const out) noexcept
+{
+  dim_type const outWidth = width > 1 ? width / 2 : 1;
+  if (width == 1) {
+    out[0] = row[0];
+    return;
+  }
+
+  dim_type x = poolVectorPairs<OP>(row, outWidth, out);
+  for (; x < outWidth; ++x) {
+    out[x] = OP::apply(row[2*x], row[(2*x)+1]);
+  }
+
+  if (width % 2 == 1) {
+    out[outWidth-1] = OP::apply(out[outWidth-1], row[width-1]);
+  }
+}
+
+
+/**
+* @brief Pool blocks of pixels into a heat map of half the width and height.
+* Rows of the block are pooled first, in a loop the compiler can vectorize,
+* and then their pairs of pixels.
+*
+* @tparam OP The pooling operation.
+* @tparam T The type of pixel.
+* @param pixels The pixels.
+* @param width The width of the pixels.
+* @param height The height of the pixels.
+* @param out The pooled pixels (output).
+*/
+template<typename OP, typename T>
+void poolBlocks(
+    T const * const pixels,
+    dim_type const width,
+    dim_type const height,
+    T * const out)
+{
+  dim_type const outWidth = width > 1 ? width / 2 : 1;
+  dim_type const outHeight = height > 1 ? height / 2 : 1;
+
+  unsigned const numThreads = Parallel::getNumThreads( \
+      static_cast<size_t>(outWidth) * outHeight);
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    dim_type const start = static_cast<dim_type>(Parallel::getChunkStart( \
+        outHeight, numThreads, tid));
+    dim_type const end = static_cast<dim_type>(Parallel::getChunkStart( \
+        outHeight, numThreads, tid+1));
+
+    std::vector<T> rows(width);
+    for (dim_type y = start; y < end; ++y) {
+      // the last row of pixels also takes in an odd row left over
+      dim_type const first = height > 1 ? 2*y : 0;
+      dim_type const last = y + 1 == outHeight ? height : first + 2;
+
+      T const * const top = pixels + (static_cast<size_t>(first) * width);
+      std::copy(top, top + width, rows.begin());
+      for (dim_type r = first + 1; r < last; ++r) {
+        T const * const row = pixels + (static_cast<size_t>(r) * width);
+        for (dim_type x = 0; x < width; ++x) {
+          rows[x] = OP::apply(rows[x], row[x]);
+        }
+      }
+
+      poolPairs<OP>(rows.data(), width, \
+          out + (static_cast<size_t>(y) * outWidth));
+    }
+  });
+}
+
+
+/**
+* @brief Set pooled pixels to their values added to the default, and find
+* their range.
+*
+* @tparam F The type of function supplying the value of a pixel.
+* @param num The number of pixels.
+* @param def The default value.
+* @param getValue The function supplying the value above the default of a
+* pixel, which may read the pixel being set.
+* @param values The pixels (output).
+* @param min The smallest pixel (output).
+* @param max The largest pixel (output).
+*/
+template<typename F>
+void setPooled(
+    size_t const num,
+    value_type const def,
+    F getValue,
+    value_type * const values,
+    value_type * const min,
+    value_type * const max)
+{
+  unsigned const numThreads = Parallel::getNumThreads(num);
+  std::vector<value_type> mins(numThreads, def);
+  std::vector<value_type> maxes(numThreads, def);
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    size_t const start = Parallel::getChunkStart(num, numThreads, tid);
+    size_t const end = Parallel::getChunkStart(num, numThreads, tid+1);
+
+    value_type localMin = def;
+    value_type localMax = def;
+    for (size_t i = start; i < end; ++i) {
+      value_type const value = def + getValue(i);
+      values[i] = value;
+      localMin = value < localMin ? value : localMin;
+      localMax = value > localMax ? value : localMax;
+    }
+    mins[tid] = localMin;
+    maxes[tid] = localMax;
+  });
+
+  *min = *std::min_element(mins.begin(), mins.end());
+  *max = *std::max_element(maxes.begin(), maxes.end());
+}
+
+
+}
+
+
+
+
 /******************************************************************************
 * CONSTRUCTORS / DESTRUCTOR ***************************************************
 ******************************************************************************/
@@ -29,10 +979,12 @@ HeatMap::HeatMap(
     value_type const def) :
   m_width(width),
   m_height(height),
+  m_mode(COUNT_MODE),
   m_default(def),
   m_min(def),
   m_max(def),
-  m_values(width*height,def)
+  m_values(width*height,def),
+  m_counts()
 {
   // do nothing
 }
@@ -69,6 +1021,31 @@ std::vector<value_type> const * HeatMap::getValues() const noexcept
 }
 
 
+HeatMap::mode_type HeatMap::getMode() const noexcept
+{
+  return m_mode;
+}
+
+
+void HeatMap::setMode(
+    mode_type const mode) noexcept
+{
+  m_mode = mode;
+}
+
+
+value_type HeatMap::getMin() const noexcept
+{
+  return m_min;
+}
+
+
+value_type HeatMap::getMax() const noexcept
+{
+  return m_max;
+}
+
+
 void HeatMap::resize(
     dim_type const width,
     dim_type const height)
@@ -77,6 +1054,7 @@ void HeatMap::resize(
   m_height = height;
 
   m_values.assign(width*height,m_default);
+  m_counts.clear();
 
   m_min = m_default;
   m_max = m_default;
@@ -88,6 +1066,9 @@ void HeatMap::normalize()
   size_t const numValues = m_values.size();
   const value_type range = m_max-m_min;
 
+  // the values are no longer counts
+  m_counts.clear();
+
   if (range > 0) {
     for (size_t i = 0; i < numValues; ++i) {
       m_values[i] = (m_values[i] - m_min) / range;
@@ -100,6 +1081,370 @@ void HeatMap::normalize()
 }
 
 
+void HeatMap::countNonZeros(
+    CSRMatrix const & matrix,
+    float const scale,
+    std::atomic<bool> const * const cancel)
+{
+  sample_struct sample{};
+  countNonZeros(matrix, scale, 1, &sample, cancel);
+}
+
+
+void HeatMap::countNonZeros(
+    CSRMatrix const & matrix,
+    float const scale,
+    dim_type const stride,
+    sample_struct * const sample,
+    std::atomic<bool> const * const cancel)
+{
+  if (!binSample(matrix, scale, stride, m_mode, sample, cancel)) {
+    return;
+  }
+
+  if (!matrix.isHalfStorage()) {
+    setBins(sample->counts, sample->sums, stride);
+    return;
+  }
+
+  // only the lower triangle is stored, which is counted again transposed,
+  // in a copy so that the sample can still be added to, unless it has all of
+  // the rows
+  ASSERT_EQUAL(m_width, m_height);
+  std::vector<index_type> copy;
+  std::vector<double> sumsCopy;
+  std::vector<index_type> & folded = stride == 1 ? sample->counts : \
+      (copy = sample->counts);
+  std::vector<double> & foldedSums = stride == 1 ? sample->sums : \
+      (sumsCopy = sample->sums);
+  if (stride == 1) {
+    sample->stride = 0;
+  }
+  foldBins(getBinType(m_mode), m_height, *sample, folded.data(), \
+      foldedSums.data());
+
+  setBins(folded, foldedSums, stride);
+}
+
+
+void HeatMap::countNonZeros(
+    CSRMatrix const & matrix,
+    dim_type const firstRow,
+    dim_type const firstCol,
+    unsigned const shift)
+{
+  // the region may extend past the end of the matrix
+  dim_type const rowEnd = static_cast<dim_type>(std::min<uint64_t>( \
+      matrix.getNumRows(), firstRow + (static_cast<uint64_t>(m_height) << \
+      shift)));
+  dim_type const colEnd = static_cast<dim_type>(std::min<uint64_t>( \
+      matrix.getNumColumns(), firstCol + (static_cast<uint64_t>(m_width) << \
+      shift)));
+
+  bin_type const bin = getBinType(m_mode);
+  bool const magnitude = m_mode != SIGNED_SUM_MODE;
+  std::vector<index_type> counts(m_values.size(), 0);
+  std::vector<double> sums(bin != COUNT_BIN ? m_values.size() : 0, 0.0);
+  binBlock(bin, matrix, magnitude, firstRow, rowEnd, firstCol, colEnd, \
+      shift, false, m_width, counts.data(), sums.data());
+
+  // only the lower triangle is stored, so the entries in the rows of the
+  // region's columns are counted again transposed
+  if (matrix.isHalfStorage()) {
+    binBlock(bin, matrix, magnitude, firstCol, colEnd, firstRow, rowEnd, \
+        shift, true, m_width, counts.data(), sums.data());
+  }
+
+  setBins(counts, sums);
+}
+
+
+void HeatMap::countBand(
+    CSRMatrix const & matrix,
+    float const scale,
+    dim_type const firstLine)
+{
+  dim_type const numRows = matrix.getNumRows();
+  index_type const * const offsets = matrix.getOffsets();
+  bin_type const bin = getBinType(m_mode);
+  bool const magnitude = m_mode != SIGNED_SUM_MODE;
+
+  // the rows of the band, which are also its columns when mirrored
+  dim_type const bandStart = getFirstIndex(0, numRows, scale, firstLine);
+  dim_type const bandEnd = getFirstIndex(bandStart, numRows, scale, \
+      firstLine + m_height);
+
+  std::vector<index_type> counts(m_values.size(), 0);
+  std::vector<double> sums(bin != COUNT_BIN ? m_values.size() : 0, 0.0);
+  bin_target_struct const target{&matrix, scale, firstLine, m_width, \
+      counts.data(), sums.data()};
+
+  unsigned const numThreads = Parallel::getNumThreads( \
+      offsets[bandEnd] - offsets[bandStart]);
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    dim_type const start = getBandStart(offsets, bandStart, bandEnd, scale, \
+        numThreads, tid);
+    dim_type const end = getBandStart(offsets, bandStart, bandEnd, scale, \
+        numThreads, tid+1);
+    binRows(bin, target, magnitude, start, end, 1, 0, nullptr, nullptr, \
+        nullptr);
+  });
+
+  // only the lower triangle is stored, so the entries of the later rows in
+  // the columns of the band are counted again transposed, split between
+  // threads in runs of whole pixel columns
+  if (matrix.isHalfStorage()) {
+    unsigned const numMirrorThreads = Parallel::getNumThreads( \
+        offsets[numRows] - offsets[bandStart]);
+    Parallel::run(numMirrorThreads, [&](unsigned const tid) {
+      dim_type const start = getBandStart(offsets, bandStart, numRows, \
+          scale, numMirrorThreads, tid);
+      dim_type const end = getBandStart(offsets, bandStart, numRows, \
+          scale, numMirrorThreads, tid+1);
+      binTransposed(bin, target, magnitude, start, end, bandStart, bandEnd);
+    });
+  }
+
+  setBins(counts, sums);
+}
+
+
+bool HeatMap::binNonZeros(
+    CSRMatrix const & matrix,
+    float const scale,
+    std::vector<index_type> * const counts,
+    std::vector<double> * const sums,
+    std::atomic<bool> const * const cancel) const
+{
+  sample_struct sample{};
+  if (!binSample(matrix, scale, 1, SIGNED_SUM_MODE, &sample, cancel)) {
+    return false;
+  }
+
+  if (matrix.isHalfStorage()) {
+    ASSERT_EQUAL(m_width, m_height);
+    foldBins(SUM_BIN, m_height, sample, sample.counts.data(), \
+        sample.sums.data());
+  }
+
+  counts->swap(sample.counts);
+  sums->swap(sample.sums);
+
+  return true;
+}
+
+
+HeatMap HeatMap::pool(
+    pool_type const type) const
+{
+  HeatMap coarse(m_width > 1 ? m_width / 2 : 1, \
+      m_height > 1 ? m_height / 2 : 1, m_default);
+  coarse.m_mode = m_mode;
+
+  size_t const numPooled = coarse.m_values.size();
+  value_type * const pooled = coarse.m_values.data();
+
+  if (m_mode == COUNT_MODE && !m_counts.empty()) {
+    // pool the counts themselves, which a float would round past 2^24, and
+    // only make values of them afterwards
+    coarse.m_counts.resize(numPooled);
+    if (type == MAX_POOL) {
+      poolBlocks<max_op_struct>(m_counts.data(), m_width, m_height, \
+          coarse.m_counts.data());
+    } else {
+      poolBlocks<sum_op_struct>(m_counts.data(), m_width, m_height, \
+          coarse.m_counts.data());
+    }
+    index_type const * const counts = coarse.m_counts.data();
+    setPooled(numPooled, m_default, [counts](size_t const i) {
+      return static_cast<value_type>(counts[i]);
+    }, pooled, &coarse.m_min, &coarse.m_max);
+    return coarse;
+  }
+
+  // pool the values above the default, so that it is not counted many times
+  std::vector<value_type> above(m_values.size());
+  Parallel::forRange(m_values.size(), [&](unsigned, size_t const start, \
+      size_t const end) {
+    for (size_t i = start; i < end; ++i) {
+      above[i] = m_values[i] - m_default;
+    }
+  });
+
+  if (type == MAX_POOL && m_mode == SIGNED_SUM_MODE) {
+    poolBlocks<magnitude_op_struct>(above.data(), m_width, m_height, pooled);
+  } else if (type == MAX_POOL) {
+    poolBlocks<max_op_struct>(above.data(), m_width, m_height, pooled);
+  } else if (m_mode == MEAN_MODE) {
+    // an average over a block is the total of the values in its pixels over
+    // the number of them, so that empty pixels do not pull it down
+    bool const weighted = !m_counts.empty();
+    if (weighted) {
+      Parallel::forRange(above.size(), [&](unsigned, size_t const start, \
+          size_t const end) {
+        for (size_t i = start; i < end; ++i) {
+          above[i] *= static_cast<value_type>(m_counts[i]);
+        }
+      });
+    }
+
+    std::vector<index_type> const ones(weighted ? 0 : m_values.size(), 1);
+    coarse.m_counts.resize(numPooled);
+    poolBlocks<sum_op_struct>(weighted ? m_counts.data() : ones.data(), \
+        m_width, m_height, coarse.m_counts.data());
+    poolBlocks<sum_op_struct>(above.data(), m_width, m_height, pooled);
+
+    index_type const * const counts = coarse.m_counts.data();
+    setPooled(numPooled, m_default, [pooled, counts](size_t const i) {
+      return counts[i] > 0 ? pooled[i] / counts[i] : 0.0f;
+    }, pooled, &coarse.m_min, &coarse.m_max);
+    return coarse;
+  } else {
+    poolBlocks<sum_op_struct>(above.data(), m_width, m_height, pooled);
+  }
+
+  setPooled(numPooled, m_default, [pooled](size_t const i) {
+    return pooled[i];
+  }, pooled, &coarse.m_min, &coarse.m_max);
+
+  return coarse;
+}
+
+
+
+/******************************************************************************
+* PRIVATE FUNCTIONS ***********************************************************
+******************************************************************************/
+
+
+bool HeatMap::binSample(
+    CSRMatrix const & matrix,
+    float const scale,
+    dim_type const stride,
+    mode_type const mode,
+    sample_struct * const sample,
+    std::atomic<bool> const * const cancel) const
+{
+  dim_type const numRows = matrix.getNumRows();
+  index_type const * const offsets = matrix.getOffsets();
+  bool const mirror = matrix.isHalfStorage();
+  bin_type const bin = getBinType(mode);
+  bool const weighted = bin != COUNT_BIN;
+
+  // the rows of a sample at a coarser stride are a subset of these
+  if (sample->stride == 0 || sample->stride % stride != 0 || \
+      sample->mode != mode || sample->counts.size() != m_values.size()) {
+    // counts are kept as integers, as a float stops counting at 2^24, and
+    // totals as doubles for the same reason
+    sample->counts.assign(m_values.size(), 0);
+    sample->sums.assign(weighted ? m_values.size() : 0, 0.0);
+    // the entries on the diagonal of each pixel row, which are not mirrored
+    sample->diagonal.assign(mirror ? m_height : 0, 0);
+    sample->diagonalSums.assign(mirror && weighted ? m_height : 0, 0.0);
+    sample->mode = mode;
+    sample->stride = 0;
+  }
+  dim_type const counted = sample->stride;
+  bool const magnitude = mode != SIGNED_SUM_MODE;
+  bin_target_struct const target{&matrix, scale, 0, m_width, \
+      sample->counts.data(), sample->sums.data()};
+  index_type * const diagonal = mirror ? sample->diagonal.data() : nullptr;
+  double * const diagonalSums = mirror ? sample->diagonalSums.data() : \
+      nullptr;
+
+  unsigned const numThreads = Parallel::getNumThreads( \
+      offsets[numRows] / stride);
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    dim_type const start = getBandStart(offsets, 0, numRows, scale, \
+        numThreads, tid);
+    dim_type const end = getBandStart(offsets, 0, numRows, scale, \
+        numThreads, tid+1);
+    dim_type const first = static_cast<dim_type>( \
+        ((static_cast<uint64_t>(start) + stride - 1) / stride) * stride);
+    binRows(bin, target, magnitude, first, end, stride, counted, cancel, \
+        diagonal, diagonalSums);
+  });
+
+  if (cancel != nullptr && cancel->load()) {
+    sample->stride = 0;
+    return false;
+  }
+  sample->stride = stride;
+
+  return true;
+}
+
+
+void HeatMap::setBins(
+    std::vector<index_type> const & counts,
+    std::vector<double> const & sums,
+    index_type const factor)
+{
+  ASSERT_EQUAL(counts.size(), m_values.size());
+
+  size_t const numValues = counts.size();
+  mode_type const mode = m_mode;
+  value_type const def = m_default;
+  value_type * const values = m_values.data();
+
+  // counts are pooled exactly, and averages are weighed by them
+  if (mode == COUNT_MODE || mode == MEAN_MODE) {
+    m_counts.resize(numValues);
+  } else {
+    m_counts.clear();
+  }
+  index_type * const pixelCounts = m_counts.data();
+
+  unsigned const numThreads = Parallel::getNumThreads(numValues);
+  std::vector<value_type> mins(numThreads, def);
+  std::vector<value_type> maxes(numThreads, def);
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    size_t const start = Parallel::getChunkStart(numValues, numThreads, tid);
+    size_t const end = Parallel::getChunkStart(numValues, numThreads, tid+1);
+
+    // a plain loop for each mode, which the compiler can vectorize
+    switch (mode) {
+      case COUNT_MODE:
+        for (size_t i = start; i < end; ++i) {
+          pixelCounts[i] = counts[i] * factor;
+          values[i] = def + static_cast<value_type>(pixelCounts[i]);
+        }
+        break;
+      case MAX_MODE:
+        for (size_t i = start; i < end; ++i) {
+          values[i] = def + static_cast<value_type>(sums[i]);
+        }
+        break;
+      case MEAN_MODE:
+        // the stride scales the total and the count alike
+        for (size_t i = start; i < end; ++i) {
+          values[i] = def + (counts[i] > 0 ? \
+              static_cast<value_type>(sums[i] / counts[i]) : 0.0f);
+          pixelCounts[i] = counts[i];
+        }
+        break;
+      default:
+        for (size_t i = start; i < end; ++i) {
+          values[i] = def + static_cast<value_type>(sums[i] * factor);
+        }
+    }
+
+    // untouched pixels keep the default, which is always in the range
+    value_type localMin = def;
+    value_type localMax = def;
+    for (size_t i = start; i < end; ++i) {
+      value_type const value = values[i];
+      localMin = value < localMin ? value : localMin;
+      localMax = value > localMax ? value : localMax;
+    }
+    mins[tid] = localMin;
+    maxes[tid] = localMax;
+  });
+
+  m_min = *std::min_element(mins.begin(), mins.end());
+  m_max = *std::max_element(maxes.begin(), maxes.end());
+}
+
 
 }
 
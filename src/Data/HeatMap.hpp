@@ -15,6 +15,7 @@
 
 
 
+#include <atomic>
 #include <cassert>
 #include <vector>
 #include "Types.hpp"
@@ -26,9 +27,58 @@ namespace MatrixInspector
 {
 
 
+class CSRMatrix;
+
+
 class HeatMap
 {
   public:
+    enum mode_type {
+      // each pixel is the number of non-zeros in it
+      COUNT_MODE,
+      // each pixel is the total magnitude of the values in it
+      SUM_MODE,
+      // each pixel is the largest magnitude of the values in it
+      MAX_MODE,
+      // each pixel is the average magnitude of the values in it
+      MEAN_MODE,
+      // each pixel is the total of the signed values in it, which is meant
+      // for a diverging color map
+      SIGNED_SUM_MODE
+    };
+
+
+    enum pool_type {
+      // each pixel of a coarser level is the total of those it covers, which
+      // is their density
+      SUM_POOL,
+      // each pixel of a coarser level is the largest of those it covers, so
+      // that isolated non-zeros are not lost
+      MAX_POOL
+    };
+
+
+    /**
+    * @brief The counts of a sample of the rows of a matrix, kept between
+    * progressively denser samples so that each row is only counted once.
+    */
+    struct sample_struct
+    {
+      // the count of each pixel
+      std::vector<index_type> counts;
+      // the entries on the diagonal of each pixel row, for half storage
+      std::vector<index_type> diagonal;
+      // the total or largest of the values of each pixel, and of those on
+      // the diagonal of each pixel row, unless counting
+      std::vector<double> sums;
+      std::vector<double> diagonalSums;
+      // what the sample was taken for
+      mode_type mode;
+      // the rows counted are the multiples of this, or none if zero
+      dim_type stride;
+    };
+
+
     static inline uint32_t floatToRGBA(
         float const val)
     {
@@ -84,6 +134,31 @@ class HeatMap
     std::vector<value_type> const * getValues() const noexcept;
 
 
+    /**
+    * @brief Get what each pixel is made of the non-zeros in it.
+    *
+    * @return The mode.
+    */
+    mode_type getMode() const noexcept;
+
+
+    /**
+    * @brief Set what each pixel is made of the non-zeros in it, the next
+    * time they are counted. Non-finite values are left out of the modes
+    * which use the values.
+    *
+    * @param mode The mode.
+    */
+    void setMode(
+        mode_type mode) noexcept;
+
+
+    value_type getMin() const noexcept;
+
+
+    value_type getMax() const noexcept;
+
+
     void resize(
         dim_type width,
         dim_type height);
@@ -92,6 +167,128 @@ class HeatMap
     void normalize();
 
 
+    /**
+    * @brief Replace the values with the number of non-zeros of a matrix that
+    * fall in each pixel, or their values as set by the mode, added to the
+    * default value. The rows are split between threads in bands of whole
+    * pixel rows with about the same number of non-zeros, so that no two
+    * threads count in the same pixel.
+    *
+    * @param matrix The matrix, which is mirrored if in half storage.
+    * @param scale The number of pixels per row and column of the matrix.
+    * @param cancel The flag which, once set, stops the count and leaves the
+    * values unchanged.
+    */
+    void countNonZeros(
+        CSRMatrix const & matrix,
+        float scale,
+        std::atomic<bool> const * cancel = nullptr);
+
+
+    /**
+    * @brief Replace the values with an estimate of the number of non-zeros of
+    * a matrix that fall in each pixel, or their values as set by the mode,
+    * added to the default value, from the rows which are multiples of a
+    * stride, whose counts and totals are scaled by it. The rows already in
+    * the sample are not counted again, if its stride is a multiple of this
+    * one and it was taken for the same mode, and otherwise it is started
+    * over. With a stride of one the counts are exact, and the sample may be
+    * left empty.
+    *
+    * @param matrix The matrix, which is mirrored if in half storage.
+    * @param scale The number of pixels per row and column of the matrix.
+    * @param stride The stride of the rows to count.
+    * @param sample The sample to add the rows to.
+    * @param cancel The flag which, once set, stops the count and leaves the
+    * values unchanged, and the sample to be started over.
+    */
+    void countNonZeros(
+        CSRMatrix const & matrix,
+        float scale,
+        dim_type stride,
+        sample_struct * sample,
+        std::atomic<bool> const * cancel = nullptr);
+
+
+    /**
+    * @brief Replace the values with the number of non-zeros in a region of a
+    * matrix that fall in each pixel, or their values as set by the mode,
+    * added to the default value, where each pixel covers a square of 2^shift
+    * rows and columns. The entries of each row inside of the region are
+    * found by binary search over its sorted columns, so only the rows of the
+    * region are visited.
+    *
+    * @param matrix The matrix, which is mirrored if in half storage.
+    * @param firstRow The row at the top of the region.
+    * @param firstCol The column at the left of the region.
+    * @param shift The base two logarithm of the rows and columns per pixel.
+    */
+    void countNonZeros(
+        CSRMatrix const & matrix,
+        dim_type firstRow,
+        dim_type firstCol,
+        unsigned shift);
+
+
+    /**
+    * @brief Replace the values with the number of non-zeros of a matrix that
+    * fall in a band of the pixel rows of a heat map of the full matrix, or
+    * their values as set by the mode, added to the default value. This heat
+    * map is the full width, and as tall as the band, so that images too
+    * large to count at once can be counted a band at a time.
+    *
+    * @param matrix The matrix, which is mirrored if in half storage.
+    * @param scale The number of pixels per row and column of the matrix.
+    * @param firstLine The pixel row at the top of the band.
+    */
+    void countBand(
+        CSRMatrix const & matrix,
+        float scale,
+        dim_type firstLine);
+
+
+    /**
+    * @brief Bin the non-zeros of a matrix in the pixels of this heat map,
+    * into their exact number and the total of their finite values, without
+    * changing its values, for when the bins themselves are needed rather
+    * than colors.
+    *
+    * @param matrix The matrix, which is mirrored if in half storage.
+    * @param scale The number of pixels per row and column of the matrix.
+    * @param counts The number of non-zeros of each pixel (output).
+    * @param sums The total of the values of each pixel (output).
+    * @param cancel The flag which, once set, stops the binning.
+    *
+    * @return Whether the binning finished, rather than being cancelled.
+    */
+    bool binNonZeros(
+        CSRMatrix const & matrix,
+        float scale,
+        std::vector<index_type> * counts,
+        std::vector<double> * sums,
+        std::atomic<bool> const * cancel = nullptr) const;
+
+
+    /**
+    * @brief Build the next coarser level of a mip chain, of half the width
+    * and height rounded down, but at least one, as OpenGL requires. Each
+    * pixel pools the block of two by two pixels beneath it, and the last row
+    * and column of pixels also pool the odd row and column left over, so
+    * that none are dropped. The values above the default are pooled, or the
+    * counts themselves when counting, which are only made values afterwards
+    * so that large counts stay exact. Pixels of signed totals are pooled by
+    * the largest magnitude rather than the largest value, and pixels of
+    * averages by the average of the non-zeros in them, so that empty pixels
+    * are left out.
+    *
+    * @param type How the pixels are pooled.
+    *
+    * @return The coarser level.
+    */
+    HeatMap pool(
+        pool_type type) const;
+
+
     inline void add(
         dim_type const x,
         dim_type const y,
@@ -99,6 +296,7 @@ class HeatMap
     {
       index_type const idx = (y*m_width)+x;
       m_values[idx] += val;
+      m_counts.clear();
 
       if (m_values[idx] > m_max) {
         m_max = m_values[idx];
@@ -112,10 +310,54 @@ class HeatMap
   private:
     dim_type m_width;
     dim_type m_height;
+    mode_type m_mode;
     value_type m_default;
     value_type m_min;
     value_type m_max;
     std::vector<value_type> m_values;
+    // the number of non-zeros in each pixel, when counted, which coarser
+    // levels pool exactly rather than as values, and weigh averages by, or
+    // empty when the values are not counts
+    std::vector<index_type> m_counts;
+
+
+    /**
+    * @brief Add the non-zeros of every stride-th row of a matrix to a sample
+    * taken for a mode, which is started over as countNonZeros() describes,
+    * without folding the lower triangle of a matrix in half storage onto
+    * the upper.
+    *
+    * @param matrix The matrix.
+    * @param scale The number of pixels per row and column of the matrix.
+    * @param stride The stride of the rows.
+    * @param mode How the values are binned.
+    * @param sample The sample (input and output).
+    * @param cancel The flag which, once set, stops the binning.
+    *
+    * @return Whether the binning finished, rather than being cancelled.
+    */
+    bool binSample(
+        CSRMatrix const & matrix,
+        float scale,
+        dim_type stride,
+        mode_type mode,
+        sample_struct * sample,
+        std::atomic<bool> const * cancel) const;
+
+
+    /**
+    * @brief Set the values from counts, or from totals or the largest values
+    * as set by the mode, and find their range in a single pass at the end
+    * rather than with each addition.
+    *
+    * @param counts The count of each pixel.
+    * @param sums The total or largest value of each pixel, unless counting.
+    * @param factor The scale of the counts and totals.
+    */
+    void setBins(
+        std::vector<index_type> const & counts,
+        std::vector<double> const & sums,
+        index_type factor = 1);
 
 };
 
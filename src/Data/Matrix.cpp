@@ -12,6 +12,7 @@
 #include <stdexcept>
 #include <vector>
 #include <algorithm>
+#include <utility>
 #include "Utility/Debug.hpp"
 #include "Operations/Stats.hpp"
 #include "Matrix.hpp"
@@ -23,6 +24,18 @@ namespace MatrixInspector
 {
 
 
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+
+constexpr int Matrix::NUM_PERCENTILES;
+constexpr double Matrix::PERCENTILES[Matrix::NUM_PERCENTILES];
+constexpr int Matrix::MIN_MAGNITUDE;
+constexpr int Matrix::NUM_MAGNITUDE_BINS;
+
+
+
 
 /******************************************************************************
 * CONSTRUCTORS / DESTRUCTOR ***************************************************
@@ -45,11 +58,18 @@ Matrix::Matrix(
   m_numCols(numCols),
   m_symmetrySet(true),
   m_symmetry(sym),
-  m_statsSet(false),
-  m_maxRowSize(0),
-  m_maxColumnSize(0),
-  m_numEmptyRows(0),
-  m_numEmptyColumns(0)
+  m_rowStatsSet(false),
+  m_columnStatsSet(false),
+  m_diagonalStatsSet(false),
+  m_valueStatsSet(false),
+  m_rowDegreesSet(false),
+  m_columnDegreesSet(false),
+  m_rowStats(),
+  m_columnStats(),
+  m_diagonalStats(),
+  m_valueStats(),
+  m_rowDegrees(),
+  m_columnDegrees()
 {
   // do nothing
 }
@@ -102,116 +122,263 @@ bool Matrix::isSquare() const noexcept
 
 bool Matrix::isStatsSet() const noexcept 
 {
-  return m_statsSet;
+  return m_rowStatsSet && m_columnStatsSet && m_diagonalStatsSet && \
+      m_valueStatsSet;
+}
+
+
+bool Matrix::isRowStatsSet() const noexcept 
+{
+  return m_rowStatsSet;
+}
+
+
+bool Matrix::isColumnStatsSet() const noexcept 
+{
+  return m_columnStatsSet;
+}
+
+
+bool Matrix::isDiagonalStatsSet() const noexcept 
+{
+  return m_diagonalStatsSet;
+}
+
+
+bool Matrix::isValueStatsSet() const noexcept 
+{
+  return m_valueStatsSet;
+}
+
+
+Matrix::degree_stats_struct const & Matrix::getRowStats() const
+{
+  if (!isRowStatsSet()) {
+    throw std::runtime_error("Stats have not been computed yet.");
+  }
+
+  return m_rowStats;
+}
+
+
+Matrix::degree_stats_struct const & Matrix::getColumnStats() const
+{
+  if (!isColumnStatsSet()) {
+    throw std::runtime_error("Stats have not been computed yet.");
+  }
+
+  return m_columnStats;
+}
+
+
+Matrix::diagonal_stats_struct const & Matrix::getDiagonalStats() const
+{
+  if (!isDiagonalStatsSet()) {
+    throw std::runtime_error("Stats have not been computed yet.");
+  }
+
+  return m_diagonalStats;
+}
+
+
+Matrix::value_stats_struct const & Matrix::getValueStats() const
+{
+  if (!isValueStatsSet()) {
+    throw std::runtime_error("Stats have not been computed yet.");
+  }
+
+  return m_valueStats;
 }
 
 
 dim_type Matrix::getMaxRowSize() const
 {
-  if (!isStatsSet()) {
+  if (!isRowStatsSet()) {
     throw std::runtime_error("Stats have not been computed yet.");
   }
 
-  return m_maxRowSize;
+  return m_rowStats.max;
 }
 
 
 dim_type Matrix::getMaxColumnSize() const
 {
-  if (!isStatsSet()) {
+  if (!isColumnStatsSet()) {
     throw std::runtime_error("Stats have not been computed yet.");
   }
 
-  return m_maxColumnSize;
+  return m_columnStats.max;
 }
 
 
 dim_type Matrix::getNumEmptyRows() const
 {
-  if (!isStatsSet()) {
+  if (!isRowStatsSet()) {
     throw std::runtime_error("Stats have not been computed yet.");
   }
 
-  return m_numEmptyRows;
+  return m_rowStats.numEmpty;
 }
 
 
 dim_type Matrix::getNumEmptyColumns() const
 {
-  if (!isStatsSet()) {
+  if (!isColumnStatsSet()) {
     throw std::runtime_error("Stats have not been computed yet.");
   }
 
-  return m_numEmptyColumns;
+  return m_columnStats.numEmpty;
 }
 
 
-void Matrix::computeStats(
-    double * const progress,
-    double scale)
+bool Matrix::isRowDegreesSet() const noexcept
 {
-  // set symmetry if neccessary
-  if (!isSymmetrySet()) {
-    computeSymmetry();
+  return m_rowDegreesSet;
+}
+
+
+bool Matrix::isColumnDegreesSet() const noexcept
+{
+  return m_columnDegreesSet;
+}
+
+
+std::vector<dim_type> const & Matrix::getRowDegrees()
+{
+  if (!isRowDegreesSet()) {
+    computeDegrees();
   }
 
-  if (getNumRows() == 0 || getNumColumns() == 0) {
-    // handle empty matrix
-    m_maxRowSize = 0;
-    m_maxColumnSize = 0;
-    m_numEmptyRows = getNumRows();
-    m_numEmptyColumns = getNumColumns();
+  return m_rowDegrees;
+}
+
 
-    if (progress != nullptr) {
-      *progress += scale;
-    }
-  } else {
-    // compute row stats
-    {
-      std::vector<dim_type> rowCounts(getNumRows());
-      Stats::countRowNonZeros(this,rowCounts.data());
-      std::sort(rowCounts.begin(),rowCounts.end());
+std::vector<dim_type> const & Matrix::getColumnDegrees()
+{
+  if (!isColumnDegreesSet()) {
+    computeDegrees();
+  }
+
+  return m_columnDegrees;
+}
 
-      m_maxRowSize = rowCounts.back();
 
-      index_type i = 0;
-      while (i < rowCounts.size() && rowCounts[i] == 0) {
-        ++i;
-      }
-      m_numEmptyRows = i;
+void Matrix::computeDegrees(
+    double * const progress,
+    double const scale,
+    std::atomic<bool> const * const cancel)
+{
+  if (!isRowDegreesSet()) {
+    std::vector<dim_type> degrees(getNumRows());
+    Stats::countRowNonZeros(this, degrees.data(), progress, scale*0.5, \
+        cancel);
+    if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) {
+      return;
     }
+    setRowDegrees(std::move(degrees));
+  } else if (progress != nullptr) {
+    *progress += scale*0.5;
+  }
 
+  if (!isColumnDegreesSet()) {
+    std::vector<dim_type> degrees(getNumColumns());
+    Stats::countColumnNonZeros(this, degrees.data(), progress, scale*0.5, \
+        cancel);
+    if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) {
+      return;
+    }
+    setColumnDegrees(std::move(degrees));
+  } else if (progress != nullptr) {
+    *progress += scale*0.5;
+  }
+}
+
+
+void Matrix::computeStats(
+    double * const progress,
+    double const scale,
+    std::atomic<bool> const * const cancel)
+{
+  // the degree statistics are summarized from the cached degrees
+  bool const degrees = !isRowStatsSet() || !isColumnStatsSet();
+  double const degreeScale = degrees ? scale*0.3 : 0;
+  if (degrees) {
+    computeDegrees(progress, degreeScale*0.8, cancel);
+    if (!isRowDegreesSet() || !isColumnDegreesSet()) {
+      // cancelled
+      return;
+    }
+    if (!isRowStatsSet()) {
+      setRowStats(Stats::summarizeDegrees(m_rowDegrees.data(), \
+          getNumRows()));
+    }
+    if (!isColumnStatsSet()) {
+      setColumnStats(Stats::summarizeDegrees(m_columnDegrees.data(), \
+          getNumColumns()));
+    }
     if (progress != nullptr) {
-      *progress += scale*0.5;
+      *progress += degreeScale*0.2;
     }
+  }
 
-    // compute col stats
-    {
-      std::vector<dim_type> colCounts(getNumColumns());
-      Stats::countColumnNonZeros(this,colCounts.data());
-      std::sort(colCounts.begin(),colCounts.end());
+  // only compute what is missing
+  int flags = 0;
+  if (!isDiagonalStatsSet()) {
+    flags |= Stats::DIAGONAL_STATS;
+  }
+  if (!isValueStatsSet()) {
+    flags |= Stats::VALUE_STATS;
+  }
+  if (!isSymmetrySet()) {
+    flags |= Stats::STRUCTURAL_SYMMETRY;
+  }
 
-      m_maxColumnSize = colCounts.back();
+  // a numerical symmetry check may be needed after the sweep
+  double const remaining = scale - degreeScale;
+  double const sweepScale = isSymmetrySet() ? remaining : remaining*0.4;
 
-      index_type i;
-      for (i = 0; i < colCounts.size() && colCounts[i] == 0; ++i);
-      m_numEmptyColumns = i;
+  if (flags != 0) {
+    Stats::matrix_stats_struct const stats = \
+        Stats::compute(this, flags, progress, sweepScale, cancel);
+    if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) {
+      return;
     }
 
-    if (progress != nullptr) {
-      *progress += scale*0.5;
+    if (flags & Stats::DIAGONAL_STATS) {
+      setDiagonalStats(stats.diagonal);
+    }
+    if (flags & Stats::VALUE_STATS) {
+      setValueStats(stats.values);
+    }
+    if (flags & Stats::STRUCTURAL_SYMMETRY) {
+      if (stats.structurallySymmetric) {
+        // the values still need to be compared
+        computeSymmetry(progress, remaining - sweepScale, cancel);
+      } else {
+        setSymmetry(false);
+        setStructuralSymmetry(false);
+        if (progress != nullptr) {
+          *progress += remaining - sweepScale;
+        }
+      }
     }
+  } else if (progress != nullptr) {
+    *progress += remaining;
   }
 
-  m_statsSet = true;
-
-  assert(isStatsSet());
+  assert(isStatsSet() || (cancel != nullptr && \
+      cancel->load(std::memory_order_relaxed)));
 }
 
 
 void Matrix::invalidateStats()
 {
-  m_statsSet = false;
+  m_rowStatsSet = false;
+  m_columnStatsSet = false;
+  m_diagonalStatsSet = false;
+  m_valueStatsSet = false;
+  m_rowDegreesSet = false;
+  m_columnDegreesSet = false;
 
   assert(!isStatsSet());
 }
@@ -249,14 +416,14 @@ void Matrix::reorder(
 
 void Matrix::computeSymmetry()
 {
-  computeSymmetry(nullptr, 1.0);
+  computeSymmetry(nullptr, 1.0, nullptr);
 }
 
 
 void Matrix::computeSymmetry(
     double * const progress)
 {
-  computeSymmetry(progress, 1.0);
+  computeSymmetry(progress, 1.0, nullptr);
 }
 
 /******************************************************************************
@@ -264,6 +431,21 @@ void Matrix::computeSymmetry(
 ******************************************************************************/
 
 
+bool Matrix::isSymmetricPermutation(
+    dim_type const * const rowPerm,
+    dim_type const * const colPerm,
+    dim_type const len) noexcept
+{
+  if (rowPerm == colPerm) {
+    return true;
+  } else if (rowPerm == nullptr || colPerm == nullptr) {
+    return false;
+  } else {
+    return std::equal(rowPerm, rowPerm+len, colPerm);
+  }
+}
+
+
 void Matrix::setNumRows(
     dim_type const numRows)
 {
@@ -294,5 +476,103 @@ void Matrix::unsetSymmetry()
 }
 
 
+void Matrix::setStructuralSymmetry(
+    bool)
+{
+  // do nothing
+}
+
+
+void Matrix::transformStats(
+    stats_transform_type const rowStats,
+    stats_transform_type const columnStats,
+    stats_transform_type const diagonalStats,
+    stats_transform_type const valueStats,
+    stats_transform_type const symmetry)
+{
+  assert((rowStats == STATS_SWAP) == (columnStats == STATS_SWAP));
+  assert(diagonalStats != STATS_SWAP);
+  assert(valueStats != STATS_SWAP);
+  assert(symmetry != STATS_SWAP);
+
+  if (rowStats == STATS_SWAP) {
+    std::swap(m_rowStatsSet, m_columnStatsSet);
+    std::swap(m_rowStats, m_columnStats);
+    std::swap(m_rowDegreesSet, m_columnDegreesSet);
+    m_rowDegrees.swap(m_columnDegrees);
+  }
+
+  if (rowStats == STATS_INVALIDATE) {
+    m_rowStatsSet = false;
+    m_rowDegreesSet = false;
+    m_rowDegrees = std::vector<dim_type>();
+  }
+  if (columnStats == STATS_INVALIDATE) {
+    m_columnStatsSet = false;
+    m_columnDegreesSet = false;
+    m_columnDegrees = std::vector<dim_type>();
+  }
+  if (diagonalStats == STATS_INVALIDATE) {
+    m_diagonalStatsSet = false;
+  }
+  if (valueStats == STATS_INVALIDATE) {
+    m_valueStatsSet = false;
+  }
+  if (symmetry == STATS_INVALIDATE) {
+    unsetSymmetry();
+  }
+}
+
+
+void Matrix::setRowDegrees(
+    std::vector<dim_type> degrees)
+{
+  assert(degrees.size() == getNumRows());
+  m_rowDegrees = std::move(degrees);
+  m_rowDegreesSet = true;
+}
+
+
+void Matrix::setColumnDegrees(
+    std::vector<dim_type> degrees)
+{
+  assert(degrees.size() == getNumColumns());
+  m_columnDegrees = std::move(degrees);
+  m_columnDegreesSet = true;
+}
+
+
+void Matrix::setRowStats(
+    degree_stats_struct const & stats)
+{
+  m_rowStats = stats;
+  m_rowStatsSet = true;
+}
+
+
+void Matrix::setColumnStats(
+    degree_stats_struct const & stats)
+{
+  m_columnStats = stats;
+  m_columnStatsSet = true;
+}
+
+
+void Matrix::setDiagonalStats(
+    diagonal_stats_struct const & stats)
+{
+  m_diagonalStats = stats;
+  m_diagonalStatsSet = true;
+}
+
+
+void Matrix::setValueStats(
+    value_stats_struct const & stats)
+{
+  m_valueStats = stats;
+  m_valueStatsSet = true;
+}
+
+
 
 }
@@ -15,6 +15,8 @@
 
 
 
+#include <atomic>
+#include <vector>
 #include "Types.hpp"
 
 
@@ -27,6 +29,69 @@ namespace MatrixInspector
 class Matrix
 {
   public:
+    static constexpr int NUM_PERCENTILES = 6;
+
+
+    /**
+    * @brief The percentiles reported in the degree statistics.
+    */
+    static constexpr double PERCENTILES[NUM_PERCENTILES] = {
+      0.10, 0.25, 0.50, 0.75, 0.90, 0.99
+    };
+
+
+    /**
+    * @brief Statistics of the number of non-zeros per row (or column).
+    */
+    struct degree_stats_struct {
+      dim_type min;
+      dim_type max;
+      double mean;
+      double variance;
+      dim_type percentiles[NUM_PERCENTILES];
+      dim_type numEmpty;
+    };
+
+
+    static constexpr int MIN_MAGNITUDE = -64;
+    static constexpr int NUM_MAGNITUDE_BINS = 128;
+
+
+    /**
+    * @brief Statistics of the values of the non-zeros. Non-finite values are
+    * only counted.
+    */
+    struct value_stats_struct {
+      index_type numValues;
+      value_type min;
+      value_type max;
+      double sum;
+      double absSum;
+      index_type numZeros;
+      index_type numNegative;
+      index_type numNaN;
+      index_type numInfinite;
+      // the number of finite non-zeros with a magnitude in
+      // [2^(MIN_MAGNITUDE+i), 2^(MIN_MAGNITUDE+i+1)), where the first and
+      // last bins also hold anything smaller or larger
+      index_type magnitudes[NUM_MAGNITUDE_BINS];
+    };
+
+
+    /**
+    * @brief Statistics of the placement of the non-zeros relative to the
+    * diagonal.
+    */
+    struct diagonal_stats_struct {
+      // the number of non-zeros on the diagonal
+      index_type numNonZeros;
+      // the number of diagonal positions which are empty or store a zero
+      index_type numZeros;
+      // the maximum distance of a non-zero from the diagonal
+      dim_type bandwidth;
+    };
+
+
     /**
     * @brief Create a new matrix.
     *
@@ -105,6 +170,70 @@ class Matrix
     bool isStatsSet() const noexcept;
 
 
+    /**
+    * @brief Check if the row statistics are known.
+    *
+    * @return True if the row statistics are known.
+    */
+    bool isRowStatsSet() const noexcept;
+
+
+    /**
+    * @brief Check if the column statistics are known.
+    *
+    * @return True if the column statistics are known.
+    */
+    bool isColumnStatsSet() const noexcept;
+
+
+    /**
+    * @brief Check if the diagonal statistics are known.
+    *
+    * @return True if the diagonal statistics are known.
+    */
+    bool isDiagonalStatsSet() const noexcept;
+
+
+    /**
+    * @brief Check if the value statistics are known.
+    *
+    * @return True if the value statistics are known.
+    */
+    bool isValueStatsSet() const noexcept;
+
+
+    /**
+    * @brief Get the statistics of the values.
+    *
+    * @return The value statistics.
+    */
+    value_stats_struct const & getValueStats() const;
+
+
+    /**
+    * @brief Get the statistics of the number of non-zeros per row.
+    *
+    * @return The row statistics.
+    */
+    degree_stats_struct const & getRowStats() const;
+
+
+    /**
+    * @brief Get the statistics of the number of non-zeros per column.
+    *
+    * @return The column statistics.
+    */
+    degree_stats_struct const & getColumnStats() const;
+
+
+    /**
+    * @brief Get the statistics of the diagonal.
+    *
+    * @return The diagonal statistics.
+    */
+    diagonal_stats_struct const & getDiagonalStats() const;
+
+
     /**
     * @brief Get the maximum number of non-zero per row.
     *
@@ -138,14 +267,67 @@ class Matrix
 
 
     /**
-    * @brief Compute the statistics of the matrix.
+    * @brief Check if the number of non-zeros in each row is cached.
+    *
+    * @return True if the row degrees are cached.
+    */
+    bool isRowDegreesSet() const noexcept;
+
+
+    /**
+    * @brief Check if the number of non-zeros in each column is cached.
+    *
+    * @return True if the column degrees are cached.
+    */
+    bool isColumnDegreesSet() const noexcept;
+
+
+    /**
+    * @brief Get the number of non-zeros in each row, counting them on first
+    * use. The counts are kept up to date across edits.
+    *
+    * @return The row degrees.
+    */
+    std::vector<dim_type> const & getRowDegrees();
+
+
+    /**
+    * @brief Get the number of non-zeros in each column, counting them on
+    * first use. The counts are kept up to date across edits.
+    *
+    * @return The column degrees.
+    */
+    std::vector<dim_type> const & getColumnDegrees();
+
+
+    /**
+    * @brief Count the number of non-zeros in each row and column, if they are
+    * not already cached.
+    *
+    * @param progress The progress counter to update.
+    * @param scale The amount of progress this task contributes.
+    * @param cancel The flag which, once set, stops the counting without
+    * caching any degrees.
+    */
+    void computeDegrees(
+        double * progress = nullptr,
+        double scale = 1.0,
+        std::atomic<bool> const * cancel = nullptr);
+
+
+    /**
+    * @brief Compute the statistics of the matrix. Only those statistics which
+    * are not currently known are computed.
     *
     * @param progress The progress counter to update.
     * @param scale The amount of progress this task contributes.
+    * @param cancel The flag which, once set, stops the computation. The
+    * statistics finished before then are kept, and the rest are left unset.
     */
     void computeStats(
         double * progress = nullptr,
-        double scale = 1.0);
+        double scale = 1.0,
+        std::atomic<bool> const * cancel = nullptr);
 
 
     /**
@@ -259,13 +441,45 @@ class Matrix
     *
     * @param progress The progress of the task.
     * @param scale The fraction of the task this operation completes.
+    * @param cancel The flag which, once set, stops the check without setting
+    * the symmetry (may be null).
     */
     virtual void computeSymmetry(
         double * progress,
-        double scale) = 0;
+        double scale,
+        std::atomic<bool> const * cancel) = 0;
 
 
   protected:
+    /**
+    * @brief How an edit to the matrix affects a cached statistic.
+    */
+    enum stats_transform_type {
+      // the statistic is unchanged by the edit
+      STATS_PRESERVE,
+      // the row and column statistics trade places
+      STATS_SWAP,
+      // the statistic is no longer known
+      STATS_INVALIDATE
+    };
+
+
+    /**
+    * @brief Check if a row and column permutation are the same (i.e., they
+    * form a symmetric permutation).
+    *
+    * @param rowPerm The row permutation.
+    * @param colPerm The column permutation.
+    * @param len The length of the permutations.
+    *
+    * @return True if they are the same.
+    */
+    static bool isSymmetricPermutation(
+        dim_type const * rowPerm,
+        dim_type const * colPerm,
+        dim_type len) noexcept;
+
+
     void setNumRows(
         dim_type numRows);
 
@@ -278,7 +492,94 @@ class Matrix
         bool sym);
 
 
-    void unsetSymmetry();
+    virtual void unsetSymmetry();
+
+
+    /**
+    * @brief Set the structural symmetry of the matrix. Matrices without a
+    * sparsity structure ignore this.
+    *
+    * @param sym Whether or not the matrix is structurally symmetric.
+    */
+    virtual void setStructuralSymmetry(
+        bool sym);
+
+
+    /**
+    * @brief Update the cached statistics after an edit. Swapping must be
+    * applied to both the rows and the columns. The cached row and column
+    * degrees are swapped or invalidated along with their statistics.
+    *
+    * @param rowStats The effect on the row statistics.
+    * @param columnStats The effect on the column statistics.
+    * @param diagonalStats The effect on the diagonal statistics (swapping is
+    * not meaningful).
+    * @param valueStats The effect on the value statistics (swapping is not
+    * meaningful).
+    * @param symmetry The effect on the symmetry (swapping is not meaningful).
+    */
+    void transformStats(
+        stats_transform_type rowStats,
+        stats_transform_type columnStats,
+        stats_transform_type diagonalStats,
+        stats_transform_type valueStats,
+        stats_transform_type symmetry);
+
+
+    /**
+    * @brief Set the cached row degrees, when they are derived by an edit.
+    *
+    * @param degrees The number of non-zeros in each row.
+    */
+    void setRowDegrees(
+        std::vector<dim_type> degrees);
+
+
+    /**
+    * @brief Set the cached column degrees, when they are derived by an edit.
+    *
+    * @param degrees The number of non-zeros in each column.
+    */
+    void setColumnDegrees(
+        std::vector<dim_type> degrees);
+
+
+    /**
+    * @brief Set the row statistics, when they can be cheaply derived by an
+    * edit.
+    *
+    * @param stats The row statistics.
+    */
+    void setRowStats(
+        degree_stats_struct const & stats);
+
+
+    /**
+    * @brief Set the column statistics, when they can be cheaply derived by an
+    * edit.
+    *
+    * @param stats The column statistics.
+    */
+    void setColumnStats(
+        degree_stats_struct const & stats);
+
+
+    /**
+    * @brief Set the diagonal statistics.
+    *
+    * @param stats The diagonal statistics.
+    */
+    void setDiagonalStats(
+        diagonal_stats_struct const & stats);
+
+
+    /**
+    * @brief Set the value statistics.
+    *
+    * @param stats The value statistics.
+    */
+    void setValueStats(
+        value_stats_struct const & stats);
 
 
 
@@ -287,11 +588,18 @@ class Matrix
     dim_type m_numCols;
     bool m_symmetrySet;
     bool m_symmetry;
-    bool m_statsSet;
-    dim_type m_maxRowSize;
-    dim_type m_maxColumnSize;
-    dim_type m_numEmptyRows;
-    dim_type m_numEmptyColumns;
+    bool m_rowStatsSet;
+    bool m_columnStatsSet;
+    bool m_diagonalStatsSet;
+    bool m_valueStatsSet;
+    bool m_rowDegreesSet;
+    bool m_columnDegreesSet;
+    degree_stats_struct m_rowStats;
+    degree_stats_struct m_columnStats;
+    diagonal_stats_struct m_diagonalStats;
+    value_stats_struct m_valueStats;
+    std::vector<dim_type> m_rowDegrees;
+    std::vector<dim_type> m_columnDegrees;
 
 
 
@@ -0,0 +1,446 @@
+/**
+ * @file RegionTable.cpp
+ * @brief Implementation of the RegionTable class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "RegionTable.hpp"
+#include "CSRMatrix.hpp"
+#include "HeatMap.hpp"
+#include "Utility/Parallel.hpp"
+#include "Utility/Debug.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+
+/**
+* @brief The rows or columns of a range which fill whole pixels.
+*/
+struct inner_struct
+{
+  dim_type firstPixel;
+  dim_type pixelEnd;
+  // the first row or column of the first whole pixel, and the first after
+  // the last, which are both the end of the range if there are none
+  dim_type start;
+  dim_type end;
+};
+
+
+/**
+* @brief Get the pixel a row or column falls in, as the heat map does.
+*
+* @param index The row or column.
+* @param scale The number of pixels per row or column.
+*
+* @return The pixel.
+*/
+inline dim_type toPixel(
+    dim_type const index,
+    float const scale) noexcept
+{
+  return static_cast<dim_type>(index * scale);
+}
+
+
+/**
+* @brief Get the first row or column which falls in a pixel or one after it.
+*
+* @param num The number of rows or columns.
+* @param scale The number of pixels per row or column.
+* @param pixel The pixel.
+*
+* @return The row or column, or the number of them if none do.
+*/
+dim_type getFirstIndex(
+    dim_type const num,
+    float const scale,
+    dim_type const pixel) noexcept
+{
+  // the pixel of each row never decreases
+  dim_type first = 0;
+  dim_type last = num;
+  while (first < last) {
+    dim_type const mid = first + ((last - first) / 2);
+    if (toPixel(mid, scale) < pixel) {
+      first = mid + 1;
+    } else {
+      last = mid;
+    }
+  }
+
+  return first;
+}
+
+
+/**
+* @brief Get the whole pixels of a range of rows or columns.
+*
+* @param start The first row or column of the range.
+* @param end The end of the range.
+* @param num The number of rows or columns.
+* @param scale The number of pixels per row or column.
+* @param numPixels The number of pixels.
+*
+* @return The whole pixels.
+*/
+inner_struct getInner(
+    dim_type const start,
+    dim_type const end,
+    dim_type const num,
+    float const scale,
+    dim_type const numPixels) noexcept
+{
+  dim_type firstPixel = toPixel(start, scale);
+  if (getFirstIndex(num, scale, firstPixel) < start) {
+    ++firstPixel;
+  }
+  // the pixel of the end holds rows past the range, but those before it
+  // hold none
+  dim_type const pixelEnd = end < num ? toPixel(end, scale) : numPixels;
+
+  if (firstPixel >= pixelEnd) {
+    return inner_struct{0, 0, end, end};
+  }
+
+  return inner_struct{firstPixel, pixelEnd, \
+      getFirstIndex(num, scale, firstPixel), \
+      getFirstIndex(num, scale, pixelEnd)};
+}
+
+
+/**
+* @brief Add the non-zeros of a value to a region, if it is finite, as the
+* heat map bins them.
+*
+* @param value The value.
+* @param region The region (input and output).
+*/
+inline void addValue(
+    value_type const value,
+    RegionTable::region_struct * const region) noexcept
+{
+  ++region->count;
+  if (std::fabs(value) < std::numeric_limits<value_type>::infinity()) {
+    region->sum += value;
+  }
+}
+
+
+/**
+* @brief Get the entries stored in a block of a matrix, found by binary
+* search over the sorted columns of each of its rows, which are split between
+* threads.
+*
+* @param matrix The matrix.
+* @param rowStart The first row of the block.
+* @param rowEnd The end of the rows of the block.
+* @param colStart The first column of the block.
+* @param colEnd The end of the columns of the block.
+*
+* @return The entries.
+*/
+RegionTable::region_struct getStored(
+    CSRMatrix const & matrix,
+    dim_type const rowStart,
+    dim_type const rowEnd,
+    dim_type const colStart,
+    dim_type const colEnd)
+{
+  if (rowStart >= rowEnd || colStart >= colEnd) {
+    return RegionTable::region_struct{0, 0.0};
+  }
+
+  index_type const * const offsets = matrix.getOffsets();
+  dim_type const * const columns = matrix.getColumns();
+  ValueArray const & values = matrix.getValueArray();
+
+  dim_type const numRows = rowEnd - rowStart;
+  unsigned const numThreads = Parallel::getNumThreads(numRows);
+  std::vector<RegionTable::region_struct> parts(numThreads, \
+      RegionTable::region_struct{0, 0.0});
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    dim_type const start = rowStart + static_cast<dim_type>( \
+        Parallel::getChunkStart(numRows, numThreads, tid));
+    dim_type const end = rowStart + static_cast<dim_type>( \
+        Parallel::getChunkStart(numRows, numThreads, tid+1));
+
+    RegionTable::region_struct part{0, 0.0};
+    for (dim_type row = start; row < end; ++row) {
+      dim_type const * const first = std::lower_bound(columns+offsets[row], \
+          columns+offsets[row+1], colStart);
+      dim_type const * const last = std::lower_bound(first, \
+          columns+offsets[row+1], colEnd);
+      for (index_type idx = first - columns; idx < \
+          static_cast<index_type>(last - columns); ++idx) {
+        addValue(values.get(idx), &part);
+      }
+    }
+    parts[tid] = part;
+  });
+
+  RegionTable::region_struct total{0, 0.0};
+  for (RegionTable::region_struct const & part : parts) {
+    total.count += part.count;
+    total.sum += part.sum;
+  }
+
+  return total;
+}
+
+
+/**
+* @brief Get the non-zeros of a block of a matrix. Only the lower triangle of
+* a matrix in half storage is stored, so the transpose of the block is added,
+* less the diagonal which is then counted twice. The last entry of each row
+* of the lower triangle is the only one which can be on the diagonal.
+*
+* @param matrix The matrix.
+* @param rowStart The first row of the block.
+* @param rowEnd The end of the rows of the block.
+* @param colStart The first column of the block.
+* @param colEnd The end of the columns of the block.
+*
+* @return The non-zeros.
+*/
+RegionTable::region_struct getBlock(
+    CSRMatrix const & matrix,
+    dim_type const rowStart,
+    dim_type const rowEnd,
+    dim_type const colStart,
+    dim_type const colEnd)
+{
+  RegionTable::region_struct block = getStored(matrix, rowStart, rowEnd, \
+      colStart, colEnd);
+  if (!matrix.isHalfStorage()) {
+    return block;
+  }
+
+  RegionTable::region_struct const transposed = getStored(matrix, colStart, \
+      colEnd, rowStart, rowEnd);
+  block.count += transposed.count;
+  block.sum += transposed.sum;
+
+  index_type const * const offsets = matrix.getOffsets();
+  dim_type const * const columns = matrix.getColumns();
+  ValueArray const & values = matrix.getValueArray();
+  RegionTable::region_struct diagonal{0, 0.0};
+  dim_type const diagEnd = std::min(rowEnd, colEnd);
+  for (dim_type row = std::max(rowStart, colStart); row < diagEnd; ++row) {
+    if (offsets[row] < offsets[row+1] && columns[offsets[row+1]-1] == row) {
+      addValue(values.get(offsets[row+1]-1), &diagonal);
+    }
+  }
+  block.count -= diagonal.count;
+  block.sum -= diagonal.sum;
+
+  return block;
+}
+
+
+}
+
+
+
+
+/******************************************************************************
+* CONSTRUCTORS / DESTRUCTOR ***************************************************
+******************************************************************************/
+
+
+RegionTable::RegionTable() :
+  m_width(0),
+  m_height(0),
+  m_scale(0),
+  m_counts(),
+  m_sums()
+{
+  // do nothing
+}
+
+
+
+
+/******************************************************************************
+* PUBLIC FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+bool RegionTable::build(
+    CSRMatrix const & matrix,
+    float const scale,
+    dim_type const width,
+    dim_type const height,
+    std::atomic<bool> const * const cancel)
+{
+  HeatMap const heatmap(width, height);
+  if (!heatmap.binNonZeros(matrix, scale, &m_counts, &m_sums, cancel)) {
+    *this = RegionTable();
+    return false;
+  }
+  m_width = width;
+  m_height = height;
+  m_scale = scale;
+
+  index_type * const counts = m_counts.data();
+  double * const sums = m_sums.data();
+  size_t const numPixels = static_cast<size_t>(width) * height;
+
+  // sum along each row, split between threads by rows
+  unsigned const numRowThreads = Parallel::getNumThreads(numPixels);
+  Parallel::run(numRowThreads, [&](unsigned const tid) {
+    size_t const start = Parallel::getChunkStart(height, numRowThreads, tid);
+    size_t const end = Parallel::getChunkStart(height, numRowThreads, tid+1);
+    for (size_t y = start; y < end; ++y) {
+      index_type * const countLine = counts + (y * width);
+      double * const sumLine = sums + (y * width);
+      for (dim_type x = 1; x < width; ++x) {
+        countLine[x] += countLine[x-1];
+        sumLine[x] += sumLine[x-1];
+      }
+    }
+  });
+
+  // then down each column, split between threads by columns, in a loop over
+  // each row which the compiler can vectorize
+  unsigned const numColThreads = Parallel::getNumThreads(numPixels);
+  Parallel::run(numColThreads, [&](unsigned const tid) {
+    size_t const start = Parallel::getChunkStart(width, numColThreads, tid);
+    size_t const end = Parallel::getChunkStart(width, numColThreads, tid+1);
+    for (size_t y = 1; y < height; ++y) {
+      index_type * const countLine = counts + (y * width);
+      double * const sumLine = sums + (y * width);
+      index_type const * const countAbove = countLine - width;
+      double const * const sumAbove = sumLine - width;
+      for (size_t x = start; x < end; ++x) {
+        countLine[x] += countAbove[x];
+        sumLine[x] += sumAbove[x];
+      }
+    }
+  });
+
+  return true;
+}
+
+
+dim_type RegionTable::getWidth() const noexcept
+{
+  return m_width;
+}
+
+
+dim_type RegionTable::getHeight() const noexcept
+{
+  return m_height;
+}
+
+
+float RegionTable::getScale() const noexcept
+{
+  return m_scale;
+}
+
+
+RegionTable::region_struct RegionTable::queryPixels(
+    dim_type const firstLine,
+    dim_type const firstPixel,
+    dim_type lineEnd,
+    dim_type pixelEnd) const noexcept
+{
+  lineEnd = std::min(lineEnd, m_height);
+  pixelEnd = std::min(pixelEnd, m_width);
+  if (firstLine >= lineEnd || firstPixel >= pixelEnd) {
+    return region_struct{0, 0.0};
+  }
+
+  region_struct const all = getCorner(lineEnd, pixelEnd);
+  region_struct const above = getCorner(firstLine, pixelEnd);
+  region_struct const left = getCorner(lineEnd, firstPixel);
+  region_struct const both = getCorner(firstLine, firstPixel);
+
+  return region_struct{all.count - above.count - left.count + both.count, \
+      all.sum - above.sum - left.sum + both.sum};
+}
+
+
+RegionTable::region_struct RegionTable::query(
+    CSRMatrix const & matrix,
+    dim_type const rowStart,
+    dim_type const colStart,
+    dim_type rowEnd,
+    dim_type colEnd) const
+{
+  rowEnd = std::min(rowEnd, matrix.getNumRows());
+  colEnd = std::min(colEnd, matrix.getNumColumns());
+  if (rowStart >= rowEnd || colStart >= colEnd) {
+    return region_struct{0, 0.0};
+  }
+
+  inner_struct const rows = getInner(rowStart, rowEnd, matrix.getNumRows(), \
+      m_scale, m_height);
+  inner_struct const cols = getInner(colStart, colEnd, \
+      matrix.getNumColumns(), m_scale, m_width);
+
+  // the whole pixels, and the four strips around them which cut through
+  // pixels
+  region_struct region = queryPixels(rows.firstPixel, cols.firstPixel, \
+      rows.pixelEnd, cols.pixelEnd);
+  region_struct const strips[] = {
+    getBlock(matrix, rowStart, rows.start, colStart, colEnd),
+    getBlock(matrix, rows.end, rowEnd, colStart, colEnd),
+    getBlock(matrix, rows.start, rows.end, colStart, cols.start),
+    getBlock(matrix, rows.start, rows.end, cols.end, colEnd)
+  };
+  for (region_struct const & strip : strips) {
+    region.count += strip.count;
+    region.sum += strip.sum;
+  }
+
+  return region;
+}
+
+
+
+
+/******************************************************************************
+* PRIVATE FUNCTIONS ***********************************************************
+******************************************************************************/
+
+
+RegionTable::region_struct RegionTable::getCorner(
+    dim_type const line,
+    dim_type const pixel) const noexcept
+{
+  if (line == 0 || pixel == 0) {
+    return region_struct{0, 0.0};
+  }
+
+  size_t const idx = (static_cast<size_t>(line - 1) * m_width) + pixel - 1;
+  return region_struct{m_counts[idx], m_sums[idx]};
+}
+
+
+
+
+}
@@ -0,0 +1,174 @@
+/**
+ * @file RegionTable.hpp
+ * @brief The RegionTable class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_REGIONTABLE_HPP
+#define MATRIXINSPECTOR_REGIONTABLE_HPP
+
+
+
+
+#include <atomic>
+#include <vector>
+#include "Types.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+class CSRMatrix;
+
+
+/**
+* @brief Summed-area tables of the number of non-zeros and the total of their
+* values over the pixels of a heat map of a matrix, so that the non-zeros of
+* any block of pixels are found from four entries of each table. The
+* non-zeros of a region of the matrix whose edges cut through pixels are
+* found by adding those of the rows and columns along its edges.
+*/
+class RegionTable
+{
+  public:
+    /**
+    * @brief The non-zeros of a region.
+    */
+    struct region_struct
+    {
+      index_type count;
+      // the total of the finite values
+      double sum;
+    };
+
+
+    /**
+    * @brief Create an empty table, over which every region is empty.
+    */
+    RegionTable();
+
+
+    /**
+    * @brief Replace the tables with those of a heat map of a matrix. The
+    * non-zeros are binned as HeatMap::binNonZeros() does, and the tables are
+    * summed along their rows and then down their columns, each split
+    * between threads.
+    *
+    * @param matrix The matrix, which is mirrored if in half storage.
+    * @param scale The number of pixels per row and column of the matrix.
+    * @param width The width of the heat map.
+    * @param height The height of the heat map.
+    * @param cancel The flag which, once set, stops the building, and leaves
+    * the table empty.
+    *
+    * @return Whether the tables were built, rather than being cancelled.
+    */
+    bool build(
+        CSRMatrix const & matrix,
+        float scale,
+        dim_type width,
+        dim_type height,
+        std::atomic<bool> const * cancel = nullptr);
+
+
+    dim_type getWidth() const noexcept;
+
+
+    dim_type getHeight() const noexcept;
+
+
+    /**
+    * @brief Get the number of pixels per row and column of the matrix.
+    *
+    * @return The scale.
+    */
+    float getScale() const noexcept;
+
+
+    /**
+    * @brief Get the non-zeros of a block of pixels, in constant time. The
+    * block is cut to the heat map.
+    *
+    * @param firstLine The pixel row at the top of the block.
+    * @param firstPixel The pixel column at the left of the block.
+    * @param lineEnd The pixel row after the bottom of the block.
+    * @param pixelEnd The pixel column after the right of the block.
+    *
+    * @return The non-zeros.
+    */
+    region_struct queryPixels(
+        dim_type firstLine,
+        dim_type firstPixel,
+        dim_type lineEnd,
+        dim_type pixelEnd) const noexcept;
+
+
+    /**
+    * @brief Get the exact non-zeros of a region of the matrix the table was
+    * built from. The pixels wholly inside of the region are found from the
+    * tables, and the entries of the rows and columns along its edges which
+    * cut through pixels by binary search over their sorted columns, so the
+    * time taken grows with the height and width of the region, rather than
+    * its area.
+    *
+    * @param matrix The matrix the table was built from.
+    * @param rowStart The first row of the region.
+    * @param colStart The first column of the region.
+    * @param rowEnd The end of the rows of the region.
+    * @param colEnd The end of the columns of the region.
+    *
+    * @return The non-zeros.
+    */
+    region_struct query(
+        CSRMatrix const & matrix,
+        dim_type rowStart,
+        dim_type colStart,
+        dim_type rowEnd,
+        dim_type colEnd) const;
+
+
+  private:
+    dim_type m_width;
+    dim_type m_height;
+    float m_scale;
+    // the totals of the pixels above and to the left of, and including,
+    // each pixel
+    std::vector<index_type> m_counts;
+    std::vector<double> m_sums;
+
+
+    /**
+    * @brief Get the totals of the pixels above and to the left of a pixel,
+    * not including its row or column.
+    *
+    * @param line The pixel row.
+    * @param pixel The pixel column.
+    *
+    * @return The non-zeros.
+    */
+    region_struct getCorner(
+        dim_type line,
+        dim_type pixel) const noexcept;
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
@@ -34,7 +34,8 @@ SparseMatrix::SparseMatrix(
   m_structuralSymmetry(false),
   m_structuralSymmetrySet(false)
 {
-  // do nothing
+  // symmetry needs to be determined from the non-zeros
+  Matrix::unsetSymmetry();
 }
 
 
@@ -80,4 +81,11 @@ void SparseMatrix::setStructuralSymmetry(
   m_structuralSymmetrySet = true;
 }
 
+void SparseMatrix::unsetSymmetry()
+{
+  Matrix::unsetSymmetry();
+  m_structuralSymmetry = false;
+  m_structuralSymmetrySet = false;
+}
+
 }
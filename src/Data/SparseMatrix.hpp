@@ -73,8 +73,14 @@ class SparseMatrix :
     *
     * @param structuralSymmetry The structural symmetry.
     */
-    void setStructuralSymmetry(
-        bool structuralSymmetry);
+    virtual void setStructuralSymmetry(
+        bool structuralSymmetry) override;
+
+    /**
+    * @brief Mark both the numerical and structural symmetry of the matrix as
+    * unknown.
+    */
+    virtual void unsetSymmetry() override;
 
   private:
     index_type m_numNonZeros;
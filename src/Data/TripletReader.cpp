@@ -0,0 +1,659 @@
+/**
+* @file TripletReader.cpp
+* @brief Implementation of the TripletReader class.
+* @author Dominique LaSalle <dominique@solidlake.com>
+* Copyright 2018
+* @version 1
+*/
+
+
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include "TripletReader.hpp"
+#include "Utility/String.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+size_t const BUFFER_SIZE = 1 << 20;
+
+// the longest number which can be parsed
+size_t const MAX_TOKEN_LENGTH = 64;
+
+int const END_OF_FILE = -1;
+
+
+/**
+* @brief Get the lower case extension of a file.
+*
+* @param path The path of the file.
+*
+* @return The extension (empty if there is none).
+*/
+std::string getExtension(
+    char const * const path)
+{
+  std::string const name(path);
+  size_t const dot = name.find_last_of('.');
+  if (dot == std::string::npos) {
+    return std::string("");
+  }
+
+  std::string const ext = name.substr(dot+1);
+  return String::toLower(&ext);
+}
+
+
+bool isBlank(
+    int const c) noexcept
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+
+bool isDigit(
+    int const c) noexcept
+{
+  return c >= '0' && c <= '9';
+}
+
+}
+
+
+
+
+/******************************************************************************
+* PUBLIC STATIC FUNCTIONS *****************************************************
+******************************************************************************/
+
+
+bool TripletReader::isSupported(
+    char const * const path)
+{
+  std::string const ext = getExtension(path);
+  return ext == "mtx" || ext == "mm" || ext == "graph" || ext == "chaco" || \
+      ext == "snap";
+}
+
+
+
+
+/******************************************************************************
+* CONSTRUCTORS / DESTRUCTOR ***************************************************
+******************************************************************************/
+
+
+TripletReader::TripletReader(
+    char const * const path) :
+  m_path(path),
+  m_file(path, std::ios::in | std::ios::binary),
+  m_format(EDGE_LIST),
+  m_symmetry(GENERAL),
+  m_hasDimensions(false),
+  m_numRows(0),
+  m_numCols(0),
+  m_numEntries(0),
+  m_hasValues(true),
+  m_numSkipped(0),
+  m_buffer(BUFFER_SIZE),
+  m_pos(0),
+  m_end(0),
+  m_bufferStart(0),
+  m_fileSize(0),
+  m_dataStart(0),
+  m_line(1),
+  m_dataLine(1),
+  m_vertex(0),
+  m_inLine(false),
+  m_numRead(0),
+  m_maxRow(0),
+  m_maxCol(0)
+{
+  if (!m_file) {
+    throw std::runtime_error(std::string("Failed to open ") + path);
+  }
+
+  m_file.seekg(0, std::ios::end);
+  m_fileSize = static_cast<uint64_t>(m_file.tellg());
+  m_file.seekg(0, std::ios::beg);
+
+  std::string const ext = getExtension(path);
+  if (ext == "mtx" || ext == "mm") {
+    m_format = MATRIX_MARKET;
+    readMatrixMarketHeader();
+  } else if (ext == "graph" || ext == "chaco") {
+    m_format = METIS;
+    readMetisHeader();
+  } else if (ext == "snap") {
+    m_format = EDGE_LIST;
+  } else {
+    throw std::runtime_error(std::string("Unable to stream ") + path);
+  }
+
+  m_dataStart = m_bufferStart + m_pos;
+  m_dataLine = m_line;
+}
+
+
+
+
+/******************************************************************************
+* PUBLIC FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+bool TripletReader::hasDimensions() const noexcept
+{
+  return m_hasDimensions;
+}
+
+
+dim_type TripletReader::getNumRows() const noexcept
+{
+  return m_numRows;
+}
+
+
+dim_type TripletReader::getNumColumns() const noexcept
+{
+  return m_numCols;
+}
+
+
+index_type TripletReader::getNumEntries() const noexcept
+{
+  return m_numEntries;
+}
+
+
+TripletReader::symmetry_type TripletReader::getSymmetry() const noexcept
+{
+  return m_symmetry;
+}
+
+
+bool TripletReader::next(
+    dim_type * const row,
+    dim_type * const col,
+    value_type * const value)
+{
+  bool found;
+  switch (m_format) {
+    case MATRIX_MARKET:
+      found = nextMatrixMarket(row, col, value);
+      break;
+    case METIS:
+      found = nextMetis(row, col, value);
+      break;
+    default:
+      found = nextEdgeList(row, col, value);
+  }
+
+  if (found) {
+    ++m_numRead;
+    m_maxRow = std::max(m_maxRow, *row);
+    m_maxCol = std::max(m_maxCol, *col);
+  } else if (!m_hasDimensions) {
+    // an edge list describes a graph, so it is as wide as it is tall
+    m_hasDimensions = true;
+    m_numRows = m_numRead > 0 ? std::max(m_maxRow, m_maxCol) + 1 : 0;
+    m_numCols = m_numRows;
+    m_numEntries = m_numRead;
+  }
+
+  return found;
+}
+
+
+void TripletReader::rewind()
+{
+  m_file.clear();
+  m_file.seekg(static_cast<std::streamoff>(m_dataStart), std::ios::beg);
+
+  m_pos = 0;
+  m_end = 0;
+  m_bufferStart = m_dataStart;
+  m_line = m_dataLine;
+
+  m_vertex = 0;
+  m_inLine = false;
+
+  m_numRead = 0;
+  m_maxRow = 0;
+  m_maxCol = 0;
+}
+
+
+double TripletReader::getProgress() const noexcept
+{
+  if (m_fileSize == 0) {
+    return 1.0;
+  }
+
+  return static_cast<double>(m_bufferStart + m_pos) / \
+      static_cast<double>(m_fileSize);
+}
+
+
+
+
+/******************************************************************************
+* PRIVATE FUNCTIONS ***********************************************************
+******************************************************************************/
+
+
+void TripletReader::readMatrixMarketHeader()
+{
+  std::string header;
+  if (!readLine(&header)) {
+    throw error("Missing Matrix Market header");
+  }
+  header = String::toLower(&header);
+
+  std::istringstream stream(header);
+  std::string banner, object, format, field, symmetry;
+  stream >> banner >> object >> format >> field >> symmetry;
+
+  if (banner != "%%matrixmarket" || object != "matrix") {
+    throw error("Invalid Matrix Market header");
+  }
+  if (format != "coordinate") {
+    throw error("Only coordinate Matrix Market files can be streamed");
+  }
+
+  // complex values are reduced to their real part
+  if (field == "pattern") {
+    m_hasValues = false;
+  } else if (field != "real" && field != "integer" && field != "double" && \
+      field != "complex") {
+    throw error("Unknown Matrix Market field '" + field + "'");
+  }
+
+  if (symmetry == "general") {
+    m_symmetry = GENERAL;
+  } else if (symmetry == "symmetric") {
+    m_symmetry = SYMMETRIC;
+  } else if (symmetry == "skew-symmetric") {
+    m_symmetry = SKEW_SYMMETRIC;
+  } else if (symmetry == "hermitian") {
+    m_symmetry = HERMITIAN;
+  } else {
+    throw error("Unknown Matrix Market symmetry '" + symmetry + "'");
+  }
+
+  // skip comments
+  while (atLineEnd() || peek() == '%') {
+    if (peek() == END_OF_FILE) {
+      throw error("Missing Matrix Market size line");
+    }
+    skipLine();
+  }
+
+  uint64_t numRows, numCols, numEntries;
+  if (!readInteger(&numRows) || !readInteger(&numCols) || \
+      !readInteger(&numEntries) || !atLineEnd()) {
+    throw error("Invalid Matrix Market size line");
+  }
+  skipLine();
+
+  if (numRows >= NULL_DIM || numCols >= NULL_DIM) {
+    throw error("Matrix is too large");
+  }
+
+  m_hasDimensions = true;
+  m_numRows = static_cast<dim_type>(numRows);
+  m_numCols = static_cast<dim_type>(numCols);
+  m_numEntries = static_cast<index_type>(numEntries);
+}
+
+
+void TripletReader::readMetisHeader()
+{
+  // skip comments
+  while (peek() == '%') {
+    skipLine();
+  }
+
+  uint64_t numVertices, numEdges;
+  if (!readInteger(&numVertices) || !readInteger(&numEdges)) {
+    throw error("Invalid METIS header");
+  }
+
+  // the format flags are digits: vertex sizes, vertex weights, edge weights
+  uint64_t format = 0;
+  uint64_t numConstraints = 1;
+  if (readInteger(&format)) {
+    readInteger(&numConstraints);
+  }
+  if (!atLineEnd()) {
+    throw error("Invalid METIS header");
+  }
+  skipLine();
+
+  if (numVertices >= NULL_DIM) {
+    throw error("Graph is too large");
+  }
+
+  bool const hasSizes = (format / 100) % 10 != 0;
+  bool const hasVertexWeights = (format / 10) % 10 != 0;
+  m_hasValues = format % 10 != 0;
+  m_numSkipped = (hasSizes ? 1 : 0) + \
+      (hasVertexWeights ? static_cast<int>(numConstraints) : 0);
+
+  // each edge is listed by both of its vertices
+  m_hasDimensions = true;
+  m_numRows = static_cast<dim_type>(numVertices);
+  m_numCols = m_numRows;
+  m_numEntries = static_cast<index_type>(numEdges*2);
+}
+
+
+bool TripletReader::nextMatrixMarket(
+    dim_type * const row,
+    dim_type * const col,
+    value_type * const value)
+{
+  while (atLineEnd() || peek() == '%') {
+    if (peek() == END_OF_FILE) {
+      if (m_numRead != m_numEntries) {
+        throw error("Expected " + std::to_string(m_numEntries) + \
+            " entries but found " + std::to_string(m_numRead));
+      }
+      return false;
+    }
+    skipLine();
+  }
+
+  uint64_t i, j;
+  if (!readInteger(&i) || !readInteger(&j)) {
+    throw error("Invalid entry");
+  }
+  *row = toIndex(i, 1, m_numRows);
+  *col = toIndex(j, 1, m_numCols);
+
+  if (value != nullptr) {
+    double val = 1.0;
+    if (m_hasValues && !readReal(&val)) {
+      throw error("Missing value");
+    }
+    *value = static_cast<value_type>(val);
+  }
+
+  skipLine();
+
+  return true;
+}
+
+
+bool TripletReader::nextMetis(
+    dim_type * const row,
+    dim_type * const col,
+    value_type * const value)
+{
+  while (true) {
+    if (!m_inLine) {
+      if (m_vertex >= m_numRows) {
+        return false;
+      }
+
+      // comments are not vertices, but empty lines are
+      while (peek() == '%') {
+        skipLine();
+      }
+      if (peek() == END_OF_FILE) {
+        throw error("Expected " + std::to_string(m_numRows) + \
+            " vertices but found " + std::to_string(m_vertex));
+      }
+
+      for (int i = 0; i < m_numSkipped; ++i) {
+        if (!readReal(nullptr)) {
+          throw error("Missing vertex weight");
+        }
+      }
+      m_inLine = true;
+    }
+
+    uint64_t neighbor;
+    if (readInteger(&neighbor)) {
+      *row = m_vertex;
+      *col = toIndex(neighbor, 1, m_numCols);
+
+      double val = 1.0;
+      if (m_hasValues && !readReal(value != nullptr ? &val : nullptr)) {
+        throw error("Missing edge weight");
+      }
+      if (value != nullptr) {
+        *value = static_cast<value_type>(val);
+      }
+
+      return true;
+    }
+
+    if (!atLineEnd()) {
+      throw error("Invalid neighbor");
+    }
+    skipLine();
+    m_inLine = false;
+    ++m_vertex;
+  }
+}
+
+
+bool TripletReader::nextEdgeList(
+    dim_type * const row,
+    dim_type * const col,
+    value_type * const value)
+{
+  while (atLineEnd() || peek() == '#' || peek() == '%') {
+    if (peek() == END_OF_FILE) {
+      return false;
+    }
+    skipLine();
+  }
+
+  uint64_t i, j;
+  if (!readInteger(&i) || !readInteger(&j)) {
+    throw error("Invalid edge");
+  }
+  *row = toIndex(i, 0, NULL_DIM);
+  *col = toIndex(j, 0, NULL_DIM);
+
+  // the weight is optional
+  if (value != nullptr) {
+    double val = 1.0;
+    readReal(&val);
+    *value = static_cast<value_type>(val);
+  }
+
+  skipLine();
+
+  return true;
+}
+
+
+int TripletReader::peek()
+{
+  if (m_pos == m_end) {
+    m_bufferStart += m_end;
+    m_pos = 0;
+    m_file.read(m_buffer.data(), m_buffer.size());
+    m_end = static_cast<size_t>(m_file.gcount());
+    if (m_end == 0) {
+      return END_OF_FILE;
+    }
+  }
+
+  return static_cast<unsigned char>(m_buffer[m_pos]);
+}
+
+
+void TripletReader::skipBlanks()
+{
+  while (isBlank(peek())) {
+    char const * const buffer = m_buffer.data();
+    size_t pos = m_pos;
+    while (pos < m_end && isBlank(buffer[pos])) {
+      ++pos;
+    }
+    m_pos = pos;
+  }
+}
+
+
+bool TripletReader::atLineEnd()
+{
+  skipBlanks();
+  int const c = peek();
+  return c == '\n' || c == END_OF_FILE;
+}
+
+
+void TripletReader::skipLine()
+{
+  while (peek() != END_OF_FILE) {
+    char const * const buffer = m_buffer.data();
+    void const * const newline = \
+        std::memchr(buffer + m_pos, '\n', m_end - m_pos);
+    if (newline != nullptr) {
+      m_pos = static_cast<char const *>(newline) - buffer + 1;
+      break;
+    }
+    m_pos = m_end;
+  }
+  ++m_line;
+}
+
+
+bool TripletReader::readLine(
+    std::string * const line)
+{
+  line->clear();
+  int c = peek();
+  if (c == END_OF_FILE) {
+    return false;
+  }
+
+  while (c != END_OF_FILE && c != '\n') {
+    line->push_back(static_cast<char>(c));
+    ++m_pos;
+    c = peek();
+  }
+  skipLine();
+
+  return true;
+}
+
+
+bool TripletReader::readInteger(
+    uint64_t * const num)
+{
+  skipBlanks();
+  int c = peek();
+  if (!isDigit(c)) {
+    return false;
+  }
+
+  // parse the digits within the buffer before checking for a refill
+  uint64_t result = 0;
+  do {
+    char const * const buffer = m_buffer.data();
+    size_t pos = m_pos;
+    while (pos < m_end && isDigit(buffer[pos])) {
+      result = result*10 + static_cast<uint64_t>(buffer[pos] - '0');
+      ++pos;
+    }
+    m_pos = pos;
+    c = peek();
+  } while (isDigit(c));
+
+  if (!isBlank(c) && c != '\n' && c != END_OF_FILE) {
+    throw error("Invalid integer");
+  }
+
+  *num = result;
+
+  return true;
+}
+
+
+bool TripletReader::readReal(
+    double * const num)
+{
+  skipBlanks();
+
+  int c = peek();
+  if (num == nullptr) {
+    bool const found = !isBlank(c) && c != '\n' && c != END_OF_FILE;
+    while (!isBlank(c) && c != '\n' && c != END_OF_FILE) {
+      ++m_pos;
+      c = peek();
+    }
+    return found;
+  }
+
+  char token[MAX_TOKEN_LENGTH];
+  size_t length = 0;
+  while (!isBlank(c) && c != '\n' && c != END_OF_FILE) {
+    if (length+1 == MAX_TOKEN_LENGTH) {
+      throw error("Number is too long");
+    }
+    token[length++] = static_cast<char>(c);
+    ++m_pos;
+    c = peek();
+  }
+  token[length] = '\0';
+
+  if (length == 0) {
+    return false;
+  }
+
+  char * end;
+  *num = std::strtod(token, &end);
+  if (end != token + length) {
+    throw error(std::string("Invalid number '") + token + "'");
+  }
+
+  return true;
+}
+
+
+dim_type TripletReader::toIndex(
+    uint64_t const num,
+    uint64_t const base,
+    dim_type const limit)
+{
+  if (num < base || num - base >= limit) {
+    throw error("Index " + std::to_string(num) + " is out of range");
+  }
+
+  return static_cast<dim_type>(num - base);
+}
+
+
+std::runtime_error TripletReader::error(
+    std::string const & msg) const
+{
+  return std::runtime_error(m_path + ":" + std::to_string(m_line) + ": " + \
+      msg + ".");
+}
+
+
+
+
+}
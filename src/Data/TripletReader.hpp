@@ -0,0 +1,311 @@
+/**
+* @file TripletReader.hpp
+* @brief The TripletReader class.
+* @author Dominique LaSalle <dominique@solidlake.com>
+* Copyright 2018
+* @version 1
+*/
+
+
+
+
+#ifndef MATRIXINSPECTOR_TRIPLETREADER_HPP
+#define MATRIXINSPECTOR_TRIPLETREADER_HPP
+
+
+
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Types.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/**
+* @brief A reader which streams the entries of a matrix file one at a time,
+* without holding the matrix in memory. It can be rewound to make another
+* pass over the file. Matrix Market coordinate files, METIS (and Chaco)
+* graphs, and SNAP edge lists are supported.
+*/
+class TripletReader
+{
+  public:
+    enum symmetry_type {
+      // every entry is stored
+      GENERAL,
+      // only one triangle is stored, and each entry implies its mirror
+      SYMMETRIC,
+      // as symmetric, but the mirror is negated
+      SKEW_SYMMETRIC,
+      // as symmetric, but the mirror is conjugated
+      HERMITIAN
+    };
+
+
+    /**
+    * @brief Check if a file can be streamed, based on its extension.
+    *
+    * @param path The path of the file.
+    *
+    * @return True if the file can be streamed.
+    */
+    static bool isSupported(
+        char const * path);
+
+
+    /**
+    * @brief Open a file and read its header.
+    *
+    * @param path The path of the file.
+    */
+    TripletReader(
+        char const * path);
+
+
+    /**
+    * @brief Check if the dimensions of the matrix are known. Edge lists have
+    * no header, so this is only true once a full pass has been made.
+    *
+    * @return True if the dimensions are known.
+    */
+    bool hasDimensions() const noexcept;
+
+
+    /**
+    * @brief Get the number of rows.
+    *
+    * @return The number of rows.
+    */
+    dim_type getNumRows() const noexcept;
+
+
+    /**
+    * @brief Get the number of columns.
+    *
+    * @return The number of columns.
+    */
+    dim_type getNumColumns() const noexcept;
+
+
+    /**
+    * @brief Get the number of entries stored in the file, which excludes
+    * implied mirrors.
+    *
+    * @return The number of entries.
+    */
+    index_type getNumEntries() const noexcept;
+
+
+    /**
+    * @brief Get how the entries not stored in the file are implied.
+    *
+    * @return The symmetry.
+    */
+    symmetry_type getSymmetry() const noexcept;
+
+
+    /**
+    * @brief Read the next entry of the file.
+    *
+    * @param row The row of the entry (output).
+    * @param col The column of the entry (output).
+    * @param value The value of the entry (output). Values are not parsed if
+    * this is null, which makes passes over only the structure faster.
+    *
+    * @return False if the end of the file has been reached.
+    */
+    bool next(
+        dim_type * row,
+        dim_type * col,
+        value_type * value);
+
+
+    /**
+    * @brief Go back to the first entry of the file.
+    */
+    void rewind();
+
+
+    /**
+    * @brief Make a pass over the entries of the file, from the first.
+    *
+    * @tparam F The function type.
+    * @param mirror Whether to also visit the entries implied by symmetric
+    * files.
+    * @param values Whether the values are needed (otherwise they are zero).
+    * @param progress The progress variable.
+    * @param scale The fraction of the progress this pass contributes.
+    * @param func The function to call with the row, column, and value of
+    * each entry.
+    */
+    template<typename F>
+    void forEachEntry(
+        bool const mirror,
+        bool const values,
+        double * const progress,
+        double const scale,
+        F func)
+    {
+      bool const implied = mirror && m_symmetry != GENERAL;
+      bool const negate = m_symmetry == SKEW_SYMMETRIC;
+
+      rewind();
+
+      double reported = 0.0;
+      index_type count = 0;
+      dim_type row, col;
+      value_type value = 0;
+      while (next(&row, &col, values ? &value : nullptr)) {
+        func(row, col, value);
+        if (implied && row != col) {
+          func(col, row, negate ? -value : value);
+        }
+
+        if (progress != nullptr && ++count % PROGRESS_INTERVAL == 0) {
+          double const done = getProgress()*scale;
+          *progress += done - reported;
+          reported = done;
+        }
+      }
+
+      if (progress != nullptr) {
+        *progress += scale - reported;
+      }
+    }
+
+
+    /**
+    * @brief Get the fraction of the file which has been read.
+    *
+    * @return The fraction.
+    */
+    double getProgress() const noexcept;
+
+
+  private:
+    // the number of entries read between progress updates
+    static constexpr index_type PROGRESS_INTERVAL = 1 << 16;
+
+
+    enum format_type {
+      MATRIX_MARKET,
+      METIS,
+      EDGE_LIST
+    };
+
+
+    std::string m_path;
+    std::ifstream m_file;
+    format_type m_format;
+    symmetry_type m_symmetry;
+    bool m_hasDimensions;
+    dim_type m_numRows;
+    dim_type m_numCols;
+    index_type m_numEntries;
+    // whether entries carry values, and how many numbers precede them
+    bool m_hasValues;
+    int m_numSkipped;
+
+    std::vector<char> m_buffer;
+    size_t m_pos;
+    size_t m_end;
+    uint64_t m_bufferStart;
+    uint64_t m_fileSize;
+    uint64_t m_dataStart;
+    size_t m_line;
+    size_t m_dataLine;
+
+    // the position within a METIS graph
+    dim_type m_vertex;
+    bool m_inLine;
+
+    // the entries and extent seen so far
+    index_type m_numRead;
+    dim_type m_maxRow;
+    dim_type m_maxCol;
+
+
+    void readMatrixMarketHeader();
+
+
+    void readMetisHeader();
+
+
+    bool nextMatrixMarket(
+        dim_type * row,
+        dim_type * col,
+        value_type * value);
+
+
+    bool nextMetis(
+        dim_type * row,
+        dim_type * col,
+        value_type * value);
+
+
+    bool nextEdgeList(
+        dim_type * row,
+        dim_type * col,
+        value_type * value);
+
+
+    int peek();
+
+
+    void skipBlanks();
+
+
+    bool atLineEnd();
+
+
+    void skipLine();
+
+
+    bool readLine(
+        std::string * line);
+
+
+    bool readInteger(
+        uint64_t * num);
+
+
+    /**
+    * @brief Read a real number.
+    *
+    * @param num The number (output). If null, the number is skipped without
+    * being parsed.
+    *
+    * @return False if there is no number before the end of the line.
+    */
+    bool readReal(
+        double * num);
+
+
+    dim_type toIndex(
+        uint64_t num,
+        uint64_t base,
+        dim_type limit);
+
+
+    std::runtime_error error(
+        std::string const & msg) const;
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
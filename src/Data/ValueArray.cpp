@@ -0,0 +1,375 @@
+/**
+* @file ValueArray.cpp
+* @brief Implementation of the ValueArray class.
+* @author Dominique LaSalle <dominique@solidlake.com>
+* Copyright 2018
+* @version 1
+*/
+
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+#include "ValueArray.hpp"
+#include "Utility/Debug.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+constexpr float NAN_VALUE = std::numeric_limits<float>::quiet_NaN();
+
+// the code of a quantized zero is the bias
+int const LOG8_BIAS = 64;
+int const LOG8_MAX = 127;
+uint8_t const LOG8_SIGN = 0x80;
+uint8_t const LOG8_NAN = LOG8_SIGN;
+
+}
+
+
+// the magnitude of code c is 2^(((c & 0x7F) - 64)/2), with the top bit being
+// the sign
+float const ValueArray::LOG8_TABLE[256] = {
+  0.0f, 3.29272254e-10f, 4.65661287e-10f, 6.58544508e-10f,
+  9.31322575e-10f, 1.31708902e-09f, 1.86264515e-09f, 2.63417803e-09f,
+  3.7252903e-09f, 5.26835606e-09f, 7.4505806e-09f, 1.05367121e-08f,
+  1.49011612e-08f, 2.10734243e-08f, 2.98023224e-08f, 4.21468485e-08f,
+  5.96046448e-08f, 8.4293697e-08f, 1.1920929e-07f, 1.68587394e-07f,
+  2.38418579e-07f, 3.37174788e-07f, 4.76837158e-07f, 6.74349576e-07f,
+  9.53674316e-07f, 1.34869915e-06f, 1.90734863e-06f, 2.6973983e-06f,
+  3.81469727e-06f, 5.39479661e-06f, 7.62939453e-06f, 1.07895932e-05f,
+  1.52587891e-05f, 2.15791864e-05f, 3.05175781e-05f, 4.31583729e-05f,
+  6.10351562e-05f, 8.63167458e-05f, 0.000122070312f, 0.000172633492f,
+  0.000244140625f, 0.000345266983f, 0.00048828125f, 0.000690533966f,
+  0.0009765625f, 0.00138106793f, 0.001953125f, 0.00276213586f,
+  0.00390625f, 0.00552427173f, 0.0078125f, 0.0110485435f,
+  0.015625f, 0.0220970869f, 0.03125f, 0.0441941738f,
+  0.0625f, 0.0883883476f, 0.125f, 0.176776695f,
+  0.25f, 0.353553391f, 0.5f, 0.707106781f,
+  1.0f, 1.41421356f, 2.0f, 2.82842712f,
+  4.0f, 5.65685425f, 8.0f, 11.3137085f,
+  16.0f, 22.627417f, 32.0f, 45.254834f,
+  64.0f, 90.509668f, 128.0f, 181.019336f,
+  256.0f, 362.038672f, 512.0f, 724.077344f,
+  1024.0f, 1448.15469f, 2048.0f, 2896.30938f,
+  4096.0f, 5792.61875f, 8192.0f, 11585.2375f,
+  16384.0f, 23170.475f, 32768.0f, 46340.95f,
+  65536.0f, 92681.9f, 131072.0f, 185363.8f,
+  262144.0f, 370727.6f, 524288.0f, 741455.2f,
+  1048576.0f, 1482910.4f, 2097152.0f, 2965820.8f,
+  4194304.0f, 5931641.6f, 8388608.0f, 11863283.2f,
+  16777216.0f, 23726566.4f, 33554432.0f, 47453132.8f,
+  67108864.0f, 94906265.6f, 134217728.0f, 189812531.0f,
+  268435456.0f, 379625062.0f, 536870912.0f, 759250125.0f,
+  1.07374182e+09f, 1.51850025e+09f, 2.14748365e+09f, 3.0370005e+09f,
+  NAN_VALUE, -3.29272254e-10f, -4.65661287e-10f, -6.58544508e-10f,
+  -9.31322575e-10f, -1.31708902e-09f, -1.86264515e-09f, -2.63417803e-09f,
+  -3.7252903e-09f, -5.26835606e-09f, -7.4505806e-09f, -1.05367121e-08f,
+  -1.49011612e-08f, -2.10734243e-08f, -2.98023224e-08f, -4.21468485e-08f,
+  -5.96046448e-08f, -8.4293697e-08f, -1.1920929e-07f, -1.68587394e-07f,
+  -2.38418579e-07f, -3.37174788e-07f, -4.76837158e-07f, -6.74349576e-07f,
+  -9.53674316e-07f, -1.34869915e-06f, -1.90734863e-06f, -2.6973983e-06f,
+  -3.81469727e-06f, -5.39479661e-06f, -7.62939453e-06f, -1.07895932e-05f,
+  -1.52587891e-05f, -2.15791864e-05f, -3.05175781e-05f, -4.31583729e-05f,
+  -6.10351562e-05f, -8.63167458e-05f, -0.000122070312f, -0.000172633492f,
+  -0.000244140625f, -0.000345266983f, -0.00048828125f, -0.000690533966f,
+  -0.0009765625f, -0.00138106793f, -0.001953125f, -0.00276213586f,
+  -0.00390625f, -0.00552427173f, -0.0078125f, -0.0110485435f,
+  -0.015625f, -0.0220970869f, -0.03125f, -0.0441941738f,
+  -0.0625f, -0.0883883476f, -0.125f, -0.176776695f,
+  -0.25f, -0.353553391f, -0.5f, -0.707106781f,
+  -1.0f, -1.41421356f, -2.0f, -2.82842712f,
+  -4.0f, -5.65685425f, -8.0f, -11.3137085f,
+  -16.0f, -22.627417f, -32.0f, -45.254834f,
+  -64.0f, -90.509668f, -128.0f, -181.019336f,
+  -256.0f, -362.038672f, -512.0f, -724.077344f,
+  -1024.0f, -1448.15469f, -2048.0f, -2896.30938f,
+  -4096.0f, -5792.61875f, -8192.0f, -11585.2375f,
+  -16384.0f, -23170.475f, -32768.0f, -46340.95f,
+  -65536.0f, -92681.9f, -131072.0f, -185363.8f,
+  -262144.0f, -370727.6f, -524288.0f, -741455.2f,
+  -1048576.0f, -1482910.4f, -2097152.0f, -2965820.8f,
+  -4194304.0f, -5931641.6f, -8388608.0f, -11863283.2f,
+  -16777216.0f, -23726566.4f, -33554432.0f, -47453132.8f,
+  -67108864.0f, -94906265.6f, -134217728.0f, -189812531.0f,
+  -268435456.0f, -379625062.0f, -536870912.0f, -759250125.0f,
+  -1.07374182e+09f, -1.51850025e+09f, -2.14748365e+09f, -3.0370005e+09f
+};
+
+
+
+
+/******************************************************************************
+* PUBLIC STATIC FUNCTIONS *****************************************************
+******************************************************************************/
+
+
+uint8_t ValueArray::floatToLog8(
+    float const val) noexcept
+{
+  if (std::isnan(val)) {
+    return LOG8_NAN;
+  } else if (val == 0) {
+    return 0;
+  }
+
+  uint8_t const sign = val < 0 ? LOG8_SIGN : 0;
+  float const exp = std::round(2.0f*std::log2(std::abs(val)));
+
+  int code;
+  if (exp > LOG8_MAX - LOG8_BIAS) {
+    code = LOG8_MAX;
+  } else if (exp < 1 - LOG8_BIAS) {
+    code = 1;
+  } else {
+    code = static_cast<int>(exp) + LOG8_BIAS;
+  }
+
+  return sign | static_cast<uint8_t>(code);
+}
+
+
+size_t ValueArray::getBytesPerValue(
+    precision_type const precision) noexcept
+{
+  switch (precision) {
+    case HALF_PRECISION:
+    case BFLOAT16_PRECISION:
+      return sizeof(uint16_t);
+    case LOG8_PRECISION:
+      return sizeof(uint8_t);
+    default:
+      return sizeof(value_type);
+  }
+}
+
+
+
+
+/******************************************************************************
+* CONSTRUCTORS / DESTRUCTOR ***************************************************
+******************************************************************************/
+
+
+ValueArray::ValueArray(
+    size_t const size,
+    precision_type const precision) :
+  m_precision(precision),
+  m_full(),
+  m_half(),
+  m_quarter()
+{
+  resize(size);
+}
+
+
+
+
+/******************************************************************************
+* PUBLIC FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+size_t ValueArray::size() const noexcept
+{
+  switch (m_precision) {
+    case HALF_PRECISION:
+    case BFLOAT16_PRECISION:
+      return m_half.size();
+    case LOG8_PRECISION:
+      return m_quarter.size();
+    default:
+      return m_full.size();
+  }
+}
+
+
+ValueArray::precision_type ValueArray::getPrecision() const noexcept
+{
+  return m_precision;
+}
+
+
+void ValueArray::setPrecision(
+    precision_type const precision)
+{
+  if (precision == m_precision) {
+    // nothing to do
+    return;
+  }
+
+  size_t const num = size();
+
+  // convert by way of full precision
+  std::vector<value_type> full;
+  if (m_precision == FULL_PRECISION) {
+    full.swap(m_full);
+  } else {
+    full.resize(num);
+    decode(0, num, full.data());
+    m_half = std::vector<uint16_t>();
+    m_quarter = std::vector<uint8_t>();
+  }
+
+  m_precision = precision;
+  if (m_precision == FULL_PRECISION) {
+    m_full.swap(full);
+  } else {
+    resize(num);
+    encode(0, num, full.data());
+  }
+}
+
+
+value_type * ValueArray::data()
+{
+  if (m_precision != FULL_PRECISION) {
+    throw std::runtime_error("Values are stored at reduced precision.");
+  }
+
+  return m_full.data();
+}
+
+
+value_type const * ValueArray::data() const
+{
+  if (m_precision != FULL_PRECISION) {
+    throw std::runtime_error("Values are stored at reduced precision.");
+  }
+
+  return m_full.data();
+}
+
+
+void ValueArray::resize(
+    size_t const num)
+{
+  switch (m_precision) {
+    case HALF_PRECISION:
+    case BFLOAT16_PRECISION:
+      m_half.resize(num);
+      break;
+    case LOG8_PRECISION:
+      m_quarter.resize(num);
+      break;
+    default:
+      m_full.resize(num);
+  }
+}
+
+
+void ValueArray::shrinkToFit()
+{
+  m_full.shrink_to_fit();
+  m_half.shrink_to_fit();
+  m_quarter.shrink_to_fit();
+}
+
+
+void ValueArray::decode(
+    size_t const start,
+    size_t const num,
+    value_type * const out) const
+{
+  ASSERT_LESSEQUAL(start+num, size());
+
+  size_t i = 0;
+  switch (m_precision) {
+    case HALF_PRECISION: {
+      uint16_t const * const in = m_half.data() + start;
+      #ifdef __F16C__
+      for (; i + 8 <= num; i += 8) {
+        __m128i const half = _mm_loadu_si128( \
+            reinterpret_cast<__m128i const *>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(half));
+      }
+      #endif
+      for (; i < num; ++i) {
+        out[i] = halfToFloat(in[i]);
+      }
+      break;
+    }
+    case BFLOAT16_PRECISION: {
+      uint16_t const * const in = m_half.data() + start;
+      for (; i < num; ++i) {
+        out[i] = bfloat16ToFloat(in[i]);
+      }
+      break;
+    }
+    case LOG8_PRECISION: {
+      uint8_t const * const in = m_quarter.data() + start;
+      for (; i < num; ++i) {
+        out[i] = log8ToFloat(in[i]);
+      }
+      break;
+    }
+    default:
+      std::copy(m_full.data() + start, m_full.data() + start + num, out);
+  }
+}
+
+
+void ValueArray::encode(
+    size_t const start,
+    size_t const num,
+    value_type const * const in)
+{
+  ASSERT_LESSEQUAL(start+num, size());
+
+  size_t i = 0;
+  switch (m_precision) {
+    case HALF_PRECISION: {
+      uint16_t * const out = m_half.data() + start;
+      #ifdef __F16C__
+      for (; i + 8 <= num; i += 8) {
+        __m128i const half = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), \
+            _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), half);
+      }
+      #endif
+      for (; i < num; ++i) {
+        out[i] = floatToHalf(in[i]);
+      }
+      break;
+    }
+    case BFLOAT16_PRECISION: {
+      uint16_t * const out = m_half.data() + start;
+      for (; i < num; ++i) {
+        out[i] = floatToBFloat16(in[i]);
+      }
+      break;
+    }
+    case LOG8_PRECISION: {
+      uint8_t * const out = m_quarter.data() + start;
+      for (; i < num; ++i) {
+        out[i] = floatToLog8(in[i]);
+      }
+      break;
+    }
+    default:
+      std::copy(in, in + num, m_full.data() + start);
+  }
+}
+
+
+
+
+}
@@ -0,0 +1,394 @@
+/**
+* @file ValueArray.hpp
+* @brief The ValueArray class.
+* @author Dominique LaSalle <dominique@solidlake.com>
+* Copyright 2018
+* @version 1
+*/
+
+
+
+
+#ifndef MATRIXINSPECTOR_VALUEARRAY_HPP
+#define MATRIXINSPECTOR_VALUEARRAY_HPP
+
+
+
+
+#include <vector>
+#include <cstring>
+#include "Types.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+class ValueArray
+{
+  public:
+    enum precision_type {
+      // full value_type
+      FULL_PRECISION,
+      // IEEE 754 binary16
+      HALF_PRECISION,
+      // the upper half of an IEEE 754 binary32
+      BFLOAT16_PRECISION,
+      // sign and a 7 bit magnitude in half powers of two
+      LOG8_PRECISION
+    };
+
+
+    /**
+    * @brief Convert a float to IEEE half precision, rounding to the nearest
+    * even.
+    *
+    * @param val The value to convert.
+    *
+    * @return The half precision bits.
+    */
+    static inline uint16_t floatToHalf(
+        float const val) noexcept
+    {
+      uint32_t const F32_INF = 255U << 23;
+      uint32_t const F16_MAX = (127U + 16U) << 23;
+      uint32_t const DENORM_MAGIC = ((127U - 15U) + (23U - 10U) + 1U) << 23;
+
+      uint32_t bits = toBits(val);
+      uint32_t const sign = bits & 0x80000000U;
+      bits ^= sign;
+
+      uint16_t out;
+      if (bits >= F16_MAX) {
+        // infinite or nan
+        out = bits > F32_INF ? 0x7E00 : 0x7C00;
+      } else if (bits < (113U << 23)) {
+        // subnormal or zero, let the fpu do the rounding
+        float const f = fromBits(bits) + fromBits(DENORM_MAGIC);
+        out = static_cast<uint16_t>(toBits(f) - DENORM_MAGIC);
+      } else {
+        uint32_t const odd = (bits >> 13) & 1U;
+        bits += ((15U - 127U) << 23) + 0xFFFU + odd;
+        out = static_cast<uint16_t>(bits >> 13);
+      }
+
+      return out | static_cast<uint16_t>(sign >> 16);
+    }
+
+
+    /**
+    * @brief Convert IEEE half precision to a float.
+    *
+    * @param half The half precision bits.
+    *
+    * @return The value.
+    */
+    static inline float halfToFloat(
+        uint16_t const half) noexcept
+    {
+      uint32_t const SHIFTED_EXP = 0x7C00U << 13;
+
+      uint32_t bits = (half & 0x7FFFU) << 13;
+      uint32_t const exp = bits & SHIFTED_EXP;
+      bits += (127U - 15U) << 23;
+
+      float out;
+      if (exp == SHIFTED_EXP) {
+        // infinite or nan
+        bits += (128U - 16U) << 23;
+        out = fromBits(bits);
+      } else if (exp == 0) {
+        // subnormal or zero
+        bits += 1U << 23;
+        out = fromBits(bits) - fromBits(113U << 23);
+      } else {
+        out = fromBits(bits);
+      }
+
+      return fromBits(toBits(out) | ((half & 0x8000U) << 16));
+    }
+
+
+    /**
+    * @brief Convert a float to bfloat16, rounding to the nearest even.
+    *
+    * @param val The value to convert.
+    *
+    * @return The bfloat16 bits.
+    */
+    static inline uint16_t floatToBFloat16(
+        float const val) noexcept
+    {
+      uint32_t const bits = toBits(val);
+      if ((bits & 0x7FFFFFFFU) > 0x7F800000U) {
+        // keep nans quiet
+        return static_cast<uint16_t>((bits >> 16) | 0x0040U);
+      }
+      return static_cast<uint16_t>( \
+          (bits + 0x7FFFU + ((bits >> 16) & 1U)) >> 16);
+    }
+
+
+    /**
+    * @brief Convert bfloat16 to a float.
+    *
+    * @param bf The bfloat16 bits.
+    *
+    * @return The value.
+    */
+    static inline float bfloat16ToFloat(
+        uint16_t const bf) noexcept
+    {
+      return fromBits(static_cast<uint32_t>(bf) << 16);
+    }
+
+
+    /**
+    * @brief Quantize a float to its sign and logarithmic magnitude. Zero maps
+    * to zero, and magnitudes are clamped to [2^-31.5, 2^31.5].
+    *
+    * @param val The value to convert.
+    *
+    * @return The quantized value.
+    */
+    static uint8_t floatToLog8(
+        float val) noexcept;
+
+
+    /**
+    * @brief Expand a logarithmicly quantized value.
+    *
+    * @param code The quantized value.
+    *
+    * @return The value.
+    */
+    static inline float log8ToFloat(
+        uint8_t const code) noexcept
+    {
+      return LOG8_TABLE[code];
+    }
+
+
+    /**
+    * @brief Get the number of bytes used per value with a given precision.
+    *
+    * @param precision The precision.
+    *
+    * @return The number of bytes.
+    */
+    static size_t getBytesPerValue(
+        precision_type precision) noexcept;
+
+
+    /**
+    * @brief Create a new value array.
+    *
+    * @param size The number of values.
+    * @param precision The precision to store values in.
+    */
+    ValueArray(
+        size_t size = 0,
+        precision_type precision = FULL_PRECISION);
+
+
+    /**
+    * @brief Get the number of values.
+    *
+    * @return The number of values.
+    */
+    size_t size() const noexcept;
+
+
+    /**
+    * @brief Get the precision values are stored at.
+    *
+    * @return The precision.
+    */
+    precision_type getPrecision() const noexcept;
+
+
+    /**
+    * @brief Change the precision the values are stored at, converting the
+    * current values.
+    *
+    * @param precision The new precision.
+    */
+    void setPrecision(
+        precision_type precision);
+
+
+    /**
+    * @brief Get direct access to the values. Only possible in full precision.
+    *
+    * @return The values.
+    */
+    value_type * data();
+
+
+    /**
+    * @brief Get direct access to the values. Only possible in full precision.
+    *
+    * @return The values.
+    */
+    value_type const * data() const;
+
+
+    /**
+    * @brief Change the number of values.
+    *
+    * @param size The new number of values.
+    */
+    void resize(
+        size_t size);
+
+
+    /**
+    * @brief Release any unused memory.
+    */
+    void shrinkToFit();
+
+
+    /**
+    * @brief Decode a range of values to full precision.
+    *
+    * @param start The first value.
+    * @param num The number of values.
+    * @param out The output buffer (must be of length num).
+    */
+    void decode(
+        size_t start,
+        size_t num,
+        value_type * out) const;
+
+
+    /**
+    * @brief Encode a range of full precision values.
+    *
+    * @param start The first value to overwrite.
+    * @param num The number of values.
+    * @param in The input buffer (must be of length num).
+    */
+    void encode(
+        size_t start,
+        size_t num,
+        value_type const * in);
+
+
+    /**
+    * @brief Get a single value.
+    *
+    * @param idx The index of the value.
+    *
+    * @return The value.
+    */
+    inline value_type get(
+        size_t const idx) const
+    {
+      switch (m_precision) {
+        case HALF_PRECISION:
+          return halfToFloat(m_half[idx]);
+        case BFLOAT16_PRECISION:
+          return bfloat16ToFloat(m_half[idx]);
+        case LOG8_PRECISION:
+          return log8ToFloat(m_quarter[idx]);
+        default:
+          return m_full[idx];
+      }
+    }
+
+
+    /**
+    * @brief Set a single value.
+    *
+    * @param idx The index of the value.
+    * @param val The value.
+    */
+    inline void set(
+        size_t const idx,
+        value_type const val)
+    {
+      switch (m_precision) {
+        case HALF_PRECISION:
+          m_half[idx] = floatToHalf(val);
+          break;
+        case BFLOAT16_PRECISION:
+          m_half[idx] = floatToBFloat16(val);
+          break;
+        case LOG8_PRECISION:
+          m_quarter[idx] = floatToLog8(val);
+          break;
+        default:
+          m_full[idx] = val;
+      }
+    }
+
+
+    /**
+    * @brief Copy a value from another array of the same precision without
+    * converting it.
+    *
+    * @param idx The index to copy to.
+    * @param src The array to copy from.
+    * @param srcIdx The index to copy from.
+    */
+    inline void copy(
+        size_t const idx,
+        ValueArray const & src,
+        size_t const srcIdx)
+    {
+      switch (m_precision) {
+        case HALF_PRECISION:
+        case BFLOAT16_PRECISION:
+          m_half[idx] = src.m_half[srcIdx];
+          break;
+        case LOG8_PRECISION:
+          m_quarter[idx] = src.m_quarter[srcIdx];
+          break;
+        default:
+          m_full[idx] = src.m_full[srcIdx];
+      }
+    }
+
+
+  private:
+    static float const LOG8_TABLE[256];
+
+    precision_type m_precision;
+    std::vector<value_type> m_full;
+    std::vector<uint16_t> m_half;
+    std::vector<uint8_t> m_quarter;
+
+
+    static inline uint32_t toBits(
+        float const val) noexcept
+    {
+      uint32_t bits;
+      std::memcpy(&bits, &val, sizeof(bits));
+      return bits;
+    }
+
+
+    static inline float fromBits(
+        uint32_t const bits) noexcept
+    {
+      float val;
+      std::memcpy(&val, &bits, sizeof(val));
+      return val;
+    }
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
@@ -0,0 +1,536 @@
+/**
+ * @file DistributionWindow.cpp
+ * @brief Implementation of the DistributionWindow class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include "GUI/WindowProperties.hpp"
+#include "Utility/String.hpp"
+#include "DistributionWindow.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+
+/******************************************************************************
+* TYPES ***********************************************************************
+******************************************************************************/
+
+namespace
+{
+
+enum event_types {
+  ID_SUBJECT,
+  ID_SCALE,
+  ID_BINS,
+  ID_TIMER
+};
+
+
+enum scale_choices {
+  LINEAR = 0,
+  LOG_LOG = 1
+};
+
+
+}
+
+
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+namespace
+{
+
+int const POLL_INTERVAL = 100;
+
+// the number of rows (and non-zeros) sampled for the distributions shown
+// while the exact ones are binned
+dim_type const PREVIEW_SAMPLE_SIZE = 1 << 14;
+
+uint64_t const PREVIEW_SEED = 0;
+
+int const DEFAULT_NUM_BINS = 50;
+
+int const MAX_NUM_BINS = 1000;
+
+int const PLOT_WIDTH = 640;
+
+int const PLOT_HEIGHT = 400;
+
+// space for the axis labels
+int const MARGIN_LEFT = 80;
+int const MARGIN_BOTTOM = 30;
+int const MARGIN = 10;
+
+char const * const SUBJECT_NAMES[] = {
+  "Non-zeros per row",
+  "Non-zeros per column",
+  "Value magnitude"
+};
+
+}
+
+
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+namespace
+{
+
+
+std::string formatNumber(
+    double const num)
+{
+  if (num == std::floor(num) && std::abs(num) < 1e15) {
+    return String::addThousandsSeparators(static_cast<index_type>(num));
+  }
+
+  std::ostringstream stream;
+  stream << std::setprecision(3) << num;
+  return stream.str();
+}
+
+
+/**
+* @brief Maps values along an axis to pixels.
+*/
+class Axis
+{
+  public:
+    Axis(
+        double const low,
+        double const high,
+        bool const logarithmic,
+        int const start,
+        int const length) :
+      m_low(logarithmic ? std::log(low) : low),
+      m_range((logarithmic ? std::log(high) : high) - m_low),
+      m_logarithmic(logarithmic),
+      m_start(start),
+      m_length(length)
+    {
+      if (m_range <= 0) {
+        m_range = 1;
+      }
+    }
+
+
+    int map(
+        double const value) const
+    {
+      double const pos = m_logarithmic ? std::log(value) : value;
+      double const frac = std::min(std::max((pos - m_low) / m_range, 0.0), \
+          1.0);
+      return m_start + static_cast<int>(frac * m_length);
+    }
+
+
+  private:
+    double m_low;
+    double m_range;
+    bool m_logarithmic;
+    int m_start;
+    int m_length;
+};
+
+
+}
+
+
+
+
+/******************************************************************************
+* MACROS **********************************************************************
+******************************************************************************/
+
+wxBEGIN_EVENT_TABLE(DistributionWindow, wxDialog)
+  EVT_CHOICE(ID_SUBJECT, DistributionWindow::onSubjectSelected)
+  EVT_CHOICE(ID_SCALE, DistributionWindow::onScaleSelected)
+  EVT_SPINCTRL(ID_BINS, DistributionWindow::onBinsChanged)
+  EVT_TIMER(ID_TIMER, DistributionWindow::onTimer)
+  EVT_BUTTON(wxID_OK, DistributionWindow::onOK)
+wxEND_EVENT_TABLE()
+
+
+
+
+/******************************************************************************
+* CONSTRUCTORS / DESTRUCTOR ***************************************************
+******************************************************************************/
+
+
+DistributionWindow::DistributionWindow(
+    wxFrame * const parent,
+    DataStorage * const storage) :
+  wxDialog(parent, wxID_ANY, "Distribution", wxDefaultPosition, \
+      wxDefaultSize),
+  m_storage(storage),
+  m_subjectChoice(nullptr),
+  m_scaleChoice(nullptr),
+  m_binsSpin(nullptr),
+  m_plot(nullptr),
+  m_fitText(nullptr),
+  m_timer(this, ID_TIMER),
+  m_progress(0),
+  m_ready(false),
+  m_cancel(false),
+  m_task(),
+  m_fine(),
+  m_fits(),
+  m_preview(),
+  m_previewFits(),
+  m_histogram(),
+  m_message()
+{
+  wxBoxSizer * allSizer = new wxBoxSizer(wxVERTICAL);
+
+  // plot controls
+  wxArrayString subjects;
+  for (char const * const name : SUBJECT_NAMES) {
+    subjects.Add(name);
+  }
+
+  wxArrayString scales;
+  scales.Add("linear");
+  scales.Add("log-log");
+
+  wxBoxSizer * controlSizer = new wxBoxSizer(wxHORIZONTAL);
+  m_subjectChoice = new wxChoice(this, ID_SUBJECT, wxDefaultPosition, \
+      wxDefaultSize, subjects);
+  m_subjectChoice->SetSelection(ROW_DEGREES);
+  controlSizer->Add(m_subjectChoice, 0, wxALIGN_CENTER_VERTICAL, BORDER);
+
+  m_scaleChoice = new wxChoice(this, ID_SCALE, wxDefaultPosition, \
+      wxDefaultSize, scales);
+  m_scaleChoice->SetSelection(LOG_LOG);
+  controlSizer->Add(m_scaleChoice, 0, wxALIGN_CENTER_VERTICAL, BORDER);
+
+  controlSizer->Add(new wxStaticText(this, wxID_ANY, "Bins:"), 0, \
+      wxALIGN_CENTER_VERTICAL, BORDER);
+  m_binsSpin = new wxSpinCtrl(this, ID_BINS, \
+      std::to_string(DEFAULT_NUM_BINS), wxDefaultPosition, wxDefaultSize, \
+      wxSP_ARROW_KEYS, 1, MAX_NUM_BINS, DEFAULT_NUM_BINS);
+  controlSizer->Add(m_binsSpin, 0, wxALIGN_CENTER_VERTICAL, BORDER);
+  allSizer->Add(controlSizer);
+
+  // the plot itself
+  m_plot = new wxPanel(this, wxID_ANY, wxDefaultPosition, \
+      wxSize(PLOT_WIDTH, PLOT_HEIGHT));
+  m_plot->SetBackgroundStyle(wxBG_STYLE_PAINT);
+  m_plot->Bind(wxEVT_PAINT, &DistributionWindow::onPaint, this);
+  allSizer->Add(m_plot, 1, wxEXPAND);
+
+  m_fitText = new wxStaticText(this, wxID_ANY, "Binning...");
+  allSizer->Add(m_fitText, 0, wxEXPAND);
+
+  // setup dialog buttons
+  wxBoxSizer * bottomSizer = new wxBoxSizer(wxHORIZONTAL);
+  bottomSizer->Add(new wxButton(this, wxID_OK, "Ok"), BORDER);
+  allSizer->Add(bottomSizer,0,wxALIGN_RIGHT);
+
+  SetSizerAndFit(allSizer);
+
+  // plot the distributions of a sample right away, where they can be
+  // sampled, while the exact ones are binned
+  Matrix const * const mat = m_storage->getMatrix();
+  try {
+    m_preview[ROW_DEGREES] = Distribution::sampleRowDegrees(mat, \
+        PREVIEW_SAMPLE_SIZE, PREVIEW_SEED);
+    m_preview[VALUE_MAGNITUDES] = Distribution::sampleValueMagnitudes(mat, \
+        PREVIEW_SAMPLE_SIZE, PREVIEW_SEED);
+    for (int subject = 0; subject < NUM_SUBJECTS; ++subject) {
+      m_previewFits[subject] = Distribution::fitPowerLaw(m_preview[subject]);
+    }
+  } catch (std::exception const &) {
+    // the exact distributions report the error
+  }
+  updateHistogram();
+
+  // bin once in the background, and then only re-bucket
+  m_task = std::async(std::launch::async, [this]() { binAll(); });
+  m_timer.Start(POLL_INTERVAL);
+}
+
+
+DistributionWindow::~DistributionWindow()
+{
+  m_timer.Stop();
+  m_cancel.store(true);
+  if (m_task.valid()) {
+    m_task.wait();
+  }
+}
+
+
+
+
+/******************************************************************************
+* PRIVATE FUNCTIONS ***********************************************************
+******************************************************************************/
+
+
+void DistributionWindow::binAll()
+{
+  Matrix * const mat = m_storage->getMatrix();
+
+  double const part = 1.0 / NUM_SUBJECTS;
+  m_fine[ROW_DEGREES] = Distribution::rowDegrees(mat, &m_progress, part, \
+      &m_cancel);
+  m_fine[COLUMN_DEGREES] = Distribution::columnDegrees(mat, &m_progress, \
+      part, &m_cancel);
+  m_fine[VALUE_MAGNITUDES] = Distribution::valueMagnitudes(mat, \
+      &m_progress, part, &m_cancel);
+  if (m_cancel.load()) {
+    return;
+  }
+
+  for (int subject = 0; subject < NUM_SUBJECTS; ++subject) {
+    m_fits[subject] = Distribution::fitPowerLaw(m_fine[subject]);
+  }
+}
+
+
+void DistributionWindow::updateHistogram()
+{
+  int const subject = m_subjectChoice->GetSelection();
+  Distribution::fine_histogram_struct const & fine = getShown(subject);
+  if (fine.values.empty()) {
+    m_histogram = Distribution::histogram_struct();
+    m_message.clear();
+    updateLabel();
+    m_plot->Refresh();
+    return;
+  }
+
+  Distribution::scale_type const scale = \
+      m_scaleChoice->GetSelection() == LOG_LOG ? Distribution::LOG_SCALE : \
+      Distribution::LINEAR_SCALE;
+
+  m_histogram = Distribution::bucket(fine, m_binsSpin->GetValue(), scale);
+
+  std::string msg;
+  Distribution::power_law_struct const & fit = getShownFit(subject);
+  if (fit.numTail > 0) {
+    std::ostringstream alpha;
+    alpha << std::setprecision(3) << fit.alpha;
+    std::ostringstream distance;
+    distance << std::setprecision(2) << fit.distance;
+    msg = "Power law fit: alpha = " + alpha.str() + " for x >= " + \
+        formatNumber(fit.xMin) + " (" + \
+        String::addThousandsSeparators(fit.numTail) + " values, KS " + \
+        distance.str() + ")";
+  } else {
+    msg = "Too few values to fit a power law";
+  }
+  if (m_histogram.numExcluded > 0) {
+    msg += ", " + String::addThousandsSeparators(m_histogram.numExcluded) + \
+        " zeros not shown";
+  }
+  m_message = msg;
+  updateLabel();
+
+  m_plot->Refresh();
+}
+
+
+void DistributionWindow::updateLabel()
+{
+  if (m_ready) {
+    m_fitText->SetLabel(m_message);
+    return;
+  }
+
+  std::string const percent = std::to_string(std::min( \
+      static_cast<int>(m_progress * 100.0), 100)) + "%";
+  if (m_message.empty()) {
+    m_fitText->SetLabel("Binning... " + percent);
+  } else {
+    m_fitText->SetLabel("Estimated from a sample, binning... " + percent + \
+        " - " + m_message);
+  }
+}
+
+
+Distribution::fine_histogram_struct const & DistributionWindow::getShown(
+    int const subject) const
+{
+  return m_ready ? m_fine[subject] : m_preview[subject];
+}
+
+
+Distribution::power_law_struct const & DistributionWindow::getShownFit(
+    int const subject) const
+{
+  return m_ready ? m_fits[subject] : m_previewFits[subject];
+}
+
+
+void DistributionWindow::drawPlot(
+    wxDC & dc,
+    int const width,
+    int const height) const
+{
+  std::vector<double> const & edges = m_histogram.edges;
+  std::vector<index_type> const & counts = m_histogram.counts;
+  bool const logarithmic = m_scaleChoice->GetSelection() == LOG_LOG;
+  int const subject = m_subjectChoice->GetSelection();
+
+  // on a log-log scale plot the density, so a power law is a straight line
+  std::vector<double> heights(counts.size());
+  double maxHeight = 0;
+  double minHeight = 0;
+  for (size_t bin = 0; bin < counts.size(); ++bin) {
+    heights[bin] = static_cast<double>(counts[bin]);
+    if (logarithmic) {
+      heights[bin] /= (edges[bin+1] - edges[bin]);
+    }
+    if (counts[bin] > 0) {
+      maxHeight = std::max(maxHeight, heights[bin]);
+      minHeight = minHeight == 0 ? heights[bin] : \
+          std::min(minHeight, heights[bin]);
+    }
+  }
+  if (maxHeight == 0) {
+    return;
+  }
+
+  int const plotWidth = width - MARGIN_LEFT - MARGIN;
+  int const plotHeight = height - MARGIN_BOTTOM - MARGIN;
+  int const bottom = MARGIN + plotHeight;
+
+  Axis const xAxis(edges.front(), edges.back(), logarithmic, MARGIN_LEFT, \
+      plotWidth);
+  // grow the log scale down a bit, so the smallest bars are visible
+  double const yLow = logarithmic ? minHeight / 2.0 : 0;
+  Axis const yAxis(yLow, maxHeight, logarithmic, bottom, -plotHeight);
+
+  // bars
+  dc.SetPen(wxPen(wxColour(40, 80, 160)));
+  dc.SetBrush(wxBrush(wxColour(90, 140, 220)));
+  for (size_t bin = 0; bin < counts.size(); ++bin) {
+    if (counts[bin] == 0) {
+      continue;
+    }
+    int const left = xAxis.map(edges[bin]);
+    int const right = std::max(left+1, xAxis.map(edges[bin+1]));
+    int const top = yAxis.map(heights[bin]);
+    dc.DrawRectangle(left, top, right - left, bottom - top);
+  }
+
+  // the power law fit
+  Distribution::power_law_struct const & fit = getShownFit(subject);
+  if (logarithmic && fit.numTail > 0 && fit.xMin < edges.back()) {
+    double const base = fit.xMin - (getShown(subject).discrete ? 0.5 : 0.0);
+    double const coefficient = fit.numTail * (fit.alpha - 1.0) / base;
+    double const start = std::max(fit.xMin, edges.front());
+    double const end = edges.back();
+    dc.SetPen(wxPen(wxColour(200, 40, 40), 2));
+    dc.DrawLine(xAxis.map(start), \
+        yAxis.map(coefficient * std::pow(start / base, -fit.alpha)), \
+        xAxis.map(end), \
+        yAxis.map(coefficient * std::pow(end / base, -fit.alpha)));
+  }
+
+  // axes
+  dc.SetPen(*wxBLACK_PEN);
+  dc.DrawLine(MARGIN_LEFT, bottom, MARGIN_LEFT + plotWidth, bottom);
+  dc.DrawLine(MARGIN_LEFT, bottom, MARGIN_LEFT, MARGIN);
+  dc.DrawText(formatNumber(edges.front()), MARGIN_LEFT, bottom + 2);
+  std::string const xMax = formatNumber(edges.back());
+  dc.DrawText(xMax, MARGIN_LEFT + plotWidth - \
+      dc.GetTextExtent(xMax).GetWidth(), bottom + 2);
+  dc.DrawText(formatNumber(maxHeight), 2, MARGIN);
+  dc.DrawText(formatNumber(yLow), 2, bottom - \
+      dc.GetTextExtent("0").GetHeight());
+}
+
+
+void DistributionWindow::onTimer(
+    wxTimerEvent&)
+{
+  if (m_task.wait_for(std::chrono::seconds(0)) != \
+      std::future_status::ready) {
+    updateLabel();
+    return;
+  }
+
+  m_timer.Stop();
+
+  try {
+    m_task.get();
+    m_ready = true;
+    updateHistogram();
+  } catch (std::exception const & e) {
+    m_fitText->SetLabel(std::string("Error: ") + e.what());
+  }
+}
+
+
+void DistributionWindow::onPaint(
+    wxPaintEvent&)
+{
+  wxPaintDC dc(m_plot);
+  dc.SetBackground(*wxWHITE_BRUSH);
+  dc.Clear();
+
+  if (!m_histogram.counts.empty()) {
+    wxSize const size = m_plot->GetClientSize();
+    drawPlot(dc, size.GetWidth(), size.GetHeight());
+  }
+}
+
+
+void DistributionWindow::onSubjectSelected(
+    wxCommandEvent&)
+{
+  updateHistogram();
+}
+
+
+void DistributionWindow::onScaleSelected(
+    wxCommandEvent&)
+{
+  updateHistogram();
+}
+
+
+void DistributionWindow::onBinsChanged(
+    wxSpinEvent&)
+{
+  updateHistogram();
+}
+
+
+void DistributionWindow::onOK(
+    wxCommandEvent&)
+{
+  if (IsModal()) {
+    EndDialog(wxID_OK);
+  } else {
+    SetReturnCode(wxID_OK);
+    Show(false);
+  }
+}
+
+
+
+
+}
@@ -0,0 +1,188 @@
+/**
+ * @file DistributionWindow.hpp
+ * @brief The DistributionWindow class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_GUI_DISTRIBUTIONWINDOW_HPP
+#define MATRIXINSPECTOR_GUI_DISTRIBUTIONWINDOW_HPP
+
+
+
+#include <wx/wx.h>
+#include <wx/spinctrl.h>
+#include <wx/timer.h>
+#include <atomic>
+#include <future>
+#include <string>
+#include "Data/DataStorage.hpp"
+#include "Operations/Distribution.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+class DistributionWindow :
+  public wxDialog
+{
+  public:
+    enum subject_type {
+      ROW_DEGREES,
+      COLUMN_DEGREES,
+      VALUE_MAGNITUDES,
+      NUM_SUBJECTS
+    };
+
+
+    /**
+    * @brief Create a new distribution window. The distributions are binned
+    * in the background, and plotted once ready. Until then, those which can
+    * be are estimated from a sample.
+    *
+    * @param parent The parent frame.
+    * @param storage The storage containing the matrix.
+    */
+    DistributionWindow(
+        wxFrame * parent,
+        DataStorage * storage);
+
+
+    virtual ~DistributionWindow();
+
+
+  private:
+    DataStorage * m_storage;
+    wxChoice * m_subjectChoice;
+    wxChoice * m_scaleChoice;
+    wxSpinCtrl * m_binsSpin;
+    wxPanel * m_plot;
+    wxStaticText * m_fitText;
+    wxTimer m_timer;
+    // written by the background task, and only read once it is done
+    double m_progress;
+    bool m_ready;
+    // set when the window closes, to stop the background task early
+    std::atomic<bool> m_cancel;
+    std::future<void> m_task;
+    Distribution::fine_histogram_struct m_fine[NUM_SUBJECTS];
+    Distribution::power_law_struct m_fits[NUM_SUBJECTS];
+    // the distributions of a sample, shown until the exact ones are ready
+    Distribution::fine_histogram_struct m_preview[NUM_SUBJECTS];
+    Distribution::power_law_struct m_previewFits[NUM_SUBJECTS];
+    // the current re-bucketing of the selected distribution
+    Distribution::histogram_struct m_histogram;
+    // the description of the fit of the current histogram
+    std::string m_message;
+
+
+    wxDECLARE_EVENT_TABLE();
+
+
+    /**
+    * @brief Bin all of the distributions at their finest resolution.
+    */
+    void binAll();
+
+
+    /**
+    * @brief Re-bucket the selected distribution with the selected bins, and
+    * redraw it.
+    */
+    void updateHistogram();
+
+
+    /**
+    * @brief Show the description of the current histogram, along with the
+    * progress of the binning if it is not done.
+    */
+    void updateLabel();
+
+
+    /**
+    * @brief Get the distribution shown for a subject, which is the estimate
+    * until the exact one is ready.
+    *
+    * @param subject The subject.
+    *
+    * @return The distribution.
+    */
+    Distribution::fine_histogram_struct const & getShown(
+        int subject) const;
+
+
+    /**
+    * @brief Get the power law fit shown for a subject.
+    *
+    * @param subject The subject.
+    *
+    * @return The fit.
+    */
+    Distribution::power_law_struct const & getShownFit(
+        int subject) const;
+
+
+    /**
+    * @brief Draw the current histogram.
+    *
+    * @param dc The context to draw on.
+    * @param width The width of the plot area.
+    * @param height The height of the plot area.
+    */
+    void drawPlot(
+        wxDC & dc,
+        int width,
+        int height) const;
+
+
+    void onTimer(
+        wxTimerEvent& event);
+
+
+    void onPaint(
+        wxPaintEvent& event);
+
+
+    void onSubjectSelected(
+        wxCommandEvent& event);
+
+
+    void onScaleSelected(
+        wxCommandEvent& event);
+
+
+    void onBinsChanged(
+        wxSpinEvent& event);
+
+
+    void onOK(
+        wxCommandEvent& event);
+
+
+    // prevent copying
+    DistributionWindow(
+        DistributionWindow const & rhs);
+    DistributionWindow& operator=(
+        DistributionWindow const & rhs);
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
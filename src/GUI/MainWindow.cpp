@@ -13,14 +13,18 @@
 #include <future>
 #include <wx/progdlg.h>
 #include "MainWindow.hpp"
+#include "GUI/DistributionWindow.hpp"
 #include "GUI/ReorderWindow.hpp"
 #include "GUI/SampleWindow.hpp"
 #include "GUI/StatsWindow.hpp"
 #include "View/HeatMapView.hpp"
 #include "Operations/Reorder.hpp"
 #include "Operations/Sample.hpp"
+#include "Operations/StreamStats.hpp"
 #include "Utility/Debug.hpp"
+#include "Utility/Random.hpp"
 #include "Data/CSRMatrix.hpp"
+#include "Data/TripletReader.hpp"
 
 
 
@@ -41,15 +45,32 @@ namespace
 enum event_types {
   // file
   ID_OPEN,
+  ID_OPEN_SAMPLE,
+  ID_ANALYZE_FILE,
   ID_SAVE,
   ID_SAVEAS,
+  ID_PRECISION_FULL,
+  ID_PRECISION_HALF,
+  ID_PRECISION_BFLOAT16,
+  ID_PRECISION_LOG8,
   // edit
   ID_TRANSPOSE,
   ID_REORDER,
   ID_SAMPLE,
   // analyze 
   ID_STATS,
-  ID_DISTRIBUTION
+  ID_DISTRIBUTION,
+  // view
+  ID_COLORMAP_HEAT,
+  ID_COLORMAP_VIRIDIS,
+  ID_COLORMAP_GRAYSCALE,
+  ID_COLORMAP_LOG,
+  ID_MAX_POOLING,
+  ID_MODE_COUNT,
+  ID_MODE_SUM,
+  ID_MODE_MAX,
+  ID_MODE_MEAN,
+  ID_MODE_SIGNED
 };
 
 
@@ -69,6 +90,14 @@ const char * const SUPPORTED_TYPES_STRING = \
       "GRAPH / MATRIX (*.csr;*.graph;*.chaco;*.mtx;*.mm;*.snap)|" \
       "*.csr;*.graph;*.chaco;*.mtx;*.mm;*.snap";
 
+// the types which can be sampled or analyzed while they are read
+const char * const STREAM_TYPES_STRING = \
+      "GRAPH / MATRIX (*.graph;*.chaco;*.mtx;*.mm;*.snap)|" \
+      "*.graph;*.chaco;*.mtx;*.mm;*.snap";
+
+// the largest width and height of the heat map of an analyzed file
+dim_type const ANALYZE_HEATMAP_SIZE = 256;
+
 }
 
 
@@ -81,8 +110,14 @@ const char * const SUPPORTED_TYPES_STRING = \
 wxBEGIN_EVENT_TABLE(MainWindow, wxFrame)
   // File
   EVT_MENU(ID_OPEN, MainWindow::onOpen)
+  EVT_MENU(ID_OPEN_SAMPLE, MainWindow::onOpenSample)
+  EVT_MENU(ID_ANALYZE_FILE, MainWindow::onAnalyzeFile)
   EVT_MENU(ID_SAVE, MainWindow::onSave)
   EVT_MENU(ID_SAVEAS, MainWindow::onSaveAs)
+  EVT_MENU(ID_PRECISION_FULL, MainWindow::onPrecision)
+  EVT_MENU(ID_PRECISION_HALF, MainWindow::onPrecision)
+  EVT_MENU(ID_PRECISION_BFLOAT16, MainWindow::onPrecision)
+  EVT_MENU(ID_PRECISION_LOG8, MainWindow::onPrecision)
   EVT_MENU(wxID_EXIT, MainWindow::onExit)
   // Edit
   EVT_MENU(ID_TRANSPOSE, MainWindow::onTranspose)
@@ -90,6 +125,18 @@ wxBEGIN_EVENT_TABLE(MainWindow, wxFrame)
   EVT_MENU(ID_SAMPLE, MainWindow::onSample)
   // Analyze
   EVT_MENU(ID_STATS, MainWindow::onStats)
+  EVT_MENU(ID_DISTRIBUTION, MainWindow::onDistribution)
+  // View
+  EVT_MENU(ID_COLORMAP_HEAT, MainWindow::onColorMap)
+  EVT_MENU(ID_COLORMAP_VIRIDIS, MainWindow::onColorMap)
+  EVT_MENU(ID_COLORMAP_GRAYSCALE, MainWindow::onColorMap)
+  EVT_MENU(ID_COLORMAP_LOG, MainWindow::onColorMap)
+  EVT_MENU(ID_MAX_POOLING, MainWindow::onPooling)
+  EVT_MENU(ID_MODE_COUNT, MainWindow::onMode)
+  EVT_MENU(ID_MODE_SUM, MainWindow::onMode)
+  EVT_MENU(ID_MODE_MAX, MainWindow::onMode)
+  EVT_MENU(ID_MODE_MEAN, MainWindow::onMode)
+  EVT_MENU(ID_MODE_SIGNED, MainWindow::onMode)
 wxEND_EVENT_TABLE()
 
 
@@ -112,11 +159,29 @@ MainWindow::MainWindow(
   m_menuFile(nullptr),
   m_menuEdit(nullptr),
   m_menuAnalyze(nullptr),
+  m_menuView(nullptr),
   m_currentPath(),
+  m_valuePrecision(ValueArray::FULL_PRECISION),
   m_view(new HeatMapView(this))
 {
+  wxMenu * const menuPrecision = new wxMenu;
+  menuPrecision->AppendRadioItem(ID_PRECISION_FULL, "Full", \
+      "Store values at full precision.");
+  menuPrecision->AppendRadioItem(ID_PRECISION_HALF, "Half (fp16)", \
+      "Store values as IEEE half precision floats.");
+  menuPrecision->AppendRadioItem(ID_PRECISION_BFLOAT16, "BFloat16", \
+      "Store values as bfloat16.");
+  menuPrecision->AppendRadioItem(ID_PRECISION_LOG8, "Log magnitude (8 bit)", \
+      "Store only the sign and logarithmic magnitude of values.");
+
   m_menuFile = new wxMenu;
 	m_menuFile->Append(ID_OPEN, "&Open...\tCtrl-O", "Open a matrix.");
+  m_menuFile->Append(ID_OPEN_SAMPLE, "Open Sample...", \
+      "Open a sample of a matrix, without loading all of it.");
+  m_menuFile->Append(ID_ANALYZE_FILE, "Analyze File...", \
+      "View the statistics of a matrix, without loading it.");
+  m_menuFile->AppendSubMenu(menuPrecision, "Value Precision", \
+      "The precision to store values at when opening a matrix.");
 	m_menuFile->Append(ID_SAVE, "&Save...\tCtrl-S", "Save the current matrix.");
   m_menuFile->Enable(ID_SAVE,false);
 	m_menuFile->Append(ID_SAVEAS, "Save As...", "Save the current matrix.");
@@ -131,10 +196,34 @@ MainWindow::MainWindow(
   m_menuAnalyze = new wxMenu;
   m_menuAnalyze->Append(ID_STATS, "Statistics", \
       "View the statistics of the matrix.");
-  /*
   m_menuAnalyze->Append(ID_DISTRIBUTION, "Distribution", \
       "View the distribution of the matrix.");
-  */
+
+  m_menuView = new wxMenu;
+  m_menuView->AppendRadioItem(ID_COLORMAP_HEAT, "Heat", \
+      "Color the non-zeros from blue through red to white.");
+  m_menuView->AppendRadioItem(ID_COLORMAP_VIRIDIS, "Viridis", \
+      "Color the non-zeros from dark blue through green to yellow.");
+  m_menuView->AppendRadioItem(ID_COLORMAP_GRAYSCALE, "Grayscale", \
+      "Color the non-zeros from black to white.");
+  m_menuView->AppendSeparator();
+  m_menuView->AppendCheckItem(ID_COLORMAP_LOG, "Log Scale", \
+      "Space the colors by the logarithm of the number of non-zeros.");
+  m_menuView->AppendCheckItem(ID_MAX_POOLING, "Max Pooling", \
+      "When zoomed out, color by the densest pixel rather than the total, " \
+      "so that isolated non-zeros stay visible.");
+  m_menuView->AppendSeparator();
+  m_menuView->AppendRadioItem(ID_MODE_COUNT, "Count", \
+      "Color each pixel by the number of non-zeros in it.");
+  m_menuView->AppendRadioItem(ID_MODE_SUM, "Magnitude Sum", \
+      "Color each pixel by the total magnitude of its values.");
+  m_menuView->AppendRadioItem(ID_MODE_MAX, "Largest Magnitude", \
+      "Color each pixel by the largest magnitude of its values.");
+  m_menuView->AppendRadioItem(ID_MODE_MEAN, "Mean Magnitude", \
+      "Color each pixel by the average magnitude of its values.");
+  m_menuView->AppendRadioItem(ID_MODE_SIGNED, "Signed Sum", \
+      "Color each pixel by the total of its values, from blue for negative " \
+      "through white to red for positive.");
 
   m_menuBar = new wxMenuBar;
   m_menuBar->Append( m_menuFile, "&File" );
@@ -142,6 +231,7 @@ MainWindow::MainWindow(
   m_menuBar->EnableTop(1,false);
   m_menuBar->Append( m_menuAnalyze, "&Analyze" );
   m_menuBar->EnableTop(2,false);
+  m_menuBar->Append( m_menuView, "&View" );
   SetMenuBar( m_menuBar );
 
   CreateStatusBar(3);
@@ -156,12 +246,27 @@ MainWindow::MainWindow(
 
 void MainWindow::load(
     std::string const name)
+{
+  DataStorage::load_options_struct options{};
+  options.type = DataStorage::LOAD_ALL;
+
+  load(name, options);
+}
+
+
+void MainWindow::load(
+    std::string const name,
+    DataStorage::load_options_struct const & options)
 {
   try {
+    // the old matrix is about to be replaced
+    m_view->cancel();
+
     runTaskProgress("Loading", \
         std::string("Opening ") + name + std::string(" ..."),
         [&](double * const done) {
-          m_storage.loadDataset(name.c_str(), done);
+          m_storage.loadDataset(name.c_str(), options, done, \
+              m_valuePrecision);
         });
 
     updateMatrixSize();
@@ -275,6 +380,140 @@ void MainWindow::onOpen(
 }
 
 
+void MainWindow::onOpenSample(
+    wxCommandEvent&)
+{
+	wxFileDialog openFileDialog(this, _("Open Sample of Matrix/Graph"), "", \
+      "", STREAM_TYPES_STRING, wxFD_OPEN|wxFD_FILE_MUST_EXIST);
+
+	if (openFileDialog.ShowModal() == wxID_CANCEL) {
+		// user canceled
+		return;
+	}
+
+  std::string const filename(openFileDialog.GetPath().mb_str());
+
+  DataStorage::load_options_struct options{};
+
+  try {
+    // only the header is needed to choose the sample, unless there is none
+    TripletReader reader(filename.c_str());
+    if (!reader.hasDimensions()) {
+      runTaskProgress("Scanning", \
+          std::string("Scanning ") + filename + std::string(" ..."),
+          [&](double * const done) {
+            dim_type row, col;
+            value_type value;
+            while (reader.next(&row, &col, &value)) {
+              *done = reader.getProgress();
+            }
+          });
+    }
+
+    if (reader.getNumRows() == 0 || reader.getNumColumns() == 0) {
+      throw std::runtime_error("The matrix is empty.");
+    }
+
+    index_type numNonZeros = reader.getNumEntries();
+    if (reader.getSymmetry() != TripletReader::GENERAL) {
+      numNonZeros *= 2;
+    }
+
+    SampleWindow sw(this, reader.getNumRows(), reader.getNumColumns(), \
+        numNonZeros);
+
+    if (sw.ShowModal() == wxID_CANCEL) {
+      // user canceled
+      return;
+    }
+
+    SampleWindow::sample_struct const sample = sw.getOptions();
+    switch (sample.type) {
+      case SampleWindow::RANDOM:
+        options.type = DataStorage::LOAD_RANDOM;
+        options.numSampleRows = sample.numRandRows;
+        options.numSampleCols = sample.numRandCols;
+        options.symmetric = sample.symmetric;
+        options.seed = Random::randomSeed();
+        break;
+      case SampleWindow::THRESHOLD:
+        options.type = sample.threshType == SampleWindow::ROWS ? \
+            DataStorage::LOAD_THRESHOLD_ROWS : \
+            DataStorage::LOAD_THRESHOLD_COLUMNS;
+        options.minSize = sample.minSize;
+        options.maxSize = sample.maxSize;
+        break;
+    }
+  } catch (std::exception const & e) {
+    wxMessageDialog msg(this,std::string("Error: ") + e.what(), "", \
+        wxOK|wxICON_ERROR);
+    msg.ShowModal();
+    return;
+  }
+
+  load(filename, options);
+}
+
+
+void MainWindow::onAnalyzeFile(
+    wxCommandEvent&)
+{
+	wxFileDialog openFileDialog(this, _("Analyze Matrix/Graph"), "", "", \
+      STREAM_TYPES_STRING, wxFD_OPEN|wxFD_FILE_MUST_EXIST);
+
+	if (openFileDialog.ShowModal() == wxID_CANCEL) {
+		// user canceled
+		return;
+	}
+
+  std::string const filename(openFileDialog.GetPath().mb_str());
+
+  StreamStats::stream_stats_struct stats;
+  HeatMap heatmap;
+  try {
+    runTaskProgress("Analyzing", \
+        std::string("Analyzing ") + filename + std::string(" ..."),
+        [&](double * const done) {
+          stats = StreamStats::compute(filename.c_str(), &heatmap, \
+              ANALYZE_HEATMAP_SIZE, done, 1.0);
+        });
+  } catch (std::bad_alloc const & e) {
+    wxMessageDialog msg(this, "Not enough memory to analyze the matrix.", \
+        "", wxOK|wxICON_ERROR);
+    msg.ShowModal();
+    return;
+  } catch (std::exception const & e) {
+    wxMessageDialog msg(this,std::string("Error: ") + e.what(), "", \
+        wxOK|wxICON_ERROR);
+    msg.ShowModal();
+    return;
+  }
+
+  StatsWindow sw(this, stats, &heatmap);
+
+  sw.ShowModal();
+}
+
+
+void MainWindow::onPrecision(
+    wxCommandEvent& event)
+{
+  switch (event.GetId()) {
+    case ID_PRECISION_HALF:
+      m_valuePrecision = ValueArray::HALF_PRECISION;
+      break;
+    case ID_PRECISION_BFLOAT16:
+      m_valuePrecision = ValueArray::BFLOAT16_PRECISION;
+      break;
+    case ID_PRECISION_LOG8:
+      m_valuePrecision = ValueArray::LOG8_PRECISION;
+      break;
+    default:
+      m_valuePrecision = ValueArray::FULL_PRECISION;
+  }
+}
+
+
 void MainWindow::onSave(
     wxCommandEvent&)
 {
@@ -322,6 +561,10 @@ void MainWindow::onTranspose(
 
 
   try {
+    if (m_view) {
+      m_view->cancel();
+    }
+
     runTaskProgress("Transposing","Transposing matrix...",
         [&](double * done) { mat->transpose(done); });
 
@@ -362,6 +605,10 @@ void MainWindow::onReorder(
   ReorderWindow::reorder_struct options = rw.getOptions();
 
   try {
+    if (m_view) {
+      m_view->cancel();
+    }
+
     runTaskProgress("Reordering","Reordering matrix...",
         [&](double * done) {
           switch (options.type) {
@@ -425,6 +672,10 @@ void MainWindow::onSample(
   SampleWindow::sample_struct options = sw.getOptions();
 
   try {
+    if (m_view) {
+      m_view->cancel();
+    }
+
     runTaskProgress("Sampling","Sampling matrix...",
         [&](double * done) {
           switch (options.type) {
@@ -441,6 +692,29 @@ void MainWindow::onSample(
                     options.maxSize,done);
               }
               break;
+            case SampleWindow::GRAPH:
+              switch (options.graphType) {
+                case SampleWindow::RANDOM_WALK:
+                  Sample::randomWalk(mat, options.numVertices, \
+                      options.probability, Random::randomSeed(), done);
+                  break;
+                case SampleWindow::FOREST_FIRE:
+                  Sample::forestFire(mat, options.numVertices, \
+                      options.probability, Random::randomSeed(), done);
+                  break;
+                case SampleWindow::NEIGHBORHOOD:
+                  Sample::neighborhood(mat, options.seeds.data(), \
+                      options.seeds.size(), options.numHops, done);
+                  break;
+              }
+              break;
+            case SampleWindow::WEIGHTED:
+              Sample::weighted(mat, options.numWeightRows, \
+                  options.numWeightCols, \
+                  options.rowKeys.empty() ? nullptr : options.rowKeys.data(), \
+                  options.colKeys.empty() ? nullptr : options.colKeys.data(), \
+                  options.symmetric, Random::randomSeed(), done);
+              break;
           }
         });
 
@@ -465,34 +739,70 @@ void MainWindow::onSample(
 void MainWindow::onStats(
     wxCommandEvent&)
 {
-  Matrix * const mat = m_storage.getMatrix();
+  // statistics which are not known are estimated, and computed in the
+  // background by the window
+  StatsWindow sw(this, &m_storage);
 
-  try {
-    if (!mat->isStatsSet()) {
-      runTaskProgress("Statistics","Computing matrix statistics...",
-          [&](double * done) {
-            if (mat->isSymmetrySet()) {
-              mat->computeSymmetry(done, 0.6);
-              mat->computeStats(done, 0.4);
-            } else {
-              mat->computeStats(done, 1.0);
-            }
-          });
-    }
-  } catch (std::bad_alloc const & e) {
-    wxMessageDialog msg(this, \
-        "Not enough memory to perform stats operation.", "", \
-        wxOK|wxICON_ERROR);
-    msg.ShowModal();
-  } catch (std::exception const & e) {
-    wxMessageDialog msg(this,std::string("Error: ") + e.what(), "", \
-        wxOK|wxICON_ERROR);
-    msg.ShowModal();
+  sw.ShowModal();
+}
+
+
+void MainWindow::onDistribution(
+    wxCommandEvent&)
+{
+  DistributionWindow dw(this, &m_storage);
+
+  dw.ShowModal();
+}
+
+
+void MainWindow::onColorMap(
+    wxCommandEvent&)
+{
+  ColorMap::colormap_type type = ColorMap::HEAT;
+  if (m_menuView->IsChecked(ID_COLORMAP_VIRIDIS)) {
+    type = ColorMap::VIRIDIS;
+  } else if (m_menuView->IsChecked(ID_COLORMAP_GRAYSCALE)) {
+    type = ColorMap::GRAYSCALE;
   }
 
-  StatsWindow sw(this, &m_storage);
+  ColorMap::scale_type const scale = m_menuView->IsChecked(ID_COLORMAP_LOG) ? \
+      ColorMap::LOG_SCALE : ColorMap::LINEAR_SCALE;
 
-  sw.ShowModal();
+  m_view->setColorMap(ColorMap(type, scale));
+}
+
+
+void MainWindow::onPooling(
+    wxCommandEvent&)
+{
+  m_view->setPooling(m_menuView->IsChecked(ID_MAX_POOLING) ? \
+      HeatMap::MAX_POOL : HeatMap::SUM_POOL);
+}
+
+
+void MainWindow::onMode(
+    wxCommandEvent& event)
+{
+  HeatMap::mode_type mode;
+  switch (event.GetId()) {
+    case ID_MODE_SUM:
+      mode = HeatMap::SUM_MODE;
+      break;
+    case ID_MODE_MAX:
+      mode = HeatMap::MAX_MODE;
+      break;
+    case ID_MODE_MEAN:
+      mode = HeatMap::MEAN_MODE;
+      break;
+    case ID_MODE_SIGNED:
+      mode = HeatMap::SIGNED_SUM_MODE;
+      break;
+    default:
+      mode = HeatMap::COUNT_MODE;
+  }
+
+  m_view->setMode(mode);
 }
 
 
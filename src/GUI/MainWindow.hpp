@@ -66,6 +66,17 @@ class MainWindow :
         std::string name);
 
 
+    /**
+    * @brief Load a reduced matrix from the given file.
+    *
+    * @param name The name of the file.
+    * @param options The reduction to apply while loading.
+    */
+    void load(
+        std::string name,
+        DataStorage::load_options_struct const & options);
+
+
 
   private:
     DataStorage m_storage;
@@ -74,7 +85,9 @@ class MainWindow :
     wxMenu * m_menuFile;
     wxMenu * m_menuEdit;
     wxMenu * m_menuAnalyze;
+    wxMenu * m_menuView;
     std::string m_currentPath;
+    ValueArray::precision_type m_valuePrecision;
     std::unique_ptr<View> m_view;
 
 
@@ -117,6 +130,33 @@ class MainWindow :
         wxCommandEvent& event);
 
 
+    /**
+    * @brief Handle the 'open sample' event.
+    *
+    * @param event The event.
+    */
+    void onOpenSample(
+        wxCommandEvent& event);
+
+
+    /**
+    * @brief Handle the 'analyze file' event.
+    *
+    * @param event The event.
+    */
+    void onAnalyzeFile(
+        wxCommandEvent& event);
+
+
+    /**
+    * @brief Handle the selection of a value precision.
+    *
+    * @param event The event.
+    */
+    void onPrecision(
+        wxCommandEvent& event);
+
+
     /**
     * @brief Handle the 'save' event.
     *
@@ -177,6 +217,44 @@ class MainWindow :
         wxCommandEvent& event);
 
 
+    /**
+    * @brief Handle the 'distribution' event.
+    *
+    * @param event The event.
+    */
+    void onDistribution(
+        wxCommandEvent& event);
+
+/* VIEW **********************************************************************/
+
+
+    /**
+    * @brief Handle the selection of a color map or scale.
+    *
+    * @param event The event.
+    */
+    void onColorMap(
+        wxCommandEvent& event);
+
+
+    /**
+    * @brief Handle the selection of how zoomed out pixels are pooled.
+    *
+    * @param event The event.
+    */
+    void onPooling(
+        wxCommandEvent& event);
+
+
+    /**
+    * @brief Handle the selection of what each pixel is made of.
+    *
+    * @param event The event.
+    */
+    void onMode(
+        wxCommandEvent& event);
+
+
     wxDECLARE_EVENT_TABLE();
 
     // disable copying
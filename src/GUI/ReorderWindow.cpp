@@ -132,8 +132,7 @@ ReorderWindow::ReorderWindow(
   m_randomChoice->Disable();
 
   // generate random number
-  Random::setSeed();
-  m_seed = Random::inRange(0U,UINT_MAX);
+  m_seed = static_cast<unsigned int>(Random::randomSeed());
   wxIntegerValidator<unsigned int> val(&m_seed);
   m_seedText = new wxTextCtrl(this, wxID_ANY, std::to_string(m_seed), \
       wxDefaultPosition, wxDefaultSize, 0, val);
@@ -9,6 +9,10 @@
 
 
 
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include "SampleWindow.hpp"
 #include "GUI/WindowProperties.hpp"
 #include "Data/CSRMatrix.hpp"
@@ -37,7 +41,15 @@ enum event_types {
   ID_RAND_COL_CHECK,
   // threshold
   ID_THRESHOLD,
-  ID_THRESH_SUBJECT
+  ID_THRESH_SUBJECT,
+  // graph
+  ID_GRAPH,
+  ID_GRAPH_METHOD,
+  // weighted
+  ID_WEIGHTED,
+  ID_WEIGHT_SYM,
+  ID_ROW_WEIGHTS,
+  ID_COL_WEIGHTS
 };
 
 
@@ -51,6 +63,94 @@ enum cond_types {
 }
 
 
+
+
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+double const DEFAULT_RESTART_PROBABILITY = 0.15;
+double const DEFAULT_BURN_PROBABILITY = 0.7;
+
+// the burn probability gives a mean of p/(1-p) neighbors burnt, so must be
+// kept below one
+double const MAX_PROBABILITY = 0.99;
+
+dim_type const DEFAULT_NUM_HOPS = 2;
+
+char const * const DEGREE_WEIGHTS_STRING = "number of non-zeros";
+
+}
+
+
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+
+/**
+* @brief Format a probability as its validator does.
+*
+* @param probability The probability.
+*
+* @return The formatted probability.
+*/
+std::string formatProbability(
+    double const probability)
+{
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(2) << probability;
+  return stream.str();
+}
+
+
+/**
+* @brief Parse a list of rows separated by commas.
+*
+* @param str The string to parse.
+* @param numRows The number of rows in the matrix.
+* @param rows The rows (output).
+*
+* @return False if the string is not a list of rows in the matrix.
+*/
+bool parseRows(
+    std::string const & str,
+    dim_type const numRows,
+    std::vector<dim_type> * const rows)
+{
+  rows->clear();
+  for (std::string const & part : String::split(str, ",")) {
+    size_t end;
+    unsigned long row;
+    try {
+      row = std::stoul(part, &end);
+    } catch (std::exception const &) {
+      return false;
+    }
+    if (part.find_first_not_of(" \t", end) != std::string::npos || \
+        row >= numRows) {
+      return false;
+    }
+    rows->emplace_back(static_cast<dim_type>(row));
+  }
+
+  return !rows->empty();
+}
+
+
+}
+
+
 /******************************************************************************
 * MACROS **********************************************************************
 ******************************************************************************/
@@ -61,6 +161,12 @@ wxBEGIN_EVENT_TABLE(SampleWindow, wxDialog)
   EVT_CHECKBOX(ID_RAND_ROW_CHECK, SampleWindow::onRandomRowChecked)
   EVT_CHECKBOX(ID_RAND_COL_CHECK, SampleWindow::onRandomColChecked)
   EVT_CHOICE(ID_THRESH_SUBJECT, SampleWindow::onThresholdSubjectSelected)
+  EVT_RADIOBUTTON(ID_GRAPH, SampleWindow::onGraphSelected)
+  EVT_CHOICE(ID_GRAPH_METHOD, SampleWindow::onGraphMethodSelected)
+  EVT_RADIOBUTTON(ID_WEIGHTED, SampleWindow::onWeightedSelected)
+  EVT_CHECKBOX(ID_WEIGHT_SYM, SampleWindow::onWeightSymChecked)
+  EVT_BUTTON(ID_ROW_WEIGHTS, SampleWindow::onRowWeightButton)
+  EVT_BUTTON(ID_COL_WEIGHTS, SampleWindow::onColWeightButton)
   EVT_BUTTON(wxID_OK, SampleWindow::onOK)
   EVT_BUTTON(wxID_CANCEL, SampleWindow::onCancel)
 wxEND_EVENT_TABLE()
@@ -75,9 +181,28 @@ wxEND_EVENT_TABLE()
 SampleWindow::SampleWindow(
     wxFrame * const parent,
     DataStorage * const storage) :
+  SampleWindow(parent, storage->getMatrix()->getNumRows(), \
+      storage->getMatrix()->getNumColumns(), \
+      dynamic_cast<CSRMatrix const *>(storage->getMatrix())->getNumNonZeros())
+{
+  // graphs and weights can only be sampled once loaded
+  m_weightedRadio->Enable();
+  if (storage->getMatrix()->isSquare()) {
+    m_graphRadio->Enable();
+  }
+}
+
+
+SampleWindow::SampleWindow(
+    wxFrame * const parent,
+    dim_type const numRows,
+    dim_type const numCols,
+    index_type const numNZ) :
   wxDialog(parent, wxID_ANY, "Sample", wxDefaultPosition, wxDefaultSize),
-  m_options{RANDOM,false,0,0,ROWS,0,0},
-  m_storage(storage),
+  m_options{RANDOM,false,0,0,ROWS,0,0,RANDOM_WALK,0, \
+      DEFAULT_RESTART_PROBABILITY,{},DEFAULT_NUM_HOPS,0,0,{},{}},
+  m_numRows(numRows),
+  m_numCols(numCols),
   m_randomRadio(nullptr),
   m_randRowCheck(nullptr),
   m_randRowText(nullptr),
@@ -91,16 +216,28 @@ SampleWindow::SampleWindow(
   m_threshRowText(nullptr),
   m_threshColText(nullptr),
   m_threshNNZRows(0),
-  m_threshNNZCols(0)
+  m_threshNNZCols(0),
+  m_graphRadio(nullptr),
+  m_graphChoice(nullptr),
+  m_graphSizeText(nullptr),
+  m_probabilityLabel(nullptr),
+  m_probabilityText(nullptr),
+  m_seedsText(nullptr),
+  m_hopsText(nullptr),
+  m_graphNumVertices(0),
+  m_graphProbability(DEFAULT_RESTART_PROBABILITY),
+  m_graphNumHops(DEFAULT_NUM_HOPS),
+  m_weightedRadio(nullptr),
+  m_weightRowText(nullptr),
+  m_weightColText(nullptr),
+  m_weightSym(nullptr),
+  m_rowWeightButton(nullptr),
+  m_rowWeightText(nullptr),
+  m_colWeightButton(nullptr),
+  m_colWeightText(nullptr),
+  m_weightNumRows(0),
+  m_weightNumCols(0)
 {
-  CSRMatrix const * const mat = \
-      dynamic_cast<const CSRMatrix*>(m_storage->getMatrix());
-  ASSERT_NOTNULL(mat);
-
-  dim_type const numRows = mat->getNumRows();
-  dim_type const numCols = mat->getNumColumns();
-  index_type const numNZ = mat->getNumNonZeros();
-
   wxBoxSizer * allSizer = new wxBoxSizer(wxVERTICAL);
 
   wxArrayString threshSubjects;
@@ -111,15 +248,27 @@ SampleWindow::SampleWindow(
   threshOpts.Add("more than");
   threshOpts.Add("less than");
 
+  wxArrayString graphMethods;
+  graphMethods.Add("Random walk");
+  graphMethods.Add("Forest fire");
+  graphMethods.Add("Neighborhood");
+
   // set initial values
   m_randNumRows = numRows/2;
   m_randNumCols = numCols/2;
   m_threshNNZRows = numNZ / numRows;
   m_threshNNZCols = numNZ / numCols;
+  m_graphNumVertices = std::max<dim_type>(1, numRows/10);
+  m_weightNumRows = std::max<dim_type>(1, numRows/10);
+  m_weightNumCols = std::max<dim_type>(1, numCols/10);
 
   // build radio buttons
   m_randomRadio = new wxRadioButton(this,ID_RANDOM,"Random");
   m_thresholdRadio = new wxRadioButton(this,ID_THRESHOLD,"Threshold");
+  m_graphRadio = new wxRadioButton(this,ID_GRAPH,"Graph");
+  m_graphRadio->Disable();
+  m_weightedRadio = new wxRadioButton(this,ID_WEIGHTED,"Weighted");
+  m_weightedRadio->Disable();
 
   // random sampling options
   wxBoxSizer * randSizer = new wxBoxSizer(wxVERTICAL);
@@ -205,6 +354,106 @@ SampleWindow::SampleWindow(
   threshSizer->Add(horThreshSizer);
   allSizer->Add(threshSizer);
 
+  // graph sampling
+  wxBoxSizer * graphSizer = new wxBoxSizer(wxVERTICAL);
+  graphSizer->Add(m_graphRadio);
+
+  wxBoxSizer * horGraphSizer = new wxBoxSizer(wxHORIZONTAL);
+  m_graphChoice = new wxChoice(this,ID_GRAPH_METHOD,wxDefaultPosition, \
+      wxDefaultSize,graphMethods);
+  m_graphChoice->SetSelection(RANDOM_WALK);
+  horGraphSizer->Add(m_graphChoice);
+  wxIntegerValidator<dim_type> graphSizeVal(&m_graphNumVertices);
+  graphSizeVal.SetRange(1,numRows);
+  m_graphSizeText = new wxTextCtrl(this, wxID_ANY, \
+      std::to_string(m_graphNumVertices), wxDefaultPosition, wxDefaultSize, \
+      wxTE_RIGHT, graphSizeVal);
+  horGraphSizer->Add(m_graphSizeText);
+  horGraphSizer->Add(new wxStaticText(this,wxID_ANY,std::string("/") + \
+      String::addThousandsSeparators(numRows) + " vertices"), 0, \
+      wxALIGN_CENTER_VERTICAL, BORDER);
+  graphSizer->Add(horGraphSizer);
+
+  wxBoxSizer * horProbSizer = new wxBoxSizer(wxHORIZONTAL);
+  m_probabilityLabel = new wxStaticText(this,wxID_ANY,"Restart probability");
+  horProbSizer->Add(m_probabilityLabel, 0, wxALIGN_CENTER_VERTICAL, BORDER);
+  wxFloatingPointValidator<double> probVal(2, &m_graphProbability);
+  probVal.SetRange(0, MAX_PROBABILITY);
+  m_probabilityText = new wxTextCtrl(this, wxID_ANY, \
+      formatProbability(m_graphProbability), \
+      wxDefaultPosition, wxDefaultSize, wxTE_RIGHT, probVal);
+  horProbSizer->Add(m_probabilityText);
+  graphSizer->Add(horProbSizer);
+
+  // the rows of the matrix are the vertices of the graph
+  wxBoxSizer * horSeedSizer = new wxBoxSizer(wxHORIZONTAL);
+  horSeedSizer->Add(new wxStaticText(this,wxID_ANY,"Seed rows"), 0, \
+      wxALIGN_CENTER_VERTICAL, BORDER);
+  m_seedsText = new wxTextCtrl(this, wxID_ANY, "0");
+  m_seedsText->SetToolTip("The rows to start from, counting from 0 and " \
+      "separated by commas");
+  horSeedSizer->Add(m_seedsText);
+  horSeedSizer->Add(new wxStaticText(this,wxID_ANY,"within"), 0, \
+      wxALIGN_CENTER_VERTICAL, BORDER);
+  wxIntegerValidator<dim_type> hopsVal(&m_graphNumHops);
+  hopsVal.SetRange(0,numRows);
+  m_hopsText = new wxTextCtrl(this, wxID_ANY, \
+      std::to_string(m_graphNumHops), wxDefaultPosition, wxDefaultSize, \
+      wxTE_RIGHT, hopsVal);
+  horSeedSizer->Add(m_hopsText);
+  horSeedSizer->Add(new wxStaticText(this,wxID_ANY,"hops"), 0, \
+      wxALIGN_CENTER_VERTICAL, BORDER);
+  graphSizer->Add(horSeedSizer);
+
+  allSizer->Add(graphSizer);
+
+  // weighted sampling
+  wxBoxSizer * weightSizer = new wxBoxSizer(wxVERTICAL);
+  weightSizer->Add(m_weightedRadio);
+
+  wxBoxSizer * horWeightRowSizer = new wxBoxSizer(wxHORIZONTAL);
+  horWeightRowSizer->Add(new wxStaticText(this,wxID_ANY,"Rows"), 0, \
+      wxALIGN_CENTER_VERTICAL, BORDER);
+  wxIntegerValidator<dim_type> weightRowVal(&m_weightNumRows);
+  weightRowVal.SetRange(1,numRows);
+  m_weightRowText = new wxTextCtrl(this, wxID_ANY, \
+      std::to_string(m_weightNumRows), wxDefaultPosition, wxDefaultSize, \
+      wxTE_RIGHT, weightRowVal);
+  horWeightRowSizer->Add(m_weightRowText);
+  horWeightRowSizer->Add(new wxStaticText(this,wxID_ANY,std::string("/") + \
+      String::addThousandsSeparators(numRows) + " weighted by"), 0, \
+      wxALIGN_CENTER_VERTICAL, BORDER);
+  m_rowWeightText = new wxTextCtrl(this, wxID_ANY, DEGREE_WEIGHTS_STRING, \
+      wxDefaultPosition, wxDefaultSize, wxTE_READONLY);
+  horWeightRowSizer->Add(m_rowWeightText);
+  m_rowWeightButton = new wxButton(this, ID_ROW_WEIGHTS, "Browse");
+  horWeightRowSizer->Add(m_rowWeightButton);
+  weightSizer->Add(horWeightRowSizer);
+
+  m_weightSym = new wxCheckBox(this,ID_WEIGHT_SYM,"Same rows and columns");
+  weightSizer->Add(m_weightSym);
+
+  wxBoxSizer * horWeightColSizer = new wxBoxSizer(wxHORIZONTAL);
+  horWeightColSizer->Add(new wxStaticText(this,wxID_ANY,"Columns"), 0, \
+      wxALIGN_CENTER_VERTICAL, BORDER);
+  wxIntegerValidator<dim_type> weightColVal(&m_weightNumCols);
+  weightColVal.SetRange(1,numCols);
+  m_weightColText = new wxTextCtrl(this, wxID_ANY, \
+      std::to_string(m_weightNumCols), wxDefaultPosition, wxDefaultSize, \
+      wxTE_RIGHT, weightColVal);
+  horWeightColSizer->Add(m_weightColText);
+  horWeightColSizer->Add(new wxStaticText(this,wxID_ANY,std::string("/") + \
+      String::addThousandsSeparators(numCols) + " weighted by"), 0, \
+      wxALIGN_CENTER_VERTICAL, BORDER);
+  m_colWeightText = new wxTextCtrl(this, wxID_ANY, DEGREE_WEIGHTS_STRING, \
+      wxDefaultPosition, wxDefaultSize, wxTE_READONLY);
+  horWeightColSizer->Add(m_colWeightText);
+  m_colWeightButton = new wxButton(this, ID_COL_WEIGHTS, "Browse");
+  horWeightColSizer->Add(m_colWeightButton);
+  weightSizer->Add(horWeightColSizer);
+
+  allSizer->Add(weightSizer);
+
   // setup dialog buttons
   wxBoxSizer * bottomSizer = new wxBoxSizer(wxHORIZONTAL);
   bottomSizer->Add(new wxButton(this, wxID_OK, "Sample"), BORDER);
@@ -216,6 +465,8 @@ SampleWindow::SampleWindow(
   // select random radio button
   assert(m_randomRadio->GetValue());
   activateRandom(true);
+  activateGraph(false);
+  activateWeighted(false);
 }
 
 
@@ -282,6 +533,88 @@ void SampleWindow::activateThreshold(
 }
 
 
+void SampleWindow::activateGraph(
+    bool const active)
+{
+  if (active) {
+    bool const search = m_graphChoice->GetSelection() == NEIGHBORHOOD;
+    m_graphChoice->Enable();
+    m_graphSizeText->Enable(!search);
+    m_probabilityText->Enable(!search);
+    m_seedsText->Enable(search);
+    m_hopsText->Enable(search);
+  } else {
+    m_graphChoice->Disable();
+    m_graphSizeText->Disable();
+    m_probabilityText->Disable();
+    m_seedsText->Disable();
+    m_hopsText->Disable();
+  }
+}
+
+
+void SampleWindow::activateWeighted(
+    bool const active)
+{
+  if (active) {
+    bool const symmetric = m_weightSym->GetValue();
+    m_weightRowText->Enable();
+    m_rowWeightText->Enable();
+    m_rowWeightButton->Enable();
+    m_weightSym->Enable(m_numRows == m_numCols);
+    m_weightColText->Enable(!symmetric);
+    m_colWeightText->Enable(!symmetric);
+    m_colWeightButton->Enable(!symmetric);
+  } else {
+    m_weightRowText->Disable();
+    m_rowWeightText->Disable();
+    m_rowWeightButton->Disable();
+    m_weightSym->Disable();
+    m_weightColText->Disable();
+    m_colWeightText->Disable();
+    m_colWeightButton->Disable();
+  }
+}
+
+
+void SampleWindow::loadWeights(
+    dim_type const numKeys,
+    std::string const & dimName,
+    std::vector<value_type> * const keys,
+    wxTextCtrl * const text)
+{
+  wxFileDialog fileDialog(this, _("Open weights"), "", "", \
+      "Weights (*.txt)|*.txt|All files (*)|*", \
+      wxFD_OPEN|wxFD_FILE_MUST_EXIST);
+
+  if (fileDialog.ShowModal() == wxID_CANCEL) {
+    // user canceled
+    return;
+  }
+
+  std::string const filename = fileDialog.GetPath().ToStdString();
+  try {
+    *keys = DataStorage::loadVector(filename.c_str());
+
+    // make sure it's the proper size
+    if (keys->size() != numKeys) {
+      throw std::runtime_error(std::string("Weight file has ") + \
+          std::to_string(keys->size()) + std::string(" values and matrix " \
+          "has ") + std::to_string(numKeys) + " " + dimName + ".");
+    }
+
+    text->ChangeValue(filename);
+  } catch (std::exception const & e) {
+    wxMessageDialog errMsg(this,e.what(),"Error",wxOK|wxICON_ERROR);
+    errMsg.ShowModal();
+
+    // go back to weighting by non-zeros
+    keys->clear();
+    text->ChangeValue(DEGREE_WEIGHTS_STRING);
+  }
+}
+
+
 void SampleWindow::onRandomRowChecked(
     wxCommandEvent&)
 {
@@ -326,6 +659,8 @@ void SampleWindow::onRandomSelected(
 {
   activateRandom(true);
   activateThreshold(false);
+  activateGraph(false);
+  activateWeighted(false);
 
   m_options.type = RANDOM;
 }
@@ -336,21 +671,87 @@ void SampleWindow::onThresholdSelected(
 {
   activateRandom(false);
   activateThreshold(true);
+  activateGraph(false);
+  activateWeighted(false);
 
   m_options.type = THRESHOLD;
 }
 
 
-void SampleWindow::onOK(
+void SampleWindow::onGraphSelected(
+    wxCommandEvent&)
+{
+  activateRandom(false);
+  activateThreshold(false);
+  activateGraph(true);
+  activateWeighted(false);
+
+  m_options.type = GRAPH;
+}
+
+
+void SampleWindow::onWeightedSelected(
     wxCommandEvent&)
 {
-  // get matrix info
-  CSRMatrix const * const mat = \
-      dynamic_cast<const CSRMatrix*>(m_storage->getMatrix());
-  ASSERT_NOTNULL(mat);
+  activateRandom(false);
+  activateThreshold(false);
+  activateGraph(false);
+  activateWeighted(true);
+
+  m_options.type = WEIGHTED;
+}
 
-  dim_type const numRows = mat->getNumRows();
-  dim_type const numCols = mat->getNumColumns();
+
+void SampleWindow::onWeightSymChecked(
+    wxCommandEvent&)
+{
+  activateWeighted(true);
+}
+
+
+void SampleWindow::onRowWeightButton(
+    wxCommandEvent&)
+{
+  loadWeights(m_numRows, "rows", &m_options.rowKeys, m_rowWeightText);
+}
+
+
+void SampleWindow::onColWeightButton(
+    wxCommandEvent&)
+{
+  loadWeights(m_numCols, "columns", &m_options.colKeys, m_colWeightText);
+}
+
+
+void SampleWindow::onGraphMethodSelected(
+    wxCommandEvent&)
+{
+  // each method has its own meaning of the probability
+  int const method = m_graphChoice->GetSelection();
+  switch (method) {
+    case RANDOM_WALK:
+      m_probabilityLabel->SetLabel("Restart probability");
+      m_graphProbability = DEFAULT_RESTART_PROBABILITY;
+      break;
+    case FOREST_FIRE:
+      m_probabilityLabel->SetLabel("Burn probability");
+      m_graphProbability = DEFAULT_BURN_PROBABILITY;
+      break;
+    default:
+      // a neighborhood has no probability
+      break;
+  }
+  m_probabilityText->ChangeValue(formatProbability(m_graphProbability));
+
+  activateGraph(true);
+}
+
+
+void SampleWindow::onOK(
+    wxCommandEvent&)
+{
+  dim_type const numRows = m_numRows;
+  dim_type const numCols = m_numCols;
 
   // attempt to validate input
   if (!this->Validate() || !this->TransferDataFromWindow()) {
@@ -358,6 +759,18 @@ void SampleWindow::onOK(
     return;
   }
 
+  if (m_options.type == GRAPH && \
+      m_graphChoice->GetSelection() == NEIGHBORHOOD) {
+    std::string const seeds(m_seedsText->GetValue().mb_str());
+    if (!parseRows(seeds, numRows, &m_options.seeds)) {
+      wxMessageDialog msg(this, "The seed rows must be numbers from 0 to " + \
+          std::to_string(numRows-1) + ", separated by commas.", "", \
+          wxOK|wxICON_ERROR);
+      msg.ShowModal();
+      return;
+    }
+  }
+
   // set reorder struct properties
   if (IsModal()) {
     EndDialog(wxID_OK);
@@ -399,6 +812,18 @@ void SampleWindow::onOK(
         }
       }
       break;
+    case GRAPH:
+      m_options.graphType = m_graphChoice->GetSelection();
+      m_options.numVertices = m_graphNumVertices;
+      m_options.probability = m_graphProbability;
+      m_options.numHops = m_graphNumHops;
+      break;
+    case WEIGHTED:
+      m_options.symmetric = m_weightSym->GetValue();
+      m_options.numWeightRows = m_weightNumRows;
+      m_options.numWeightCols = m_options.symmetric ? m_weightNumRows : \
+          m_weightNumCols;
+      break;
     default:
       assert(false);
   }
@@ -19,6 +19,7 @@
 #include <wx/wx.h>
 #include <wx/textctrl.h>
 #include <wx/valnum.h>
+#include <string>
 #include <vector>
 #include "Data/DataStorage.hpp"
 
@@ -34,7 +35,9 @@ class SampleWindow :
   public:
     enum sample_type {
       RANDOM,
-      THRESHOLD
+      THRESHOLD,
+      GRAPH,
+      WEIGHTED
     };
 
 
@@ -44,6 +47,13 @@ class SampleWindow :
     };
 
 
+    enum graph_type {
+      RANDOM_WALK = 0,
+      FOREST_FIRE = 1,
+      NEIGHBORHOOD = 2
+    };
+
+
     struct sample_struct {
       int type;
       bool symmetric;
@@ -54,14 +64,50 @@ class SampleWindow :
       int threshType;
       dim_type minSize;
       dim_type maxSize;
+      // graph
+      int graphType;
+      dim_type numVertices;
+      // the restart probability of a random walk, or the burn probability of
+      // a forest fire
+      double probability;
+      std::vector<dim_type> seeds;
+      dim_type numHops;
+      // weighted, where rows and columns without keys are weighted by their
+      // number of non-zeros
+      dim_type numWeightRows;
+      dim_type numWeightCols;
+      std::vector<value_type> rowKeys;
+      std::vector<value_type> colKeys;
     };
 
 
+    /**
+    * @brief Create a sample window for a loaded matrix. Square matrices can
+    * also be sampled as graphs.
+    *
+    * @param parent The parent window.
+    * @param storage The storage of the matrix.
+    */
     SampleWindow(
         wxFrame * parent,
         DataStorage * storage);
 
 
+    /**
+    * @brief Create a sample window for a matrix which has not been loaded.
+    *
+    * @param parent The parent window.
+    * @param numRows The number of rows in the matrix.
+    * @param numCols The number of columns in the matrix.
+    * @param numNonZeros The (approximate) number of non-zeros in the matrix.
+    */
+    SampleWindow(
+        wxFrame * parent,
+        dim_type numRows,
+        dim_type numCols,
+        index_type numNonZeros);
+
+
     virtual ~SampleWindow();
 
 
@@ -70,7 +116,8 @@ class SampleWindow :
 
   private:
     sample_struct m_options;
-    DataStorage * m_storage;
+    dim_type m_numRows;
+    dim_type m_numCols;
 
     // random controls
     wxRadioButton * m_randomRadio;
@@ -90,6 +137,30 @@ class SampleWindow :
     dim_type m_threshNNZRows;
     dim_type m_threshNNZCols;
 
+    // graph controls
+    wxRadioButton * m_graphRadio;
+    wxChoice * m_graphChoice;
+    wxTextCtrl * m_graphSizeText;
+    wxStaticText * m_probabilityLabel;
+    wxTextCtrl * m_probabilityText;
+    wxTextCtrl * m_seedsText;
+    wxTextCtrl * m_hopsText;
+    dim_type m_graphNumVertices;
+    double m_graphProbability;
+    dim_type m_graphNumHops;
+
+    // weighted controls
+    wxRadioButton * m_weightedRadio;
+    wxTextCtrl * m_weightRowText;
+    wxTextCtrl * m_weightColText;
+    wxCheckBox * m_weightSym;
+    wxButton * m_rowWeightButton;
+    wxTextCtrl * m_rowWeightText;
+    wxButton * m_colWeightButton;
+    wxTextCtrl * m_colWeightText;
+    dim_type m_weightNumRows;
+    dim_type m_weightNumCols;
+
 
     void activateRandom(
         bool active);
@@ -99,6 +170,30 @@ class SampleWindow :
         bool active);
 
 
+    void activateGraph(
+        bool active);
+
+
+    void activateWeighted(
+        bool active);
+
+
+    /**
+    * @brief Load the keys to weight rows or columns by from a file chosen by
+    * the user.
+    *
+    * @param numKeys The number of keys the file must have.
+    * @param dimName The name of what the keys are for.
+    * @param keys The keys (output).
+    * @param text The text control to show the file in.
+    */
+    void loadWeights(
+        dim_type numKeys,
+        std::string const & dimName,
+        std::vector<value_type> * keys,
+        wxTextCtrl * text);
+
+
     void onRandomSelected(
         wxCommandEvent&);
 
@@ -107,6 +202,30 @@ class SampleWindow :
         wxCommandEvent&);
 
 
+    void onGraphSelected(
+        wxCommandEvent&);
+
+
+    void onGraphMethodSelected(
+        wxCommandEvent&);
+
+
+    void onWeightedSelected(
+        wxCommandEvent&);
+
+
+    void onWeightSymChecked(
+        wxCommandEvent&);
+
+
+    void onRowWeightButton(
+        wxCommandEvent&);
+
+
+    void onColWeightButton(
+        wxCommandEvent&);
+
+
     void onRandomRowChecked(
         wxCommandEvent&);
 
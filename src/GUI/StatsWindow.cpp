@@ -9,8 +9,17 @@
 
 
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 #include <vector>
+#include <wx/image.h>
+#include <wx/statbmp.h>
 #include "GUI/WindowProperties.hpp"
+#include "Data/ColorMap.hpp"
 #include "Data/SparseMatrix.hpp"
 #include "Utility/String.hpp"
 #include "StatsWindow.hpp"
@@ -35,6 +44,25 @@ std::vector<std::string> const BOOL_NAMES {
   "yes"
 };
 
+std::string const EXPORT_TYPES_STRING = \
+    "JSON files (*.json)|*.json|CSV files (*.csv)|*.csv";
+
+// the size the heat map of an analyzed file is scaled up to
+int const HEATMAP_DISPLAY_SIZE = 256;
+
+// the number of rows (and non-zeros) sampled for the estimates shown while
+// the exact statistics are computed, which takes a few milliseconds
+dim_type const ESTIMATE_SAMPLE_SIZE = 1 << 14;
+
+// the estimates are repeatable, so reopening the window shows the same ones
+uint64_t const ESTIMATE_SEED = 0;
+
+int const POLL_INTERVAL = 100;
+
+enum event_types {
+  ID_TIMER
+};
+
 }
 
 
@@ -46,6 +74,8 @@ std::vector<std::string> const BOOL_NAMES {
 
 wxBEGIN_EVENT_TABLE(StatsWindow, wxDialog)
   EVT_BUTTON(wxID_OK, StatsWindow::onOK)
+  EVT_BUTTON(wxID_SAVE, StatsWindow::onExport)
+  EVT_TIMER(ID_TIMER, StatsWindow::onTimer)
 wxEND_EVENT_TABLE()
 
 
@@ -60,58 +90,195 @@ StatsWindow::StatsWindow(
     wxFrame * const parent,
     DataStorage * const storage) :
   wxDialog(parent, wxID_ANY, "Statistics", wxDefaultPosition, wxDefaultSize),
-  m_storage(storage)
+  m_storage(storage),
+  m_entries(),
+  m_timer(this, ID_TIMER),
+  m_progress(0),
+  m_cancel(false),
+  m_task(),
+  m_status(nullptr)
 {
-  Matrix const * const mat = storage->getMatrix();
+  Matrix * const mat = storage->getMatrix();
+
+  if (mat->isStatsSet() && mat->isSymmetrySet()) {
+    buildExact();
+    return;
+  }
 
+  // show estimates right away, and replace them once the exact statistics
+  // are computed in the background
+  buildEstimate(Stats::estimate(mat, ESTIMATE_SAMPLE_SIZE, ESTIMATE_SEED));
+
+  m_task = std::async(std::launch::async, [this, mat]() {
+    mat->computeStats(&m_progress, 1.0, &m_cancel);
+  });
+  m_timer.Start(POLL_INTERVAL);
+}
+
+
+StatsWindow::StatsWindow(
+    wxFrame * const parent,
+    StreamStats::stream_stats_struct const & stats,
+    HeatMap const * const heatmap) :
+  wxDialog(parent, wxID_ANY, "Statistics", wxDefaultPosition, wxDefaultSize),
+  m_storage(nullptr),
+  m_entries(),
+  m_timer(this, ID_TIMER),
+  m_progress(0),
+  m_cancel(false),
+  m_task(),
+  m_status(nullptr)
+{
   wxBoxSizer * allSizer = new wxBoxSizer(wxVERTICAL);
+  wxBoxSizer * columnsSizer = new wxBoxSizer(wxHORIZONTAL);
+  wxBoxSizer * leftSizer = new wxBoxSizer(wxVERTICAL);
+  wxBoxSizer * rightSizer = new wxBoxSizer(wxVERTICAL);
+  columnsSizer->Add(leftSizer, 1, wxEXPAND);
+  columnsSizer->Add(rightSizer, 1, wxEXPAND);
+  allSizer->Add(columnsSizer, 1, wxEXPAND);
+
+  addRow(leftSizer,"Number of rows",stats.numRows);
+  addRow(leftSizer,"Number of columns",stats.numCols);
+  addRow(leftSizer,"Number of non-zeros",stats.numNonZeros);
+
+  // only the structure is compared, so the values are symmetric only if the
+  // file says so
+  addRow(leftSizer,"Square",BOOL_NAMES[stats.numRows == stats.numCols]);
+  addRow(leftSizer,"Symmetric", \
+      stats.declaredSymmetric ? BOOL_NAMES[true] : std::string("unknown"));
+  addRow(leftSizer,"Structurally Symmetric", \
+      BOOL_NAMES[stats.stats.structurallySymmetric]);
+  addRow(leftSizer,"Symmetric non-zero fraction (est.)", \
+      stats.symmetricFraction);
+
+  addRow(leftSizer,"Non-zeros on the diagonal", \
+      stats.stats.diagonal.numNonZeros);
+  addRow(leftSizer,"Zeros on the diagonal", stats.stats.diagonal.numZeros);
+  addRow(leftSizer,"Bandwidth", stats.stats.diagonal.bandwidth);
+
+  addDegreeTable(leftSizer, stats.stats.rows, stats.stats.columns);
+
+  addValueStats(rightSizer, stats.stats.values);
+  if (heatmap != nullptr) {
+    addHeatMap(rightSizer, *heatmap);
+  }
+
+  addButtons(allSizer);
+
+  SetSizerAndFit(allSizer);
+}
+
+
+StatsWindow::~StatsWindow()
+{
+  m_timer.Stop();
+  m_cancel.store(true);
+  if (m_task.valid()) {
+    m_task.wait();
+  }
+}
+
+
+
+
+/******************************************************************************
+* PRIVATE FUNCTIONS ***********************************************************
+******************************************************************************/
+
+
+void StatsWindow::buildExact()
+{
+  Matrix const * const mat = m_storage->getMatrix();
+
+  // structure on the left, values on the right
+  wxBoxSizer * allSizer = new wxBoxSizer(wxVERTICAL);
+  wxBoxSizer * columnsSizer = new wxBoxSizer(wxHORIZONTAL);
+  wxBoxSizer * leftSizer = new wxBoxSizer(wxVERTICAL);
+  wxBoxSizer * rightSizer = new wxBoxSizer(wxVERTICAL);
+  columnsSizer->Add(leftSizer, 1, wxEXPAND);
+  columnsSizer->Add(rightSizer, 1, wxEXPAND);
+  allSizer->Add(columnsSizer, 1, wxEXPAND);
 
   // matrix size
-  addRow(allSizer,"Number of rows",mat->getNumRows());
-  addRow(allSizer,"Number of columns",mat->getNumColumns());
+  addRow(leftSizer,"Number of rows",mat->getNumRows());
+  addRow(leftSizer,"Number of columns",mat->getNumColumns());
   SparseMatrix const * spMat = dynamic_cast<SparseMatrix const *>(mat);
   if (spMat != nullptr) {
-    addRow(allSizer,"Number of non-zeros", spMat->getNumNonZeros());
+    addRow(leftSizer,"Number of non-zeros", spMat->getNumNonZeros());
   }
 
   // matrix properties
-  addRow(allSizer,"Square",BOOL_NAMES[mat->isSquare()]);
-  addRow(allSizer,"Symmetric",BOOL_NAMES[mat->isSymmetric()]);
+  addRow(leftSizer,"Square",BOOL_NAMES[mat->isSquare()]);
+  addRow(leftSizer,"Symmetric",BOOL_NAMES[mat->isSymmetric()]);
 
   if (spMat != nullptr) {
-    addRow(allSizer,"Structurally Symmetric",
+    addRow(leftSizer,"Structurally Symmetric",
         BOOL_NAMES[spMat->isStructurallySymmetric()]);
   }
 
-  // real stats
-  addRow(allSizer,"Maximum NNZ per row", mat->getMaxRowSize());
-  addRow(allSizer,"Maximum NNZ per column", mat->getMaxColumnSize());
-  addRow(allSizer,"Number of empty rows", mat->getNumEmptyRows());
-  addRow(allSizer,"Number of empty columns", mat->getNumEmptyColumns());
+  // diagonal stats
+  Matrix::diagonal_stats_struct const & diagonal = mat->getDiagonalStats();
+  addRow(leftSizer,"Non-zeros on the diagonal", diagonal.numNonZeros);
+  addRow(leftSizer,"Zeros on the diagonal", diagonal.numZeros);
+  addRow(leftSizer,"Bandwidth", diagonal.bandwidth);
 
-  // setup dialog buttons
-  wxBoxSizer * bottomSizer = new wxBoxSizer(wxHORIZONTAL);
-  bottomSizer->Add(new wxButton(this, wxID_OK, "Ok"), BORDER);
-  allSizer->Add(bottomSizer,0,wxALIGN_RIGHT);
+  // degree stats
+  addDegreeTable(leftSizer, mat->getRowStats(), mat->getColumnStats());
+
+  // value stats
+  addValueStats(rightSizer, mat->getValueStats());
+
+  addButtons(allSizer);
 
   SetSizerAndFit(allSizer);
 }
 
 
-StatsWindow::~StatsWindow()
+void StatsWindow::buildEstimate(
+    Stats::estimate_stats_struct const & estimate)
 {
-  // do nothing
-}
+  Matrix const * const mat = m_storage->getMatrix();
+
+  wxBoxSizer * allSizer = new wxBoxSizer(wxVERTICAL);
 
+  // the size is known without a pass over the matrix
+  addRow(allSizer,"Number of rows",mat->getNumRows());
+  addRow(allSizer,"Number of columns",mat->getNumColumns());
+  SparseMatrix const * spMat = dynamic_cast<SparseMatrix const *>(mat);
+  if (spMat != nullptr) {
+    addRow(allSizer,"Number of non-zeros", spMat->getNumNonZeros());
+  }
+  addRow(allSizer,"Square",BOOL_NAMES[mat->isSquare()]);
 
+  allSizer->Add(new wxStaticText(this, wxID_ANY, "Estimated from " + \
+      String::addThousandsSeparators(estimate.numSampledRows) + \
+      " rows (95% confidence):"), 0, wxALIGN_LEFT | wxALL, BORDER/3);
+
+  addEstimate(allSizer, "Mean non-zeros per row", estimate.meanRowSize);
+  if (estimate.rowsEstimated) {
+    for (int p = 0; p < Matrix::NUM_PERCENTILES; ++p) {
+      int const percent = static_cast<int>(Matrix::PERCENTILES[p]*100 + 0.5);
+      addEstimate(allSizer, std::to_string(percent) + \
+          std::string("th percentile non-zeros per row"), \
+          estimate.rowPercentiles[p]);
+    }
+    addEstimate(allSizer, "Empty rows", estimate.numEmptyRows);
+  }
+  addEstimate(allSizer, "Non-zeros on the diagonal", estimate.numDiagonal);
+  addEstimate(allSizer, "Symmetric non-zero fraction", \
+      estimate.symmetricFraction);
 
+  m_status = new wxStaticText(this, wxID_ANY, \
+      "Computing exact statistics...");
+  allSizer->Add(m_status, 0, wxEXPAND | wxALL, BORDER/3);
 
-/******************************************************************************
-* PRIVATE FUNCTIONS ***********************************************************
-******************************************************************************/
+  addButtons(allSizer);
+
+  SetSizerAndFit(allSizer);
+}
 
 
-void StatsWindow::addRow(
+void StatsWindow::addField(
     wxBoxSizer * const topSizer,
     std::string const key,
     std::string const value)
@@ -129,12 +296,23 @@ void StatsWindow::addRow(
 }
 
 
+void StatsWindow::addRow(
+    wxBoxSizer * const topSizer,
+    std::string const key,
+    std::string const value)
+{
+  addField(topSizer, key, value);
+  m_entries.push_back({key, value, false});
+}
+
+
 void StatsWindow::addRow(
     wxBoxSizer * const topSizer,
     std::string const key,
     index_type num)
 {
-  addRow(topSizer, key, String::addThousandsSeparators(num));
+  addField(topSizer, key, String::addThousandsSeparators(num));
+  m_entries.push_back({key, std::to_string(num), true});
 }
 
 
@@ -152,7 +330,235 @@ void StatsWindow::addRow(
     std::string const key,
     double num)
 {
-  addRow(topSizer, key, std::to_string(num));
+  std::ostringstream display;
+  display << num;
+  addField(topSizer, key, display.str());
+
+  // export without losing precision
+  std::ostringstream exact;
+  exact << std::setprecision(std::numeric_limits<double>::max_digits10) << \
+      num;
+  m_entries.push_back({key, exact.str(), true});
+}
+
+
+void StatsWindow::addEstimate(
+    wxBoxSizer * const topSizer,
+    std::string const key,
+    Stats::interval_struct const & interval)
+{
+  std::ostringstream display;
+  display << std::setprecision(4) << interval.estimate;
+  if (interval.low < interval.high) {
+    display << " (" << interval.low << " - " << interval.high << ")";
+  }
+  addField(topSizer, key, display.str());
+
+  // export the bounds as separate statistics
+  std::ostringstream exact;
+  exact << std::setprecision(std::numeric_limits<double>::max_digits10);
+  exact << interval.estimate;
+  m_entries.push_back({key + " (estimate)", exact.str(), true});
+  exact.str("");
+  exact << interval.low;
+  m_entries.push_back({key + " (low)", exact.str(), true});
+  exact.str("");
+  exact << interval.high;
+  m_entries.push_back({key + " (high)", exact.str(), true});
+}
+
+
+void StatsWindow::addHeatMap(
+    wxBoxSizer * const topSizer,
+    HeatMap const & heatmap)
+{
+  dim_type const width = heatmap.getWidth();
+  dim_type const height = heatmap.getHeight();
+  size_t const numPixels = static_cast<size_t>(width)*height;
+
+  std::vector<uint32_t> colors(numPixels);
+  ColorMap().apply(heatmap.getValues()->data(), numPixels, \
+      heatmap.getMin(), heatmap.getMax(), colors.data());
+
+  wxImage image(width, height);
+  unsigned char * const pixels = image.GetData();
+  for (size_t i = 0; i < numPixels; ++i) {
+    uint32_t const color = colors[i];
+    pixels[(3*i)+0] = color & 0xFF;
+    pixels[(3*i)+1] = (color >> 8) & 0xFF;
+    pixels[(3*i)+2] = (color >> 16) & 0xFF;
+  }
+
+  // blocks are shown as squares of at least a pixel
+  int const scale = std::max<int>(1, \
+      HEATMAP_DISPLAY_SIZE / std::max(width, height));
+  image.Rescale(width*scale, height*scale, wxIMAGE_QUALITY_NEAREST);
+
+  topSizer->Add(new wxStaticText(this, wxID_ANY, "Non-zero density:"), 0, \
+      wxALIGN_LEFT | wxLEFT | wxRIGHT, BORDER);
+  topSizer->Add(new wxStaticBitmap(this, wxID_ANY, wxBitmap(image)), 0, \
+      wxALIGN_CENTER | wxALL, BORDER/3);
+}
+
+
+void StatsWindow::addButtons(
+    wxBoxSizer * const topSizer)
+{
+  wxBoxSizer * bottomSizer = new wxBoxSizer(wxHORIZONTAL);
+  bottomSizer->Add(new wxButton(this, wxID_SAVE, "Export..."), BORDER);
+  bottomSizer->Add(new wxButton(this, wxID_OK, "Ok"), BORDER);
+  topSizer->Add(bottomSizer,0,wxALIGN_RIGHT);
+}
+
+
+void StatsWindow::addValueStats(
+    wxBoxSizer * const topSizer,
+    Matrix::value_stats_struct const & stats)
+{
+  index_type const numFinite = stats.numValues - stats.numNaN - \
+      stats.numInfinite;
+
+  addRow(topSizer, "Minimum value", static_cast<double>(stats.min));
+  addRow(topSizer, "Maximum value", static_cast<double>(stats.max));
+  addRow(topSizer, "Mean value", \
+      numFinite > 0 ? stats.sum / numFinite : 0.0);
+  addRow(topSizer, "Sum of absolute values", stats.absSum);
+  addRow(topSizer, "Explicit zeros", stats.numZeros);
+  addRow(topSizer, "Negative values", stats.numNegative);
+  addRow(topSizer, "NaN values", stats.numNaN);
+  addRow(topSizer, "Infinite values", stats.numInfinite);
+
+  // list the non-empty bins of the magnitude histogram
+  std::string histogram;
+  for (int bin = 0; bin < Matrix::NUM_MAGNITUDE_BINS; ++bin) {
+    index_type const count = stats.magnitudes[bin];
+    if (count == 0) {
+      continue;
+    }
+
+    int const exp = Matrix::MIN_MAGNITUDE + bin;
+    std::string range;
+    if (bin == 0) {
+      range = "< 2^" + std::to_string(exp+1);
+    } else if (bin == Matrix::NUM_MAGNITUDE_BINS-1) {
+      range = ">= 2^" + std::to_string(exp);
+    } else {
+      range = "[2^" + std::to_string(exp) + ", 2^" + std::to_string(exp+1) + \
+          ")";
+    }
+
+    histogram += range + ": " + String::addThousandsSeparators(count) + "\n";
+    m_entries.push_back({"Values with magnitude " + range, \
+        std::to_string(count), true});
+  }
+
+  topSizer->Add(new wxStaticText(this, wxID_ANY, "Value magnitudes:"), 0, \
+      wxALIGN_LEFT | wxLEFT | wxRIGHT, BORDER);
+  topSizer->Add(new wxTextCtrl(this, wxID_ANY, histogram, \
+      wxDefaultPosition, wxSize(-1, 150), \
+      wxTE_READONLY | wxTE_MULTILINE), 1, wxEXPAND | wxALL, BORDER/3);
+}
+
+
+void StatsWindow::addDegreeTable(
+    wxBoxSizer * const topSizer,
+    Matrix::degree_stats_struct const & rows,
+    Matrix::degree_stats_struct const & cols)
+{
+  wxFlexGridSizer * gridSizer = new wxFlexGridSizer(3, BORDER/3, BORDER);
+  gridSizer->AddGrowableCol(1);
+  gridSizer->AddGrowableCol(2);
+
+  auto addCell = [this, gridSizer](std::string const & text) {
+    gridSizer->Add(new wxTextCtrl(this, wxID_ANY, text, wxDefaultPosition, \
+        wxDefaultSize, wxTE_READONLY | wxTE_RIGHT), 1, wxEXPAND);
+  };
+  auto addLabel = [this, gridSizer](std::string const & text) {
+    gridSizer->Add(new wxStaticText(this, wxID_ANY, text), 0, \
+        wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL);
+  };
+  auto addCounts = [&](std::string const & key, dim_type const rowNum, \
+      dim_type const colNum) {
+    addLabel(key + std::string(":"));
+    addCell(String::addThousandsSeparators(rowNum));
+    addCell(String::addThousandsSeparators(colNum));
+    m_entries.push_back({key + " non-zeros per row", \
+        std::to_string(rowNum), true});
+    m_entries.push_back({key + " non-zeros per column", \
+        std::to_string(colNum), true});
+  };
+  auto addMoments = [&](std::string const & key, double const rowNum, \
+      double const colNum) {
+    std::ostringstream rowText;
+    std::ostringstream colText;
+    rowText << rowNum;
+    colText << colNum;
+    addLabel(key + std::string(":"));
+    addCell(rowText.str());
+    addCell(colText.str());
+
+    rowText.str("");
+    colText.str("");
+    rowText << std::setprecision(std::numeric_limits<double>::max_digits10) \
+        << rowNum;
+    colText << std::setprecision(std::numeric_limits<double>::max_digits10) \
+        << colNum;
+    m_entries.push_back({key + " non-zeros per row", rowText.str(), true});
+    m_entries.push_back({key + " non-zeros per column", colText.str(), \
+        true});
+  };
+
+  addLabel("Non-zeros per");
+  addLabel("Row");
+  addLabel("Column");
+
+  addCounts("Minimum", rows.min, cols.min);
+  addCounts("Maximum", rows.max, cols.max);
+
+  addMoments("Mean", rows.mean, cols.mean);
+  addMoments("Standard deviation", std::sqrt(rows.variance), \
+      std::sqrt(cols.variance));
+
+  for (int p = 0; p < Matrix::NUM_PERCENTILES; ++p) {
+    int const percent = static_cast<int>(Matrix::PERCENTILES[p]*100 + 0.5);
+    addCounts(std::to_string(percent) + std::string("th percentile"), \
+        rows.percentiles[p], cols.percentiles[p]);
+  }
+
+  addCounts("Empty", rows.numEmpty, cols.numEmpty);
+
+  topSizer->Add(gridSizer, 0, wxEXPAND | wxALL, BORDER/3);
+}
+
+
+void StatsWindow::onTimer(
+    wxTimerEvent&)
+{
+  if (m_task.wait_for(std::chrono::seconds(0)) != \
+      std::future_status::ready) {
+    m_status->SetLabel("Computing exact statistics... " + \
+        std::to_string(std::min(static_cast<int>(m_progress * 100.0), 100)) + \
+        "%");
+    return;
+  }
+
+  m_timer.Stop();
+
+  try {
+    m_task.get();
+  } catch (std::bad_alloc const &) {
+    m_status->SetLabel("Not enough memory to compute the exact statistics.");
+    return;
+  } catch (std::exception const & e) {
+    m_status->SetLabel(std::string("Error: ") + e.what());
+    return;
+  }
+
+  // replace the estimates
+  DestroyChildren();
+  m_entries.clear();
+  m_status = nullptr;
+  buildExact();
 }
 
 
@@ -168,6 +574,68 @@ void StatsWindow::onOK(
 }
 
 
+void StatsWindow::onExport(
+    wxCommandEvent&)
+{
+  wxFileDialog saveFileDialog(this, _("Export Statistics"), "", "", \
+      EXPORT_TYPES_STRING, wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+	if (saveFileDialog.ShowModal() == wxID_CANCEL) {
+		// user canceled
+		return;
+	}
+
+  std::string const name(saveFileDialog.GetPath().mb_str());
+
+  std::ofstream out(name);
+  if (out.good()) {
+    if (String::endsWith(String::toLower(&name), ".csv")) {
+      writeCSV(out);
+    } else {
+      writeJSON(out);
+    }
+  }
+
+  if (!out.good()) {
+    wxMessageDialog msg(this, std::string("Failed to write '") + name + \
+        std::string("'."), "", wxOK|wxICON_ERROR);
+    msg.ShowModal();
+  }
+}
+
+
+void StatsWindow::writeJSON(
+    std::ostream & out) const
+{
+  out << "{" << std::endl;
+  for (size_t i = 0; i < m_entries.size(); ++i) {
+    entry_struct const & entry = m_entries[i];
+    out << "  \"" << entry.key << "\": ";
+    if (entry.isNumber) {
+      out << entry.value;
+    } else {
+      out << "\"" << entry.value << "\"";
+    }
+    if (i+1 < m_entries.size()) {
+      out << ",";
+    }
+    out << std::endl;
+  }
+  out << "}" << std::endl;
+}
+
+
+void StatsWindow::writeCSV(
+    std::ostream & out) const
+{
+  out << "statistic,value" << std::endl;
+  for (entry_struct const & entry : m_entries) {
+    // the keys may contain commas
+    out << "\"" << entry.key << "\"," << entry.value << std::endl;
+  }
+}
+
+
 
 
 }
@@ -17,8 +17,16 @@
 #include <wx/wx.h>
 #include <wx/textctrl.h>
 #include <wx/valnum.h>
+#include <wx/timer.h>
+#include <atomic>
+#include <future>
+#include <ostream>
+#include <string>
 #include <vector>
 #include "Data/DataStorage.hpp"
+#include "Data/HeatMap.hpp"
+#include "Operations/Stats.hpp"
+#include "Operations/StreamStats.hpp"
 
 
 
@@ -31,21 +39,81 @@ class StatsWindow :
   public wxDialog
 {
   public:
+    /**
+    * @brief Create a window showing the statistics of a matrix. Statistics
+    * which are not known yet are estimated from a sample, and replaced once
+    * they are computed in the background.
+    *
+    * @param parent The parent frame.
+    * @param storage The storage containing the matrix.
+    */
     StatsWindow(
         wxFrame * parent,
         DataStorage * storage);
 
 
+    /**
+    * @brief Create a window showing the statistics of a file which was
+    * analyzed without being loaded.
+    *
+    * @param parent The parent frame.
+    * @param stats The statistics of the file.
+    * @param heatmap The heat map of the non-zeros (may be null).
+    */
+    StatsWindow(
+        wxFrame * parent,
+        StreamStats::stream_stats_struct const & stats,
+        HeatMap const * heatmap);
+
+
     virtual ~StatsWindow();
 
 
   private:
+    /**
+    * @brief A displayed statistic, as it is exported.
+    */
+    struct entry_struct {
+      std::string key;
+      std::string value;
+      bool isNumber;
+    };
+
     DataStorage * m_storage;
+    std::vector<entry_struct> m_entries;
+    wxTimer m_timer;
+    // written by the background task, and only read once it is done
+    double m_progress;
+    // set when the window closes, to stop the background task early
+    std::atomic<bool> m_cancel;
+    std::future<void> m_task;
+    wxStaticText * m_status;
 
 
     wxDECLARE_EVENT_TABLE();
 
 
+    /**
+    * @brief Show the exact statistics of the matrix.
+    */
+    void buildExact();
+
+
+    /**
+    * @brief Show estimated statistics of the matrix.
+    *
+    * @param estimate The estimates.
+    */
+    void buildEstimate(
+        Stats::estimate_stats_struct const & estimate);
+
+
+    void addField(
+        wxBoxSizer * topSizer,
+        std::string key,
+        std::string value);
+
+
     void addRow(
         wxBoxSizer * topSizer,
         std::string key,
@@ -70,10 +138,52 @@ class StatsWindow :
         double num);
 
 
+    void addEstimate(
+        wxBoxSizer * topSizer,
+        std::string key,
+        Stats::interval_struct const & interval);
+
+
+    void addHeatMap(
+        wxBoxSizer * topSizer,
+        HeatMap const & heatmap);
+
+
+    void addButtons(
+        wxBoxSizer * topSizer);
+
+
+    void addValueStats(
+        wxBoxSizer * topSizer,
+        Matrix::value_stats_struct const & stats);
+
+
+    void addDegreeTable(
+        wxBoxSizer * topSizer,
+        Matrix::degree_stats_struct const & rows,
+        Matrix::degree_stats_struct const & cols);
+
+
+    void onTimer(
+        wxTimerEvent& event);
+
+
     void onOK(
         wxCommandEvent& event);
 
 
+    void onExport(
+        wxCommandEvent& event);
+
+
+    void writeJSON(
+        std::ostream & out) const;
+
+
+    void writeCSV(
+        std::ostream & out) const;
+
+
     // prevent copying
     StatsWindow(
         StatsWindow const & rhs);
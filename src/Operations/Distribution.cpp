@@ -0,0 +1,650 @@
+/**
+ * @file Distribution.cpp
+ * @brief Implementation of the Distribution class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "Data/CSRMatrix.hpp"
+#include "Utility/Parallel.hpp"
+#include "Utility/Random.hpp"
+#include "Distribution.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+// degrees beyond this are rare enough to be sorted rather than binned
+dim_type const MAX_HISTOGRAM_SIZE = 1 << 16;
+
+// the low mantissa bits dropped from a magnitude to get its fine bin, leaving
+// four, or sixteen bins per power of two
+int const MAGNITUDE_SHIFT = 19;
+
+// the fine bins cover every positive float, including infinity and nan
+size_t const NUM_MAGNITUDE_BINS = 1 << (31 - MAGNITUDE_SHIFT);
+
+// the first fine bin of the infinite and nan magnitudes
+size_t const NON_FINITE_BIN = 255 << (23 - MAGNITUDE_SHIFT);
+
+int const NUM_PROGRESS_STEPS = 50;
+
+// the number of rows binned between checks for cancellation
+dim_type const CANCEL_INTERVAL = 4096;
+
+// tails with fewer values than this are not worth fitting
+index_type const MIN_TAIL_SIZE = 10;
+
+// the most starts of the tail tried when fitting
+size_t const MAX_FIT_CANDIDATES = 256;
+
+}
+
+
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+
+/**
+* @brief Bin a set of degrees in parallel.
+*
+* @tparam F The type of function supplying the degrees.
+* @param num The number of degrees.
+* @param getDegree The function supplying the degree of an index.
+*
+* @return The distribution.
+*/
+template<typename F>
+Distribution::fine_histogram_struct binDegrees(
+    size_t const num,
+    F getDegree)
+{
+  unsigned const maxThreads = Parallel::getNumThreads();
+  std::vector<std::vector<index_type>> histograms(maxThreads);
+  std::vector<std::vector<dim_type>> large(maxThreads);
+
+  unsigned const numThreads = Parallel::forRange(num, \
+      [&](unsigned const tid, size_t const start, size_t const end) {
+    std::vector<index_type> & histogram = histograms[tid];
+    for (size_t i = start; i < end; ++i) {
+      dim_type const degree = getDegree(i);
+      if (degree < MAX_HISTOGRAM_SIZE) {
+        if (degree >= histogram.size()) {
+          histogram.resize(degree+1, 0);
+        }
+        ++histogram[degree];
+      } else {
+        large[tid].push_back(degree);
+      }
+    }
+  });
+
+  // merge in a fixed order
+  std::vector<index_type> & histogram = histograms[0];
+  std::vector<dim_type> & rest = large[0];
+  for (unsigned tid = 1; tid < numThreads; ++tid) {
+    if (histograms[tid].size() > histogram.size()) {
+      histogram.resize(histograms[tid].size(), 0);
+    }
+    for (size_t degree = 0; degree < histograms[tid].size(); ++degree) {
+      histogram[degree] += histograms[tid][degree];
+    }
+    rest.insert(rest.end(), large[tid].begin(), large[tid].end());
+  }
+  std::sort(rest.begin(), rest.end());
+
+  Distribution::fine_histogram_struct fine;
+  fine.discrete = true;
+  for (size_t degree = 0; degree < histogram.size(); ++degree) {
+    if (histogram[degree] > 0) {
+      fine.values.push_back(static_cast<double>(degree));
+      fine.counts.push_back(histogram[degree]);
+    }
+  }
+  for (size_t i = 0; i < rest.size(); ++i) {
+    if (i > 0 && rest[i] == rest[i-1]) {
+      ++fine.counts.back();
+    } else {
+      fine.values.push_back(static_cast<double>(rest[i]));
+      fine.counts.push_back(1);
+    }
+  }
+
+  return fine;
+}
+
+
+/**
+* @brief Get the fine bin of a magnitude.
+*
+* @param val The value.
+*
+* @return The bin.
+*/
+inline size_t getMagnitudeBin(
+    value_type const val) noexcept
+{
+  uint32_t bits;
+  std::memcpy(&bits, &val, sizeof(bits));
+  return (bits & 0x7FFFFFFFU) >> MAGNITUDE_SHIFT;
+}
+
+
+/**
+* @brief Get the value representing a fine bin of magnitudes, which is the
+* geometric center of the bin.
+*
+* @param bin The bin.
+*
+* @return The value.
+*/
+double getMagnitudeBinValue(
+    size_t const bin) noexcept
+{
+  uint32_t const lowBits = static_cast<uint32_t>(bin << MAGNITUDE_SHIFT);
+  uint32_t const highBits = static_cast<uint32_t>((bin+1) << MAGNITUDE_SHIFT);
+  float low, high;
+  std::memcpy(&low, &lowBits, sizeof(low));
+  std::memcpy(&high, &highBits, sizeof(high));
+
+  if (low == 0) {
+    // the smallest subnormals
+    return high / 2.0;
+  }
+  return std::sqrt(static_cast<double>(low) * high);
+}
+
+
+/**
+* @brief Get the distribution of a set of binned magnitudes.
+*
+* @param histogram The count of each fine bin.
+* @param zeros The number of zeros.
+*
+* @return The distribution.
+*/
+Distribution::fine_histogram_struct toMagnitudeHistogram(
+    std::vector<index_type> const & histogram,
+    index_type const zeros)
+{
+  Distribution::fine_histogram_struct fine;
+  fine.discrete = false;
+  if (zeros > 0) {
+    fine.values.push_back(0);
+    fine.counts.push_back(zeros);
+  }
+  for (size_t bin = 0; bin < NON_FINITE_BIN; ++bin) {
+    if (histogram[bin] > 0) {
+      fine.values.push_back(getMagnitudeBinValue(bin));
+      fine.counts.push_back(histogram[bin]);
+    }
+  }
+
+  return fine;
+}
+
+
+/**
+* @brief Scale the counts of a distribution of a sample up to the size of the
+* population it was drawn from.
+*
+* @param fine The distribution.
+* @param factor The size of the population over the size of the sample.
+*/
+void scaleCounts(
+    Distribution::fine_histogram_struct * const fine,
+    double const factor)
+{
+  for (index_type & count : fine->counts) {
+    count = static_cast<index_type>(std::llround(count * factor));
+  }
+}
+
+
+/**
+* @brief Bin the magnitudes of a matrix's values in parallel.
+*
+* @tparam F The type of function supplying the value of a non-zero.
+* @param csr The matrix.
+* @param getValue The function supplying the value at an index.
+* @param progress The progress counter to update.
+* @param scale The amount of progress this task contributes.
+* @param cancel The flag which, once set, stops the binning.
+*
+* @return The distribution.
+*/
+template<typename F>
+Distribution::fine_histogram_struct binMagnitudes(
+    CSRMatrix const * const csr,
+    F getValue,
+    double * const progress,
+    double const scale,
+    std::atomic<bool> const * const cancel)
+{
+  bool const half = csr->isHalfStorage();
+  dim_type const numRows = csr->getNumRows();
+  index_type const * const offsets = csr->getOffsets();
+  dim_type const * const columns = csr->getColumns();
+
+  unsigned const numThreads = Parallel::getNumThreads();
+  std::vector<std::vector<index_type>> histograms(numThreads);
+  std::vector<index_type> zeros(numThreads, 0);
+
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    std::vector<index_type> & histogram = histograms[tid];
+    histogram.assign(NUM_MAGNITUDE_BINS, 0);
+
+    dim_type const start = Parallel::getRowChunkStart(offsets, numRows, \
+        numThreads, tid);
+    dim_type const end = Parallel::getRowChunkStart(offsets, numRows, \
+        numThreads, tid+1);
+
+    dim_type const interval = std::max<dim_type>(1, \
+        (end - start) / NUM_PROGRESS_STEPS);
+    double const increment = scale / NUM_PROGRESS_STEPS;
+
+    for (dim_type row = start; row < end; ++row) {
+      if ((row - start) % CANCEL_INTERVAL == 0 && cancel != nullptr && \
+          cancel->load(std::memory_order_relaxed)) {
+        break;
+      }
+
+      for (index_type idx = offsets[row]; idx < offsets[row+1]; ++idx) {
+        // in half storage off-diagonal values stand for two non-zeros
+        index_type const weight = (half && columns[idx] != row) ? 2 : 1;
+        value_type const val = getValue(idx);
+        if (val == 0) {
+          zeros[tid] += weight;
+        } else {
+          histogram[getMagnitudeBin(val)] += weight;
+        }
+      }
+
+      if (tid == 0 && progress != nullptr && (row - start) % interval == 0 && \
+          (row - start) / interval < NUM_PROGRESS_STEPS) {
+        *progress += increment;
+      }
+    }
+  });
+
+  // merge in a fixed order
+  for (unsigned tid = 1; tid < numThreads; ++tid) {
+    zeros[0] += zeros[tid];
+    for (size_t bin = 0; bin < NUM_MAGNITUDE_BINS; ++bin) {
+      histograms[0][bin] += histograms[tid][bin];
+    }
+  }
+
+  return toMagnitudeHistogram(histograms[0], zeros[0]);
+}
+
+
+CSRMatrix const * toCSR(
+    Matrix const * const mat)
+{
+  CSRMatrix const * const csr = dynamic_cast<CSRMatrix const *>(mat);
+
+  if (csr == nullptr) {
+    throw std::runtime_error("Cannot compute distribution of non-csr " \
+        "matrix.");
+  }
+
+  return csr;
+}
+
+
+}
+
+
+
+
+/******************************************************************************
+* STATIC PUBLIC FUNCTIONS *****************************************************
+******************************************************************************/
+
+
+Distribution::fine_histogram_struct Distribution::degrees(
+    dim_type const * const degrees,
+    dim_type const num)
+{
+  return binDegrees(num, [degrees](size_t const i) {
+    return degrees[i];
+  });
+}
+
+
+Distribution::fine_histogram_struct Distribution::rowDegrees(
+    Matrix * const mat,
+    double * const progress,
+    double const scale,
+    std::atomic<bool> const * const cancel)
+{
+  mat->computeDegrees(progress, scale*0.8, cancel);
+  if (!mat->isRowDegreesSet() || !mat->isColumnDegreesSet()) {
+    // cancelled
+    fine_histogram_struct empty;
+    empty.discrete = true;
+    return empty;
+  }
+
+  std::vector<dim_type> const & rowDegrees = mat->getRowDegrees();
+  fine_histogram_struct const fine = degrees(rowDegrees.data(), \
+      mat->getNumRows());
+
+  if (progress != nullptr) {
+    *progress += scale*0.2;
+  }
+
+  return fine;
+}
+
+
+Distribution::fine_histogram_struct Distribution::columnDegrees(
+    Matrix * const mat,
+    double * const progress,
+    double const scale,
+    std::atomic<bool> const * const cancel)
+{
+  mat->computeDegrees(progress, scale*0.8, cancel);
+  if (!mat->isRowDegreesSet() || !mat->isColumnDegreesSet()) {
+    // cancelled
+    fine_histogram_struct empty;
+    empty.discrete = true;
+    return empty;
+  }
+
+  std::vector<dim_type> const & columnDegrees = mat->getColumnDegrees();
+  fine_histogram_struct const fine = degrees(columnDegrees.data(), \
+      mat->getNumColumns());
+
+  if (progress != nullptr) {
+    *progress += scale*0.2;
+  }
+
+  return fine;
+}
+
+
+Distribution::fine_histogram_struct Distribution::valueMagnitudes(
+    Matrix const * const mat,
+    double * const progress,
+    double const scale,
+    std::atomic<bool> const * const cancel)
+{
+  CSRMatrix const * const csr = toCSR(mat);
+  ValueArray const & values = csr->getValueArray();
+
+  if (values.getPrecision() == ValueArray::FULL_PRECISION) {
+    value_type const * const data = values.data();
+    return binMagnitudes(csr, [data](index_type const idx) {
+      return data[idx];
+    }, progress, scale, cancel);
+  } else {
+    return binMagnitudes(csr, [&values](index_type const idx) {
+      return values.get(idx);
+    }, progress, scale, cancel);
+  }
+}
+
+
+Distribution::fine_histogram_struct Distribution::sampleRowDegrees(
+    Matrix const * const mat,
+    dim_type const numSamples,
+    uint64_t const seed)
+{
+  CSRMatrix const * const csr = toCSR(mat);
+  dim_type const numRows = csr->getNumRows();
+  index_type const * const offsets = csr->getOffsets();
+
+  if (csr->isHalfStorage() || numRows == 0) {
+    // the rows do not hold their mirrored entries
+    fine_histogram_struct fine;
+    fine.discrete = true;
+    return fine;
+  }
+
+  std::vector<dim_type> rows(std::min(numSamples, numRows));
+  Random(seed).sortedSample(rows.data(), numRows, rows.size());
+
+  fine_histogram_struct fine = binDegrees(rows.size(), \
+      [&rows, offsets](size_t const i) {
+        return static_cast<dim_type>(offsets[rows[i]+1] - offsets[rows[i]]);
+      });
+  scaleCounts(&fine, static_cast<double>(numRows) / rows.size());
+
+  return fine;
+}
+
+
+Distribution::fine_histogram_struct Distribution::sampleValueMagnitudes(
+    Matrix const * const mat,
+    index_type const numSamples,
+    uint64_t const seed)
+{
+  CSRMatrix const * const csr = toCSR(mat);
+  ValueArray const & values = csr->getValueArray();
+  bool const half = csr->isHalfStorage();
+  index_type const * const offsets = csr->getOffsets();
+  dim_type const * const columns = csr->getColumns();
+  index_type const numStored = offsets[csr->getNumRows()];
+
+  std::vector<index_type> sample(std::min(numSamples, numStored));
+  Random(seed).sortedSample(sample.data(), numStored, sample.size());
+
+  std::vector<index_type> histogram(NUM_MAGNITUDE_BINS, 0);
+  index_type zeros = 0;
+  dim_type row = 0;
+  for (index_type const idx : sample) {
+    // the sample is in order, so the rows are found by walking the offsets
+    while (offsets[row+1] <= idx) {
+      ++row;
+    }
+
+    index_type const weight = (half && columns[idx] != row) ? 2 : 1;
+    value_type const val = values.get(idx);
+    if (val == 0) {
+      zeros += weight;
+    } else {
+      histogram[getMagnitudeBin(val)] += weight;
+    }
+  }
+
+  fine_histogram_struct fine = toMagnitudeHistogram(histogram, zeros);
+  if (!sample.empty()) {
+    scaleCounts(&fine, static_cast<double>(numStored) / sample.size());
+  }
+
+  return fine;
+}
+
+
+Distribution::histogram_struct Distribution::bucket(
+    fine_histogram_struct const & fine,
+    int const numBins,
+    scale_type const scale)
+{
+  if (numBins < 1) {
+    throw std::runtime_error("Must have at least one bin.");
+  }
+
+  std::vector<double> const & values = fine.values;
+  std::vector<index_type> const & counts = fine.counts;
+
+  histogram_struct hist;
+  hist.numExcluded = 0;
+
+  // skip values which have no place on a log scale
+  size_t first = 0;
+  if (scale == LOG_SCALE) {
+    while (first < values.size() && values[first] <= 0) {
+      hist.numExcluded += counts[first];
+      ++first;
+    }
+  }
+
+  if (first == values.size()) {
+    hist.edges = {0, 1};
+    hist.counts = {0};
+    return hist;
+  }
+
+  double const low = values[first];
+  double const high = values.back();
+
+  if (fine.discrete) {
+    // bins are whole ranges of integers [a,b)
+    double const end = high + 1;
+    hist.edges.push_back(low);
+    for (int i = 1; i <= numBins; ++i) {
+      double edge;
+      if (scale == LOG_SCALE) {
+        edge = std::ceil(low * std::pow(end / low, \
+            static_cast<double>(i) / numBins));
+      } else {
+        edge = std::ceil(low + ((end - low) * i) / numBins);
+      }
+      edge = std::min(edge, end);
+      if (edge > hist.edges.back()) {
+        hist.edges.push_back(edge);
+      }
+    }
+  } else if (high == low) {
+    hist.edges = {low * 0.5, low * 1.5};
+    if (low == 0) {
+      hist.edges = {-0.5, 0.5};
+    }
+  } else {
+    hist.edges.resize(numBins+1);
+    for (int i = 0; i <= numBins; ++i) {
+      double const frac = static_cast<double>(i) / numBins;
+      if (scale == LOG_SCALE) {
+        hist.edges[i] = low * std::pow(high / low, frac);
+      } else {
+        hist.edges[i] = low + ((high - low) * frac);
+      }
+    }
+    // the largest value belongs to the last bin
+    hist.edges.back() = high;
+  }
+
+  size_t const bins = hist.edges.size() - 1;
+  hist.counts.assign(bins, 0);
+
+  size_t bin = 0;
+  for (size_t i = first; i < values.size(); ++i) {
+    while (bin + 1 < bins && values[i] >= hist.edges[bin+1]) {
+      ++bin;
+    }
+    hist.counts[bin] += counts[i];
+  }
+
+  return hist;
+}
+
+
+Distribution::power_law_struct Distribution::fitPowerLaw(
+    fine_histogram_struct const & fine)
+{
+  std::vector<double> const & values = fine.values;
+  std::vector<index_type> const & counts = fine.counts;
+
+  size_t first = 0;
+  while (first < values.size() && values[first] <= 0) {
+    ++first;
+  }
+  size_t const num = values.size() - first;
+
+  // the number and sum of logs of the values in each possible tail
+  std::vector<double> tailCount(num+1, 0);
+  std::vector<double> tailLogSum(num+1, 0);
+  for (size_t i = num; i > 0; --i) {
+    double const x = values[first+i-1];
+    double const count = static_cast<double>(counts[first+i-1]);
+    tailCount[i-1] = tailCount[i] + count;
+    tailLogSum[i-1] = tailLogSum[i] + (count * std::log(x));
+  }
+
+  // the discrete approximation treats each integer as the range around it
+  double const shift = fine.discrete ? 0.5 : 0.0;
+
+  power_law_struct best;
+  best.alpha = 0;
+  best.xMin = 0;
+  best.distance = std::numeric_limits<double>::infinity();
+  best.numTail = 0;
+
+  size_t numCandidates = 0;
+  while (numCandidates < num && tailCount[numCandidates] >= MIN_TAIL_SIZE) {
+    ++numCandidates;
+  }
+  size_t const stride = std::max<size_t>(1, \
+      (numCandidates + MAX_FIT_CANDIDATES - 1) / MAX_FIT_CANDIDATES);
+
+  for (size_t start = 0; start < numCandidates; start += stride) {
+    double const xMin = values[first+start];
+    double const base = xMin - shift;
+    double const n = tailCount[start];
+    double const logs = tailLogSum[start] - (n * std::log(base));
+    if (logs <= 0) {
+      // every value in the tail is xMin
+      continue;
+    }
+    double const alpha = 1.0 + (n / logs);
+
+    // the largest gap between the cumulative distributions
+    double distance = 0;
+    double seen = 0;
+    for (size_t i = start; i < num; ++i) {
+      seen += counts[first+i];
+      double const x = values[first+i];
+      double const model = 1.0 - std::pow((x + shift) / base, 1.0 - alpha);
+      distance = std::max(distance, std::abs((seen / n) - model));
+    }
+
+    if (distance < best.distance) {
+      best.alpha = alpha;
+      best.xMin = xMin;
+      best.distance = distance;
+      best.numTail = static_cast<index_type>(n);
+    }
+  }
+
+  if (best.numTail == 0) {
+    best.distance = 0;
+  }
+
+  return best;
+}
+
+
+
+
+}
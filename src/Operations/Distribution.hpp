@@ -0,0 +1,242 @@
+/**
+ * @file Distribution.hpp
+ * @brief The Distribution class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_OPERATIONS_DISTRIBUTION_HPP
+#define MATRIXINSPECTOR_OPERATIONS_DISTRIBUTION_HPP
+
+
+
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "Data/Matrix.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+class Distribution
+{
+  public:
+    enum scale_type {
+      LINEAR_SCALE,
+      LOG_SCALE
+    };
+
+
+    /**
+    * @brief The distribution of a quantity at its finest resolution: each
+    * distinct value (sorted ascending) and the number of times it occurs.
+    * It is small regardless of the size of the matrix, and is re-bucketed
+    * for display.
+    */
+    struct fine_histogram_struct {
+      fine_histogram_struct() :
+        values(),
+        counts(),
+        discrete(false)
+      {
+        // do nothing
+      }
+
+      std::vector<double> values;
+      std::vector<index_type> counts;
+      // whether the quantity only takes integer values
+      bool discrete;
+    };
+
+
+    struct histogram_struct {
+      histogram_struct() :
+        edges(),
+        counts(),
+        numExcluded(0)
+      {
+        // do nothing
+      }
+
+      // the bin boundaries, one more than the number of bins
+      std::vector<double> edges;
+      std::vector<index_type> counts;
+      // the number of non-positive values left out of a log scale
+      index_type numExcluded;
+    };
+
+
+    /**
+    * @brief A fit of the tail x >= xMin to p(x) ~ x^-alpha.
+    */
+    struct power_law_struct {
+      double alpha;
+      double xMin;
+      // the Kolmogorov-Smirnov distance between the tail and the fit
+      double distance;
+      index_type numTail;
+    };
+
+
+    /**
+    * @brief Bin a set of degrees in parallel.
+    *
+    * @param degrees The degrees.
+    * @param num The number of degrees.
+    *
+    * @return The exact distribution of the degrees.
+    */
+    static fine_histogram_struct degrees(
+        dim_type const * degrees,
+        dim_type num);
+
+
+    /**
+    * @brief Get the distribution of the number of non-zeros per row, from
+    * the degrees cached by the matrix.
+    *
+    * @param mat The matrix.
+    * @param progress The progress counter to update.
+    * @param scale The amount of progress this task contributes.
+    * @param cancel The flag which, once set, stops the counting and leaves
+    * the distribution empty.
+    *
+    * @return The distribution.
+    */
+    static fine_histogram_struct rowDegrees(
+        Matrix * mat,
+        double * progress = nullptr,
+        double scale = 1.0,
+        std::atomic<bool> const * cancel = nullptr);
+
+
+    /**
+    * @brief Get the distribution of the number of non-zeros per column, from
+    * the degrees cached by the matrix.
+    *
+    * @param mat The matrix.
+    * @param progress The progress counter to update.
+    * @param scale The amount of progress this task contributes.
+    * @param cancel The flag which, once set, stops the counting and leaves
+    * the distribution empty.
+    *
+    * @return The distribution.
+    */
+    static fine_histogram_struct columnDegrees(
+        Matrix * mat,
+        double * progress = nullptr,
+        double scale = 1.0,
+        std::atomic<bool> const * cancel = nullptr);
+
+
+    /**
+    * @brief Get the distribution of the magnitudes of the values, binned in
+    * parallel at sixteen bins per power of two. Zeros are kept as a value of
+    * zero, and non-finite values are left out.
+    *
+    * @param mat The matrix.
+    * @param progress The progress counter to update.
+    * @param scale The amount of progress this task contributes.
+    * @param cancel The flag which, once set, stops the binning and leaves
+    * the distribution incomplete.
+    *
+    * @return The distribution.
+    */
+    static fine_histogram_struct valueMagnitudes(
+        Matrix const * mat,
+        double * progress = nullptr,
+        double scale = 1.0,
+        std::atomic<bool> const * cancel = nullptr);
+
+
+    /**
+    * @brief Estimate the distribution of the number of non-zeros per row
+    * from a uniform sample of rows, with the counts scaled up to the number
+    * of rows. In half storage the rows do not hold all of their non-zeros,
+    * so nothing is estimated and the distribution is empty.
+    *
+    * @param mat The matrix.
+    * @param numSamples The number of rows to sample.
+    * @param seed The seed of the sample.
+    *
+    * @return The estimated distribution.
+    */
+    static fine_histogram_struct sampleRowDegrees(
+        Matrix const * mat,
+        dim_type numSamples,
+        uint64_t seed);
+
+
+    /**
+    * @brief Estimate the distribution of the magnitudes of the values from a
+    * uniform sample of the non-zeros, with the counts scaled up to the number
+    * of non-zeros.
+    *
+    * @param mat The matrix.
+    * @param numSamples The number of non-zeros to sample.
+    * @param seed The seed of the sample.
+    *
+    * @return The estimated distribution.
+    */
+    static fine_histogram_struct sampleValueMagnitudes(
+        Matrix const * mat,
+        index_type numSamples,
+        uint64_t seed);
+
+
+    /**
+    * @brief Re-bucket a distribution into a number of bins spanning its
+    * range. This only touches the distinct values, so it is cheap enough to
+    * do interactively.
+    *
+    * @param fine The distribution.
+    * @param numBins The number of bins (discrete distributions may use fewer,
+    * so that every bin holds at least one integer).
+    * @param scale Whether the bins are evenly spaced linearly or
+    * logarithmically. Logarithmic bins leave out non-positive values.
+    *
+    * @return The histogram.
+    */
+    static histogram_struct bucket(
+        fine_histogram_struct const & fine,
+        int numBins,
+        scale_type scale);
+
+
+    /**
+    * @brief Fit a power law to the tail of a distribution by maximum
+    * likelihood, choosing the start of the tail which minimizes the
+    * Kolmogorov-Smirnov distance (Clauset, Shalizi and Newman). Discrete
+    * distributions use the continuous approximation with x - 1/2.
+    *
+    * @param fine The distribution.
+    *
+    * @return The fit, with numTail of zero if there are too few positive
+    * values to fit.
+    */
+    static power_law_struct fitPowerLaw(
+        fine_histogram_struct const & fine);
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
@@ -0,0 +1,210 @@
+/**
+ * @file Raster.cpp
+ * @brief Implementation of the Raster class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <algorithm>
+#include <cmath>
+#include "Raster.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+
+/**
+* @brief Get the number of pixels needed for a number of rows or columns, by
+* the pixel of the last, as the heat map rounds them.
+*
+* @param num The number of rows or columns.
+* @param scale The number of pixels per row or column.
+*
+* @return The number of pixels.
+*/
+dim_type getNumPixels(
+    dim_type const num,
+    float const scale) noexcept
+{
+  return num > 0 ? static_cast<dim_type>((num - 1) * scale) + 1 : 1;
+}
+
+
+}
+
+
+
+
+/******************************************************************************
+* STATIC PUBLIC FUNCTIONS *****************************************************
+******************************************************************************/
+
+
+Raster::size_struct Raster::fitArea(
+    dim_type const numRows,
+    dim_type const numCols,
+    float const pixels)
+{
+  dim_type const height = std::sqrt(pixels * \
+      (static_cast<float>(numRows) / static_cast<float>(numCols)));
+  dim_type const width = std::ceil(pixels / height);
+
+  float const scale = static_cast<float>(height) / \
+      static_cast<float>(numRows);
+
+  return size_struct{width, height, scale};
+}
+
+
+Raster::size_struct Raster::fitSide(
+    dim_type const numRows,
+    dim_type const numCols,
+    dim_type const side)
+{
+  dim_type const maxDim = std::max(numRows, numCols);
+  float const scale = maxDim > side ? \
+      static_cast<float>(side) / static_cast<float>(maxDim) : 1.0f;
+
+  return size_struct{getNumPixels(numCols, scale), \
+      getNumPixels(numRows, scale), scale};
+}
+
+
+void Raster::buildLevels(
+    std::vector<HeatMap> * const levels,
+    HeatMap::pool_type const pooling)
+{
+  // reserve every level up front, as a heat map is copied when moved
+  size_t numLevels = 1;
+  for (dim_type size = std::max(levels->front().getWidth(), \
+      levels->front().getHeight()); size > 1; size /= 2) {
+    ++numLevels;
+  }
+  levels->reserve(numLevels);
+
+  while (levels->back().getWidth() > 1 || levels->back().getHeight() > 1) {
+    levels->emplace_back(levels->back().pool(pooling));
+  }
+}
+
+
+std::vector<std::vector<uint32_t>> Raster::colorLevels(
+    std::vector<HeatMap> const & levels,
+    ColorMap const & colorMap)
+{
+  std::vector<std::vector<uint32_t>> pixels(levels.size());
+  for (size_t level = 0; level < levels.size(); ++level) {
+    HeatMap const & heatmap = levels[level];
+    pixels[level].resize(heatmap.getValues()->size());
+    colorMap.apply(heatmap.getValues()->data(), pixels[level].size(), \
+        heatmap.getMin(), heatmap.getMax(), pixels[level].data());
+  }
+
+  return pixels;
+}
+
+
+ColorMap Raster::getColorMap(
+    ColorMap const & colorMap,
+    HeatMap::mode_type const mode)
+{
+  if (mode == HeatMap::SIGNED_SUM_MODE) {
+    return ColorMap(ColorMap::DIVERGING);
+  }
+
+  return colorMap;
+}
+
+
+value_type Raster::getRegionMax(
+    value_type const overviewMax,
+    float const overviewScale,
+    unsigned const shift,
+    HeatMap::mode_type const mode)
+{
+  if (mode == HeatMap::MAX_MODE || mode == HeatMap::MEAN_MODE) {
+    return overviewMax;
+  }
+
+  double const area = std::ldexp(1.0, 2 * shift);
+  double const overviewArea = 1.0 / (static_cast<double>(overviewScale) * \
+      overviewScale);
+  double const max = overviewMax * area / overviewArea;
+
+  if (mode != HeatMap::COUNT_MODE) {
+    return static_cast<value_type>(max);
+  }
+
+  return static_cast<value_type>(std::min(area, std::max(1.0, max)));
+}
+
+
+void Raster::render(
+    CSRMatrix const & matrix,
+    size_struct const & size,
+    HeatMap::mode_type const mode,
+    ColorMap const & colorMap,
+    band_writer_type const & write,
+    size_t const bandPixels)
+{
+  ColorMap const colors = getColorMap(colorMap, mode);
+  dim_type const width = size.width;
+  dim_type const height = size.height;
+  dim_type const bandHeight = static_cast<dim_type>(std::min<size_t>( \
+      height, std::max<size_t>(1, bandPixels / width)));
+
+  HeatMap heatmap(width, bandHeight);
+  heatmap.setMode(mode);
+  std::vector<uint32_t> pixels(heatmap.getValues()->size());
+
+  if (bandHeight == height) {
+    heatmap.countNonZeros(matrix, size.scale);
+    colors.apply(heatmap.getValues()->data(), pixels.size(), \
+        heatmap.getMin(), heatmap.getMax(), pixels.data());
+    write(0, height, pixels.data());
+    return;
+  }
+
+  // the colors depend on the range of the whole image, so the bands are
+  // counted once to find it, as their counts may not all fit in memory
+  value_type min = 0;
+  value_type max = 0;
+  for (dim_type first = 0; first < height; first += bandHeight) {
+    dim_type const numLines = std::min(bandHeight, height - first);
+    heatmap.resize(width, numLines);
+    heatmap.countBand(matrix, size.scale, first);
+    min = first == 0 ? heatmap.getMin() : std::min(min, heatmap.getMin());
+    max = first == 0 ? heatmap.getMax() : std::max(max, heatmap.getMax());
+  }
+
+  for (dim_type first = 0; first < height; first += bandHeight) {
+    dim_type const numLines = std::min(bandHeight, height - first);
+    heatmap.resize(width, numLines);
+    heatmap.countBand(matrix, size.scale, first);
+    size_t const numPixels = heatmap.getValues()->size();
+    colors.apply(heatmap.getValues()->data(), numPixels, min, max, \
+        pixels.data());
+    write(first, numLines, pixels.data());
+  }
+}
+
+
+
+
+}
@@ -0,0 +1,194 @@
+/**
+ * @file Raster.hpp
+ * @brief The Raster class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_OPERATIONS_RASTER_HPP
+#define MATRIXINSPECTOR_OPERATIONS_RASTER_HPP
+
+
+
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "Data/ColorMap.hpp"
+#include "Data/CSRMatrix.hpp"
+#include "Data/HeatMap.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/**
+* @brief Turns matrices into images of the density of their non-zeros: their
+* binning into heat maps, the normalization of the heat maps, and their
+* coloring. None of it needs a display, so it is shared by the views and the
+* command line renderer.
+*/
+class Raster
+{
+  public:
+    /**
+    * @brief The size of a heat map of a matrix.
+    */
+    struct size_struct
+    {
+      dim_type width;
+      dim_type height;
+      // the number of pixels per row and column of the matrix
+      float scale;
+    };
+
+
+    /**
+    * @brief A function which is handed the pixels of a band of rows of an
+    * image, with the first row of the band and the number of rows in it.
+    */
+    typedef std::function<void (dim_type, dim_type, uint32_t const *)> \
+        band_writer_type;
+
+
+    /**
+    * @brief Size a heat map to have about a number of pixels, in the shape
+    * of the matrix.
+    *
+    * @param numRows The number of rows of the matrix.
+    * @param numCols The number of columns of the matrix.
+    * @param pixels The number of pixels.
+    *
+    * @return The size.
+    */
+    static size_struct fitArea(
+        dim_type numRows,
+        dim_type numCols,
+        float pixels);
+
+
+    /**
+    * @brief Size a heat map to have its longer side a number of pixels, in
+    * the shape of the matrix. It is never larger than the matrix, which
+    * would only leave gaps between the pixels of the non-zeros.
+    *
+    * @param numRows The number of rows of the matrix.
+    * @param numCols The number of columns of the matrix.
+    * @param side The number of pixels of the longer side.
+    *
+    * @return The size.
+    */
+    static size_struct fitSide(
+        dim_type numRows,
+        dim_type numCols,
+        dim_type side);
+
+
+    /**
+    * @brief Add the coarser levels of a mip chain, down to a single pixel,
+    * which are pooled from the counts rather than averaged from the colors.
+    *
+    * @param levels The finest level, to which the others are added (input
+    * and output).
+    * @param pooling How the pixels of each level are pooled.
+    */
+    static void buildLevels(
+        std::vector<HeatMap> * levels,
+        HeatMap::pool_type pooling);
+
+
+    /**
+    * @brief Color each level of a mip chain by its own range.
+    *
+    * @param levels The levels.
+    * @param colorMap The colors.
+    *
+    * @return The pixels of each level.
+    */
+    static std::vector<std::vector<uint32_t>> colorLevels(
+        std::vector<HeatMap> const & levels,
+        ColorMap const & colorMap);
+
+
+    /**
+    * @brief Get the colors to draw a heat map of a mode in, which are
+    * diverging for signed values.
+    *
+    * @param colorMap The colors chosen.
+    * @param mode The mode of the heat map.
+    *
+    * @return The colors.
+    */
+    static ColorMap getColorMap(
+        ColorMap const & colorMap,
+        HeatMap::mode_type mode);
+
+
+    /**
+    * @brief Get the value to color as the largest of a heat map with pixels
+    * of 2^shift rows and columns, such that it matches the density of the
+    * non-zeros of a coarser heat map of the whole matrix. A count is never
+    * more than the number of entries of a pixel, nor less than one. The
+    * largest and average magnitudes do not depend on the size of a pixel,
+    * so they are those of the coarser heat map.
+    *
+    * @param overviewMax The largest value of the coarser heat map, or the
+    * largest magnitude if signed.
+    * @param overviewScale The number of pixels per row and column of the
+    * coarser heat map.
+    * @param shift The base two logarithm of the rows and columns per pixel.
+    * @param mode The mode of the heat maps.
+    *
+    * @return The largest value.
+    */
+    static value_type getRegionMax(
+        value_type overviewMax,
+        float overviewScale,
+        unsigned shift,
+        HeatMap::mode_type mode = HeatMap::COUNT_MODE);
+
+
+    /**
+    * @brief Render the heat map of the non-zeros of a matrix, normalized by
+    * its range, into colored pixels. Images larger than a number of pixels
+    * are counted in bands of whole rows of pixels, once to find their range
+    * and again to color them, so that the full heat map is never held in
+    * memory. The bands are handed to the writer in order, from the top.
+    * Signed values are drawn in diverging colors, whatever the colors given.
+    *
+    * @param matrix The matrix, which is mirrored if in half storage.
+    * @param size The size of the image.
+    * @param mode What each pixel is made of the non-zeros in it.
+    * @param colorMap The colors.
+    * @param write The function to hand each band of pixels to.
+    * @param bandPixels The most pixels to count at once.
+    */
+    static void render(
+        CSRMatrix const & matrix,
+        size_struct const & size,
+        HeatMap::mode_type mode,
+        ColorMap const & colorMap,
+        band_writer_type const & write,
+        size_t bandPixels = 1 << 22);
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
@@ -11,10 +11,10 @@
 
 #include <vector>
 #include "Operations/Reorder.hpp"
-#include "Operations/Stats.hpp"
 #include "Data/CSRMatrix.hpp"
 #include "Utility/Sort.hpp"
-#include "Utility/Random.hpp"
+#include "Utility/FeistelPermutation.hpp"
+#include "Utility/Parallel.hpp"
 #include "Utility/Debug.hpp"
 
 
@@ -32,6 +32,33 @@ namespace MatrixInspector
 namespace
 {
 
+// rows and columns are permuted independently from the same seed
+uint32_t const ROW_STREAM = 0;
+uint32_t const COLUMN_STREAM = 1;
+
+
+/**
+* @brief Store a permutation as an array.
+*
+* @param perm The permutation.
+*
+* @return The array, where array[new] = old.
+*/
+std::vector<dim_type> toArray(
+    FeistelPermutation const & perm)
+{
+  std::vector<dim_type> array(perm.size());
+  Parallel::forRange(array.size(), \
+      [&](unsigned, size_t const start, size_t const end) {
+    for (size_t i = start; i < end; ++i) {
+      array[i] = static_cast<dim_type>(perm(i));
+    }
+  });
+
+  return array;
+}
+
+
 template< typename K>
 void reorderViaKeys(
     Matrix * const matrix,
@@ -103,49 +130,42 @@ void Reorder::random(
   dim_type const numRows = matrix->getNumRows();
   dim_type const numCols = matrix->getNumColumns();
 
-  Random::setSeed(seed);
+  assert(rows || columns);
+  assert(!symmetric || (rows && columns));
+  ASSERT_TRUE((!symmetric || numRows == numCols));
+
+  FeistelPermutation const rowPerm(numRows, seed, ROW_STREAM);
+  FeistelPermutation const colPerm(numCols, seed, COLUMN_STREAM);
+
+  FeistelPermutation const * const rowPermPtr = rows ? &rowPerm : nullptr;
+  FeistelPermutation const * const colPermPtr = !columns ? nullptr : \
+      (symmetric ? &rowPerm : &colPerm);
+
+  CSRMatrix * const csr = dynamic_cast<CSRMatrix*>(matrix); 
+  if (csr != nullptr) {
+    // the permutations are computed as they are applied
+    csr->reorder(rowPermPtr,colPermPtr,progress,scale);
+    return;
+  }
 
-  dim_type const * permRowPtr = nullptr;
-  dim_type const * permColPtr = nullptr;
   std::vector<dim_type> permRow;
   std::vector<dim_type> permCol;
 
-  if (rows && columns && symmetric) {
-    ASSERT_EQUAL(numRows,numCols);
-    permRow.resize(numRows);
-    Random::permutation(permRow.data(),numRows);
-
-    permRowPtr = permRow.data();
-    permColPtr = permRow.data();
-  } else if (rows && columns) {
-    assert(!symmetric);
-    permRow.resize(numRows);
-    Random::permutation(permRow.data(),numRows);
-
-    permCol.resize(numCols);
-    Random::permutation(permCol.data(),numCols);
-
-    permRowPtr = permRow.data();
-    permColPtr = permCol.data();
-  } else if (rows) {
-    assert(!symmetric);
-    permRow.resize(numRows);
-    Random::permutation(permRow.data(),numRows);
-
-    permRowPtr = permRow.data();
-  } else {
-    assert(!symmetric);
-    assert(columns);
-    permCol.resize(numCols);
-    Random::permutation(permCol.data(),numCols);
-
-    permColPtr = permCol.data();
+  if (rowPermPtr != nullptr) {
+    permRow = toArray(rowPerm);
+  }
+  if (colPermPtr != nullptr && !symmetric) {
+    permCol = toArray(colPerm);
   }
 
   if (progress != nullptr) {
     *progress += scale*0.1;
   }
 
+  dim_type const * const permRowPtr = rows ? permRow.data() : nullptr;
+  dim_type const * const permColPtr = !columns ? nullptr : \
+      (symmetric ? permRow.data() : permCol.data());
+
   matrix->reorder(permRowPtr,permColPtr,progress,scale*0.9);
 }
 
@@ -158,20 +178,15 @@ void Reorder::density(
     double * const progress,
     double const scale)
 {
-  dim_type const numRows = matrix->getNumRows();
-  dim_type const numCols = matrix->getNumColumns();
-
-  CSRMatrix * const csr = dynamic_cast<CSRMatrix*>(matrix); 
-
   dim_type const * rowKeysPtr = nullptr;
   std::vector<dim_type> rowKeys;
 
   dim_type const * colKeysPtr = nullptr;
   std::vector<dim_type> colKeys;
 
+  // the keys are copied out of the degree cache, as the reorder permutes it
   if (rows) {
-    rowKeys.resize(numRows);
-    Stats::countRowNonZeros(csr,rowKeys.data());
+    rowKeys = matrix->getRowDegrees();
 
     rowKeysPtr = rowKeys.data();
   }
@@ -181,8 +196,7 @@ void Reorder::density(
   }
 
   if (columns) {
-    colKeys.resize(numCols);
-    Stats::countColumnNonZeros(csr,colKeys.data());
+    colKeys = matrix->getColumnDegrees();
 
     colKeysPtr = colKeys.data();
   }
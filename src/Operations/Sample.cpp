@@ -9,13 +9,18 @@
 
 
 
-#include <vector>
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include "Sample.hpp"
-#include "Operations/Stats.hpp"
 #include "Data/CSRMatrix.hpp"
+#include "Utility/Parallel.hpp"
+#include "Utility/PrefixSum.hpp"
 #include "Utility/Random.hpp"
-#include "Utility/Linear.hpp"
+#include "Utility/WeightedSample.hpp"
 #include "Utility/Debug.hpp"
 
 
@@ -25,6 +30,379 @@ namespace MatrixInspector
 {
 
 
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+// the number of steps a walker takes without finding a new vertex before
+// starting over from another random vertex
+dim_type const MAX_STALLED_STEPS = 1024;
+
+// the number of steps between progress updates
+dim_type const PROGRESS_INTERVAL = 4096;
+
+// the fraction of the progress spent choosing the vertices of a graph sample,
+// with the rest spent reducing the matrix to them
+double const SEARCH_FRACTION = 0.5;
+
+}
+
+
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+
+/**
+* @brief The neighbors of each vertex of a graph stored as a square CSR
+* matrix. In half storage only the lower triangle is stored, so the neighbors
+* above the diagonal are found through its transpose, which is built without
+* the values.
+*/
+class Adjacency
+{
+  public:
+    Adjacency(
+        CSRMatrix const * const csr) :
+      m_offsets(csr->getOffsets()),
+      m_columns(csr->getColumns()),
+      m_upperOffsets(),
+      m_upperColumns()
+    {
+      if (csr->isHalfStorage()) {
+        buildUpper(csr->getNumRows());
+      }
+    }
+
+
+    inline dim_type degree(
+        dim_type const v) const noexcept
+    {
+      index_type size = m_offsets[v+1] - m_offsets[v];
+      if (!m_upperOffsets.empty()) {
+        size += m_upperOffsets[v+1] - m_upperOffsets[v];
+      }
+      return static_cast<dim_type>(size);
+    }
+
+
+    inline dim_type neighbor(
+        dim_type const v,
+        dim_type const k) const noexcept
+    {
+      index_type const lower = m_offsets[v+1] - m_offsets[v];
+      if (k < lower) {
+        return m_columns[m_offsets[v]+k];
+      }
+      return m_upperColumns[m_upperOffsets[v] + (k - lower)];
+    }
+
+
+  private:
+    index_type const * m_offsets;
+    dim_type const * m_columns;
+    std::vector<index_type> m_upperOffsets;
+    std::vector<dim_type> m_upperColumns;
+
+
+    void buildUpper(
+        dim_type const numRows)
+    {
+      std::unique_ptr<std::atomic<index_type>[]> next( \
+          new std::atomic<index_type>[numRows]);
+      Parallel::forRange(numRows, \
+          [&](unsigned, size_t const start, size_t const end) {
+        for (size_t i = start; i < end; ++i) {
+          next[i].store(0, std::memory_order_relaxed);
+        }
+      });
+
+      // count the strictly lower entries of each column
+      unsigned const numThreads = Parallel::getNumThreads();
+      Parallel::run(numThreads, [&](unsigned const tid) {
+        dim_type const start = Parallel::getRowChunkStart(m_offsets, \
+            numRows, numThreads, tid);
+        dim_type const end = Parallel::getRowChunkStart(m_offsets, \
+            numRows, numThreads, tid+1);
+        for (dim_type row = start; row < end; ++row) {
+          for (index_type idx = m_offsets[row]; idx < m_offsets[row+1]; \
+              ++idx) {
+            if (m_columns[idx] < row) {
+              next[m_columns[idx]].fetch_add(1, std::memory_order_relaxed);
+            }
+          }
+        }
+      });
+
+      m_upperOffsets.resize(numRows+1);
+      m_upperOffsets[0] = 0;
+      for (dim_type i = 0; i < numRows; ++i) {
+        m_upperOffsets[i+1] = next[i].load(std::memory_order_relaxed);
+        next[i].store(0, std::memory_order_relaxed);
+      }
+      PrefixSum::inclusive(m_upperOffsets.data()+1, numRows);
+
+      m_upperColumns.resize(m_upperOffsets[numRows]);
+      Parallel::run(numThreads, [&](unsigned const tid) {
+        dim_type const start = Parallel::getRowChunkStart(m_offsets, \
+            numRows, numThreads, tid);
+        dim_type const end = Parallel::getRowChunkStart(m_offsets, \
+            numRows, numThreads, tid+1);
+        for (dim_type row = start; row < end; ++row) {
+          for (index_type idx = m_offsets[row]; idx < m_offsets[row+1]; \
+              ++idx) {
+            dim_type const col = m_columns[idx];
+            if (col < row) {
+              m_upperColumns[m_upperOffsets[col] + \
+                  next[col].fetch_add(1, std::memory_order_relaxed)] = row;
+            }
+          }
+        }
+      });
+
+      // the order the rows land in depends on the threads, so sort them such
+      // that the neighbors of a vertex do not
+      Parallel::forRange(numRows, \
+          [&](unsigned, size_t const start, size_t const end) {
+        for (size_t i = start; i < end; ++i) {
+          std::sort(m_upperColumns.begin() + m_upperOffsets[i], \
+              m_upperColumns.begin() + m_upperOffsets[i+1]);
+        }
+      });
+    }
+
+
+    // disable copying
+    Adjacency(
+        Adjacency const & rhs);
+    Adjacency & operator=(
+        Adjacency const & rhs);
+};
+
+
+/**
+* @brief A set of vertices which threads add to concurrently, up to a maximum
+* size.
+*/
+class VertexSet
+{
+  public:
+    VertexSet(
+        dim_type const numVertices,
+        dim_type const maxSize) :
+      m_numVertices(numVertices),
+      m_maxSize(maxSize),
+      m_size(0),
+      m_flags(new std::atomic<char>[numVertices])
+    {
+      Parallel::forRange(numVertices, \
+          [&](unsigned, size_t const start, size_t const end) {
+        for (size_t i = start; i < end; ++i) {
+          m_flags[i].store(0, std::memory_order_relaxed);
+        }
+      });
+    }
+
+
+    inline bool isFull() const noexcept
+    {
+      return m_size.load(std::memory_order_relaxed) >= m_maxSize;
+    }
+
+
+    inline bool contains(
+        dim_type const v) const noexcept
+    {
+      return m_flags[v].load(std::memory_order_relaxed) != 0;
+    }
+
+
+    inline dim_type size() const noexcept
+    {
+      return std::min(m_size.load(std::memory_order_relaxed), m_maxSize);
+    }
+
+
+    /**
+    * @brief Add a vertex to the set.
+    *
+    * @param v The vertex.
+    *
+    * @return True if the vertex was added by this call, and false if it was
+    * already in the set, or the set is full.
+    */
+    inline bool add(
+        dim_type const v) noexcept
+    {
+      if (isFull() || contains(v) || m_flags[v].exchange(1) != 0) {
+        return false;
+      }
+
+      if (m_size.fetch_add(1) >= m_maxSize) {
+        // another thread filled the set first
+        m_flags[v].store(0);
+        return false;
+      }
+
+      return true;
+    }
+
+
+    /**
+    * @brief Get the vertices in the set in ascending order, as reduce
+    * requires them.
+    *
+    * @return The vertices.
+    */
+    std::vector<dim_type> getSorted() const
+    {
+      std::vector<std::vector<dim_type>> parts(Parallel::getNumThreads());
+      unsigned const numParts = Parallel::forRange(m_numVertices, \
+          [&](unsigned const tid, size_t const start, size_t const end) {
+        for (size_t i = start; i < end; ++i) {
+          if (contains(static_cast<dim_type>(i))) {
+            parts[tid].emplace_back(static_cast<dim_type>(i));
+          }
+        }
+      });
+
+      std::vector<dim_type> vertices;
+      vertices.reserve(size());
+      for (unsigned part = 0; part < numParts; ++part) {
+        vertices.insert(vertices.end(), parts[part].begin(), \
+            parts[part].end());
+      }
+
+      return vertices;
+    }
+
+
+  private:
+    dim_type m_numVertices;
+    dim_type m_maxSize;
+    std::atomic<dim_type> m_size;
+    std::unique_ptr<std::atomic<char>[]> m_flags;
+};
+
+
+/**
+* @brief Get the matrix to sample as a graph.
+*
+* @param matrix The matrix.
+*
+* @return The matrix in CSR form.
+*/
+CSRMatrix * getGraph(
+    Matrix * const matrix)
+{
+  CSRMatrix * const csr = dynamic_cast<CSRMatrix*>(matrix);
+
+  ASSERT_NOTNULL(csr);
+
+  if (!csr->isSquare()) {
+    throw std::runtime_error("Cannot do graph sampling on non-square " \
+        "matrix");
+  }
+
+  return csr;
+}
+
+
+/**
+* @brief Report the progress of filling a set of vertices.
+*
+* @param set The set of vertices.
+* @param target The number of vertices to fill it with.
+* @param progress The progress counter to update (may be null).
+* @param scale The amount of progress filling the set contributes.
+* @param reported The amount of progress reported so far (updated).
+*/
+void reportProgress(
+    VertexSet const & set,
+    dim_type const target,
+    double * const progress,
+    double const scale,
+    double * const reported)
+{
+  if (progress != nullptr && target > 0) {
+    double const done = scale * set.size() / target;
+    *progress += done - *reported;
+    *reported = done;
+  }
+}
+
+
+/**
+* @brief Sample indices by their weights, or take all of them.
+*
+* @tparam W The weight type.
+* @param weights The weights.
+* @param len The number of indices.
+* @param sampleLen The number of indices to sample.
+* @param seed The seed.
+*
+* @return The sampled indices in ascending order.
+*/
+template<typename W>
+std::vector<dim_type> sampleWeighted(
+    W const * const weights,
+    dim_type const len,
+    dim_type const sampleLen,
+    uint64_t const seed)
+{
+  std::vector<dim_type> sample(sampleLen);
+  if (sampleLen >= len) {
+    // no need to weigh them
+    sample.resize(len);
+    for (dim_type i = 0; i < len; ++i) {
+      sample[i] = i;
+    }
+  } else {
+    WeightedSample::sortedSample(weights, len, sample.data(), sampleLen, \
+        seed);
+  }
+
+  return sample;
+}
+
+
+/**
+* @brief Reduce a graph to the subgraph induced by a set of vertices.
+*
+* @param csr The graph.
+* @param set The set of vertices.
+* @param progress The progress counter to update.
+* @param scale The amount of progress this task contributes.
+*/
+void induce(
+    CSRMatrix * const csr,
+    VertexSet const & set,
+    double * const progress,
+    double const scale)
+{
+  std::vector<dim_type> const vertices = set.getSorted();
+  dim_type const numVertices = static_cast<dim_type>(vertices.size());
+
+  csr->reduce(vertices.data(), numVertices, vertices.data(), numVertices, \
+      progress, scale);
+}
+
+
+}
+
+
+
+
 /******************************************************************************
 * PUBLIC STATIC FUNCTIONS *****************************************************
 ******************************************************************************/
@@ -44,11 +422,14 @@ void Sample::random(
   ASSERT_LESSEQUAL(numSampleRows,numRows);
   ASSERT_LESSEQUAL(numSampleCols,numCols);
 
-  std::vector<dim_type> rows;
+  // the samples are drawn in ascending order, as reduce requires them
+  std::vector<dim_type> rows(numSampleRows);
   std::vector<dim_type> cols;
 
-  dim_type const * rowPtr = nullptr;
-  dim_type const * colPtr = nullptr;
+  dim_type const * rowPtr = rows.data();
+  dim_type const * colPtr = rows.data();
+
+  Random rng(Random::randomSeed());
 
   if (symmetric) {
     ASSERT_EQUAL(numSampleRows,numSampleCols);
@@ -59,50 +440,74 @@ void Sample::random(
           "non-square matrix");
     }
 
-    rows.resize(numRows);
+    rng.sortedSample(rows.data(),numRows,numSampleRows);
+  } else {
+    cols.resize(numSampleCols);
+    colPtr = cols.data();
 
-    rowPtr = rows.data();
-    colPtr = rows.data();
+    rng.sortedSample(rows.data(),numRows,numSampleRows);
+    rng.sortedSample(cols.data(),numCols,numSampleCols);
+  }
 
-    Linear::step(rows.data(),numRows);
+  if (progress != nullptr) {
+    *progress += scale*0.2;
+  }
 
-    if (progress != nullptr) {
-      *progress += scale*0.1;
-    }
+  matrix->reduce(rowPtr,numSampleRows,colPtr,numSampleCols,progress,scale*0.8);
+}
 
-    Random::sample(rows.data(),numRows,numSampleRows);
 
-    std::sort(rows.data(),rows.data()+numSampleRows);
+void Sample::weighted(
+    Matrix * const matrix,
+    dim_type const numSampleRows,
+    dim_type const numSampleCols,
+    value_type const * const rowWeights,
+    value_type const * const colWeights,
+    bool const symmetric,
+    uint64_t const seed,
+    double * const progress,
+    double const scale)
+{
+  CSRMatrix * const csr = dynamic_cast<CSRMatrix*>(matrix);
 
-    if (progress != nullptr) {
-      *progress += scale*0.1;
-    }
-  } else {
-    rows.resize(numRows);
-    cols.resize(numCols);
+  ASSERT_NOTNULL(csr);
 
-    rowPtr = rows.data();
-    colPtr = cols.data();
+  dim_type const numRows = csr->getNumRows();
+  dim_type const numCols = csr->getNumColumns();
 
-    Linear::step(rows.data(),numRows);
-    Linear::step(cols.data(),numCols);
+  ASSERT_LESSEQUAL(numSampleRows,numRows);
+  ASSERT_LESSEQUAL(numSampleCols,numCols);
 
-    if (progress != nullptr) {
-      *progress += scale*0.1;
-    }
+  if (symmetric) {
+    ASSERT_EQUAL(numSampleRows,numSampleCols);
 
-    Random::sample(rows.data(),numRows,numSampleRows);
-    Random::sample(cols.data(),numCols,numSampleCols);
+    // make sure the matrix is square
+    if (!matrix->isSquare()) {
+      throw std::runtime_error("Cannot do symmetric sampling on " \
+          "non-square matrix");
+    }
+  }
 
-    std::sort(rows.data(),rows.data()+numSampleRows);
-    std::sort(cols.data(),cols.data()+numSampleCols);
+  // the columns are drawn with a different seed than the rows
+  std::vector<dim_type> const rows = rowWeights != nullptr ? \
+      sampleWeighted(rowWeights, numRows, numSampleRows, seed) : \
+      sampleWeighted(csr->getRowDegrees().data(), numRows, numSampleRows, \
+          seed);
+  std::vector<dim_type> cols;
+  if (!symmetric) {
+    cols = colWeights != nullptr ? \
+        sampleWeighted(colWeights, numCols, numSampleCols, ~seed) : \
+        sampleWeighted(csr->getColumnDegrees().data(), numCols, \
+            numSampleCols, ~seed);
+  }
+  std::vector<dim_type> const & sampleCols = symmetric ? rows : cols;
 
-    if (progress != nullptr) {
-      *progress += scale*0.1;
-    }
+  if (progress != nullptr) {
+    *progress += scale*0.2;
   }
 
-  matrix->reduce(rowPtr,numSampleRows,colPtr,numSampleCols,progress,scale*0.8);
+  csr->reduce(rows.data(), rows.size(), sampleCols.data(), sampleCols.size(), \
+      progress, scale*0.8);
 }
 
 
@@ -123,13 +528,14 @@ void Sample::thresholdRows(
   std::vector<dim_type> sampleRows;
   sampleRows.reserve(numRows);
 
-  index_type const * const offsets = csr->getOffsets();
+  // the cached counts include the mirrored entries of half storage
+  std::vector<dim_type> const & rowCounts = csr->getRowDegrees();
 
   dim_type const interval = numCols > 10 ? numRows / 10 : 1; 
   double const increment = scale*0.01;
 
   for (dim_type row = 0; row < numRows; ++row) {
-    dim_type size = offsets[row+1] - offsets[row];
+    dim_type const size = rowCounts[row];
     if (size >= minRowSize && size <= maxRowSize) {
       sampleRows.emplace_back(row);
     }
@@ -162,8 +568,7 @@ void Sample::thresholdColumns(
   sampleCols.reserve(numCols);
 
   // count columns
-  std::vector<dim_type> colCounts(numCols,0);
-  Stats::countColumnNonZeros(csr,colCounts.data());
+  std::vector<dim_type> const & colCounts = csr->getColumnDegrees();
 
   if (progress != nullptr) {
     *progress += scale*0.1;
@@ -188,6 +593,213 @@ void Sample::thresholdColumns(
 }
 
 
+void Sample::randomWalk(
+    Matrix * const matrix,
+    dim_type const numVertices,
+    double const restartProbability,
+    uint64_t const seed,
+    double * const progress,
+    double const scale)
+{
+  CSRMatrix * const csr = getGraph(matrix);
+  dim_type const numRows = csr->getNumRows();
+
+  ASSERT_LESSEQUAL(numVertices,numRows);
+  dim_type const target = std::min(numVertices, numRows);
+
+  Adjacency const adj(csr);
+  VertexSet set(numRows, target);
+
+  double const searchScale = scale*SEARCH_FRACTION;
+  double reported = 0;
+
+  Parallel::run(Parallel::getNumThreads(target), [&](unsigned const tid) {
+    Random rng(seed, tid);
+    dim_type steps = 0;
+    while (!set.isFull()) {
+      dim_type const start = rng.inRange<dim_type>(0, numRows-1);
+      set.add(start);
+
+      dim_type current = start;
+      dim_type stalled = 0;
+      while (stalled < MAX_STALLED_STEPS && !set.isFull()) {
+        dim_type const degree = adj.degree(current);
+        if (degree == 0 || rng.uniform() < restartProbability) {
+          current = start;
+        } else {
+          current = adj.neighbor(current, \
+              rng.inRange<dim_type>(0, degree-1));
+        }
+
+        if (set.add(current)) {
+          stalled = 0;
+        } else {
+          ++stalled;
+        }
+
+        // only the first thread reports progress
+        if (tid == 0 && ++steps % PROGRESS_INTERVAL == 0) {
+          reportProgress(set, target, progress, searchScale, &reported);
+        }
+      }
+    }
+  });
+
+  if (progress != nullptr) {
+    *progress += searchScale - reported;
+  }
+
+  induce(csr, set, progress, scale-searchScale);
+}
+
+
+void Sample::forestFire(
+    Matrix * const matrix,
+    dim_type const numVertices,
+    double const burnProbability,
+    uint64_t const seed,
+    double * const progress,
+    double const scale)
+{
+  CSRMatrix * const csr = getGraph(matrix);
+  dim_type const numRows = csr->getNumRows();
+
+  ASSERT_LESSEQUAL(numVertices,numRows);
+  dim_type const target = std::min(numVertices, numRows);
+
+  Adjacency const adj(csr);
+  VertexSet set(numRows, target);
+
+  double const searchScale = scale*SEARCH_FRACTION;
+  double reported = 0;
+
+  Parallel::run(Parallel::getNumThreads(target), [&](unsigned const tid) {
+    Random rng(seed, tid);
+    std::vector<dim_type> burning;
+    std::vector<dim_type> unburnt;
+    dim_type steps = 0;
+    while (!set.isFull()) {
+      dim_type const start = rng.inRange<dim_type>(0, numRows-1);
+      if (!set.add(start)) {
+        continue;
+      }
+
+      // the fire spreads breadth first from where it started
+      burning.assign(1, start);
+      for (size_t head = 0; head < burning.size() && !set.isFull(); ++head) {
+        dim_type const v = burning[head];
+        dim_type const degree = adj.degree(v);
+
+        unburnt.clear();
+        for (dim_type k = 0; k < degree; ++k) {
+          dim_type const u = adj.neighbor(v, k);
+          if (!set.contains(u)) {
+            unburnt.emplace_back(u);
+          }
+        }
+
+        // the number of neighbors to burn is geometrically distributed
+        dim_type numBurn = 0;
+        while (numBurn < unburnt.size() && rng.uniform() < burnProbability) {
+          ++numBurn;
+        }
+
+        // burn a random subset of them
+        for (size_t i = 0; i < unburnt.size() && numBurn > 0; ++i) {
+          std::swap(unburnt[i], \
+              unburnt[rng.inRange<size_t>(i, unburnt.size()-1)]);
+          if (set.add(unburnt[i])) {
+            burning.emplace_back(unburnt[i]);
+            --numBurn;
+          }
+        }
+
+        // only the first thread reports progress
+        if (tid == 0 && ++steps % PROGRESS_INTERVAL == 0) {
+          reportProgress(set, target, progress, searchScale, &reported);
+        }
+      }
+    }
+  });
+
+  if (progress != nullptr) {
+    *progress += searchScale - reported;
+  }
+
+  induce(csr, set, progress, scale-searchScale);
+}
+
+
+void Sample::neighborhood(
+    Matrix * const matrix,
+    dim_type const * const seeds,
+    dim_type const numSeeds,
+    dim_type const numHops,
+    double * const progress,
+    double const scale)
+{
+  CSRMatrix * const csr = getGraph(matrix);
+  dim_type const numRows = csr->getNumRows();
+
+  for (dim_type i = 0; i < numSeeds; ++i) {
+    if (seeds[i] >= numRows) {
+      throw std::runtime_error("Seed vertex " + std::to_string(seeds[i]) + \
+          " is not in the matrix.");
+    }
+  }
+
+  Adjacency const adj(csr);
+  VertexSet set(numRows, numRows);
+
+  std::vector<dim_type> frontier;
+  for (dim_type i = 0; i < numSeeds; ++i) {
+    if (set.add(seeds[i])) {
+      frontier.emplace_back(seeds[i]);
+    }
+  }
+
+  double const searchScale = scale*SEARCH_FRACTION;
+
+  // expand the frontier one hop at a time, with each thread collecting the
+  // vertices it adds
+  std::vector<std::vector<dim_type>> next(Parallel::getNumThreads());
+  dim_type hop = 0;
+  for (; hop < numHops && !frontier.empty(); ++hop) {
+    unsigned const numParts = Parallel::forRange(frontier.size(), \
+        [&](unsigned const tid, size_t const start, size_t const end) {
+      next[tid].clear();
+      for (size_t i = start; i < end; ++i) {
+        dim_type const v = frontier[i];
+        dim_type const degree = adj.degree(v);
+        for (dim_type k = 0; k < degree; ++k) {
+          dim_type const u = adj.neighbor(v, k);
+          if (set.add(u)) {
+            next[tid].emplace_back(u);
+          }
+        }
+      }
+    });
+
+    frontier.clear();
+    for (unsigned part = 0; part < numParts; ++part) {
+      frontier.insert(frontier.end(), next[part].begin(), next[part].end());
+    }
+
+    if (progress != nullptr) {
+      *progress += searchScale / numHops;
+    }
+  }
+
+  // the search may have stopped early
+  if (progress != nullptr) {
+    *progress += numHops > 0 ? searchScale * (numHops - hop) / numHops : \
+        searchScale;
+  }
+
+  induce(csr, set, progress, scale-searchScale);
+}
+
+
 
 
 }
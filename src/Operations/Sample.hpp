@@ -15,6 +15,7 @@
 
 
 
+#include <cstdint>
 #include "Data/Matrix.hpp"
 
 
@@ -36,6 +37,37 @@ class Sample
         double scale = 1.0f);
 
 
+    /**
+    * @brief Sample rows and columns of a matrix with probability
+    * proportional to their weights, drawing them one at a time without
+    * replacement. This keeps the heavy rows and columns which a uniform
+    * sample almost never picks.
+    *
+    * @param matrix The matrix to sample.
+    * @param numRows The number of rows to sample.
+    * @param numCols The number of columns to sample.
+    * @param rowWeights The weight of each row, or null to weight rows by
+    * their number of non-zeros.
+    * @param colWeights The weight of each column, or null to weight columns
+    * by their number of non-zeros.
+    * @param symmetric Whether to sample the same rows and columns (by the
+    * row weights) of a square matrix.
+    * @param seed The seed, which gives the same sample on any machine.
+    * @param progress The progress counter to update.
+    * @param scale The amount of progress this task contributes.
+    */
+    static void weighted(
+        Matrix * matrix,
+        dim_type numRows,
+        dim_type numCols,
+        value_type const * rowWeights,
+        value_type const * colWeights,
+        bool symmetric,
+        uint64_t seed,
+        double * progress = nullptr,
+        double scale = 1.0);
+
+
     static void thresholdRows(
         Matrix * matrix,
         dim_type minRowSize,
@@ -52,6 +84,79 @@ class Sample
         double scale = 1.0f);
 
 
+    /**
+    * @brief Sample the vertices of a graph by random walks with restart, and
+    * reduce the matrix to the subgraph they induce. The rows of the matrix
+    * are the vertices, and the columns of each row its neighbors. A walker
+    * is started from a random vertex on each thread, and returns to its
+    * starting vertex with the given probability at each step, so as to stay
+    * within the local structure around it. A walker which stops finding new
+    * vertices starts over from another random vertex.
+    *
+    * @param matrix The (square) matrix to sample.
+    * @param numVertices The number of vertices to sample.
+    * @param restartProbability The probability of a walker returning to its
+    * starting vertex at each step.
+    * @param seed The seed of the random walks. As the walkers run in
+    * parallel, the sample is not the same for the same seed.
+    * @param progress The progress counter to update.
+    * @param scale The amount of progress this task contributes.
+    */
+    static void randomWalk(
+        Matrix * matrix,
+        dim_type numVertices,
+        double restartProbability,
+        uint64_t seed,
+        double * progress = nullptr,
+        double scale = 1.0);
+
+
+    /**
+    * @brief Sample the vertices of a graph by forest fire, and reduce the
+    * matrix to the subgraph they induce. A fire is started from a random
+    * vertex on each thread, and spreads from each vertex it burns to a
+    * geometrically distributed number of its unburnt neighbors. A fire which
+    * dies out is started again from another random vertex.
+    *
+    * @param matrix The (square) matrix to sample.
+    * @param numVertices The number of vertices to sample.
+    * @param burnProbability The forward burning probability, which gives a
+    * mean of p/(1-p) neighbors burnt from each vertex.
+    * @param seed The seed of the fires. As the fires burn in parallel, the
+    * sample is not the same for the same seed.
+    * @param progress The progress counter to update.
+    * @param scale The amount of progress this task contributes.
+    */
+    static void forestFire(
+        Matrix * matrix,
+        dim_type numVertices,
+        double burnProbability,
+        uint64_t seed,
+        double * progress = nullptr,
+        double scale = 1.0);
+
+
+    /**
+    * @brief Reduce a graph to the subgraph induced by the vertices within a
+    * number of hops of a set of seed vertices, found by a parallel breadth
+    * first search.
+    *
+    * @param matrix The (square) matrix to sample.
+    * @param seeds The seed vertices.
+    * @param numSeeds The number of seed vertices.
+    * @param numHops The number of hops from the seeds to include.
+    * @param progress The progress counter to update.
+    * @param scale The amount of progress this task contributes.
+    */
+    static void neighborhood(
+        Matrix * matrix,
+        dim_type const * seeds,
+        dim_type numSeeds,
+        dim_type numHops,
+        double * progress = nullptr,
+        double scale = 1.0);
+
+
 
 
 };
@@ -10,7 +10,20 @@
 
 
 #include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 #include "Data/CSRMatrix.hpp"
+#include "Utility/Parallel.hpp"
+#include "Utility/Random.hpp"
 #include "Stats.hpp"
 
 
@@ -20,60 +33,1398 @@ namespace MatrixInspector
 {
 
 
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+// degrees beyond this are rare enough to be sorted rather than binned
+dim_type const MAX_HISTOGRAM_SIZE = 1 << 16;
+
+// the fraction of the progress spent sweeping the non-zeros
+double const SWEEP_FRACTION = 0.8;
+
+int const NUM_PROGRESS_STEPS = 50;
+
+// the number of rows swept between checks for cancellation
+dim_type const CANCEL_INTERVAL = 4096;
+
+// the fraction of the progress spent reducing values, when requested
+double const VALUE_FRACTION = 0.3;
+
+// the number of separate sums kept while reducing values, which is the width
+// of the widest vector path, so every path sums in the same order
+int const NUM_LANES = 16;
+
+// values are summed in chunks of a fixed size, so the result does not depend
+// on how they are split among threads
+size_t const VALUE_CHUNK_SIZE = 1 << 16;
+
+size_t const DECODE_BLOCK_SIZE = 1 << 12;
+
+// the normal quantile of a two sided 95% confidence interval
+double const CONFIDENCE_Z = 1.96;
+
+}
+
+
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+
+/**
+* @brief Check whether a task has been cancelled.
+*
+* @param cancel The cancellation flag (may be null).
+*
+* @return True if the flag is set.
+*/
+bool isCancelled(
+    std::atomic<bool> const * const cancel)
+{
+  return cancel != nullptr && cancel->load(std::memory_order_relaxed);
+}
+
+
+/**
+* @brief Accumulates the distribution of a set of degrees, such that
+* accumulators for different parts of the set can be merged.
+*/
+class DegreeReducer
+{
+  public:
+    DegreeReducer() :
+      m_min(std::numeric_limits<dim_type>::max()),
+      m_max(0),
+      m_count(0),
+      m_sum(0),
+      m_histogram(),
+      m_large()
+    {
+      // do nothing
+    }
+
+
+    inline void add(
+        dim_type const degree)
+    {
+      m_min = std::min(m_min, degree);
+      m_max = std::max(m_max, degree);
+      ++m_count;
+      m_sum += degree;
+
+      if (degree < MAX_HISTOGRAM_SIZE) {
+        if (degree >= m_histogram.size()) {
+          m_histogram.resize(degree+1, 0);
+        }
+        ++m_histogram[degree];
+      } else {
+        m_large.push_back(degree);
+      }
+    }
+
+
+    void merge(
+        DegreeReducer const & other)
+    {
+      m_min = std::min(m_min, other.m_min);
+      m_max = std::max(m_max, other.m_max);
+      m_count += other.m_count;
+      m_sum += other.m_sum;
+
+      if (other.m_histogram.size() > m_histogram.size()) {
+        m_histogram.resize(other.m_histogram.size(), 0);
+      }
+      for (size_t i = 0; i < other.m_histogram.size(); ++i) {
+        m_histogram[i] += other.m_histogram[i];
+      }
+
+      m_large.insert(m_large.end(), other.m_large.begin(), \
+          other.m_large.end());
+    }
+
+
+    Matrix::degree_stats_struct finish()
+    {
+      Matrix::degree_stats_struct stats;
+
+      if (m_count == 0) {
+        stats.min = 0;
+        stats.max = 0;
+        stats.mean = 0;
+        stats.variance = 0;
+        std::fill(stats.percentiles, stats.percentiles + \
+            Matrix::NUM_PERCENTILES, 0);
+        stats.numEmpty = 0;
+        return stats;
+      }
+
+      std::sort(m_large.begin(), m_large.end());
+
+      stats.min = m_min;
+      stats.max = m_max;
+      stats.mean = static_cast<double>(m_sum) / m_count;
+      stats.numEmpty = m_histogram.empty() ? 0 : \
+          static_cast<dim_type>(m_histogram[0]);
+
+      // use the exact distribution rather than the sum of squares, to avoid
+      // cancellation
+      double sumSquares = 0;
+      for (size_t degree = 0; degree < m_histogram.size(); ++degree) {
+        double const diff = degree - stats.mean;
+        sumSquares += m_histogram[degree] * diff * diff;
+      }
+      for (dim_type const degree : m_large) {
+        double const diff = degree - stats.mean;
+        sumSquares += diff * diff;
+      }
+      stats.variance = sumSquares / m_count;
+
+      // nearest rank percentiles
+      int p = 0;
+      index_type seen = 0;
+      for (size_t degree = 0; degree < m_histogram.size() && \
+          p < Matrix::NUM_PERCENTILES; ++degree) {
+        seen += m_histogram[degree];
+        while (p < Matrix::NUM_PERCENTILES && seen >= getRank(p)) {
+          stats.percentiles[p++] = static_cast<dim_type>(degree);
+        }
+      }
+      for (dim_type const degree : m_large) {
+        ++seen;
+        while (p < Matrix::NUM_PERCENTILES && seen >= getRank(p)) {
+          stats.percentiles[p++] = degree;
+        }
+      }
+
+      return stats;
+    }
+
+
+  private:
+    dim_type m_min;
+    dim_type m_max;
+    index_type m_count;
+    index_type m_sum;
+    std::vector<index_type> m_histogram;
+    std::vector<dim_type> m_large;
+
+
+    index_type getRank(
+        int const p) const noexcept
+    {
+      index_type const rank = static_cast<index_type>( \
+          std::ceil(Matrix::PERCENTILES[p] * m_count));
+      return std::max<index_type>(rank, 1);
+    }
+};
+
+
+/**
+* @brief The partial results of a thread's sweep over the non-zeros.
+*/
+struct sweep_struct
+{
+  sweep_struct() :
+    rows(),
+    numDiagonal(0),
+    numZeroDiagonal(0),
+    bandwidth(0),
+    fingerprint(0)
+  {
+    // do nothing
+  }
+
+  DegreeReducer rows;
+  index_type numDiagonal;
+  index_type numZeroDiagonal;
+  dim_type bandwidth;
+  uint64_t fingerprint;
+};
+
+
+/**
+* @brief Hash the position of a non-zero.
+*
+* @param row The row.
+* @param col The column.
+*
+* @return The hash.
+*/
+inline uint64_t hashPosition(
+    dim_type const row,
+    dim_type const col) noexcept
+{
+  // splitmix64 finalizer
+  uint64_t x = (static_cast<uint64_t>(row) << 32) ^ static_cast<uint64_t>(col);
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+
+/**
+* @brief The partial sums of a chunk of values.
+*/
+struct lane_sums_struct
+{
+  double sum[NUM_LANES];
+  double absSum[NUM_LANES];
+};
+
+
+/**
+* @brief The partial results of a thread's reduction of values, none of which
+* depend on the order they are merged in.
+*/
+struct value_reducer_struct
+{
+  value_type min;
+  value_type max;
+  index_type numZeros;
+  index_type numNegative;
+  index_type numNaN;
+  index_type numInfinite;
+  index_type magnitudes[Matrix::NUM_MAGNITUDE_BINS];
+};
+
+
+void initValueReducer(
+    value_reducer_struct & reducer)
+{
+  reducer.min = std::numeric_limits<value_type>::infinity();
+  reducer.max = -std::numeric_limits<value_type>::infinity();
+  reducer.numZeros = 0;
+  reducer.numNegative = 0;
+  reducer.numNaN = 0;
+  reducer.numInfinite = 0;
+  std::fill(reducer.magnitudes, reducer.magnitudes + \
+      Matrix::NUM_MAGNITUDE_BINS, 0);
+}
+
+
+/**
+* @brief Get the histogram bin of a finite non-zero magnitude.
+*
+* @param mag The magnitude.
+*
+* @return The bin.
+*/
+inline int getMagnitudeBin(
+    value_type const mag) noexcept
+{
+  int const bin = std::ilogb(mag) - Matrix::MIN_MAGNITUDE;
+  return std::min(std::max(bin, 0), Matrix::NUM_MAGNITUDE_BINS-1);
+}
+
+
+/**
+* @brief Reduce a block of values, which starts on a lane boundary.
+*
+* @tparam T The type of value.
+* @param vals The values.
+* @param num The number of values.
+* @param lanes The partial sums to add to.
+* @param reducer The reducer to add to.
+*/
+template<typename T>
+void reduceValuesScalar(
+    T const * const vals,
+    size_t const num,
+    lane_sums_struct & lanes,
+    value_reducer_struct & reducer)
+{
+  for (size_t i = 0; i < num; ++i) {
+    T const val = vals[i];
+    if (std::isnan(val)) {
+      ++reducer.numNaN;
+      continue;
+    }
+    if (val < 0) {
+      ++reducer.numNegative;
+    }
+    if (std::isinf(val)) {
+      ++reducer.numInfinite;
+      continue;
+    }
+
+    if (val == 0) {
+      ++reducer.numZeros;
+    } else {
+      ++reducer.magnitudes[getMagnitudeBin(std::abs(val))];
+    }
+
+    reducer.min = std::min(reducer.min, val);
+    reducer.max = std::max(reducer.max, val);
+
+    int const lane = i % NUM_LANES;
+    lanes.sum[lane] += val;
+    lanes.absSum[lane] += std::abs(val);
+  }
+}
+
+
+template<typename T>
+inline void reduceValues(
+    T const * const vals,
+    size_t const num,
+    lane_sums_struct & lanes,
+    value_reducer_struct & reducer)
+{
+  reduceValuesScalar(vals, num, lanes, reducer);
+}
+
+
+#if defined(__AVX512F__)
+
+// the avx-512 intrinsics in older gcc headers trip -Wmaybe-uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+inline void reduceValues(
+    float const * const vals,
+    size_t const num,
+    lane_sums_struct & lanes,
+    value_reducer_struct & reducer)
+{
+  __m512 const inf = _mm512_set1_ps(std::numeric_limits<float>::infinity());
+  __m512 const zero = _mm512_setzero_ps();
+  __m512i const binOffset = _mm512_set1_epi32(127 + Matrix::MIN_MAGNITUDE);
+  __m512i const minBin = _mm512_setzero_si512();
+  __m512i const maxBin = _mm512_set1_epi32(Matrix::NUM_MAGNITUDE_BINS-1);
+
+  // lanes 0-7 and 8-15
+  __m512d sumLow = _mm512_loadu_pd(lanes.sum);
+  __m512d sumHigh = _mm512_loadu_pd(lanes.sum+8);
+  __m512d absLow = _mm512_loadu_pd(lanes.absSum);
+  __m512d absHigh = _mm512_loadu_pd(lanes.absSum+8);
+  __m512 vmin = _mm512_set1_ps(reducer.min);
+  __m512 vmax = _mm512_set1_ps(reducer.max);
+
+  alignas(64) int32_t bins[NUM_LANES];
+
+  size_t i;
+  for (i = 0; i + NUM_LANES <= num; i += NUM_LANES) {
+    __m512 const x = _mm512_loadu_ps(vals+i);
+    __m512 const a = _mm512_abs_ps(x);
+
+    __mmask16 const finite = _mm512_cmp_ps_mask(a, inf, _CMP_LT_OQ);
+    __mmask16 const zeros = _mm512_cmp_ps_mask(x, zero, _CMP_EQ_OQ);
+    __mmask16 const negative = _mm512_cmp_ps_mask(x, zero, _CMP_LT_OQ);
+    __mmask16 const nan = _mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q);
+    __mmask16 const infinite = _mm512_cmp_ps_mask(a, inf, _CMP_EQ_OQ);
+
+    __m512 const xf = _mm512_maskz_mov_ps(finite, x);
+    __m512 const af = _mm512_maskz_mov_ps(finite, a);
+    sumLow = _mm512_add_pd(sumLow, \
+        _mm512_cvtps_pd(_mm512_castps512_ps256(xf)));
+    sumHigh = _mm512_add_pd(sumHigh, _mm512_cvtps_pd(_mm256_castpd_ps( \
+        _mm512_extractf64x4_pd(_mm512_castps_pd(xf), 1))));
+    absLow = _mm512_add_pd(absLow, \
+        _mm512_cvtps_pd(_mm512_castps512_ps256(af)));
+    absHigh = _mm512_add_pd(absHigh, _mm512_cvtps_pd(_mm256_castpd_ps( \
+        _mm512_extractf64x4_pd(_mm512_castps_pd(af), 1))));
+
+    vmin = _mm512_mask_min_ps(vmin, finite, vmin, x);
+    vmax = _mm512_mask_max_ps(vmax, finite, vmax, x);
+
+    reducer.numZeros += __builtin_popcount(zeros);
+    reducer.numNegative += __builtin_popcount(negative);
+    reducer.numNaN += __builtin_popcount(nan);
+    reducer.numInfinite += __builtin_popcount(infinite);
+
+    unsigned binMask = finite & ~zeros;
+    if (binMask != 0) {
+      __m512i exp = _mm512_srli_epi32(_mm512_castps_si512(a), 23);
+      exp = _mm512_sub_epi32(exp, binOffset);
+      exp = _mm512_min_epi32(_mm512_max_epi32(exp, minBin), maxBin);
+      _mm512_store_si512(bins, exp);
+      while (binMask != 0) {
+        ++reducer.magnitudes[bins[__builtin_ctz(binMask)]];
+        binMask &= binMask - 1;
+      }
+    }
+  }
+
+  _mm512_storeu_pd(lanes.sum, sumLow);
+  _mm512_storeu_pd(lanes.sum+8, sumHigh);
+  _mm512_storeu_pd(lanes.absSum, absLow);
+  _mm512_storeu_pd(lanes.absSum+8, absHigh);
+  alignas(64) float mins[NUM_LANES];
+  alignas(64) float maxs[NUM_LANES];
+  _mm512_store_ps(mins, vmin);
+  _mm512_store_ps(maxs, vmax);
+  for (size_t lane = 0; lane < NUM_LANES; ++lane) {
+    reducer.min = std::min(reducer.min, mins[lane]);
+    reducer.max = std::max(reducer.max, maxs[lane]);
+  }
+
+  // i is on a lane boundary
+  reduceValuesScalar(vals+i, num-i, lanes, reducer);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#elif defined(__AVX2__)
+
+inline void reduceValues(
+    float const * const vals,
+    size_t const num,
+    lane_sums_struct & lanes,
+    value_reducer_struct & reducer)
+{
+  __m256 const inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  __m256 const negInf = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+  __m256 const zero = _mm256_setzero_ps();
+  __m256 const signBit = _mm256_set1_ps(-0.0f);
+  __m256i const binOffset = _mm256_set1_epi32(127 + Matrix::MIN_MAGNITUDE);
+  __m256i const minBin = _mm256_setzero_si256();
+  __m256i const maxBin = _mm256_set1_epi32(Matrix::NUM_MAGNITUDE_BINS-1);
+
+  // four lanes per register
+  __m256d sum[NUM_LANES/4];
+  __m256d absSum[NUM_LANES/4];
+  for (int j = 0; j < NUM_LANES/4; ++j) {
+    sum[j] = _mm256_loadu_pd(lanes.sum+(4*j));
+    absSum[j] = _mm256_loadu_pd(lanes.absSum+(4*j));
+  }
+  __m256 vmin = _mm256_set1_ps(reducer.min);
+  __m256 vmax = _mm256_set1_ps(reducer.max);
+
+  alignas(32) int32_t bins[8];
+
+  size_t i;
+  for (i = 0; i + NUM_LANES <= num; i += NUM_LANES) {
+    for (int h = 0; h < 2; ++h) {
+      __m256 const x = _mm256_loadu_ps(vals+i+(8*h));
+      __m256 const a = _mm256_andnot_ps(signBit, x);
+
+      __m256 const finite = _mm256_cmp_ps(a, inf, _CMP_LT_OQ);
+      int const zeros = _mm256_movemask_ps(_mm256_cmp_ps(x, zero, \
+          _CMP_EQ_OQ));
+
+      __m256 const xf = _mm256_and_ps(x, finite);
+      __m256 const af = _mm256_and_ps(a, finite);
+      sum[2*h] = _mm256_add_pd(sum[2*h], \
+          _mm256_cvtps_pd(_mm256_castps256_ps128(xf)));
+      sum[2*h+1] = _mm256_add_pd(sum[2*h+1], \
+          _mm256_cvtps_pd(_mm256_extractf128_ps(xf, 1)));
+      absSum[2*h] = _mm256_add_pd(absSum[2*h], \
+          _mm256_cvtps_pd(_mm256_castps256_ps128(af)));
+      absSum[2*h+1] = _mm256_add_pd(absSum[2*h+1], \
+          _mm256_cvtps_pd(_mm256_extractf128_ps(af, 1)));
+
+      vmin = _mm256_min_ps(vmin, _mm256_blendv_ps(inf, x, finite));
+      vmax = _mm256_max_ps(vmax, _mm256_blendv_ps(negInf, x, finite));
+
+      reducer.numZeros += __builtin_popcount(zeros);
+      reducer.numNegative += __builtin_popcount(_mm256_movemask_ps( \
+          _mm256_cmp_ps(x, zero, _CMP_LT_OQ)));
+      reducer.numNaN += __builtin_popcount(_mm256_movemask_ps( \
+          _mm256_cmp_ps(x, x, _CMP_UNORD_Q)));
+      reducer.numInfinite += __builtin_popcount(_mm256_movemask_ps( \
+          _mm256_cmp_ps(a, inf, _CMP_EQ_OQ)));
+
+      unsigned binMask = _mm256_movemask_ps(finite) & ~zeros;
+      if (binMask != 0) {
+        __m256i exp = _mm256_srli_epi32(_mm256_castps_si256(a), 23);
+        exp = _mm256_sub_epi32(exp, binOffset);
+        exp = _mm256_min_epi32(_mm256_max_epi32(exp, minBin), maxBin);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(bins), exp);
+        while (binMask != 0) {
+          ++reducer.magnitudes[bins[__builtin_ctz(binMask)]];
+          binMask &= binMask - 1;
+        }
+      }
+    }
+  }
+
+  for (int j = 0; j < NUM_LANES/4; ++j) {
+    _mm256_storeu_pd(lanes.sum+(4*j), sum[j]);
+    _mm256_storeu_pd(lanes.absSum+(4*j), absSum[j]);
+  }
+
+  alignas(32) float mins[8];
+  alignas(32) float maxes[8];
+  _mm256_store_ps(mins, vmin);
+  _mm256_store_ps(maxes, vmax);
+  for (int j = 0; j < 8; ++j) {
+    reducer.min = std::min(reducer.min, mins[j]);
+    reducer.max = std::max(reducer.max, maxes[j]);
+  }
+
+  // i is on a lane boundary
+  reduceValuesScalar(vals+i, num-i, lanes, reducer);
+}
+
+#endif
+
+
+/**
+* @brief Sum a set of partial sums in a fixed pairwise order.
+*
+* @param sums The partial sums.
+* @param num The number of partial sums.
+*
+* @return The total.
+*/
+double pairwiseSum(
+    double const * const sums,
+    size_t const num) noexcept
+{
+  if (num == 0) {
+    return 0;
+  } else if (num == 1) {
+    return sums[0];
+  } else {
+    size_t const half = num / 2;
+    return pairwiseSum(sums, half) + pairwiseSum(sums+half, num-half);
+  }
+}
+
+
+/**
+* @brief Reduce a stream of values in parallel.
+*
+* @tparam F The type of function supplying blocks of values.
+* @param num The number of values.
+* @param getBlock The function which, given the start and length of a block
+* and a buffer to decode it into, returns a pointer to the values.
+* @param progress The progress counter to update.
+* @param scale The amount of progress this task contributes.
+* @param cancel The flag which, once set, stops the reduction between chunks.
+*
+* @return The statistics of the values.
+*/
+template<typename F>
+Matrix::value_stats_struct reduceValueStream(
+    size_t const num,
+    F getBlock,
+    double * const progress,
+    double const scale,
+    std::atomic<bool> const * const cancel)
+{
+  size_t const numChunks = (num + VALUE_CHUNK_SIZE - 1) / VALUE_CHUNK_SIZE;
+  std::vector<double> chunkSums(numChunks);
+  std::vector<double> chunkAbsSums(numChunks);
+
+  unsigned const numThreads = static_cast<unsigned>(std::max<size_t>(1, \
+      std::min<size_t>(Parallel::getNumThreads(), numChunks)));
+  std::vector<value_reducer_struct> reducers(numThreads);
+
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    value_reducer_struct & reducer = reducers[tid];
+    initValueReducer(reducer);
+
+    std::vector<value_type> buffer(DECODE_BLOCK_SIZE);
+
+    size_t const first = Parallel::getChunkStart(numChunks, numThreads, tid);
+    size_t const last = Parallel::getChunkStart(numChunks, numThreads, tid+1);
+    for (size_t chunk = first; chunk < last; ++chunk) {
+      if (isCancelled(cancel)) {
+        break;
+      }
+
+      lane_sums_struct lanes;
+      std::fill(lanes.sum, lanes.sum+NUM_LANES, 0.0);
+      std::fill(lanes.absSum, lanes.absSum+NUM_LANES, 0.0);
+
+      size_t const start = chunk * VALUE_CHUNK_SIZE;
+      size_t const end = std::min(num, start + VALUE_CHUNK_SIZE);
+      for (size_t block = start; block < end; block += DECODE_BLOCK_SIZE) {
+        size_t const size = std::min(DECODE_BLOCK_SIZE, end - block);
+        reduceValues(getBlock(block, size, buffer.data()), size, lanes, \
+            reducer);
+      }
+
+      chunkSums[chunk] = pairwiseSum(lanes.sum, NUM_LANES);
+      chunkAbsSums[chunk] = pairwiseSum(lanes.absSum, NUM_LANES);
+
+      // only the first thread reports progress
+      if (tid == 0 && progress != nullptr) {
+        *progress += scale / (last - first);
+      }
+    }
+  });
+
+  if (progress != nullptr && numChunks == 0) {
+    *progress += scale;
+  }
+
+  value_reducer_struct & total = reducers[0];
+  for (unsigned tid = 1; tid < numThreads; ++tid) {
+    value_reducer_struct const & reducer = reducers[tid];
+    total.min = std::min(total.min, reducer.min);
+    total.max = std::max(total.max, reducer.max);
+    total.numZeros += reducer.numZeros;
+    total.numNegative += reducer.numNegative;
+    total.numNaN += reducer.numNaN;
+    total.numInfinite += reducer.numInfinite;
+    for (int bin = 0; bin < Matrix::NUM_MAGNITUDE_BINS; ++bin) {
+      total.magnitudes[bin] += reducer.magnitudes[bin];
+    }
+  }
+
+  Matrix::value_stats_struct stats;
+  stats.numValues = num;
+  if (total.min > total.max) {
+    // no finite values
+    stats.min = 0;
+    stats.max = 0;
+  } else {
+    stats.min = total.min;
+    stats.max = total.max;
+  }
+  stats.sum = pairwiseSum(chunkSums.data(), numChunks);
+  stats.absSum = pairwiseSum(chunkAbsSums.data(), numChunks);
+  stats.numZeros = total.numZeros;
+  stats.numNegative = total.numNegative;
+  stats.numNaN = total.numNaN;
+  stats.numInfinite = total.numInfinite;
+  std::copy(total.magnitudes, total.magnitudes + Matrix::NUM_MAGNITUDE_BINS, \
+      stats.magnitudes);
+
+  return stats;
+}
+
+
+/**
+* @brief Reduce the values of a matrix.
+*
+* @param csr The matrix.
+* @param progress The progress counter to update.
+* @param scale The amount of progress this task contributes.
+* @param cancel The flag which, once set, stops the reduction.
+*
+* @return The statistics of the values.
+*/
+Matrix::value_stats_struct reduceMatrixValues(
+    CSRMatrix const * const csr,
+    double * const progress,
+    double const scale,
+    std::atomic<bool> const * const cancel)
+{
+  ValueArray const & values = csr->getValueArray();
+
+  double const storedScale = csr->isHalfStorage() ? scale * 0.8 : scale;
+
+  Matrix::value_stats_struct stats = reduceValueStream(values.size(), \
+      [&values](size_t const start, size_t const num, \
+          value_type * const buffer) -> value_type const * {
+        if (values.getPrecision() == ValueArray::FULL_PRECISION) {
+          return values.data() + start;
+        }
+        values.decode(start, num, buffer);
+        return buffer;
+      }, progress, storedScale, cancel);
+
+  if (csr->isHalfStorage() && !isCancelled(cancel)) {
+    // each off-diagonal value stands for two non-zeros, so count everything
+    // twice and take the diagonal back out
+    dim_type const numRows = csr->getNumRows();
+    index_type const * const offsets = csr->getOffsets();
+    dim_type const * const columns = csr->getColumns();
+
+    std::vector<value_type> diagonal(numRows);
+    std::vector<char> present(numRows, 0);
+    Parallel::forRange(numRows, \
+        [&](unsigned, size_t const start, size_t const end) {
+      for (size_t row = start; row < end; ++row) {
+        for (index_type idx = offsets[row]; idx < offsets[row+1]; ++idx) {
+          if (columns[idx] == row) {
+            diagonal[row] = values.get(idx);
+            present[row] = 1;
+            break;
+          }
+        }
+      }
+    });
+
+    size_t numDiagonal = 0;
+    for (dim_type row = 0; row < numRows; ++row) {
+      if (present[row]) {
+        diagonal[numDiagonal++] = diagonal[row];
+      }
+    }
+
+    Matrix::value_stats_struct const diag = reduceValueStream(numDiagonal, \
+        [&diagonal](size_t const start, size_t, value_type *) {
+          return diagonal.data() + start;
+        }, progress, scale - storedScale, cancel);
+
+    stats.numValues = (2*stats.numValues) - diag.numValues;
+    stats.sum = (2*stats.sum) - diag.sum;
+    stats.absSum = (2*stats.absSum) - diag.absSum;
+    stats.numZeros = (2*stats.numZeros) - diag.numZeros;
+    stats.numNegative = (2*stats.numNegative) - diag.numNegative;
+    stats.numNaN = (2*stats.numNaN) - diag.numNaN;
+    stats.numInfinite = (2*stats.numInfinite) - diag.numInfinite;
+    for (int bin = 0; bin < Matrix::NUM_MAGNITUDE_BINS; ++bin) {
+      stats.magnitudes[bin] = (2*stats.magnitudes[bin]) - \
+          diag.magnitudes[bin];
+    }
+  }
+
+  return stats;
+}
+
+
+/**
+* @brief Count the non-zeros landing in each column in parallel. In half
+* storage, this counts the mirror of each strictly lower entry on top of the
+* row lengths, giving the degrees of both the rows and columns.
+*
+* @param csr The matrix.
+* @param counts The counts to fill.
+* @param progress The progress counter to update.
+* @param scale The amount of progress this task contributes.
+* @param cancel The flag which, once set, stops the counting before the
+* counts are filled.
+*/
+void scatterCounts(
+    CSRMatrix const * const csr,
+    dim_type * const counts,
+    double * const progress,
+    double const scale,
+    std::atomic<bool> const * const cancel)
+{
+  bool const half = csr->isHalfStorage();
+  dim_type const numRows = csr->getNumRows();
+  dim_type const numCounts = half ? numRows : csr->getNumColumns();
+  index_type const * const offsets = csr->getOffsets();
+  dim_type const * const columns = csr->getColumns();
+
+  std::unique_ptr<std::atomic<dim_type>[]> shared( \
+      new std::atomic<dim_type>[numCounts]);
+  Parallel::forRange(numCounts, \
+      [&](unsigned, size_t const start, size_t const end) {
+    for (size_t i = start; i < end; ++i) {
+      dim_type const init = half ? \
+          static_cast<dim_type>(offsets[i+1] - offsets[i]) : 0;
+      shared[i].store(init, std::memory_order_relaxed);
+    }
+  });
+
+  unsigned const numThreads = Parallel::getNumThreads();
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    dim_type const start = Parallel::getRowChunkStart(offsets, numRows, \
+        numThreads, tid);
+    dim_type const end = Parallel::getRowChunkStart(offsets, numRows, \
+        numThreads, tid+1);
+
+    // only the first thread reports progress, as the chunks have about the
+    // same number of non-zeros
+    dim_type const interval = std::max<dim_type>(1, \
+        (end - start) / NUM_PROGRESS_STEPS);
+    double const increment = scale * SWEEP_FRACTION / NUM_PROGRESS_STEPS;
+
+    for (dim_type row = start; row < end; ++row) {
+      if ((row - start) % CANCEL_INTERVAL == 0 && isCancelled(cancel)) {
+        break;
+      }
+
+      for (index_type idx = offsets[row]; idx < offsets[row+1]; ++idx) {
+        dim_type const col = columns[idx];
+        if (!half || col != row) {
+          shared[col].fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+
+      if (tid == 0 && progress != nullptr && (row - start) % interval == 0 && \
+          (row - start) / interval < NUM_PROGRESS_STEPS) {
+        *progress += increment;
+      }
+    }
+  });
+
+  if (isCancelled(cancel)) {
+    return;
+  }
+
+  Parallel::forRange(numCounts, \
+      [&](unsigned, size_t const start, size_t const end) {
+    for (size_t i = start; i < end; ++i) {
+      counts[i] = shared[i].load(std::memory_order_relaxed);
+    }
+  });
+
+  if (progress != nullptr) {
+    *progress += scale * (1.0 - SWEEP_FRACTION);
+  }
+}
+
+
+/**
+* @brief Summarize a set of degrees in parallel.
+*
+* @tparam F The type of function supplying the degrees.
+* @param num The number of degrees.
+* @param getDegree The function supplying the degree of an index.
+*
+* @return The summary.
+*/
+template<typename F>
+Matrix::degree_stats_struct summarize(
+    size_t const num,
+    F getDegree)
+{
+  std::vector<DegreeReducer> reducers(Parallel::getNumThreads());
+  unsigned const numThreads = Parallel::forRange(num, \
+      [&](unsigned const tid, size_t const start, size_t const end) {
+    DegreeReducer & reducer = reducers[tid];
+    for (size_t i = start; i < end; ++i) {
+      reducer.add(getDegree(i));
+    }
+  });
+
+  // merge in a fixed order
+  for (unsigned tid = 1; tid < numThreads; ++tid) {
+    reducers[0].merge(reducers[tid]);
+  }
+
+  return reducers[0].finish();
+}
+
+
+/**
+* @brief Get the finite population correction of the variance of a sample.
+*
+* @param num The size of the sample.
+* @param population The size of the population.
+*
+* @return The correction, which is zero when the sample is the population.
+*/
+double populationCorrection(
+    double const num,
+    double const population) noexcept
+{
+  if (population <= 1) {
+    return 0;
+  }
+  return std::max(0.0, (population - num) / (population - 1));
+}
+
+
+/**
+* @brief Estimate a proportion with a Wilson score interval.
+*
+* @param successes The number of successes in the sample.
+* @param num The size of the sample.
+* @param population The size of the population.
+*
+* @return The estimate.
+*/
+Stats::interval_struct proportionInterval(
+    index_type const successes,
+    index_type const num,
+    double const population) noexcept
+{
+  if (num == 0) {
+    return Stats::interval_struct{0, 0, 1};
+  }
+
+  double const n = static_cast<double>(num);
+  double const p = successes / n;
+  double const z2 = CONFIDENCE_Z * CONFIDENCE_Z * \
+      populationCorrection(n, population);
+
+  double const denom = 1.0 + (z2 / n);
+  double const center = (p + (z2 / (2.0*n))) / denom;
+  double const spread = std::sqrt(z2 * ((p*(1.0-p) / n) + \
+      (z2 / (4.0*n*n)))) / denom;
+
+  return Stats::interval_struct{p, std::max(0.0, center - spread), \
+      std::min(1.0, center + spread)};
+}
+
+
+/**
+* @brief Estimate a percentile from a sorted sample, with an interval from
+* the ranks the percentile falls between with 95% probability.
+*
+* @param sorted The sorted sample.
+* @param percentile The percentile, in (0, 1].
+* @param population The size of the population.
+*
+* @return The estimate.
+*/
+Stats::interval_struct percentileInterval(
+    std::vector<dim_type> const & sorted,
+    double const percentile,
+    double const population)
+{
+  double const n = static_cast<double>(sorted.size());
+  double const expected = percentile * n;
+  double const spread = CONFIDENCE_Z * std::sqrt(expected * \
+      (1.0 - percentile) * populationCorrection(n, population));
+
+  // nearest rank, as for exact percentiles
+  double const rank = std::max(1.0, std::ceil(expected));
+  double const low = std::min(rank, std::max(1.0, \
+      std::ceil(expected - spread)));
+  double const high = std::max(rank, std::min(n, \
+      std::ceil(expected + spread)));
+
+  return Stats::interval_struct{ \
+      static_cast<double>(sorted[static_cast<size_t>(rank)-1]), \
+      static_cast<double>(sorted[static_cast<size_t>(low)-1]), \
+      static_cast<double>(sorted[static_cast<size_t>(high)-1])};
+}
+
+
+/**
+* @brief Scale an estimated proportion to a count.
+*
+* @param interval The proportion.
+* @param num The size of the population.
+*
+* @return The count.
+*/
+Stats::interval_struct scaleInterval(
+    Stats::interval_struct const & interval,
+    double const num) noexcept
+{
+  return Stats::interval_struct{interval.estimate*num, interval.low*num, \
+      interval.high*num};
+}
+
+
+/**
+* @brief Add the mirrors of the strictly lower entries of a matrix in half
+* storage to the degrees of a sample of its rows. A row's entries above the
+* diagonal are only stored as the entries of its column below the diagonal,
+* so they are counted in one parallel pass over the column indices, where a
+* bitmap of the sampled rows skips the other columns.
+*
+* @param csr The matrix.
+* @param rows The sampled rows, in increasing order.
+* @param degrees The degrees of the sampled rows to add to.
+*/
+void addMirroredDegrees(
+    CSRMatrix const * const csr,
+    std::vector<dim_type> const & rows,
+    dim_type * const degrees)
+{
+  dim_type const numRows = csr->getNumRows();
+  index_type const * const offsets = csr->getOffsets();
+  dim_type const * const columns = csr->getColumns();
+
+  std::vector<uint64_t> sampled((static_cast<size_t>(numRows) + 63) / 64, 0);
+  for (dim_type const row : rows) {
+    sampled[row / 64] |= uint64_t(1) << (row % 64);
+  }
+
+  unsigned const numThreads = Parallel::getNumThreads();
+  std::vector<std::vector<dim_type>> counts(numThreads);
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    dim_type const start = Parallel::getRowChunkStart(offsets, numRows, \
+        numThreads, tid);
+    dim_type const end = Parallel::getRowChunkStart(offsets, numRows, \
+        numThreads, tid+1);
+
+    std::vector<dim_type> & local = counts[tid];
+    local.assign(rows.size(), 0);
+    for (dim_type row = start; row < end; ++row) {
+      for (index_type idx = offsets[row]; idx < offsets[row+1]; ++idx) {
+        dim_type const col = columns[idx];
+        if (col != row && ((sampled[col / 64] >> (col % 64)) & 1) != 0) {
+          ++local[std::lower_bound(rows.begin(), rows.end(), col) - \
+              rows.begin()];
+        }
+      }
+    }
+  });
+
+  for (std::vector<dim_type> const & local : counts) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+      degrees[i] += local[i];
+    }
+  }
+}
+
+
+}
+
+
+
+
 /******************************************************************************
 * STATIC PUBLIC FUNCTIONS *****************************************************
 ******************************************************************************/
 
 
-void Stats::countRowNonZeros(
-    Matrix * const matrix,
-    dim_type * const counts)
+Stats::matrix_stats_struct Stats::compute(
+    Matrix const * const matrix,
+    int const flags,
+    double * const progress,
+    double const scale,
+    std::atomic<bool> const * const cancel)
 {
   CSRMatrix const * const csr = dynamic_cast<CSRMatrix const *>(matrix);
 
   if (csr == nullptr) {
-    throw std::runtime_error("Cannot perform row count on non-csr matrix.");
+    throw std::runtime_error("Cannot compute stats of non-csr matrix.");
   }
 
   dim_type const numRows = csr->getNumRows();
+  dim_type const numCols = csr->getNumColumns();
   index_type const * const offsets = csr->getOffsets();
+  dim_type const * const columns = csr->getColumns();
+  ValueArray const & values = csr->getValueArray();
+  bool const half = csr->isHalfStorage();
 
-  for (dim_type row = 0; row < numRows; ++row) {
-    counts[row] = offsets[row+1] - offsets[row];
+  // in half storage the rows and columns are the same, and both need the
+  // mirrored entries counted
+  bool const scatterRows = half && (flags & (ROW_STATS | COLUMN_STATS));
+  bool const scatterColumns = !half && (flags & COLUMN_STATS);
+  bool const diagonal = flags & DIAGONAL_STATS;
+  bool const fingerprint = (flags & STRUCTURAL_SYMMETRY) && !half && \
+      numRows == numCols;
+  bool const sweep = scatterRows || scatterColumns || diagonal || \
+      fingerprint;
+
+  double const valueScale = (flags & VALUE_STATS) ? scale*VALUE_FRACTION : 0;
+  double const structureScale = scale - valueScale;
+
+  // counts which must be scattered are shared between threads
+  dim_type const numCounts = half ? numRows : numCols;
+  std::unique_ptr<std::atomic<dim_type>[]> counts;
+  if (scatterRows || scatterColumns) {
+    counts.reset(new std::atomic<dim_type>[numCounts]);
+    Parallel::forRange(numCounts, \
+        [&](unsigned, size_t const start, size_t const end) {
+      for (size_t i = start; i < end; ++i) {
+        dim_type const init = scatterRows ? \
+            static_cast<dim_type>(offsets[i+1] - offsets[i]) : 0;
+        counts[i].store(init, std::memory_order_relaxed);
+      }
+    });
   }
+
+  unsigned const numThreads = Parallel::getNumThreads();
+  std::vector<sweep_struct> sweeps(numThreads);
+
+  Parallel::run(numThreads, [&](unsigned const tid) {
+    sweep_struct & local = sweeps[tid];
+
+    dim_type const start = Parallel::getRowChunkStart(offsets, numRows, \
+        numThreads, tid);
+    dim_type const end = Parallel::getRowChunkStart(offsets, numRows, \
+        numThreads, tid+1);
+
+    // only the first thread reports progress, as the chunks have about the
+    // same number of non-zeros
+    dim_type const interval = std::max<dim_type>(1, \
+        (end - start) / NUM_PROGRESS_STEPS);
+    double const increment = structureScale * SWEEP_FRACTION / \
+        NUM_PROGRESS_STEPS;
+
+    for (dim_type row = start; row < end; ++row) {
+      if ((row - start) % CANCEL_INTERVAL == 0 && isCancelled(cancel)) {
+        break;
+      }
+
+      if (!half && (flags & ROW_STATS)) {
+        local.rows.add(static_cast<dim_type>(offsets[row+1] - offsets[row]));
+      }
+
+      if (sweep) {
+        for (index_type idx = offsets[row]; idx < offsets[row+1]; ++idx) {
+          dim_type const col = columns[idx];
+          if (scatterColumns || (scatterRows && col != row)) {
+            counts[col].fetch_add(1, std::memory_order_relaxed);
+          }
+          if (diagonal) {
+            if (col == row) {
+              ++local.numDiagonal;
+              if (values.get(idx) == 0) {
+                ++local.numZeroDiagonal;
+              }
+            }
+            local.bandwidth = std::max(local.bandwidth, \
+                col > row ? col - row : row - col);
+          }
+          if (fingerprint) {
+            // the sum is zero for any set of positions closed under
+            // transposition
+            local.fingerprint += hashPosition(row, col) - \
+                hashPosition(col, row);
+          }
+        }
+      }
+
+      if (tid == 0 && progress != nullptr && (row - start) % interval == 0 && \
+          (row - start) / interval < NUM_PROGRESS_STEPS) {
+        *progress += increment;
+      }
+    }
+  });
+
+  matrix_stats_struct stats;
+  if (isCancelled(cancel)) {
+    return stats;
+  }
+
+  // merge in a fixed order
+  index_type numZeroDiagonal = 0;
+  uint64_t sum = 0;
+  stats.diagonal.numNonZeros = 0;
+  stats.diagonal.bandwidth = 0;
+  for (unsigned tid = 0; tid < numThreads; ++tid) {
+    if (tid > 0) {
+      sweeps[0].rows.merge(sweeps[tid].rows);
+    }
+    stats.diagonal.numNonZeros += sweeps[tid].numDiagonal;
+    stats.diagonal.bandwidth = std::max(stats.diagonal.bandwidth, \
+        sweeps[tid].bandwidth);
+    numZeroDiagonal += sweeps[tid].numZeroDiagonal;
+    sum += sweeps[tid].fingerprint;
+  }
+  stats.diagonal.numZeros = std::min(numRows, numCols) - \
+      stats.diagonal.numNonZeros + numZeroDiagonal;
+
+  if (half) {
+    stats.structurallySymmetric = true;
+  } else if (numRows != numCols) {
+    stats.structurallySymmetric = false;
+  } else {
+    stats.structurallySymmetric = sum == 0;
+  }
+
+  if (counts) {
+    Matrix::degree_stats_struct const countStats = summarize(numCounts, \
+        [&](size_t const i) {
+          return counts[i].load(std::memory_order_relaxed);
+        });
+    if (half) {
+      stats.rows = countStats;
+    }
+    stats.columns = countStats;
+  }
+  if (!half && (flags & ROW_STATS)) {
+    stats.rows = sweeps[0].rows.finish();
+  }
+
+  if (progress != nullptr) {
+    *progress += structureScale * (1.0 - SWEEP_FRACTION);
+  }
+
+  if (flags & VALUE_STATS) {
+    stats.values = reduceMatrixValues(csr, progress, valueScale, cancel);
+  }
+
+  return stats;
 }
 
 
-void Stats::countColumnNonZeros(
-    Matrix * const matrix,
-    dim_type * const counts)
+Stats::estimate_stats_struct Stats::estimate(
+    Matrix const * const matrix,
+    dim_type const numSampleRows,
+    uint64_t const seed)
 {
-  dim_type const numRows = matrix->getNumRows();
-  dim_type const numCols = matrix->getNumColumns();
-
   CSRMatrix const * const csr = dynamic_cast<CSRMatrix const *>(matrix);
 
   if (csr == nullptr) {
-    throw std::runtime_error("Cannot perform row count on non-csr matrix.");
+    throw std::runtime_error("Cannot estimate stats of non-csr matrix.");
   }
 
+  dim_type const numRows = csr->getNumRows();
+  dim_type const numCols = csr->getNumColumns();
+  dim_type const minDim = std::min(numRows, numCols);
   index_type const * const offsets = csr->getOffsets();
   dim_type const * const columns = csr->getColumns();
+  index_type const numStored = offsets[numRows];
+  bool const half = csr->isHalfStorage();
+
+  Random rng(seed);
+
+  estimate_stats_struct stats;
+
+  // a uniform sample of rows, in order
+  std::vector<dim_type> rows(std::min(numSampleRows, numRows));
+  rng.sortedSample(rows.data(), numRows, rows.size());
+  stats.numSampledRows = static_cast<dim_type>(rows.size());
+
+  std::vector<dim_type> degrees(rows.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    dim_type const row = rows[i];
+    degrees[i] = static_cast<dim_type>(offsets[row+1] - offsets[row]);
+  }
+  if (half) {
+    addMirroredDegrees(csr, rows, degrees.data());
+  }
+
+  index_type numEmpty = 0;
+  index_type numDiagonalRows = 0;
+  index_type numDiagonal = 0;
+  for (size_t i = 0; i < rows.size(); ++i) {
+    dim_type const row = rows[i];
+    if (degrees[i] == 0) {
+      ++numEmpty;
+    }
+    if (row < minDim) {
+      ++numDiagonalRows;
+      if (std::find(columns+offsets[row], columns+offsets[row+1], row) != \
+          columns+offsets[row+1]) {
+        ++numDiagonal;
+      }
+    }
+  }
+
+  // the rows below the diagonal are an unbiased sample of the diagonal
+  stats.numDiagonal = scaleInterval(proportionInterval(numDiagonal, \
+      numDiagonalRows, minDim), minDim);
+
+  stats.rowsEstimated = !rows.empty();
+  if (half) {
+    // every off-diagonal non-zero is stored once, so the mean only depends
+    // on the diagonal
+    double const n = numRows > 0 ? static_cast<double>(numRows) : 1.0;
+    stats.meanRowSize = interval_struct{ \
+        ((2.0*numStored) - stats.numDiagonal.estimate) / n, \
+        ((2.0*numStored) - stats.numDiagonal.high) / n, \
+        ((2.0*numStored) - stats.numDiagonal.low) / n};
+  } else {
+    double const mean = numRows > 0 ? \
+        static_cast<double>(numStored) / numRows : 0;
+    stats.meanRowSize = interval_struct{mean, mean, mean};
+  }
 
-  // initialize counts
-  for (dim_type col = 0; col < numCols; ++col) {
-    counts[col] = 0;
+  if (stats.rowsEstimated) {
+    std::sort(degrees.begin(), degrees.end());
+    for (int p = 0; p < Matrix::NUM_PERCENTILES; ++p) {
+      stats.rowPercentiles[p] = percentileInterval(degrees, \
+          Matrix::PERCENTILES[p], numRows);
+    }
+    stats.numEmptyRows = scaleInterval(proportionInterval(numEmpty, \
+        rows.size(), numRows), numRows);
+  } else {
+    std::fill(stats.rowPercentiles, stats.rowPercentiles + \
+        Matrix::NUM_PERCENTILES, interval_struct{0, 0, 0});
+    stats.numEmptyRows = interval_struct{0, 0, 0};
+  }
+
+  if (half) {
+    stats.numSampledNonZeros = 0;
+    stats.symmetricFraction = interval_struct{1, 1, 1};
+    return stats;
+  }
+
+  // a uniform sample of non-zeros, in order, which lets the rows be found by
+  // walking the offsets
+  std::vector<index_type> sample(std::min<index_type>(numSampleRows, \
+      numStored));
+  rng.sortedSample(sample.data(), numStored, sample.size());
+
+  std::vector<std::pair<dim_type, dim_type>> positions;
+  positions.reserve(sample.size());
+  dim_type row = 0;
+  for (index_type const idx : sample) {
+    while (offsets[row+1] <= idx) {
+      ++row;
+    }
+    if (columns[idx] != row) {
+      positions.emplace_back(row, columns[idx]);
+    }
   }
 
-  // actually count
-  for (dim_type row = 0; row < numRows; ++row) {
-    for (index_type idx = offsets[row]; idx < offsets[row+1]; ++idx) {
-      ++counts[columns[idx]];
+  // rows are sorted, so finding a transpose is a binary search of its row
+  index_type numMirrored = 0;
+  for (std::pair<dim_type, dim_type> const & position : positions) {
+    dim_type const col = position.second;
+    if (col < numRows && std::binary_search(columns + offsets[col], \
+        columns + offsets[col+1], position.first)) {
+      ++numMirrored;
     }
   }
+
+  stats.numSampledNonZeros = positions.size();
+  stats.symmetricFraction = proportionInterval(numMirrored, \
+      stats.numSampledNonZeros, numStored - stats.numDiagonal.estimate);
+
+  return stats;
 }
 
 
+Matrix::degree_stats_struct Stats::summarizeDegrees(
+    dim_type const * const counts,
+    dim_type const num)
+{
+  return summarize(num, [counts](size_t const i) {
+    return counts[i];
+  });
+}
+
+
+void Stats::countRowNonZeros(
+    Matrix * const matrix,
+    dim_type * const counts,
+    double * const progress,
+    double const scale,
+    std::atomic<bool> const * const cancel)
+{
+  CSRMatrix const * const csr = dynamic_cast<CSRMatrix const *>(matrix);
+
+  if (csr == nullptr) {
+    throw std::runtime_error("Cannot perform row count on non-csr matrix.");
+  }
+
+  if (csr->isHalfStorage()) {
+    // add the mirror of each strictly lower entry
+    scatterCounts(csr, counts, progress, scale, cancel);
+    return;
+  }
+
+  index_type const * const offsets = csr->getOffsets();
+  Parallel::forRange(csr->getNumRows(), \
+      [&](unsigned, size_t const start, size_t const end) {
+    for (size_t row = start; row < end; ++row) {
+      counts[row] = static_cast<dim_type>(offsets[row+1] - offsets[row]);
+    }
+  });
+
+  if (progress != nullptr) {
+    *progress += scale;
+  }
+}
+
+
+void Stats::countColumnNonZeros(
+    Matrix * const matrix,
+    dim_type * const counts,
+    double * const progress,
+    double const scale,
+    std::atomic<bool> const * const cancel)
+{
+  CSRMatrix const * const csr = dynamic_cast<CSRMatrix const *>(matrix);
+
+  if (csr == nullptr) {
+    throw std::runtime_error("Cannot perform row count on non-csr matrix.");
+  }
+
+  if (csr->isHalfStorage()) {
+    // the columns are the rows
+    countRowNonZeros(matrix, counts, progress, scale, cancel);
+    return;
+  }
+
+  scatterCounts(csr, counts, progress, scale, cancel);
+}
+
 
 
 }
@@ -15,6 +15,7 @@
 
 
 
+#include <atomic>
 #include "Data/Matrix.hpp"
 
 
@@ -27,15 +28,166 @@ namespace MatrixInspector
 class Stats
 {
   public:
+    /**
+    * @brief The groups of statistics to compute.
+    */
+    enum stats_flag_type {
+      ROW_STATS = 1 << 0,
+      COLUMN_STATS = 1 << 1,
+      DIAGONAL_STATS = 1 << 2,
+      STRUCTURAL_SYMMETRY = 1 << 3,
+      VALUE_STATS = 1 << 4,
+      ALL_STATS = ROW_STATS | COLUMN_STATS | DIAGONAL_STATS | \
+          STRUCTURAL_SYMMETRY | VALUE_STATS
+    };
+
+
+    struct matrix_stats_struct {
+      Matrix::degree_stats_struct rows;
+      Matrix::degree_stats_struct columns;
+      Matrix::diagonal_stats_struct diagonal;
+      Matrix::value_stats_struct values;
+      bool structurallySymmetric;
+    };
+
+
+    /**
+    * @brief An estimate and its 95% confidence interval.
+    */
+    struct interval_struct {
+      double estimate;
+      double low;
+      double high;
+    };
+
+
+    /**
+    * @brief Statistics estimated from a sample of a matrix.
+    */
+    struct estimate_stats_struct {
+      dim_type numSampledRows;
+      // the number of off-diagonal non-zeros checked for a transpose
+      index_type numSampledNonZeros;
+      // whether the distribution of the row sizes was estimated, which
+      // needs at least one sampled row
+      bool rowsEstimated;
+      interval_struct meanRowSize;
+      interval_struct rowPercentiles[Matrix::NUM_PERCENTILES];
+      interval_struct numEmptyRows;
+      // the number of diagonal positions holding a non-zero
+      interval_struct numDiagonal;
+      // the fraction of off-diagonal non-zeros whose transpose is also a
+      // non-zero
+      interval_struct symmetricFraction;
+    };
+
+
+    /**
+    * @brief Compute a set of statistics of a matrix in a single parallel
+    * sweep over its non-zeros.
+    *
+    * Structural symmetry is determined by comparing a fingerprint of the
+    * non-zero positions with that of their transposed positions, and so a
+    * non-symmetric matrix is reported as symmetric with a probability of
+    * about 2^-64.
+    *
+    * The value statistics are reduced in a separate vectorized stream over
+    * the values. Sums are accumulated over fixed size chunks and merged
+    * pairwise, so they do not depend on the number of threads or the
+    * instruction set.
+    *
+    * @param mat The matrix.
+    * @param flags The groups of statistics to compute (any others are left
+    * unset).
+    * @param progress The progress counter to update.
+    * @param scale The amount of progress this task contributes.
+    * @param cancel The flag which, once set, stops the sweep, leaving the
+    * statistics incomplete.
+    *
+    * @return The statistics.
+    */
+    static matrix_stats_struct compute(
+        Matrix const * mat,
+        int flags = ALL_STATS,
+        double * progress = nullptr,
+        double scale = 1.0,
+        std::atomic<bool> const * cancel = nullptr);
+
+
+    /**
+    * @brief Estimate a set of statistics of a matrix from a uniform sample
+    * of its rows and non-zeros, in time proportional to the size of the
+    * sample rather than the matrix. In half storage, the row sizes of the
+    * sample also include the mirrored entries, which takes a single pass
+    * over the column indices. Proportions use Wilson score intervals
+    * and percentiles use the binomial ranks of the sorted sample, both with
+    * a finite population correction, so sampling every row gives exact
+    * values.
+    *
+    * @param mat The matrix.
+    * @param numSampleRows The number of rows to sample (also the number of
+    * non-zeros checked for a transpose).
+    * @param seed The seed of the sample.
+    *
+    * @return The estimates.
+    */
+    static estimate_stats_struct estimate(
+        Matrix const * mat,
+        dim_type numSampleRows,
+        uint64_t seed);
+
+
+    /**
+    * @brief Summarize a set of non-zero counts.
+    *
+    * @param counts The counts.
+    * @param num The number of counts.
+    *
+    * @return The summary.
+    */
+    static Matrix::degree_stats_struct summarizeDegrees(
+        dim_type const * counts,
+        dim_type num);
+
+
+    /**
+    * @brief Count the non-zeros in each row in parallel. Most callers should
+    * use the degrees cached by the matrix instead.
+    *
+    * @param mat The matrix.
+    * @param counts The counts (must be of length equal to the number of
+    * rows).
+    * @param progress The progress counter to update.
+    * @param scale The amount of progress this task contributes.
+    * @param cancel The flag which, once set, stops the counting, leaving the
+    * counts incomplete.
+    */
     static void countRowNonZeros(
         Matrix * mat,
-        dim_type * counts);
-
-
+        dim_type * counts,
+        double * progress = nullptr,
+        double scale = 1.0,
+        std::atomic<bool> const * cancel = nullptr);
+
+
+    /**
+    * @brief Count the non-zeros in each column in parallel. Most callers
+    * should use the degrees cached by the matrix instead.
+    *
+    * @param mat The matrix.
+    * @param counts The counts (must be of length equal to the number of
+    * columns).
+    * @param progress The progress counter to update.
+    * @param scale The amount of progress this task contributes.
+    * @param cancel The flag which, once set, stops the counting, leaving the
+    * counts incomplete.
+    */
     static void countColumnNonZeros(
         Matrix * mat,
-        dim_type * counts);
-
+        dim_type * counts,
+        double * progress = nullptr,
+        double scale = 1.0,
+        std::atomic<bool> const * cancel = nullptr);
 
 
 
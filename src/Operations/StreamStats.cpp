@@ -0,0 +1,408 @@
+/**
+ * @file StreamStats.cpp
+ * @brief Implementation of the StreamStats class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "Data/TripletReader.hpp"
+#include "StreamStats.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+// the fraction of the progress spent reading the file
+double const PASS_FRACTION = 0.9;
+
+// the most positions the symmetry sketch holds at once
+size_t const MAX_SKETCH_PAIRS = 1 << 16;
+
+}
+
+
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+
+/**
+* @brief Hash a 64-bit key.
+*
+* @param x The key.
+*
+* @return The hash.
+*/
+inline uint64_t hashKey(
+    uint64_t x) noexcept
+{
+  // splitmix64 finalizer
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+
+/**
+* @brief Hash the position of a non-zero, as Stats::compute() does.
+*
+* @param row The row.
+* @param col The column.
+*
+* @return The hash.
+*/
+inline uint64_t hashPosition(
+    dim_type const row,
+    dim_type const col) noexcept
+{
+  return hashKey((static_cast<uint64_t>(row) << 32) ^ \
+      static_cast<uint64_t>(col));
+}
+
+
+/**
+* @brief Counts the non-zeros in square blocks of a matrix whose size may not
+* be known in advance. When an entry falls outside of the grid, the blocks
+* are doubled in size by merging them in fours.
+*/
+class DensityGrid
+{
+  public:
+    DensityGrid(
+        dim_type const maxSize,
+        dim_type const numRows,
+        dim_type const numCols) :
+      m_size(maxSize),
+      m_shift(0),
+      m_counts(static_cast<size_t>(maxSize)*maxSize, 0)
+    {
+      dim_type const maxDim = std::max(numRows, numCols);
+      while (m_size > 0 && maxDim > 0 && \
+          ((maxDim - 1) >> m_shift) >= m_size) {
+        ++m_shift;
+      }
+    }
+
+
+    inline void add(
+        dim_type const row,
+        dim_type const col)
+    {
+      while ((row >> m_shift) >= m_size || (col >> m_shift) >= m_size) {
+        fold();
+      }
+      ++m_counts[(static_cast<size_t>(row >> m_shift)*m_size) + \
+          (col >> m_shift)];
+    }
+
+
+    void fill(
+        HeatMap * const heatmap,
+        dim_type const numRows,
+        dim_type const numCols) const
+    {
+      dim_type const width = numCols > 0 ? ((numCols - 1) >> m_shift) + 1 : 1;
+      dim_type const height = numRows > 0 ? ((numRows - 1) >> m_shift) + 1 : 1;
+
+      heatmap->resize(width, height);
+      for (dim_type y = 0; y < height; ++y) {
+        for (dim_type x = 0; x < width; ++x) {
+          index_type const count = m_counts[(static_cast<size_t>(y)*m_size)+x];
+          if (count > 0) {
+            heatmap->add(x, y, static_cast<value_type>(count));
+          }
+        }
+      }
+    }
+
+
+  private:
+    dim_type m_size;
+    unsigned m_shift;
+    std::vector<index_type> m_counts;
+
+
+    void fold()
+    {
+      std::vector<index_type> folded(m_counts.size(), 0);
+      for (dim_type y = 0; y < m_size; ++y) {
+        for (dim_type x = 0; x < m_size; ++x) {
+          folded[(static_cast<size_t>(y/2)*m_size) + (x/2)] += \
+              m_counts[(static_cast<size_t>(y)*m_size) + x];
+        }
+      }
+      m_counts.swap(folded);
+      ++m_shift;
+    }
+};
+
+
+/**
+* @brief Estimates the fraction of off-diagonal non-zeros whose transposed
+* position is also a non-zero, in bounded memory. An entry and its transpose
+* hash to the same key, so they are always kept or dropped together. Keys are
+* kept if the top bits of their hash are zero, and each time the sketch fills
+* up, one more bit is required, dropping about half of the keys.
+*/
+class SymmetrySketch
+{
+  public:
+    SymmetrySketch() :
+      m_level(0),
+      m_pairs()
+    {
+      // do nothing
+    }
+
+
+    inline void add(
+        dim_type const row,
+        dim_type const col)
+    {
+      if (row == col) {
+        return;
+      }
+
+      uint64_t const key = (static_cast<uint64_t>(std::max(row, col)) << 32) | \
+          std::min(row, col);
+      if (!isKept(key)) {
+        return;
+      }
+
+      // a bit for each orientation
+      m_pairs[key] |= row > col ? 1 : 2;
+
+      while (m_pairs.size() > MAX_SKETCH_PAIRS) {
+        ++m_level;
+        for (auto it = m_pairs.begin(); it != m_pairs.end();) {
+          if (isKept(it->first)) {
+            ++it;
+          } else {
+            it = m_pairs.erase(it);
+          }
+        }
+      }
+    }
+
+
+    double estimate() const
+    {
+      index_type both = 0;
+      index_type one = 0;
+      for (auto const & pair : m_pairs) {
+        if (pair.second == 3) {
+          ++both;
+        } else {
+          ++one;
+        }
+      }
+
+      if (both + one == 0) {
+        return 1.0;
+      }
+
+      return static_cast<double>(2*both) / ((2*both) + one);
+    }
+
+
+  private:
+    unsigned m_level;
+    std::unordered_map<uint64_t, unsigned char> m_pairs;
+
+
+    inline bool isKept(
+        uint64_t const key) const noexcept
+    {
+      return m_level == 0 || (hashKey(key) >> (64 - m_level)) == 0;
+    }
+};
+
+
+}
+
+
+
+
+/******************************************************************************
+* STATIC PUBLIC FUNCTIONS *****************************************************
+******************************************************************************/
+
+
+StreamStats::stream_stats_struct StreamStats::compute(
+    char const * const path,
+    HeatMap * const heatmap,
+    dim_type const maxHeatMapSize,
+    double * const progress,
+    double const scale)
+{
+  if (!TripletReader::isSupported(path)) {
+    throw std::runtime_error(std::string("Cannot analyze '") + path + \
+        "' without loading it.");
+  }
+
+  TripletReader reader(path);
+
+  stream_stats_struct result;
+  result.declaredSymmetric = reader.getSymmetry() != TripletReader::GENERAL;
+
+  bool const known = reader.hasDimensions();
+  std::vector<dim_type> rowCounts(known ? reader.getNumRows() : 0, 0);
+  std::vector<dim_type> colCounts(known ? reader.getNumColumns() : 0, 0);
+
+  bool const mapped = heatmap != nullptr && maxHeatMapSize > 0;
+  DensityGrid grid(mapped ? maxHeatMapSize : 0, \
+      known ? reader.getNumRows() : 0, known ? reader.getNumColumns() : 0);
+  SymmetrySketch sketch;
+
+  index_type numNonZeros = 0;
+  index_type numDiagonal = 0;
+  index_type numZeroDiagonal = 0;
+  dim_type bandwidth = 0;
+  uint64_t fingerprint = 0;
+
+  Matrix::value_stats_struct & values = result.stats.values;
+  value_type minValue = std::numeric_limits<value_type>::infinity();
+  value_type maxValue = -std::numeric_limits<value_type>::infinity();
+  values.sum = 0;
+  values.absSum = 0;
+  values.numZeros = 0;
+  values.numNegative = 0;
+  values.numNaN = 0;
+  values.numInfinite = 0;
+  std::fill(values.magnitudes, values.magnitudes + \
+      Matrix::NUM_MAGNITUDE_BINS, 0);
+
+  bool const sketched = !result.declaredSymmetric;
+
+  reader.forEachEntry(true, true, progress, scale*PASS_FRACTION, \
+      [&](dim_type const row, dim_type const col, value_type const val) {
+    // edge lists declare no dimensions, so grow the counts as needed
+    if (row >= rowCounts.size()) {
+      rowCounts.resize(std::max<size_t>(row+1, 2*rowCounts.size()), 0);
+    }
+    if (col >= colCounts.size()) {
+      colCounts.resize(std::max<size_t>(col+1, 2*colCounts.size()), 0);
+    }
+    ++rowCounts[row];
+    ++colCounts[col];
+    ++numNonZeros;
+
+    if (row == col) {
+      ++numDiagonal;
+      if (val == 0) {
+        ++numZeroDiagonal;
+      }
+    }
+    bandwidth = std::max(bandwidth, col > row ? col - row : row - col);
+
+    if (mapped) {
+      grid.add(row, col);
+    }
+    if (sketched) {
+      fingerprint += hashPosition(row, col) - hashPosition(col, row);
+      sketch.add(row, col);
+    }
+
+    if (std::isnan(val)) {
+      ++values.numNaN;
+      return;
+    }
+    if (val < 0) {
+      ++values.numNegative;
+    }
+    if (std::isinf(val)) {
+      ++values.numInfinite;
+      return;
+    }
+    if (val == 0) {
+      ++values.numZeros;
+    } else {
+      int const bin = std::ilogb(val) - Matrix::MIN_MAGNITUDE;
+      ++values.magnitudes[std::min(std::max(bin, 0), \
+          Matrix::NUM_MAGNITUDE_BINS-1)];
+    }
+    minValue = std::min(minValue, val);
+    maxValue = std::max(maxValue, val);
+    values.sum += val;
+    values.absSum += std::abs(val);
+  });
+
+  // the dimensions of edge lists are known after a full pass
+  dim_type const numRows = reader.getNumRows();
+  dim_type const numCols = reader.getNumColumns();
+  rowCounts.resize(numRows, 0);
+  colCounts.resize(numCols, 0);
+
+  result.numRows = numRows;
+  result.numCols = numCols;
+  result.numNonZeros = numNonZeros;
+
+  result.stats.rows = Stats::summarizeDegrees(rowCounts.data(), numRows);
+  result.stats.columns = Stats::summarizeDegrees(colCounts.data(), numCols);
+
+  result.stats.diagonal.numNonZeros = numDiagonal;
+  result.stats.diagonal.numZeros = std::min(numRows, numCols) - numDiagonal + \
+      numZeroDiagonal;
+  result.stats.diagonal.bandwidth = bandwidth;
+
+  values.numValues = numNonZeros;
+  if (minValue > maxValue) {
+    // no finite values
+    values.min = 0;
+    values.max = 0;
+  } else {
+    values.min = minValue;
+    values.max = maxValue;
+  }
+
+  if (result.declaredSymmetric) {
+    result.stats.structurallySymmetric = true;
+    result.symmetricFraction = 1.0;
+  } else {
+    result.stats.structurallySymmetric = numRows == numCols && \
+        fingerprint == 0;
+    result.symmetricFraction = sketch.estimate();
+  }
+
+  if (mapped) {
+    grid.fill(heatmap, numRows, numCols);
+  }
+
+  if (progress != nullptr) {
+    *progress += scale * (1.0 - PASS_FRACTION);
+  }
+
+  return result;
+}
+
+
+
+}
@@ -0,0 +1,86 @@
+/**
+ * @file StreamStats.hpp
+ * @brief The StreamStats class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_OPERATIONS_STREAMSTATS_HPP
+#define MATRIXINSPECTOR_OPERATIONS_STREAMSTATS_HPP
+
+
+
+
+#include "Data/HeatMap.hpp"
+#include "Operations/Stats.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+class StreamStats
+{
+  public:
+    struct stream_stats_struct {
+      dim_type numRows;
+      dim_type numCols;
+      index_type numNonZeros;
+      // whether the file declares the matrix symmetric (or skew-symmetric, or
+      // hermitian)
+      bool declaredSymmetric;
+      Stats::matrix_stats_struct stats;
+      // the estimated fraction of the off-diagonal non-zeros whose
+      // transposed position is also a non-zero
+      double symmetricFraction;
+    };
+
+
+    /**
+    * @brief Compute the statistics of a matrix file in a single pass over its
+    * entries, without building the matrix. Memory use is proportional to the
+    * number of rows and columns plus the size of the heat map. Only files
+    * supported by the TripletReader can be analyzed.
+    *
+    * Structural symmetry is decided by the same fingerprint used by
+    * Stats::compute(), and the fraction of symmetric non-zeros is estimated
+    * from a bounded sample of positions, chosen by hash so that an entry and
+    * its transpose are always sampled together.
+    *
+    * @param path The path of the file.
+    * @param heatmap The heat map to fill with the number of non-zeros in each
+    * block of the matrix (may be null). Blocks are square, so the heat map
+    * keeps the shape of the matrix.
+    * @param maxHeatMapSize The maximum width and height of the heat map.
+    * @param progress The progress counter to update.
+    * @param scale The amount of progress this task contributes.
+    *
+    * @return The statistics.
+    */
+    static stream_stats_struct compute(
+        char const * path,
+        HeatMap * heatmap,
+        dim_type maxHeatMapSize,
+        double * progress = nullptr,
+        double scale = 1.0);
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
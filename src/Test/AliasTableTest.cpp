@@ -0,0 +1,91 @@
+/**
+ * @file AliasTableTest.cpp
+ * @brief Unit tests for the AliasTable class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Utility/AliasTable.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+TEST
+{
+  // draws follow the weights, and zero weights are never drawn
+  {
+    std::vector<float> const weights{1, 0, 2, 3, 0, 4};
+    AliasTable const table(weights.data(), weights.size());
+    testEquals(table.size(), weights.size());
+
+    Random rng(3);
+    std::vector<size_t> counts(weights.size(), 0);
+    for (int i = 0; i < 100000; ++i) {
+      ++counts[table.draw(rng)];
+    }
+    testEquals(counts[1], 0);
+    testEquals(counts[4], 0);
+    for (size_t i = 0; i < weights.size(); ++i) {
+      double const expected = 10000.0 * weights[i];
+      testGreaterThanOrEqual(counts[i], expected * 0.95);
+      testLessThanOrEqual(counts[i], expected * 1.05);
+    }
+  }
+
+  // several chunks, with all of the weight in the last and in one of the
+  // middle, which are built on different threads
+  {
+    std::vector<uint32_t> weights(300000, 0);
+    weights[70000] = 1;
+    weights.back() = 3;
+    AliasTable const table(weights.data(), weights.size());
+
+    Random rng(5);
+    size_t numLast = 0;
+    for (int i = 0; i < 40000; ++i) {
+      size_t const index = table.draw(rng);
+      testTrue(index == 70000 || index == weights.size()-1);
+      if (index == weights.size()-1) {
+        ++numLast;
+      }
+    }
+    testGreaterThan(numLast, 29000);
+    testLessThan(numLast, 31000);
+  }
+
+  // invalid weights
+  std::vector<std::vector<double>> const invalid{{0, 0}, {1, -1}, \
+      {1, std::numeric_limits<double>::quiet_NaN()}, \
+      {1, std::numeric_limits<double>::infinity()}};
+  for (std::vector<double> const & weights : invalid) {
+    bool thrown = false;
+    try {
+      AliasTable const table(weights.data(), weights.size());
+    } catch (std::runtime_error const &) {
+      thrown = true;
+    }
+    testTrue(thrown);
+  }
+}
+
+
+
+}
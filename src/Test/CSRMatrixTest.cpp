@@ -8,8 +8,11 @@
 */
 
 
+#include <vector>
+#include <algorithm>
 #include "Test/UnitTest.hpp"
 #include "Data/CSRMatrix.hpp"
+#include "Operations/Stats.hpp"
 
 
 using namespace MatrixInspector;
@@ -49,10 +52,65 @@ TEST
   values[6] = 7.0;
 
   // compute symmetry
-  mat.computeSymmetry()
+  mat.computeSymmetry();
 
   // check for symmetry
   testEquals(mat.isSymmetric(), true);
+
+  // store only the lower triangle
+  CSRMatrix half(mat);
+  half.convertToHalfStorage();
+
+  testTrue(half.isHalfStorage());
+  testEquals(half.getNumNonZeros(), 7);
+  testEquals(half.getNumStoredNonZeros(), 6);
+
+  std::vector<dim_type> fullCounts(5);
+  std::vector<dim_type> halfCounts(5);
+  Stats::countRowNonZeros(&mat,fullCounts.data());
+  Stats::countRowNonZeros(&half,halfCounts.data());
+  for (dim_type row = 0; row < 5; ++row) {
+    testEquals(halfCounts[row], fullCounts[row]);
+  }
+  Stats::countColumnNonZeros(&half,halfCounts.data());
+  for (dim_type col = 0; col < 5; ++col) {
+    testEquals(halfCounts[col], fullCounts[col]);
+  }
+
+  // permute both symmetrically
+  std::vector<dim_type> const perm{3,0,4,1,2};
+  mat.reorder(perm.data(),perm.data());
+  half.reorder(perm.data(),perm.data());
+  testTrue(half.isHalfStorage());
+
+  // the rows stay sorted by column
+  for (CSRMatrix const * const m : {&mat, &half}) {
+    for (dim_type row = 0; row < 5; ++row) {
+      testTrue(std::is_sorted(m->getColumns()+m->getOffsets()[row], \
+          m->getColumns()+m->getOffsets()[row+1]));
+    }
+  }
+
+  // expanding should give back the same matrix
+  half.expandToFullStorage();
+  testTrue(!half.isHalfStorage());
+  testEquals(half.getNumNonZeros(), 7);
+
+  for (dim_type row = 0; row < 5; ++row) {
+    index_type const start = mat.getOffsets()[row];
+    index_type const end = mat.getOffsets()[row+1];
+    testEquals(half.getOffsets()[row+1], end);
+
+    std::vector<std::pair<dim_type,value_type>> expected;
+    std::vector<std::pair<dim_type,value_type>> actual;
+    for (index_type idx = start; idx < end; ++idx) {
+      expected.emplace_back(mat.getColumns()[idx], mat.getValues()[idx]);
+      actual.emplace_back(half.getColumns()[idx], half.getValues()[idx]);
+    }
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    testTrue(expected == actual);
+  }
 }
 
 }
@@ -0,0 +1,151 @@
+/**
+ * @file ColorMapTest.cpp
+ * @brief Unit tests for the ColorMap class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Data/ColorMap.hpp"
+#include "Data/HeatMap.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+namespace
+{
+
+
+uint32_t getGray(
+    uint32_t const color)
+{
+  // grayscale has all three channels the same
+  uint32_t const red = color & 0xFF;
+  uint32_t const green = (color >> 8) & 0xFF;
+  uint32_t const blue = (color >> 16) & 0xFF;
+  testEquals(red, green);
+  testEquals(red, blue);
+  return red;
+}
+
+
+}
+
+
+TEST
+{
+  // the values of a heat map, which are counts, spanning more than a vector
+  size_t const num = 4099;
+  std::vector<value_type> values(num);
+  for (size_t i = 0; i < num; ++i) {
+    values[i] = static_cast<value_type>((i * 7) % 4096);
+  }
+  std::vector<uint32_t> colors(num);
+
+  // the heat map matches the normalized colors
+  {
+    ColorMap const map;
+    testEquals(map.getType(), ColorMap::HEAT);
+    testEquals(map.getScale(), ColorMap::LINEAR_SCALE);
+
+    map.apply(values.data(), num, 0.0f, 4095.0f, colors.data());
+    for (size_t i = 0; i < num; ++i) {
+      float const val = values[i] / 4095.0f;
+      testEquals(colors[i], HeatMap::floatToRGBA(val));
+      testEquals(colors[i], map.getColor(val));
+    }
+
+    // an empty range is all the middle color, as when normalized
+    map.apply(values.data(), num, 2.0f, 2.0f, colors.data());
+    for (size_t i = 0; i < num; ++i) {
+      testEquals(colors[i], map.getColor(0.5f));
+    }
+  }
+
+  // the ends of viridis
+  {
+    ColorMap const map(ColorMap::VIRIDIS);
+    uint32_t const first = (84U << 16) | (1U << 8) | 68U;
+    uint32_t const last = (37U << 16) | (231U << 8) | 253U;
+    testEquals(map.getColor(0.0f), first);
+    testEquals(map.getColor(1.0f), last);
+  }
+
+  // a diverging map is centered on zero, and ignores the log scale
+  {
+    ColorMap const map(ColorMap::DIVERGING, ColorMap::LOG_SCALE);
+    uint32_t const blue = (97U << 16) | (48U << 8) | 5U;
+    uint32_t const white = (247U << 16) | (247U << 8) | 247U;
+    uint32_t const red = (31U << 16) | (0U << 8) | 103U;
+    testEquals(map.getColor(0.0f), blue);
+    testEquals(map.getColor(0.5f), white);
+    testEquals(map.getColor(1.0f), red);
+
+    std::vector<value_type> const signedValues{-4.0f, 0.0f, 1.0f, 2.0f, \
+        -1.0f, 4.0f};
+    std::vector<uint32_t> signedColors(signedValues.size());
+    map.apply(signedValues.data(), signedValues.size(), -4.0f, 2.0f, \
+        signedColors.data());
+    testEquals(signedColors[0], blue);
+    testEquals(signedColors[1], white);
+    testEquals(signedColors[2], map.getColor(0.625f));
+    testEquals(signedColors[3], map.getColor(0.75f));
+    testEquals(signedColors[4], map.getColor(0.375f));
+    testEquals(signedColors[5], red);
+  }
+
+  // the log scale spaces small values further apart, and is increasing
+  {
+    ColorMap const linear(ColorMap::GRAYSCALE, ColorMap::LINEAR_SCALE);
+    ColorMap const log(ColorMap::GRAYSCALE, ColorMap::LOG_SCALE);
+
+    std::vector<value_type> ramp(num);
+    for (size_t i = 0; i < num; ++i) {
+      ramp[i] = static_cast<value_type>(i) + 1.0f;
+    }
+    value_type const max = static_cast<value_type>(num);
+
+    std::vector<uint32_t> linearColors(num);
+    linear.apply(ramp.data(), num, 1.0f, max, linearColors.data());
+    log.apply(ramp.data(), num, 1.0f, max, colors.data());
+
+    testEquals(getGray(colors[0]), 0);
+    testEquals(getGray(colors[num-1]), 255);
+    for (size_t i = 1; i < num; ++i) {
+      testLessThanOrEqual(getGray(colors[i-1]), getGray(colors[i]));
+      testGreaterThanOrEqual(getGray(colors[i]), getGray(linearColors[i]));
+    }
+    testGreaterThan(getGray(colors[num/16]), 128);
+
+    // values out of range are clamped, and nans are the lowest color
+    std::vector<value_type> odd{-5.0f, 1e30f, \
+        std::numeric_limits<value_type>::infinity(), \
+        std::numeric_limits<value_type>::quiet_NaN()};
+    std::vector<uint32_t> oddColors(odd.size());
+    linear.apply(odd.data(), odd.size(), 0.0f, 1.0f, oddColors.data());
+    testEquals(getGray(oddColors[0]), 0);
+    testEquals(getGray(oddColors[1]), 255);
+    testEquals(getGray(oddColors[2]), 255);
+    testEquals(getGray(oddColors[3]), 0);
+  }
+}
+
+
+
+}
@@ -0,0 +1,380 @@
+/**
+ * @file DataStorageTest.cpp
+ * @brief Unit tests for loading reduced matrices with the DataStorage class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Data/DataStorage.hpp"
+#include "Data/CSRMatrix.hpp"
+#include "Utility/Random.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+namespace
+{
+
+typedef std::vector<std::vector<value_type>> dense_type;
+
+
+dense_type randomDense(
+    dim_type const numRows,
+    dim_type const numCols,
+    bool const symmetric,
+    uint64_t const seed)
+{
+  Random rng(seed);
+  dense_type dense(numRows, std::vector<value_type>(numCols, 0));
+  for (dim_type row = 0; row < numRows; ++row) {
+    for (dim_type col = 0; col < (symmetric ? row+1 : numCols); ++col) {
+      if (rng.uniform() < 0.3) {
+        value_type const value = static_cast<value_type>(row*100 + col + 1);
+        dense[row][col] = value;
+        if (symmetric) {
+          dense[col][row] = value;
+        }
+      }
+    }
+  }
+
+  return dense;
+}
+
+
+std::vector<dim_type> all(
+    dim_type const num)
+{
+  std::vector<dim_type> indices(num);
+  for (dim_type i = 0; i < num; ++i) {
+    indices[i] = i;
+  }
+
+  return indices;
+}
+
+
+std::vector<dim_type> withDegrees(
+    dense_type const & dense,
+    bool const byRow,
+    dim_type const minSize,
+    dim_type const maxSize)
+{
+  size_t const num = byRow ? dense.size() : dense[0].size();
+  std::vector<dim_type> kept;
+  for (size_t i = 0; i < num; ++i) {
+    dim_type degree = 0;
+    for (size_t j = 0; j < (byRow ? dense[0].size() : dense.size()); ++j) {
+      if ((byRow ? dense[i][j] : dense[j][i]) != 0) {
+        ++degree;
+      }
+    }
+    if (degree >= minSize && degree <= maxSize) {
+      kept.push_back(static_cast<dim_type>(i));
+    }
+  }
+
+  return kept;
+}
+
+
+/**
+* @brief Write the lower triangle (if symmetric) or all of the entries of a
+* matrix in column-major order, as Matrix Market files usually are.
+*/
+void writeMatrixMarket(
+    std::string const & path,
+    dense_type const & dense,
+    bool const symmetric)
+{
+  std::vector<std::string> lines;
+  for (size_t col = 0; col < dense[0].size(); ++col) {
+    for (size_t row = symmetric ? col : 0; row < dense.size(); ++row) {
+      if (dense[row][col] != 0) {
+        lines.push_back(std::to_string(row+1) + " " + \
+            std::to_string(col+1) + " " + std::to_string(dense[row][col]));
+      }
+    }
+  }
+
+  std::ofstream file(path);
+  file << "%%MatrixMarket matrix coordinate real " << \
+      (symmetric ? "symmetric" : "general") << std::endl;
+  file << "% a comment" << std::endl;
+  file << dense.size() << " " << dense[0].size() << " " << lines.size() << \
+      std::endl;
+  for (std::string const & line : lines) {
+    file << line << std::endl;
+  }
+}
+
+
+void testMatrix(
+    CSRMatrix const * const mat,
+    dense_type const & dense,
+    std::vector<dim_type> const & rows,
+    std::vector<dim_type> const & cols)
+{
+  testEquals(mat->getNumRows(), rows.size());
+  testEquals(mat->getNumColumns(), cols.size());
+
+  index_type const * const offsets = mat->getOffsets();
+  dim_type const * const columns = mat->getColumns();
+  value_type const * const values = mat->getValues();
+
+  bool const half = mat->isHalfStorage();
+  for (dim_type row = 0; row < rows.size(); ++row) {
+    index_type idx = offsets[row];
+    for (dim_type col = 0; col < (half ? row+1 : cols.size()); ++col) {
+      value_type const value = dense[rows[row]][cols[col]];
+      if (value != 0) {
+        testLessThan(idx, offsets[row+1]);
+        testEquals(columns[idx], col);
+        testEquals(values[idx], value);
+        ++idx;
+      }
+    }
+    testEquals(idx, offsets[row+1]);
+  }
+}
+
+
+DataStorage::load_options_struct thresholdOptions(
+    DataStorage::load_sample_type const type,
+    dim_type const minSize,
+    dim_type const maxSize)
+{
+  return DataStorage::load_options_struct{type, 0, 0, false, 0, minSize, \
+      maxSize};
+}
+
+
+DataStorage::load_options_struct randomOptions(
+    dim_type const numRows,
+    dim_type const numCols,
+    bool const symmetric,
+    uint64_t const seed)
+{
+  return DataStorage::load_options_struct{DataStorage::LOAD_RANDOM, numRows, \
+      numCols, symmetric, seed, 0, 0};
+}
+
+
+CSRMatrix const * load(
+    DataStorage * const storage,
+    std::string const & path,
+    DataStorage::load_options_struct const & options,
+    ValueArray::precision_type const precision = \
+        ValueArray::FULL_PRECISION)
+{
+  double progress = 0;
+  storage->loadDataset(path.c_str(), options, &progress, precision);
+  testTrue(progress > 0.99 && progress < 1.01);
+
+  CSRMatrix const * const mat = \
+      dynamic_cast<CSRMatrix const *>(storage->getMatrix());
+  testTrue(mat != nullptr);
+
+  return mat;
+}
+
+}
+
+
+TEST
+{
+  DataStorage storage;
+
+  // general Matrix Market files
+  {
+    std::string const path("DataStorageTest_general.mtx");
+    dense_type const dense = randomDense(40, 30, false, 1);
+    writeMatrixMarket(path, dense, false);
+
+    // whole files are streamed as well
+    CSRMatrix const * mat = load(&storage, path, \
+        DataStorage::load_options_struct{DataStorage::LOAD_ALL, 0, 0, false, \
+        0, 0, 0});
+    testMatrix(mat, dense, all(40), all(30));
+    testTrue(!mat->isHalfStorage());
+
+    mat = load(&storage, path, \
+        thresholdOptions(DataStorage::LOAD_THRESHOLD_ROWS, 8, 12));
+    testMatrix(mat, dense, withDegrees(dense, true, 8, 12), all(30));
+    testTrue(!mat->isHalfStorage());
+
+    mat = load(&storage, path, \
+        thresholdOptions(DataStorage::LOAD_THRESHOLD_COLUMNS, 0, 11));
+    testMatrix(mat, dense, all(40), withDegrees(dense, false, 0, 11));
+
+    // the sample follows the seed
+    std::vector<dim_type> rows(15);
+    std::vector<dim_type> cols(10);
+    Random rng(7);
+    rng.sortedSample(rows.data(), 40, 15);
+    rng.sortedSample(cols.data(), 30, 10);
+    mat = load(&storage, path, randomOptions(15, 10, false, 7));
+    testMatrix(mat, dense, rows, cols);
+
+    // samples are limited to the size of the matrix
+    mat = load(&storage, path, randomOptions(100, 100, false, 7));
+    testMatrix(mat, dense, all(40), all(30));
+
+    std::remove(path.c_str());
+  }
+
+  // symmetric Matrix Market files
+  {
+    std::string const path("DataStorageTest_symmetric.mtx");
+    dense_type const dense = randomDense(25, 25, true, 2);
+    writeMatrixMarket(path, dense, true);
+
+    // the same rows and columns keep the matrix in half storage
+    std::vector<dim_type> rows(12);
+    Random rng(3);
+    rng.sortedSample(rows.data(), 25, 12);
+    CSRMatrix const * mat = load(&storage, path, \
+        randomOptions(12, 12, true, 3));
+    testTrue(mat->isHalfStorage());
+    testMatrix(mat, dense, rows, rows);
+
+    // the whole file is read straight into half storage
+    mat = load(&storage, path, DataStorage::load_options_struct{ \
+        DataStorage::LOAD_ALL, 0, 0, false, 0, 0, 0});
+    testTrue(mat->isHalfStorage());
+    testTrue(mat->isSymmetric());
+    testMatrix(mat, dense, all(25), all(25));
+
+    // values are encoded as they are read
+    mat = load(&storage, path, DataStorage::load_options_struct{ \
+        DataStorage::LOAD_ALL, 0, 0, false, 0, 0, 0}, \
+        ValueArray::HALF_PRECISION);
+    testTrue(mat->isHalfStorage());
+    testEquals(mat->getValuePrecision(), ValueArray::HALF_PRECISION);
+    for (dim_type row = 0; row < 25; ++row) {
+      index_type idx = mat->getOffsets()[row];
+      for (dim_type col = 0; col <= row; ++col) {
+        if (dense[row][col] != 0) {
+          value_type const expected = ValueArray::halfToFloat( \
+              ValueArray::floatToHalf(dense[row][col]));
+          testEquals(mat->getColumns()[idx], col);
+          testEquals(mat->getValueArray().get(idx), expected);
+          ++idx;
+        }
+      }
+      testEquals(idx, mat->getOffsets()[row+1]);
+    }
+
+    // thresholds count the implied entries, and expand them
+    mat = load(&storage, path, \
+        thresholdOptions(DataStorage::LOAD_THRESHOLD_ROWS, 7, 25));
+    testTrue(!mat->isHalfStorage());
+    testMatrix(mat, dense, withDegrees(dense, true, 7, 25), all(25));
+
+    std::remove(path.c_str());
+  }
+
+  // METIS graphs, with vertex weights and an isolated vertex
+  {
+    std::string const path("DataStorageTest.graph");
+    std::ofstream file(path);
+    file << "% a graph" << std::endl;
+    file << "4 3 11" << std::endl;
+    file << "1 2 5 3 6" << std::endl;
+    file << "2 1 5" << std::endl;
+    file << "3 1 6 4 7" << std::endl;
+    file << "4 3 7" << std::endl;
+    file.close();
+
+    dense_type const dense{{0, 5, 6, 0}, {5, 0, 0, 0}, {6, 0, 0, 7}, \
+        {0, 0, 7, 0}};
+    CSRMatrix const * const mat = load(&storage, path, \
+        thresholdOptions(DataStorage::LOAD_THRESHOLD_ROWS, 1, 1));
+    testMatrix(mat, dense, {1, 3}, all(4));
+
+    std::ofstream isolated(path);
+    isolated << "3 1" << std::endl;
+    isolated << "3" << std::endl;
+    isolated << std::endl;
+    isolated << "1" << std::endl;
+    isolated.close();
+
+    dense_type const pattern{{0, 0, 1}, {0, 0, 0}, {1, 0, 0}};
+    testMatrix(load(&storage, path, \
+        thresholdOptions(DataStorage::LOAD_THRESHOLD_COLUMNS, 0, 3)), \
+        pattern, all(3), all(3));
+
+    std::remove(path.c_str());
+  }
+
+  // edge lists declare no dimensions, and are not sorted
+  {
+    std::string const path("DataStorageTest.snap");
+    std::ofstream file(path);
+    file << "# Directed graph" << std::endl;
+    file << "# FromNodeId\tToNodeId" << std::endl;
+    file << "0\t4" << std::endl;
+    file << "0\t1" << std::endl;
+    file << "3\t0" << std::endl;
+    file << "4\t2\t2.5" << std::endl;
+    file.close();
+
+    dense_type const dense{{0, 1, 0, 0, 1}, {0, 0, 0, 0, 0}, \
+        {0, 0, 0, 0, 0}, {1, 0, 0, 0, 0}, {0, 0, 2.5, 0, 0}};
+    std::vector<dim_type> rows(3);
+    std::vector<dim_type> cols(4);
+    Random rng(11);
+    rng.sortedSample(rows.data(), 5, 3);
+    rng.sortedSample(cols.data(), 5, 4);
+    testMatrix(load(&storage, path, randomOptions(3, 4, false, 11)), dense, \
+        rows, cols);
+
+    std::remove(path.c_str());
+  }
+
+  // malformed files are reported
+  {
+    std::string const path("DataStorageTest_invalid.mtx");
+    std::ofstream file(path);
+    file << "%%MatrixMarket matrix coordinate real general" << std::endl;
+    file << "2 2 2" << std::endl;
+    file << "1 1 1.0" << std::endl;
+    file << "3 1 1.0" << std::endl;
+    file.close();
+
+    bool thrown = false;
+    try {
+      load(&storage, path, \
+          thresholdOptions(DataStorage::LOAD_THRESHOLD_ROWS, 0, 2));
+    } catch (std::runtime_error const &) {
+      thrown = true;
+    }
+    testTrue(thrown);
+
+    std::remove(path.c_str());
+  }
+}
+
+
+
+
+}
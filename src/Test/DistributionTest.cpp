@@ -0,0 +1,205 @@
+/**
+ * @file DistributionTest.cpp
+ * @brief Unit tests for the Distribution class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Operations/Distribution.hpp"
+#include "Data/CSRMatrix.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+TEST
+{
+  CSRMatrix mat(5,4,6);
+
+  index_type * const offsets = mat.getOffsets();
+  offsets[0] = 0;
+  offsets[1] = 1;
+  offsets[2] = 3;
+  offsets[3] = 3;
+  offsets[4] = 5;
+  offsets[5] = 6;
+
+  dim_type * const columns = mat.getColumns();
+  columns[0] = 1;
+  columns[1] = 0;
+  columns[2] = 3;
+  columns[3] = 0;
+  columns[4] = 1;
+  columns[5] = 2;
+
+  value_type * const values = mat.getValues();
+  values[0] = 1.0;
+  values[1] = -2.0;
+  values[2] = 0.0;
+  values[3] = 4.0;
+  values[4] = 5.0;
+  values[5] = 6.0;
+
+  // a cancelled binning counts nothing
+  {
+    CSRMatrix copy(mat);
+    std::atomic<bool> const cancel(true);
+    Distribution::fine_histogram_struct const none = \
+        Distribution::rowDegrees(&copy, nullptr, 1.0, &cancel);
+    testTrue(none.values.empty());
+    testTrue(!copy.isRowDegreesSet());
+    Distribution::fine_histogram_struct const noValues = \
+        Distribution::valueMagnitudes(&copy, nullptr, 1.0, &cancel);
+    testTrue(noValues.values.empty());
+  }
+
+  // check rows
+  Distribution::fine_histogram_struct const rows = \
+      Distribution::rowDegrees(&mat);
+  testTrue(rows.discrete);
+  testEquals(rows.values.size(),3);
+  testEquals(rows.values[0],0.0);
+  testEquals(rows.values[2],2.0);
+  testEquals(rows.counts[0],1);
+  testEquals(rows.counts[1],2);
+  testEquals(rows.counts[2],2);
+
+  // check columns
+  Distribution::fine_histogram_struct const cols = \
+      Distribution::columnDegrees(&mat);
+  testEquals(cols.values.size(),2);
+  testEquals(cols.values[0],1.0);
+  testEquals(cols.counts[0],2);
+  testEquals(cols.counts[1],2);
+
+  // check values
+  Distribution::fine_histogram_struct const mags = \
+      Distribution::valueMagnitudes(&mat);
+  testTrue(!mags.discrete);
+  testEquals(mags.values.size(),6);
+  testEquals(mags.values[0],0.0);
+  testEquals(mags.counts[0],1);
+  for (size_t i = 1; i < mags.values.size(); ++i) {
+    testGreaterThan(mags.values[i],mags.values[i-1]);
+  }
+  // the bins are 1/16th of a power of two wide
+  testLessThan(std::abs(mags.values[1]-1.0),1.0/16.0);
+  testLessThan(std::abs(mags.values[2]-2.0),2.0/16.0);
+
+  // a sample of every row or value is exact
+  Distribution::fine_histogram_struct const sampledRows = \
+      Distribution::sampleRowDegrees(&mat, 5, 1);
+  testTrue(sampledRows.values == rows.values);
+  testTrue(sampledRows.counts == rows.counts);
+  Distribution::fine_histogram_struct const sampledMags = \
+      Distribution::sampleValueMagnitudes(&mat, 100, 1);
+  testTrue(sampledMags.values == mags.values);
+  testTrue(sampledMags.counts == mags.counts);
+
+  // and a smaller one is scaled up to the whole matrix
+  Distribution::fine_histogram_struct const partRows = \
+      Distribution::sampleRowDegrees(&mat, 2, 1);
+  index_type numRows = 0;
+  for (index_type const count : partRows.counts) {
+    testEquals(count % 2,1);
+    numRows += count;
+  }
+  testTrue(numRows == 5 || numRows == 6);
+
+  // check re-bucketing
+  Distribution::histogram_struct linear = Distribution::bucket(rows, 2, \
+      Distribution::LINEAR_SCALE);
+  testEquals(linear.counts.size(),2);
+  testEquals(linear.edges[0],0.0);
+  testEquals(linear.edges[1],2.0);
+  testEquals(linear.edges[2],3.0);
+  testEquals(linear.counts[0],3);
+  testEquals(linear.counts[1],2);
+  testEquals(linear.numExcluded,0);
+
+  // integer bins are never empty of integers
+  Distribution::histogram_struct const log = Distribution::bucket(rows, 10, \
+      Distribution::LOG_SCALE);
+  testEquals(log.numExcluded,1);
+  testEquals(log.counts.size(),2);
+  testEquals(log.counts[0],2);
+  testEquals(log.counts[1],2);
+
+  Distribution::histogram_struct const magLog = Distribution::bucket(mags, \
+      4, Distribution::LOG_SCALE);
+  testEquals(magLog.counts.size(),4);
+  testEquals(magLog.numExcluded,1);
+  index_type total = 0;
+  for (index_type const count : magLog.counts) {
+    total += count;
+  }
+  testEquals(total,5);
+
+  // half storage counts the mirrored entries
+  CSRMatrix square(3,3,4);
+  square.getOffsets()[0] = 0;
+  square.getOffsets()[1] = 1;
+  square.getOffsets()[2] = 3;
+  square.getOffsets()[3] = 4;
+  square.getColumns()[0] = 1;
+  square.getColumns()[1] = 0;
+  square.getColumns()[2] = 2;
+  square.getColumns()[3] = 1;
+  for (index_type i = 0; i < 4; ++i) {
+    square.getValues()[i] = 3.0;
+  }
+  square.convertToHalfStorage();
+  Distribution::fine_histogram_struct const halfRows = \
+      Distribution::rowDegrees(&square);
+  testEquals(halfRows.values.size(),2);
+  testEquals(halfRows.counts[0],2);
+  testEquals(halfRows.counts[1],1);
+  Distribution::fine_histogram_struct const halfMags = \
+      Distribution::valueMagnitudes(&square);
+  testEquals(halfMags.values.size(),1);
+  testEquals(halfMags.counts[0],4);
+  testTrue(Distribution::sampleRowDegrees(&square, 3, 1).values.empty());
+  Distribution::fine_histogram_struct const sampledHalfMags = \
+      Distribution::sampleValueMagnitudes(&square, 3, 1);
+  testTrue(sampledHalfMags.counts == halfMags.counts);
+
+  // fit a power law with an exponent of 2.5
+  std::vector<dim_type> degrees;
+  for (dim_type degree = 1; degree <= 1000; ++degree) {
+    index_type const count = static_cast<index_type>( \
+        1.0e6 * std::pow(degree, -2.5));
+    degrees.insert(degrees.end(), count, degree);
+  }
+  Distribution::fine_histogram_struct const tail = Distribution::degrees( \
+      degrees.data(), static_cast<dim_type>(degrees.size()));
+  testEquals(tail.counts[0],1000000);
+  Distribution::power_law_struct const fit = Distribution::fitPowerLaw(tail);
+  testGreaterThan(fit.numTail,0);
+  testLessThan(std::abs(fit.alpha-2.5),0.1);
+  testLessThan(fit.distance,0.05);
+
+  // too few values to fit
+  Distribution::power_law_struct const none = Distribution::fitPowerLaw(rows);
+  testEquals(none.numTail,0);
+}
+
+
+
+
+}
@@ -0,0 +1,84 @@
+/**
+ * @file FeistelPermutationTest.cpp
+ * @brief Unit tests for the FeistelPermutation class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <cstdint>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Utility/FeistelPermutation.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+TEST
+{
+  // sizes which are and are not powers of two, with odd and even numbers of
+  // bits
+  uint64_t const sizes[] = {1, 2, 3, 5, 64, 100, 1000, 65537};
+  for (uint64_t const size : sizes) {
+    FeistelPermutation const perm(size, 42);
+    testEquals(perm.size(),size);
+
+    std::vector<bool> seen(size,false);
+    for (uint64_t i = 0; i < size; ++i) {
+      uint64_t const mapped = perm(i);
+      testLessThan(mapped,size);
+      testTrue(!seen[mapped]);
+      seen[mapped] = true;
+      testEquals(perm.inverse(mapped),i);
+    }
+  }
+
+  // reproducible from the seed and stream
+  FeistelPermutation const a(1000, 7);
+  FeistelPermutation const b(1000, 7);
+  FeistelPermutation const c(1000, 7, 1);
+  FeistelPermutation const d(1000, 8);
+  testTrue(a == b);
+  testTrue(!(a == c));
+  testTrue(!(a == d));
+  size_t numFixed = 0;
+  size_t numSame = 0;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    testEquals(a(i),b(i));
+    if (a(i) == i) {
+      ++numFixed;
+    }
+    if (a(i) == c(i)) {
+      ++numSame;
+    }
+  }
+  // a random permutation has one fixed point on average
+  testLessThan(numFixed,10);
+  testLessThan(numSame,10);
+
+  // large sizes are evaluated without storing anything
+  FeistelPermutation const large(4000000000ULL, 3);
+  for (uint64_t i = 0; i < 1000; ++i) {
+    uint64_t const index = i * 3999999ULL;
+    uint64_t const mapped = large(index);
+    testLessThan(mapped,4000000000ULL);
+    testEquals(large.inverse(mapped),index);
+  }
+}
+
+
+
+
+}
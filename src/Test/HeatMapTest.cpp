@@ -0,0 +1,600 @@
+/**
+ * @file HeatMapTest.cpp
+ * @brief Unit tests for the HeatMap class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Test/TestMatrix.hpp"
+#include "Data/HeatMap.hpp"
+#include "Data/CSRMatrix.hpp"
+#include "Utility/Random.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+namespace
+{
+
+
+/**
+* @brief Check that counting the non-zeros of a matrix gives the same heat
+* map as adding them one at a time.
+*
+* @param mat The matrix in full storage.
+* @param size The width and height of the heat map.
+*/
+void testCounts(
+    CSRMatrix const & mat,
+    dim_type const size)
+{
+  float const scale = static_cast<float>(size) / mat.getNumRows();
+
+  HeatMap expected(size, size);
+  for (dim_type row = 0; row < mat.getNumRows(); ++row) {
+    for (index_type idx = mat.getOffsets()[row]; \
+        idx < mat.getOffsets()[row+1]; ++idx) {
+      expected.add(static_cast<dim_type>(mat.getColumns()[idx] * scale), \
+          static_cast<dim_type>(row * scale));
+    }
+  }
+
+  for (int half = 0; half < 2; ++half) {
+    CSRMatrix copy(mat);
+    if (half) {
+      copy.convertToHalfStorage();
+    }
+
+    // left over values are replaced
+    HeatMap heatmap(size, size);
+    heatmap.add(0, 0, 5.0f);
+    heatmap.countNonZeros(copy, scale);
+
+    testEquals(heatmap.getWidth(), size);
+    testEquals(heatmap.getHeight(), size);
+    testTrue(*heatmap.getValues() == *expected.getValues());
+
+    // the range is the same
+    HeatMap normalized(expected);
+    normalized.normalize();
+    heatmap.normalize();
+    testTrue(*heatmap.getValues() == *normalized.getValues());
+  }
+}
+
+
+/**
+* @brief Check that progressively denser samples of the rows of a matrix give
+* the counts of their rows, scaled by the stride.
+*
+* @param mat The matrix in full storage.
+* @param size The width and height of the heat map.
+*/
+void testSample(
+    CSRMatrix const & mat,
+    dim_type const size)
+{
+  float const scale = static_cast<float>(size) / mat.getNumRows();
+
+  for (int half = 0; half < 2; ++half) {
+    CSRMatrix copy(mat);
+    if (half) {
+      copy.convertToHalfStorage();
+    }
+
+    HeatMap::sample_struct sample{};
+    // the last stride does not divide the one before, so starts over
+    for (dim_type const stride : {64U, 16U, 4U, 1U, 3U}) {
+      std::vector<value_type> expected(size*size, 0);
+      for (dim_type row = 0; row < mat.getNumRows(); row += stride) {
+        dim_type const y = static_cast<dim_type>(row * scale);
+        for (index_type idx = mat.getOffsets()[row]; \
+            idx < mat.getOffsets()[row+1]; ++idx) {
+          dim_type const col = mat.getColumns()[idx];
+          dim_type const x = static_cast<dim_type>(col * scale);
+          if (!half) {
+            expected[(y*size) + x] += stride;
+          } else if (col <= row) {
+            // the lower triangle is mirrored
+            expected[(y*size) + x] += stride;
+            if (col != row) {
+              expected[(x*size) + y] += stride;
+            }
+          }
+        }
+      }
+
+      HeatMap heatmap(size, size);
+      heatmap.countNonZeros(copy, scale, stride, &sample);
+      testTrue(*heatmap.getValues() == expected);
+    }
+  }
+}
+
+
+/**
+* @brief Check that counting a heat map a band of pixel rows at a time gives
+* the same counts as counting it at once.
+*
+* @param mat The matrix in full storage.
+* @param size The width and height of the heat map.
+* @param bandHeight The number of pixel rows of each band.
+*/
+void testBand(
+    CSRMatrix const & mat,
+    dim_type const size,
+    dim_type const bandHeight)
+{
+  float const scale = static_cast<float>(size) / mat.getNumRows();
+
+  for (int half = 0; half < 2; ++half) {
+    CSRMatrix copy(mat);
+    if (half) {
+      copy.convertToHalfStorage();
+    }
+
+    HeatMap whole(size, size);
+    whole.countNonZeros(copy, scale);
+    std::vector<value_type> const & expected = *whole.getValues();
+
+    for (dim_type first = 0; first < size; first += bandHeight) {
+      dim_type const height = std::min(bandHeight, size - first);
+      HeatMap band(size, height);
+      band.countBand(copy, scale, first);
+      std::vector<value_type> const & values = *band.getValues();
+      testTrue(std::equal(values.begin(), values.end(), \
+          expected.begin() + (first * size)));
+    }
+  }
+}
+
+
+/**
+* @brief Check that pooling a heat map gives the total or largest of the
+* values above the default in each block of pixels.
+*
+* @param width The width of the heat map.
+* @param height The height of the heat map.
+*/
+void testPool(
+    dim_type const width,
+    dim_type const height)
+{
+  value_type const def = 2.0f;
+  Random rng(width * height);
+  HeatMap heatmap(width, height, def);
+  for (dim_type i = 0; i < width * height / 3; ++i) {
+    heatmap.add(rng.inRange<dim_type>(0, width-1), \
+        rng.inRange<dim_type>(0, height-1), \
+        static_cast<value_type>(rng.inRange<dim_type>(1, 9)));
+  }
+  std::vector<value_type> const & values = *heatmap.getValues();
+
+  dim_type const outWidth = std::max(width / 2, 1U);
+  dim_type const outHeight = std::max(height / 2, 1U);
+  for (int max = 0; max < 2; ++max) {
+    HeatMap const coarse = heatmap.pool(max ? HeatMap::MAX_POOL : \
+        HeatMap::SUM_POOL);
+    testEquals(coarse.getWidth(), outWidth);
+    testEquals(coarse.getHeight(), outHeight);
+
+    value_type maxValue = def;
+    for (dim_type y = 0; y < outHeight; ++y) {
+      // the last row and column take in any left over
+      dim_type const lastRow = y + 1 == outHeight ? height : (2*y) + 2;
+      for (dim_type x = 0; x < outWidth; ++x) {
+        dim_type const lastCol = x + 1 == outWidth ? width : (2*x) + 2;
+        value_type pooled = 0;
+        for (dim_type r = 2*y; r < lastRow; ++r) {
+          for (dim_type c = 2*x; c < lastCol; ++c) {
+            value_type const above = values[(r*width) + c] - def;
+            pooled = max ? std::max(pooled, above) : pooled + above;
+          }
+        }
+        value_type const expected = def + pooled;
+        testEquals((*coarse.getValues())[(y*outWidth) + x], expected);
+        maxValue = std::max(maxValue, expected);
+      }
+    }
+    testEquals(coarse.getMax(), maxValue);
+    testEquals(coarse.getMin(), def);
+  }
+}
+
+
+/**
+* @brief Check that counting a region of a matrix gives the same counts as
+* checking each of its non-zeros.
+*
+* @param mat The matrix in full storage.
+* @param firstRow The row at the top of the region.
+* @param firstCol The column at the left of the region.
+* @param shift The base two logarithm of the rows and columns per pixel.
+*/
+void testRegion(
+    CSRMatrix const & mat,
+    dim_type const firstRow,
+    dim_type const firstCol,
+    unsigned const shift)
+{
+  dim_type const width = 37;
+  dim_type const height = 23;
+
+  std::vector<value_type> expected(width*height, 0);
+  for (dim_type row = 0; row < mat.getNumRows(); ++row) {
+    for (index_type idx = mat.getOffsets()[row]; \
+        idx < mat.getOffsets()[row+1]; ++idx) {
+      dim_type const col = mat.getColumns()[idx];
+      if (row < firstRow || col < firstCol) {
+        continue;
+      }
+      dim_type const y = (row - firstRow) >> shift;
+      dim_type const x = (col - firstCol) >> shift;
+      if (y < height && x < width) {
+        ++expected[(y*width) + x];
+      }
+    }
+  }
+
+  for (int half = 0; half < 2; ++half) {
+    CSRMatrix copy(mat);
+    if (half) {
+      copy.convertToHalfStorage();
+    }
+
+    HeatMap heatmap(width, height);
+    heatmap.countNonZeros(copy, firstRow, firstCol, shift);
+    testTrue(*heatmap.getValues() == expected);
+  }
+}
+
+
+/**
+* @brief Check that the modes which use the values give the same heat maps
+* as adding each of the values, whether the matrix is mirrored or its values
+* are at a reduced precision, and whether counted at once, in bands, or by
+* region. The values are small integers, which are summed exactly.
+*
+* @param mat The matrix in full storage, whose size is a multiple of the
+* rows per pixel.
+* @param shift The base two logarithm of the rows and columns per pixel.
+*/
+void testModes(
+    CSRMatrix mat,
+    unsigned const shift)
+{
+  dim_type const n = mat.getNumRows();
+  dim_type const size = n >> shift;
+  float const scale = 1.0f / static_cast<float>(1U << shift);
+
+  // symmetric values of both signs, and a value which is left out
+  value_type * const values = mat.getValues();
+  for (dim_type row = 0; row < n; ++row) {
+    for (index_type idx = mat.getOffsets()[row]; \
+        idx < mat.getOffsets()[row+1]; ++idx) {
+      dim_type const col = mat.getColumns()[idx];
+      values[idx] = static_cast<value_type>(((row + col) * 7 + \
+          (row * col)) % 13) - 6.0f;
+    }
+  }
+  values[0] = std::numeric_limits<value_type>::quiet_NaN();
+
+  std::vector<index_type> counts(size*size, 0);
+  std::vector<double> sums(size*size, 0);
+  std::vector<double> maxes(size*size, 0);
+  std::vector<double> signedSums(size*size, 0);
+  for (dim_type row = 0; row < n; ++row) {
+    for (index_type idx = mat.getOffsets()[row]; \
+        idx < mat.getOffsets()[row+1]; ++idx) {
+      size_t const pixel = ((row >> shift) * size) + \
+          (mat.getColumns()[idx] >> shift);
+      ++counts[pixel];
+      if (!std::isnan(values[idx])) {
+        sums[pixel] += std::fabs(values[idx]);
+        maxes[pixel] = std::max<double>(maxes[pixel], std::fabs(values[idx]));
+        signedSums[pixel] += values[idx];
+      }
+    }
+  }
+
+  for (HeatMap::mode_type const mode : {HeatMap::SUM_MODE, \
+      HeatMap::MAX_MODE, HeatMap::MEAN_MODE, HeatMap::SIGNED_SUM_MODE}) {
+    std::vector<value_type> expected(size*size);
+    for (size_t i = 0; i < expected.size(); ++i) {
+      double value;
+      switch (mode) {
+        case HeatMap::SUM_MODE:
+          value = sums[i];
+          break;
+        case HeatMap::MAX_MODE:
+          value = maxes[i];
+          break;
+        case HeatMap::MEAN_MODE:
+          value = counts[i] > 0 ? sums[i] / counts[i] : 0.0;
+          break;
+        default:
+          value = signedSums[i];
+      }
+      expected[i] = static_cast<value_type>(value);
+    }
+    value_type const min = *std::min_element(expected.begin(), \
+        expected.end());
+
+    for (int half = 0; half < 2; ++half) {
+      for (ValueArray::precision_type const precision : \
+          {ValueArray::FULL_PRECISION, ValueArray::HALF_PRECISION}) {
+        CSRMatrix copy(mat);
+        if (half) {
+          copy.convertToHalfStorage();
+        }
+        copy.setValuePrecision(precision);
+
+        HeatMap heatmap(size, size);
+        heatmap.setMode(mode);
+        testEquals(heatmap.getMode(), mode);
+        heatmap.countNonZeros(copy, scale);
+        testTrue(*heatmap.getValues() == expected);
+        value_type const expectedMin = std::min(min, 0.0f);
+        testEquals(heatmap.getMin(), expectedMin);
+
+        HeatMap region(size, size);
+        region.setMode(mode);
+        region.countNonZeros(copy, 0, 0, shift);
+        testTrue(*region.getValues() == expected);
+
+        dim_type const bandHeight = 5;
+        for (dim_type first = 0; first < size; first += bandHeight) {
+          dim_type const height = std::min(bandHeight, size - first);
+          HeatMap band(size, height);
+          band.setMode(mode);
+          band.countBand(copy, scale, first);
+          std::vector<value_type> const & bandValues = *band.getValues();
+          testTrue(std::equal(bandValues.begin(), bandValues.end(), \
+              expected.begin() + (first * size)));
+        }
+      }
+    }
+  }
+
+  // a sample taken for counting is started over for another mode
+  HeatMap::sample_struct sample{};
+  HeatMap heatmap(size, size);
+  heatmap.countNonZeros(mat, scale, 4, &sample);
+  heatmap.setMode(HeatMap::MAX_MODE);
+  heatmap.countNonZeros(mat, scale, 1, &sample);
+  std::vector<value_type> const & result = *heatmap.getValues();
+  for (size_t i = 0; i < result.size(); ++i) {
+    testEquals(result[i], static_cast<value_type>(maxes[i]));
+  }
+}
+
+
+/**
+* @brief Check that averages are pooled by their average, and signed totals
+* by their largest magnitude.
+*
+* @param width The width of the heat map.
+* @param height The height of the heat map.
+*/
+void testPoolModes(
+    dim_type const width,
+    dim_type const height)
+{
+  Random rng(width + height);
+  HeatMap mean(width, height);
+  HeatMap signedSum(width, height);
+  mean.setMode(HeatMap::MEAN_MODE);
+  signedSum.setMode(HeatMap::SIGNED_SUM_MODE);
+  for (dim_type y = 0; y < height; ++y) {
+    for (dim_type x = 0; x < width; ++x) {
+      value_type const value = static_cast<value_type>( \
+          rng.inRange<dim_type>(0, 16)) - 8.0f;
+      mean.add(x, y, std::fabs(value));
+      signedSum.add(x, y, value);
+    }
+  }
+
+  HeatMap const meanCoarse = mean.pool(HeatMap::SUM_POOL);
+  HeatMap const signedCoarse = signedSum.pool(HeatMap::MAX_POOL);
+  testEquals(meanCoarse.getMode(), HeatMap::MEAN_MODE);
+  testEquals(signedCoarse.getMode(), HeatMap::SIGNED_SUM_MODE);
+
+  dim_type const outWidth = std::max(width / 2, 1U);
+  dim_type const outHeight = std::max(height / 2, 1U);
+  for (dim_type y = 0; y < outHeight; ++y) {
+    dim_type const lastRow = y + 1 == outHeight ? height : (2*y) + 2;
+    for (dim_type x = 0; x < outWidth; ++x) {
+      dim_type const lastCol = x + 1 == outWidth ? width : (2*x) + 2;
+      value_type total = 0;
+      value_type largest = 0;
+      for (dim_type r = 2*y; r < lastRow; ++r) {
+        for (dim_type c = 2*x; c < lastCol; ++c) {
+          total += (*mean.getValues())[(r*width) + c];
+          value_type const value = (*signedSum.getValues())[(r*width) + c];
+          largest = std::fabs(value) > std::fabs(largest) ? value : largest;
+        }
+      }
+      value_type const area = static_cast<value_type>((lastRow - (2*y)) * \
+          (lastCol - (2*x)));
+      value_type const average = total / area;
+      value_type const pooledMean = \
+          (*meanCoarse.getValues())[(y*outWidth) + x];
+      value_type const pooledSigned = \
+          (*signedCoarse.getValues())[(y*outWidth) + x];
+      testEquals(pooledMean, average);
+      testEquals(std::fabs(pooledSigned), std::fabs(largest));
+    }
+  }
+}
+
+
+/**
+* @brief Check that pooling averages weighs each pixel by its number of
+* non-zeros, so that empty pixels are left out, down to a single pixel.
+*/
+void testPoolWeights()
+{
+  // one non-zero of 10 in the top left pixel, three of magnitude 5 in the
+  // bottom left, and none in the right
+  entry_map_type entries;
+  entries[std::make_pair(0U, 0U)] = 10.0f;
+  entries[std::make_pair(2U, 0U)] = 5.0f;
+  entries[std::make_pair(2U, 1U)] = 5.0f;
+  entries[std::make_pair(3U, 0U)] = -5.0f;
+  HeatMap corners(2, 2);
+  corners.setMode(HeatMap::MEAN_MODE);
+  corners.countNonZeros(buildMatrix(4, 4, entries), 0.5f);
+  HeatMap const pooled = corners.pool(HeatMap::SUM_POOL);
+  value_type const mean = pooled.getValues()->front();
+  testEquals(mean, 6.25f);
+
+  // every level of a sparse heat map averages all of the non-zeros
+  entries = randomSymmetricEntries(64, 40, 23, 7, [](Random & rng) {
+    return static_cast<value_type>(rng.inRange<int>(-9, 9));
+  });
+  double total = 0;
+  for (entry_map_type::value_type const & entry : entries) {
+    total += std::fabs(entry.second);
+  }
+  double const expected = total / entries.size();
+
+  HeatMap level(8, 8);
+  level.setMode(HeatMap::MEAN_MODE);
+  level.countNonZeros(buildMatrix(64, 64, entries), 0.125f);
+  testTrue(std::count(level.getValues()->begin(), \
+      level.getValues()->end(), 0.0f) > 0);
+  while (level.getWidth() > 1) {
+    level = level.pool(HeatMap::SUM_POOL);
+  }
+  value_type const overall = level.getValues()->front();
+  testLessThan(std::fabs(overall - expected), 1e-4 * expected);
+}
+
+
+/**
+* @brief Check that pooling counts keeps them exact past where a float can
+* count, and only rounds them once they are made values.
+*/
+void testPoolCounts()
+{
+  // a single row, whose counts are scaled by a stride past 2^24, into pixels
+  // of two, one, one, and one non-zeros
+  index_type const stride = (1 << 24) + 1;
+  entry_map_type entries;
+  for (dim_type const col : {0U, 1U, 2U, 4U, 6U}) {
+    entries[std::make_pair(0U, col)] = 1.0f;
+  }
+  HeatMap level(4, 1);
+  HeatMap::sample_struct sample{};
+  level.countNonZeros(buildMatrix(1, 8, entries), 0.5f, \
+      static_cast<dim_type>(stride), &sample);
+
+  level = level.pool(HeatMap::SUM_POOL);
+  testEquals((*level.getValues())[0], static_cast<value_type>(3*stride));
+  testEquals((*level.getValues())[1], static_cast<value_type>(2*stride));
+
+  // summing the rounded counts would give 5 * 2^24 instead
+  level = level.pool(HeatMap::SUM_POOL);
+  value_type const total = level.getValues()->front();
+  testEquals(total, static_cast<value_type>(5*stride));
+  testEquals(level.getMax(), total);
+}
+
+
+}
+
+
+TEST
+{
+  // more rows than pixels, so bands must not split a pixel row
+  testCounts(randomSymmetricMatrix(30000, 100000, 11, 3), 97);
+
+  // more pixels than rows
+  testCounts(randomSymmetricMatrix(50, 200, 11, 3), 128);
+
+  // samples with more rows than pixels, and the reverse
+  testSample(randomSymmetricMatrix(30000, 100000, 11, 3), 97);
+  testSample(randomSymmetricMatrix(50, 200, 11, 3), 128);
+
+  // bands of many rows each, split between threads, and of single rows
+  testBand(randomSymmetricMatrix(30000, 100000, 11, 3), 97, 10);
+  testBand(randomSymmetricMatrix(50, 200, 11, 3), 128, 1);
+
+  // pooling odd and even sizes, down to a single pixel, and rows wide enough
+  // to be pooled eight pixels at a time
+  testPool(37, 23);
+  testPool(64, 64);
+  testPool(1, 5);
+  testPool(16, 1);
+  testPool(1, 1);
+  testPool(2000, 777);
+
+  // the modes which use the values, with pixels of several rows and of one
+  testModes(randomSymmetricMatrix(3072, 400000, 11, 3), 5);
+  testModes(randomSymmetricMatrix(64, 300, 11, 3), 0);
+
+  // pooling averages and signed totals, eight pixels at a time and not
+  testPoolModes(2000, 777);
+  testPoolModes(37, 23);
+  testPoolModes(1, 1);
+  testPoolWeights();
+  testPoolCounts();
+
+  // regions of single entries, of blocks, and past the end of the matrix,
+  // which is large enough for a region to be split between threads
+  {
+    CSRMatrix const mat = randomSymmetricMatrix(3000, 400000, 11, 3);
+    testRegion(mat, 0, 0, 0);
+    testRegion(mat, 1234, 17, 0);
+    testRegion(mat, 40, 2000, 3);
+    testRegion(mat, 2900, 2950, 2);
+    testRegion(mat, 0, 0, 7);
+  }
+
+  // a cancelled count leaves the values as they were
+  {
+    CSRMatrix const mat = randomSymmetricMatrix(3000, 400000, 11, 3);
+    HeatMap heatmap(30, 30, 7.0f);
+    std::atomic<bool> const cancel(true);
+    heatmap.countNonZeros(mat, 0.01f, &cancel);
+    for (value_type const value : *heatmap.getValues()) {
+      testEquals(value, 7.0f);
+    }
+    testEquals(heatmap.getMax(), 7.0f);
+  }
+
+  // an empty matrix
+  {
+    CSRMatrix mat(10, 10, 0);
+    std::fill(mat.getOffsets(), mat.getOffsets()+11, 0);
+    HeatMap heatmap(4, 4);
+    heatmap.countNonZeros(mat, 0.4f);
+    for (value_type const value : *heatmap.getValues()) {
+      testEquals(value, 0.0f);
+    }
+  }
+}
+
+
+
+}
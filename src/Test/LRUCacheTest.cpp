@@ -0,0 +1,76 @@
+/**
+ * @file LRUCacheTest.cpp
+ * @brief Unit tests for the LRUCache class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Utility/LRUCache.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+TEST
+{
+  std::vector<int> evicted;
+  {
+    LRUCache<int, int> cache(10, [&](int & value) {
+      evicted.emplace_back(value);
+    });
+
+    cache.put(1, 100, 4);
+    cache.put(2, 200, 4);
+    testEquals(cache.size(), 2);
+    testEquals(cache.getCost(), 8);
+    testTrue(cache.get(3) == nullptr);
+
+    // using the first makes the second the least recent
+    testEquals(*cache.get(1), 100);
+    cache.put(3, 300, 4);
+    testEquals(evicted.size(), 1);
+    testEquals(evicted[0], 200);
+    testTrue(cache.get(2) == nullptr);
+    testEquals(*cache.get(3), 300);
+    testEquals(cache.getCost(), 8);
+
+    // replacing an entry evicts the old value
+    cache.put(1, 101, 2);
+    testEquals(evicted.size(), 2);
+    testEquals(evicted[1], 100);
+    testEquals(*cache.get(1), 101);
+    testEquals(cache.getCost(), 6);
+
+    // an entry larger than the capacity pushes out everything else
+    cache.put(4, 400, 20);
+    testEquals(cache.size(), 1);
+    testEquals(*cache.get(4), 400);
+    testEquals(evicted.size(), 4);
+
+    cache.put(5, 500, 1);
+    testEquals(cache.size(), 1);
+    testEquals(evicted.back(), 400);
+  }
+
+  // destroying the cache evicts what is left
+  testEquals(evicted.size(), 6);
+  testEquals(evicted.back(), 500);
+}
+
+
+
+}
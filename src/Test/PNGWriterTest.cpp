@@ -0,0 +1,100 @@
+/**
+ * @file PNGWriterTest.cpp
+ * @brief Unit tests for the PNGWriter class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <png.h>
+#include "Test/UnitTest.hpp"
+#include "Utility/PNGWriter.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+TEST
+{
+  std::string const path("PNGWriterTest.png");
+  uint32_t const width = 5;
+  uint32_t const height = 3;
+
+  std::vector<uint32_t> pixels(width * height);
+  for (uint32_t i = 0; i < pixels.size(); ++i) {
+    // the fourth byte is not written
+    pixels[i] = 0xFF000000 | (i << 16) | ((i * 7) << 8) | (255 - i);
+  }
+
+  // the rows are written in bands
+  {
+    PNGWriter writer(path, width, height);
+    writer.write(pixels.data(), 2);
+    writer.write(pixels.data() + (2 * width), 1);
+
+    bool threw = false;
+    try {
+      writer.write(pixels.data(), 1);
+    } catch (std::runtime_error const &) {
+      threw = true;
+    }
+    testTrue(threw);
+  }
+
+  // read it back a row at a time, which older versions of libpng support
+  std::FILE * const file = std::fopen(path.c_str(), "rb");
+  testTrue(file != nullptr);
+  png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, \
+      nullptr, nullptr);
+  png_infop info = png_create_info_struct(png);
+  png_init_io(png, file);
+  png_read_info(png, info);
+  testEquals(png_get_image_width(png, info), width);
+  testEquals(png_get_image_height(png, info), height);
+  testEquals(png_get_color_type(png, info), PNG_COLOR_TYPE_RGB);
+
+  std::vector<unsigned char> row(width * 3);
+  for (uint32_t y = 0; y < height; ++y) {
+    png_read_row(png, row.data(), nullptr);
+    for (uint32_t x = 0; x < width; ++x) {
+      uint32_t const pixel = pixels[(y * width) + x];
+      for (uint32_t c = 0; c < 3; ++c) {
+        unsigned const expected = (pixel >> (8 * c)) & 0xFF;
+        unsigned const actual = row[(x * 3) + c];
+        testEquals(actual, expected);
+      }
+    }
+  }
+  png_destroy_read_struct(&png, &info, nullptr);
+  std::fclose(file);
+
+  std::remove(path.c_str());
+
+  // a file which cannot be created is reported
+  bool threw = false;
+  try {
+    PNGWriter writer("PNGWriterTest/missing/image.png", width, height);
+  } catch (std::runtime_error const &) {
+    threw = true;
+  }
+  testTrue(threw);
+}
+
+
+
+}
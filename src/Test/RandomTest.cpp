@@ -0,0 +1,155 @@
+/**
+ * @file RandomTest.cpp
+ * @brief Unit tests for the Random class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Utility/Random.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+TEST
+{
+  // known answers of Philox4x32-10
+  uint32_t const zeroKey[2] = {0, 0};
+  uint32_t zero[4] = {0, 0, 0, 0};
+  Random::philox(zeroKey,zero);
+  testEquals(zero[0],0x6627e8d5U);
+  testEquals(zero[1],0xe169c58dU);
+  testEquals(zero[2],0xbc57ac4cU);
+  testEquals(zero[3],0x9b00dbd8U);
+
+  uint32_t const piKey[2] = {0xa4093822, 0x299f31d0};
+  uint32_t pi[4] = {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344};
+  Random::philox(piKey,pi);
+  testEquals(pi[0],0xd16cfe09U);
+  testEquals(pi[1],0x94fdccebU);
+  testEquals(pi[2],0x5001e420U);
+  testEquals(pi[3],0x24126ea1U);
+
+  // streams are reproducible and distinct
+  Random a(7), b(7), c(7,1);
+  uint32_t const first = a.next32();
+  testEquals(first,b.next32());
+  testTrue(first != c.next32());
+
+  // ranges
+  std::vector<size_t> counts(10,0);
+  for (int i = 0; i < 100000; ++i) {
+    int const value = a.inRange(-5,4);
+    testGreaterThanOrEqual(value,-5);
+    testLessThanOrEqual(value,4);
+    ++counts[value+5];
+  }
+  for (size_t const count : counts) {
+    testGreaterThan(count,9000);
+    testLessThan(count,11000);
+  }
+  testEquals(a.inRange(3U,3U),3U);
+  a.inRange<uint64_t>(0,std::numeric_limits<uint64_t>::max());
+  for (int i = 0; i < 1000; ++i) {
+    uint64_t const wide = a.inRange<uint64_t>(1ULL << 40, (1ULL << 41) - 1);
+    testGreaterThanOrEqual(wide,1ULL << 40);
+    testLessThan(wide,1ULL << 41);
+    double const u = a.uniform();
+    testGreaterThanOrEqual(u,0.0);
+    testLessThan(u,1.0);
+  }
+
+  // permutations span several blocks, and do not depend on the number of
+  // threads
+  size_t const len = 300000;
+  std::vector<uint32_t> perm(len);
+  Random::permutation(perm.data(),len,42);
+  std::vector<bool> seen(len,false);
+  for (uint32_t const v : perm) {
+    testLessThan(v,len);
+    testTrue(!seen[v]);
+    seen[v] = true;
+  }
+  testEquals(perm[0],170251U);
+  testEquals(perm[1],146118U);
+  testEquals(perm[150000],68257U);
+  testEquals(perm[299999],208803U);
+
+  std::vector<uint32_t> other(len);
+  Random::permutation(other.data(),len,42,1);
+  testTrue(perm != other);
+
+  // sorted samples, both skipping (Algorithm D) and stepping through the
+  // remaining elements (Algorithm A)
+  std::vector<size_t> included(1000,0);
+  double minSum = 0;
+  for (int trial = 0; trial < 20000; ++trial) {
+    uint32_t subset[5];
+    a.sortedSample(subset,1000,5);
+    testLessThan(subset[4],1000U);
+    for (int i = 0; i < 5; ++i) {
+      if (i > 0) {
+        testGreaterThan(subset[i],subset[i-1]);
+      }
+      ++included[subset[i]];
+    }
+    minSum += subset[0];
+  }
+  for (size_t const count : included) {
+    testGreaterThan(count,40);
+    testLessThan(count,170);
+  }
+  // the expected minimum is (1000-5)/(5+1)
+  testLessThan(std::abs(minSum/20000 - 995.0/6.0),5.0);
+
+  std::vector<uint32_t> all(100);
+  a.sortedSample(all.data(),100,100);
+  for (uint32_t i = 0; i < 100; ++i) {
+    testEquals(all[i],i);
+  }
+
+  std::vector<uint64_t> sparse(10000);
+  a.sortedSample(sparse.data(),1ULL << 40,sparse.size());
+  for (size_t i = 1; i < sparse.size(); ++i) {
+    testGreaterThan(sparse[i],sparse[i-1]);
+  }
+  testLessThan(sparse.back(),1ULL << 40);
+
+  // each ordering of three elements is equally likely
+  std::vector<size_t> orders(9,0);
+  for (uint64_t seed = 0; seed < 60000; ++seed) {
+    uint32_t small[3];
+    Random::permutation(small,3,seed);
+    ++orders[small[0]*3+small[1]];
+  }
+  for (uint32_t x = 0; x < 3; ++x) {
+    for (uint32_t y = 0; y < 3; ++y) {
+      if (x != y) {
+        testGreaterThan(orders[x*3+y],9500);
+        testLessThan(orders[x*3+y],10500);
+      }
+    }
+  }
+}
+
+
+
+
+}
@@ -0,0 +1,178 @@
+/**
+ * @file RasterTest.cpp
+ * @brief Unit tests for the Raster class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <algorithm>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Test/TestMatrix.hpp"
+#include "Operations/Raster.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+namespace
+{
+
+
+/**
+* @brief Render a matrix, checking that the bands arrive in order and cover
+* the image.
+*
+* @param mat The matrix.
+* @param size The size of the image.
+* @param bandPixels The most pixels to count at once.
+* @param mode What each pixel shows.
+*
+* @return The pixels of the image.
+*/
+std::vector<uint32_t> render(
+    CSRMatrix const & mat,
+    Raster::size_struct const & size,
+    size_t const bandPixels,
+    HeatMap::mode_type const mode = HeatMap::COUNT_MODE)
+{
+  std::vector<uint32_t> image;
+  ColorMap const colorMap(ColorMap::VIRIDIS, ColorMap::LOG_SCALE);
+  Raster::render(mat, size, mode, colorMap, [&](dim_type const firstRow, \
+      dim_type const numRows, uint32_t const * const pixels) {
+    testEquals(image.size(), static_cast<size_t>(firstRow) * size.width);
+    image.insert(image.end(), pixels, pixels + \
+        (static_cast<size_t>(numRows) * size.width));
+  }, bandPixels);
+
+  size_t const numPixels = static_cast<size_t>(size.width) * size.height;
+  testEquals(image.size(), numPixels);
+
+  return image;
+}
+
+
+}
+
+
+TEST
+{
+  // images are fit to their longer side, but never larger than the matrix
+  {
+    Raster::size_struct const size = Raster::fitSide(3000, 1000, 100);
+    testEquals(size.height, 100);
+    testEquals(size.width, 34);
+
+    Raster::size_struct const small = Raster::fitSide(30, 50, 100);
+    testEquals(small.height, 30);
+    testEquals(small.width, 50);
+    testEquals(small.scale, 1.0f);
+  }
+
+  // an image drawn in bands is the same as one drawn at once, whether the
+  // matrix is mirrored or not
+  {
+    CSRMatrix mat = randomSymmetricMatrix(20000, 60000, 5, 2);
+    Raster::size_struct const size = Raster::fitSide(mat.getNumRows(), \
+        mat.getNumColumns(), 301);
+    testEquals(size.width, 301);
+    testEquals(size.height, 301);
+
+    std::vector<uint32_t> const whole = render(mat, size, 1 << 22);
+    testTrue(render(mat, size, size.width * 16) == whole);
+    testTrue(render(mat, size, 1) == whole);
+
+    // the image is not all one color
+    testTrue(std::count(whole.begin(), whole.end(), whole.front()) < \
+        static_cast<std::ptrdiff_t>(whole.size()));
+
+    mat.convertToHalfStorage();
+    testTrue(render(mat, size, 1 << 22) == whole);
+    testTrue(render(mat, size, size.width * 16) == whole);
+  }
+
+  // signed totals are drawn in diverging colors, centered on zero, in bands
+  // the same as at once
+  {
+    CSRMatrix mat = randomSymmetricMatrix(5000, 20000, 5, 2);
+    value_type * const values = mat.getValues();
+    for (dim_type row = 0; row < mat.getNumRows(); ++row) {
+      for (index_type idx = mat.getOffsets()[row]; \
+          idx < mat.getOffsets()[row+1]; ++idx) {
+        values[idx] = row % 2 == 0 ? -1.0f : 1.0f;
+      }
+    }
+    Raster::size_struct const size = Raster::fitSide(mat.getNumRows(), \
+        mat.getNumColumns(), 5000);
+
+    std::vector<uint32_t> const whole = render(mat, size, 1 << 26, \
+        HeatMap::SIGNED_SUM_MODE);
+    testTrue(render(mat, size, size.width * 7, HeatMap::SIGNED_SUM_MODE) == \
+        whole);
+
+    ColorMap const diverging(ColorMap::DIVERGING);
+    uint32_t const white = diverging.getColor(0.5f);
+    uint32_t const blue = diverging.getColor(0.0f);
+    uint32_t const red = diverging.getColor(1.0f);
+    testTrue(std::count(whole.begin(), whole.end(), white) > 0);
+    testTrue(std::count(whole.begin(), whole.end(), blue) > 0);
+    testTrue(std::count(whole.begin(), whole.end(), red) > 0);
+    testEquals(whole[0], blue);
+
+    ColorMap const chosen = Raster::getColorMap(ColorMap(), \
+        HeatMap::SIGNED_SUM_MODE);
+    testEquals(chosen.getType(), ColorMap::DIVERGING);
+    ColorMap const kept = Raster::getColorMap(ColorMap(ColorMap::VIRIDIS), \
+        HeatMap::SUM_MODE);
+    testEquals(kept.getType(), ColorMap::VIRIDIS);
+  }
+
+  // the largest value of a tile grows with its pixels for totals, but not
+  // for the largest or average magnitudes, and counts are bounded by the
+  // entries of a pixel
+  {
+    testEquals(Raster::getRegionMax(2.0f, 0.5f, 1), 2.0f);
+    testEquals(Raster::getRegionMax(2.0f, 0.5f, 0), 1.0f);
+    testEquals(Raster::getRegionMax(2.0f, 0.25f, 2, HeatMap::SUM_MODE), \
+        2.0f);
+    testEquals(Raster::getRegionMax(2.0f, 0.25f, 0, HeatMap::SUM_MODE), \
+        0.125f);
+    testEquals(Raster::getRegionMax(3.0f, 0.25f, 0, HeatMap::MAX_MODE), \
+        3.0f);
+    testEquals(Raster::getRegionMax(3.0f, 0.25f, 4, HeatMap::MEAN_MODE), \
+        3.0f);
+  }
+
+  // a mip chain goes down to a single pixel, and each level is colored
+  {
+    std::vector<HeatMap> levels(1, HeatMap(37, 23));
+    levels.front().add(3, 4, 2.0f);
+    Raster::buildLevels(&levels, HeatMap::MAX_POOL);
+    testEquals(levels.size(), 6);
+    testEquals(levels.back().getWidth(), 1);
+    testEquals(levels.back().getHeight(), 1);
+
+    std::vector<std::vector<uint32_t>> const pixels = \
+        Raster::colorLevels(levels, ColorMap());
+    testEquals(pixels.size(), levels.size());
+    for (size_t level = 0; level < levels.size(); ++level) {
+      testEquals(pixels[level].size(), levels[level].getValues()->size());
+    }
+  }
+}
+
+
+
+}
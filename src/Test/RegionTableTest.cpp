@@ -0,0 +1,194 @@
+/**
+ * @file RegionTableTest.cpp
+ * @brief Unit tests for the RegionTable class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Test/TestMatrix.hpp"
+#include "Data/RegionTable.hpp"
+#include "Data/CSRMatrix.hpp"
+#include "Utility/Random.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+namespace
+{
+
+
+/**
+* @brief Build a random symmetric matrix of small integer values, so that
+* their totals are exact, with an infinite value which is counted but not
+* added.
+*
+* @param n The number of rows and columns.
+* @param numEdges The number of off-diagonal pairs.
+*
+* @return The matrix.
+*/
+CSRMatrix makeMatrix(
+    dim_type const n,
+    index_type const numEdges)
+{
+  entry_map_type entries = randomSymmetricEntries(n, numEdges, 13, 3, \
+      [](Random & rng) {
+        return static_cast<value_type>(rng.inRange<int>(-3, 3));
+      });
+  value_type const inf = std::numeric_limits<value_type>::infinity();
+  entries[std::make_pair(n-1, 0U)] = inf;
+  entries[std::make_pair(0U, n-1)] = inf;
+
+  return buildMatrix(n, n, entries);
+}
+
+
+/**
+* @brief Get the non-zeros of a region of a matrix one entry at a time.
+*
+* @param mat The matrix in full storage.
+* @param rowStart The first row.
+* @param colStart The first column.
+* @param rowEnd The end of the rows.
+* @param colEnd The end of the columns.
+*
+* @return The non-zeros.
+*/
+RegionTable::region_struct countRegion(
+    CSRMatrix const & mat,
+    dim_type const rowStart,
+    dim_type const colStart,
+    dim_type const rowEnd,
+    dim_type const colEnd)
+{
+  RegionTable::region_struct region{0, 0.0};
+  for (dim_type row = rowStart; row < std::min(rowEnd, mat.getNumRows()); \
+      ++row) {
+    for (index_type idx = mat.getOffsets()[row]; \
+        idx < mat.getOffsets()[row+1]; ++idx) {
+      dim_type const col = mat.getColumns()[idx];
+      if (col >= colStart && col < colEnd) {
+        value_type const value = mat.getValues()[idx];
+        ++region.count;
+        if (value != std::numeric_limits<value_type>::infinity()) {
+          region.sum += value;
+        }
+      }
+    }
+  }
+
+  return region;
+}
+
+
+/**
+* @brief Check that the regions of a table of a matrix, in full and half
+* storage, match those counted one entry at a time.
+*
+* @param mat The matrix in full storage.
+* @param size The width and height of the heat map.
+*/
+void testRegions(
+    CSRMatrix const & mat,
+    dim_type const size)
+{
+  dim_type const n = mat.getNumRows();
+  float const scale = static_cast<float>(size) / n;
+  RegionTable::region_struct const total = countRegion(mat, 0, 0, n, n);
+
+  for (int half = 0; half < 2; ++half) {
+    CSRMatrix copy(mat);
+    if (half) {
+      copy.convertToHalfStorage();
+    }
+
+    RegionTable table;
+    testTrue(table.build(copy, scale, size, size));
+    testEquals(table.getWidth(), size);
+    testEquals(table.getHeight(), size);
+
+    // the whole heat map, and blocks past its end
+    RegionTable::region_struct const all = table.queryPixels(0, 0, size, \
+        size);
+    testEquals(all.count, total.count);
+    testEquals(all.sum, total.sum);
+    RegionTable::region_struct const past = table.queryPixels(size, 0, \
+        size+5, size);
+    testEquals(past.count, 0);
+
+    // the whole matrix, single entries, and random regions
+    Random rng(17);
+    for (int i = 0; i < 64; ++i) {
+      dim_type const rowStart = rng.inRange<dim_type>(0, n-1);
+      dim_type const colStart = rng.inRange<dim_type>(0, n-1);
+      dim_type rowEnd = rng.inRange<dim_type>(rowStart, n+3);
+      dim_type colEnd = rng.inRange<dim_type>(colStart, n+3);
+      if (i == 0) {
+        rowEnd = n;
+        colEnd = n;
+      } else if (i < 4) {
+        rowEnd = rowStart + 1;
+        colEnd = colStart + 1;
+      }
+
+      RegionTable::region_struct const expected = countRegion(mat, \
+          rowStart, colStart, rowEnd, colEnd);
+      RegionTable::region_struct const region = table.query(copy, rowStart, \
+          colStart, rowEnd, colEnd);
+      testEquals(region.count, expected.count);
+      testEquals(region.sum, expected.sum);
+    }
+  }
+}
+
+
+}
+
+
+TEST
+{
+  // more rows than pixels, large enough for the edges of a region to be
+  // split between threads, and more pixels than rows
+  testRegions(makeMatrix(20000, 100000), 97);
+  testRegions(makeMatrix(50, 200), 128);
+
+  // a heat map large enough for the tables to be summed by several threads
+  testRegions(makeMatrix(3000, 50000), 600);
+
+  // an empty table, and a cancelled one
+  {
+    RegionTable table;
+    RegionTable::region_struct const region = table.queryPixels(0, 0, 5, 5);
+    testEquals(region.count, 0);
+    testEquals(region.sum, 0.0);
+
+    CSRMatrix const mat = makeMatrix(3000, 50000);
+    std::atomic<bool> const cancel(true);
+    testTrue(!table.build(mat, 0.01f, 30, 30, &cancel));
+    testEquals(table.getWidth(), 0);
+    testEquals(table.getHeight(), 0);
+  }
+}
+
+
+
+}
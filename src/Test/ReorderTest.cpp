@@ -9,9 +9,13 @@
 
 
 
+#include <cstdint>
+#include <algorithm>
+#include <vector>
 #include "Test/UnitTest.hpp"
 #include "Operations/Reorder.hpp"
 #include "Data/CSRMatrix.hpp"
+#include "Utility/FeistelPermutation.hpp"
 
 
 
@@ -25,6 +29,82 @@ namespace Test
 {
 
 
+namespace
+{
+
+/**
+ * @brief Fill a matrix with a pseudo-random pattern, large enough for the
+ * reorder to be split between threads.
+ *
+ * @param mat The matrix to fill.
+ * @param seed The pattern to fill it with.
+ * @param lower Whether to only fill the lower triangle.
+ */
+void fill(
+    CSRMatrix & mat,
+    uint64_t seed,
+    bool const lower)
+{
+  index_type * const offsets = mat.getOffsets();
+  dim_type * const columns = mat.getColumns();
+  value_type * const values = mat.getValues();
+  index_type const nnz = mat.getNumNonZeros();
+  dim_type const numRows = mat.getNumRows();
+  dim_type const numCols = mat.getNumColumns();
+
+  // one entry per (row, column) step along the diagonal band
+  offsets[0] = 0;
+  for (dim_type row = 0; row < numRows; ++row) {
+    offsets[row+1] = (nnz * (row+1)) / numRows;
+    dim_type const width = static_cast<dim_type>(offsets[row+1] - \
+        offsets[row]);
+    dim_type const limit = lower ? row+1 : numCols;
+    std::vector<dim_type> cols;
+    while (cols.size() < std::min(width, limit)) {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      dim_type const col = static_cast<dim_type>((seed >> 33) % limit);
+      if (std::find(cols.begin(), cols.end(), col) == cols.end()) {
+        cols.push_back(col);
+      }
+    }
+    std::sort(cols.begin(), cols.end());
+    offsets[row+1] = offsets[row] + cols.size();
+    for (size_t i = 0; i < cols.size(); ++i) {
+      columns[offsets[row]+i] = cols[i];
+      values[offsets[row]+i] = static_cast<value_type>(cols[i] + row*1000);
+    }
+  }
+}
+
+
+void testSame(
+    CSRMatrix & a,
+    CSRMatrix & b)
+{
+  testEquals(a.getNumStoredNonZeros(),b.getNumStoredNonZeros());
+  for (dim_type row = 0; row <= a.getNumRows(); ++row) {
+    testEquals(a.getOffsets()[row],b.getOffsets()[row]);
+  }
+  for (index_type idx = 0; idx < a.getNumStoredNonZeros(); ++idx) {
+    testEquals(a.getColumns()[idx],b.getColumns()[idx]);
+    testEquals(a.getValues()[idx],b.getValues()[idx]);
+  }
+}
+
+
+std::vector<dim_type> toArray(
+    FeistelPermutation const & perm)
+{
+  std::vector<dim_type> array(perm.size());
+  for (size_t i = 0; i < array.size(); ++i) {
+    array[i] = static_cast<dim_type>(perm(i));
+  }
+  return array;
+}
+
+}
+
+
 TEST
 {
   CSRMatrix mat(5,4,6);
@@ -78,6 +158,54 @@ TEST
   testEquals(values[3],3.0);
   testEquals(values[4],4.0);
   testEquals(values[5],5.0);
+
+  // permutations computed on demand match the same permutations as arrays
+  dim_type const numRows = 3000;
+  dim_type const numCols = 2000;
+  index_type const nnz = 60000;
+  FeistelPermutation const rowPerm(numRows, 11);
+  FeistelPermutation const colPerm(numCols, 11, 1);
+  std::vector<dim_type> const rowArray = toArray(rowPerm);
+  std::vector<dim_type> const colArray = toArray(colPerm);
+
+  CSRMatrix implicit(numRows,numCols,nnz);
+  CSRMatrix explicitly(numRows,numCols,nnz);
+  fill(implicit,1,false);
+  fill(explicitly,1,false);
+  implicit.reorder(&rowPerm,&colPerm,nullptr,1.0);
+  explicitly.reorder(rowArray.data(),colArray.data(),nullptr,1.0);
+  testSame(implicit,explicitly);
+
+  implicit.reorder(nullptr,&colPerm,nullptr,1.0);
+  explicitly.reorder(nullptr,colArray.data(),nullptr,1.0);
+  testSame(implicit,explicitly);
+
+  implicit.reorder(&rowPerm,nullptr,nullptr,1.0);
+  explicitly.reorder(rowArray.data(),nullptr,nullptr,1.0);
+  testSame(implicit,explicitly);
+
+  // and in half storage
+  FeistelPermutation const squarePerm(numRows, 12);
+  std::vector<dim_type> const squareArray = toArray(squarePerm);
+  CSRMatrix implicitHalf(numRows,numRows,nnz);
+  CSRMatrix explicitHalf(numRows,numRows,nnz);
+  fill(implicitHalf,2,true);
+  fill(explicitHalf,2,true);
+  implicitHalf.convertToHalfStorage();
+  explicitHalf.convertToHalfStorage();
+  implicitHalf.reorder(&squarePerm,&squarePerm,nullptr,1.0);
+  explicitHalf.reorder(squareArray.data(),squareArray.data(),nullptr,1.0);
+  testTrue(implicitHalf.isHalfStorage());
+  testSame(implicitHalf,explicitHalf);
+
+  // random orderings are reproducible from the seed
+  CSRMatrix first(numRows,numCols,nnz);
+  CSRMatrix second(numRows,numCols,nnz);
+  fill(first,3,false);
+  fill(second,3,false);
+  Reorder::random(&first,true,true,5);
+  Reorder::random(&second,true,true,5);
+  testSame(first,second);
 }
 
 
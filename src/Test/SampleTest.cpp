@@ -0,0 +1,317 @@
+/**
+ * @file SampleTest.cpp
+ * @brief Unit tests for the Sample class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Test/TestMatrix.hpp"
+#include "Operations/Sample.hpp"
+#include "Data/CSRMatrix.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+namespace
+{
+
+
+/**
+* @brief Build a symmetric graph of a ring with a chord from each vertex,
+* large enough for the reduce to be split between threads. Each vertex has a
+* self loop whose value is the vertex, so that it can be traced back after
+* sampling, and the other non-zeros are all -1.
+*
+* @param numVertices The number of vertices.
+*
+* @return The graph.
+*/
+CSRMatrix makeGraph(
+    dim_type const numVertices)
+{
+  entry_map_type edges;
+  for (dim_type v = 0; v < numVertices; ++v) {
+    dim_type const next = (v + 1) % numVertices;
+    dim_type const chord = static_cast<dim_type>( \
+        (static_cast<uint64_t>(v) * 7919) % numVertices);
+    edges[std::make_pair(v, next)] = -1.0f;
+    edges[std::make_pair(next, v)] = -1.0f;
+    edges[std::make_pair(v, chord)] = -1.0f;
+    edges[std::make_pair(chord, v)] = -1.0f;
+  }
+  for (dim_type v = 0; v < numVertices; ++v) {
+    edges[std::make_pair(v, v)] = static_cast<value_type>(v);
+  }
+
+  return buildMatrix(numVertices, numVertices, edges);
+}
+
+
+/**
+* @brief Check that a sample is the subgraph of a graph induced by some set of
+* its vertices, and find them.
+*
+* @param sample The sample.
+* @param graph The graph in full storage.
+*
+* @return The vertex of each row of the sample.
+*/
+std::vector<dim_type> traceVertices(
+    CSRMatrix const & sample,
+    CSRMatrix const & graph)
+{
+  dim_type const numRows = sample.getNumRows();
+  testEquals(sample.getNumColumns(), numRows);
+
+  CSRMatrix full(sample);
+  if (full.isHalfStorage()) {
+    full.expandToFullStorage();
+  }
+  index_type const * const offsets = full.getOffsets();
+  dim_type const * const columns = full.getColumns();
+  value_type const * const values = full.getValues();
+
+  // find the vertices by their self loops, which keep their order
+  std::vector<dim_type> vertices(numRows, NULL_DIM);
+  std::vector<dim_type> sampled(graph.getNumRows(), NULL_DIM);
+  for (dim_type row = 0; row < numRows; ++row) {
+    for (index_type idx = offsets[row]; idx < offsets[row+1]; ++idx) {
+      if (columns[idx] == row) {
+        vertices[row] = static_cast<dim_type>(values[idx]);
+      }
+    }
+    testTrue(vertices[row] != NULL_DIM);
+    testTrue(row == 0 || vertices[row] > vertices[row-1]);
+    sampled[vertices[row]] = row;
+  }
+
+  // every edge between the vertices is kept, and no others
+  index_type numEdges = 0;
+  for (dim_type const v : vertices) {
+    for (index_type idx = graph.getOffsets()[v]; \
+        idx < graph.getOffsets()[v+1]; ++idx) {
+      if (sampled[graph.getColumns()[idx]] != NULL_DIM) {
+        ++numEdges;
+      }
+    }
+  }
+  testEquals(full.getNumNonZeros(), numEdges);
+
+  for (dim_type row = 0; row < numRows; ++row) {
+    dim_type const v = vertices[row];
+    dim_type const * const start = graph.getColumns() + graph.getOffsets()[v];
+    dim_type const * const end = graph.getColumns() + graph.getOffsets()[v+1];
+    for (index_type idx = offsets[row]; idx < offsets[row+1]; ++idx) {
+      testTrue(std::binary_search(start, end, vertices[columns[idx]]));
+    }
+  }
+
+  return vertices;
+}
+
+
+/**
+* @brief Check a sample of a graph in both full and half storage.
+*
+* @param graph The graph.
+* @param numVertices The number of vertices the sample should have.
+* @param func The function taking the sample.
+*/
+template<typename F>
+void testSample(
+    CSRMatrix const & graph,
+    dim_type const numVertices,
+    F func)
+{
+  for (int half = 0; half < 2; ++half) {
+    CSRMatrix sample(graph);
+    if (half) {
+      sample.convertToHalfStorage();
+    }
+
+    double progress = 0;
+    func(&sample, &progress);
+    testTrue(progress > 0.99 && progress < 1.01);
+
+    testEquals(sample.getNumRows(), numVertices);
+    testEquals(sample.isHalfStorage(), static_cast<bool>(half));
+    testTrue(sample.isSymmetric());
+    traceVertices(sample, graph);
+
+    // the counted degrees include the mirrored entries
+    if (half) {
+      CSRMatrix full(sample);
+      full.expandToFullStorage();
+      std::vector<dim_type> const & degrees = sample.getRowDegrees();
+      for (dim_type row = 0; row < numVertices; ++row) {
+        testEquals(degrees[row], full.getOffsets()[row+1] - \
+            full.getOffsets()[row]);
+      }
+    }
+  }
+}
+
+
+}
+
+
+TEST
+{
+  dim_type const n = 20000;
+  CSRMatrix const graph = makeGraph(n);
+
+  // reduce to a non-principal submatrix
+  {
+    std::vector<dim_type> rows;
+    std::vector<dim_type> cols;
+    for (dim_type v = 0; v < n; v += 2) {
+      rows.emplace_back(v);
+    }
+    for (dim_type v = 0; v < n; v += 3) {
+      cols.emplace_back(v);
+    }
+
+    CSRMatrix sample(graph);
+    sample.reduce(rows.data(), rows.size(), cols.data(), cols.size(), \
+        nullptr, 1.0);
+    testEquals(sample.getNumRows(), rows.size());
+    testEquals(sample.getNumColumns(), cols.size());
+
+    index_type nnz = 0;
+    std::vector<dim_type> colDegrees(cols.size(), 0);
+    for (dim_type row = 0; row < rows.size(); ++row) {
+      dim_type const v = rows[row];
+      for (index_type idx = graph.getOffsets()[v]; \
+          idx < graph.getOffsets()[v+1]; ++idx) {
+        dim_type const u = graph.getColumns()[idx];
+        if (u % 3 == 0) {
+          testEquals(sample.getColumns()[nnz], u / 3);
+          testEquals(sample.getValues()[nnz], graph.getValues()[idx]);
+          ++colDegrees[u / 3];
+          ++nnz;
+        }
+      }
+      testEquals(sample.getOffsets()[row+1], nnz);
+    }
+    testEquals(sample.getNumNonZeros(), nnz);
+    testTrue(sample.getColumnDegrees() == colDegrees);
+  }
+
+  // one hop around two vertices of the ring
+  {
+    std::vector<dim_type> const seeds{0, 1};
+    CSRMatrix sample(graph);
+    sample.convertToHalfStorage();
+    Sample::neighborhood(&sample, seeds.data(), seeds.size(), 1);
+
+    // each seed reaches its ring neighbors and chords (in both directions)
+    std::set<dim_type> expected;
+    for (dim_type const seed : seeds) {
+      for (index_type idx = graph.getOffsets()[seed]; \
+          idx < graph.getOffsets()[seed+1]; ++idx) {
+        expected.emplace(graph.getColumns()[idx]);
+      }
+    }
+    testEquals(sample.getNumRows(), expected.size());
+    testTrue(sample.isHalfStorage());
+    std::vector<dim_type> const vertices = traceVertices(sample, graph);
+    testTrue(std::equal(vertices.begin(), vertices.end(), expected.begin()));
+
+    // zero hops gives only the seeds
+    testSample(graph, 2, [&](CSRMatrix * const mat, double * const progress) {
+      Sample::neighborhood(mat, seeds.data(), seeds.size(), 0, progress);
+    });
+
+    testSample(graph, expected.size(), \
+        [&](CSRMatrix * const mat, double * const progress) {
+      Sample::neighborhood(mat, seeds.data(), seeds.size(), 1, progress);
+    });
+
+    std::vector<dim_type> const bad{n};
+    CSRMatrix copy(graph);
+    bool thrown = false;
+    try {
+      Sample::neighborhood(&copy, bad.data(), bad.size(), 1);
+    } catch (std::runtime_error const &) {
+      thrown = true;
+    }
+    testTrue(thrown);
+  }
+
+  // weighted samples only take rows and columns with positive weights
+  {
+    std::vector<value_type> weights(n, 0);
+    for (dim_type v = 0; v < n; v += 10) {
+      weights[v] = static_cast<value_type>(v % 3 + 1);
+    }
+    testSample(graph, n / 10, \
+        [&](CSRMatrix * const mat, double * const progress) {
+      Sample::weighted(mat, n / 10, n / 10, weights.data(), nullptr, true, \
+          13, progress);
+    });
+
+    CSRMatrix sample(graph);
+    Sample::weighted(&sample, n / 10, n / 10, weights.data(), nullptr, true, \
+        13);
+    std::vector<dim_type> const vertices = traceVertices(sample, graph);
+    for (dim_type row = 0; row < vertices.size(); ++row) {
+      testEquals(vertices[row], row * 10);
+    }
+
+    // by the number of non-zeros, with different rows and columns
+    CSRMatrix rect(graph);
+    rect.convertToHalfStorage();
+    Sample::weighted(&rect, n / 2, n / 4, nullptr, nullptr, false, 17);
+    testEquals(rect.getNumRows(), n / 2);
+    testEquals(rect.getNumColumns(), n / 4);
+    testTrue(!rect.isHalfStorage());
+  }
+
+  // the random samplers take as many vertices as they are asked to
+  for (dim_type const size : {1U, 100U, 10000U, n}) {
+    testSample(graph, size, \
+        [&](CSRMatrix * const mat, double * const progress) {
+      Sample::randomWalk(mat, size, 0.15, 3, progress);
+    });
+
+    testSample(graph, size, \
+        [&](CSRMatrix * const mat, double * const progress) {
+      Sample::forestFire(mat, size, 0.7, 5, progress);
+    });
+  }
+
+  // a random walk which never restarts follows the ring and chords, so the
+  // sample is connected, and each vertex has a neighbor in it
+  {
+    CSRMatrix sample(graph);
+    Sample::randomWalk(&sample, 50, 0.0, 7);
+    traceVertices(sample, graph);
+    for (dim_type row = 0; row < sample.getNumRows(); ++row) {
+      testGreaterThan(sample.getOffsets()[row+1] - sample.getOffsets()[row], \
+          1);
+    }
+  }
+}
+
+
+
+}
@@ -9,6 +9,9 @@
 
 
 
+#include <cstdint>
+#include <algorithm>
+#include <limits>
 #include <vector>
 #include "Test/UnitTest.hpp"
 #include "Utility/Sort.hpp"
@@ -25,6 +28,51 @@ namespace Test
 {
 
 
+namespace
+{
+
+/**
+ * @brief Check a sort against std::stable_sort of the same keys.
+ *
+ * @tparam K The key type.
+ * @param keys The keys.
+ * @param ascending Whether to sort in ascending order.
+ */
+template<typename K>
+void checkSort(
+    std::vector<K> const & keys,
+    bool const ascending)
+{
+  std::vector<uint32_t> values(keys.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<uint32_t>(i);
+  }
+  std::vector<uint32_t> expected(values);
+
+  Sort::keyValue(keys.data(),values.data(),keys.size(),ascending);
+
+  std::stable_sort(expected.begin(),expected.end(), \
+      [&](uint32_t const a, uint32_t const b) {
+        return ascending ? keys[a] < keys[b] : keys[b] < keys[a];
+      });
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    testEquals(values[i],expected[i]);
+  }
+}
+
+
+template<typename K>
+void checkBothOrders(
+    std::vector<K> const & keys)
+{
+  checkSort(keys,true);
+  checkSort(keys,false);
+}
+
+}
+
+
 TEST
 {
   std::vector<int> keys{1,2,0,2,1};
@@ -46,6 +94,57 @@ TEST
   testEquals(valuesDes[2],0);
   testEquals(valuesDes[3],4);
   testEquals(valuesDes[4],2);
+
+  // large enough to be split between threads, with many duplicates
+  size_t const len = 100000;
+  uint64_t state = 1;
+  std::vector<uint64_t> random(len);
+  for (uint64_t & r : random) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    r = state;
+  }
+
+  std::vector<uint32_t> u32(len);
+  std::vector<int32_t> i32(len);
+  std::vector<uint64_t> u64(len);
+  std::vector<int64_t> i64(len);
+  std::vector<float> f32(len);
+  std::vector<double> f64(len);
+  for (size_t i = 0; i < len; ++i) {
+    u32[i] = static_cast<uint32_t>(random[i] >> 48);
+    i32[i] = static_cast<int32_t>(random[i] >> 32);
+    u64[i] = random[i] >> (i % 64);
+    i64[i] = static_cast<int64_t>(random[i]) >> 20;
+    f32[i] = static_cast<float>(static_cast<int32_t>(random[i] >> 40)) / 7.0f;
+    f64[i] = static_cast<double>(static_cast<int64_t>(random[i])) * 1.0e-300;
+  }
+  // negative zero sorts with zero
+  f32[0] = -0.0f;
+  f32[1] = 0.0f;
+  f32[2] = std::numeric_limits<float>::infinity();
+  f32[3] = -std::numeric_limits<float>::infinity();
+  f64[0] = -0.0;
+  f64[1] = std::numeric_limits<double>::denorm_min();
+  f64[2] = -std::numeric_limits<double>::denorm_min();
+  i32[0] = std::numeric_limits<int32_t>::min();
+  i32[1] = std::numeric_limits<int32_t>::max();
+
+  checkBothOrders(u32);
+  checkBothOrders(i32);
+  checkBothOrders(u64);
+  checkBothOrders(i64);
+  checkBothOrders(f32);
+  checkBothOrders(f64);
+
+  // keys which are all equal leave the values in place
+  checkBothOrders(std::vector<int>(len,7));
+
+  // keys which only differ in their high bits
+  std::vector<uint32_t> high(len);
+  for (size_t i = 0; i < len; ++i) {
+    high[i] = static_cast<uint32_t>(random[i] >> 62) << 30;
+  }
+  checkBothOrders(high);
 }
 
 
@@ -9,9 +9,17 @@
 
 
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <set>
+#include <utility>
+#include <vector>
 #include "Test/UnitTest.hpp"
+#include "Test/TestMatrix.hpp"
 #include "Operations/Stats.hpp"
 #include "Data/CSRMatrix.hpp"
+#include "Utility/Random.hpp"
 
 
 
@@ -69,6 +77,268 @@ TEST
   testEquals(colCounts[1],2);
   testEquals(colCounts[2],1);
   testEquals(colCounts[3],1);
+
+  // check the fused stats
+  Stats::matrix_stats_struct const stats = Stats::compute(&mat);
+  testEquals(stats.rows.min,0);
+  testEquals(stats.rows.max,2);
+  testEquals(stats.rows.mean,1.2);
+  testLessThanOrEqual(std::abs(stats.rows.variance-0.56),1e-12);
+  testEquals(stats.rows.numEmpty,1);
+  dim_type const rowPercentiles[] = {0, 1, 1, 2, 2, 2};
+  for (int p = 0; p < Matrix::NUM_PERCENTILES; ++p) {
+    testEquals(stats.rows.percentiles[p],rowPercentiles[p]);
+  }
+  testEquals(stats.columns.min,1);
+  testEquals(stats.columns.max,2);
+  testEquals(stats.columns.mean,1.5);
+  testEquals(stats.columns.numEmpty,0);
+  testEquals(stats.diagonal.numNonZeros,0);
+  testEquals(stats.diagonal.numZeros,4);
+  testEquals(stats.diagonal.bandwidth,3);
+  testTrue(!stats.structurallySymmetric);
+  testEquals(stats.values.numValues,6);
+  testEquals(stats.values.min,1.0f);
+  testEquals(stats.values.max,6.0f);
+  testEquals(stats.values.sum,21.0);
+  testEquals(stats.values.absSum,21.0);
+  testEquals(stats.values.numZeros,0);
+  testEquals(stats.values.numNegative,0);
+  testEquals(stats.values.magnitudes[-Matrix::MIN_MAGNITUDE],1);
+  testEquals(stats.values.magnitudes[1-Matrix::MIN_MAGNITUDE],2);
+  testEquals(stats.values.magnitudes[2-Matrix::MIN_MAGNITUDE],3);
+
+  // check structural symmetry
+  CSRMatrix square(3,3,4);
+  square.getOffsets()[0] = 0;
+  square.getOffsets()[1] = 1;
+  square.getOffsets()[2] = 3;
+  square.getOffsets()[3] = 4;
+  square.getColumns()[0] = 1;
+  square.getColumns()[1] = 0;
+  square.getColumns()[2] = 2;
+  square.getColumns()[3] = 1;
+  for (index_type i = 0; i < 4; ++i) {
+    square.getValues()[i] = 1.0;
+  }
+  testTrue(Stats::compute(&square).structurallySymmetric);
+  square.getColumns()[3] = 2;
+  Stats::matrix_stats_struct const squareStats = Stats::compute(&square);
+  testTrue(!squareStats.structurallySymmetric);
+  testEquals(squareStats.diagonal.numNonZeros,1);
+  testEquals(squareStats.diagonal.numZeros,2);
+
+  // a cancelled computation leaves the stats unset
+  {
+    CSRMatrix copy(mat);
+    std::atomic<bool> const cancel(true);
+    copy.computeStats(nullptr, 1.0, &cancel);
+    testTrue(!copy.isStatsSet());
+    testTrue(!copy.isRowDegreesSet());
+    testTrue(!copy.isValueStatsSet());
+    testTrue(!copy.isSymmetrySet());
+  }
+
+  // check cached stats
+  mat.computeStats();
+  testTrue(mat.isStatsSet());
+  testEquals(mat.getMaxRowSize(),2);
+  testEquals(mat.getNumEmptyRows(),1);
+  testEquals(mat.getMaxColumnSize(),2);
+  testEquals(mat.getNumEmptyColumns(),0);
+
+  // a permutation keeps the stats
+  dim_type const rowPerm[] = {4, 3, 2, 1, 0};
+  mat.reorder(rowPerm, nullptr, nullptr, 1.0);
+  testTrue(mat.isRowStatsSet());
+  testTrue(mat.isColumnStatsSet());
+  testTrue(mat.isSymmetrySet());
+  testEquals(mat.getNumEmptyRows(),1);
+
+  // a transpose swaps them
+  mat.computeStats();
+  mat.transpose();
+  testTrue(mat.isStatsSet());
+  testEquals(mat.getNumEmptyRows(),0);
+  testEquals(mat.getNumEmptyColumns(),1);
+
+  // a reduction derives the degree stats from the degrees it counts
+  dim_type const rows[] = {1, 3};
+  mat.reduce(rows, 2, nullptr, 0, nullptr, 1.0);
+  testTrue(mat.isRowStatsSet());
+  testTrue(mat.isColumnStatsSet());
+  testEquals(mat.getMaxRowSize(),2);
+  testEquals(mat.getNumEmptyRows(),0);
+  testEquals(mat.getMaxColumnSize(),1);
+  testEquals(mat.getNumEmptyColumns(),2);
+
+  mat.computeStats();
+  testEquals(mat.getMaxColumnSize(),1);
+  testEquals(mat.getNumEmptyColumns(),2);
+
+  // the degree cache follows edits rather than being recounted
+  CSRMatrix cached(5,4,6);
+  index_type const cachedOffsets[] = {0, 1, 3, 3, 5, 6};
+  dim_type const cachedColumns[] = {1, 0, 3, 0, 1, 2};
+  std::copy(cachedOffsets, cachedOffsets+6, cached.getOffsets());
+  std::copy(cachedColumns, cachedColumns+6, cached.getColumns());
+  std::fill(cached.getValues(), cached.getValues()+6, 1.0f);
+  testTrue(!cached.isRowDegreesSet());
+  testEquals(cached.getRowDegrees()[1],2);
+  testTrue(cached.isRowDegreesSet());
+  testTrue(cached.isColumnDegreesSet());
+
+  auto const checkDegrees = [&cached]() {
+    std::vector<dim_type> counts(cached.getNumRows());
+    Stats::countRowNonZeros(&cached,counts.data());
+    testTrue(cached.isRowDegreesSet());
+    testTrue(counts == cached.getRowDegrees());
+    counts.resize(cached.getNumColumns());
+    Stats::countColumnNonZeros(&cached,counts.data());
+    testTrue(cached.isColumnDegreesSet());
+    testTrue(counts == cached.getColumnDegrees());
+  };
+
+  dim_type const colPerm[] = {2, 0, 3, 1};
+  cached.reorder(rowPerm, colPerm, nullptr, 1.0);
+  checkDegrees();
+
+  cached.transpose();
+  checkDegrees();
+
+  dim_type const keepRows[] = {0, 2, 3};
+  dim_type const keepCols[] = {1, 3, 4};
+  cached.reduce(keepRows, 3, keepCols, 3, nullptr, 1.0);
+  checkDegrees();
+
+  // including the mirrored entries of half storage
+  square.getColumns()[3] = 1;
+  square.convertToHalfStorage();
+  testEquals(square.getRowDegrees()[1],2);
+  dim_type const squarePerm[] = {1, 2, 0};
+  square.reorder(squarePerm, squarePerm, nullptr, 1.0);
+  testTrue(square.isHalfStorage());
+  testEquals(square.getRowDegrees()[0],2);
+  testEquals(square.getColumnDegrees()[0],2);
+  dim_type const principal[] = {0, 1};
+  square.reduce(principal, 2, principal, 2, nullptr, 1.0);
+  testTrue(square.isHalfStorage());
+  testEquals(square.getRowDegrees()[0],1);
+  testEquals(square.getRowDegrees()[1],1);
+  testEquals(square.getColumnDegrees()[1],1);
+
+  // estimates from a sample
+  dim_type const n = 2000;
+  Random rng(17);
+  std::set<std::pair<dim_type, dim_type>> positions;
+  for (int k = 0; k < 6000; ++k) {
+    // skew the rows, so some are empty
+    dim_type const row = static_cast<dim_type>(n * std::pow(rng.uniform(), 2));
+    dim_type const col = static_cast<dim_type>(n * rng.uniform());
+    positions.emplace(row, col);
+    if (rng.uniform() < 0.4) {
+      positions.emplace(col, row);
+    }
+    if (rng.uniform() < 0.3) {
+      positions.emplace(row, row);
+    }
+  }
+
+  CSRMatrix sampled(n, n, positions.size());
+  std::fill(sampled.getOffsets(), sampled.getOffsets()+n+1, 0);
+  index_type idx = 0;
+  index_type numOffDiagonal = 0;
+  index_type numMirrored = 0;
+  for (std::pair<dim_type, dim_type> const & position : positions) {
+    ++sampled.getOffsets()[position.first+1];
+    sampled.getColumns()[idx] = position.second;
+    sampled.getValues()[idx] = 1.0f;
+    ++idx;
+    if (position.first != position.second) {
+      ++numOffDiagonal;
+      if (positions.count({position.second, position.first}) > 0) {
+        ++numMirrored;
+      }
+    }
+  }
+  for (dim_type row = 0; row < n; ++row) {
+    sampled.getOffsets()[row+1] += sampled.getOffsets()[row];
+  }
+
+  Stats::matrix_stats_struct const exact = Stats::compute(&sampled);
+  double const exactFraction = static_cast<double>(numMirrored) / \
+      numOffDiagonal;
+
+  // a sample of everything is exact
+  Stats::estimate_stats_struct const full = Stats::estimate(&sampled, \
+      static_cast<dim_type>(positions.size()), 3);
+  testTrue(full.rowsEstimated);
+  testEquals(full.numSampledRows, n);
+  for (int p = 0; p < Matrix::NUM_PERCENTILES; ++p) {
+    testEquals(full.rowPercentiles[p].estimate, exact.rows.percentiles[p]);
+    testEquals(full.rowPercentiles[p].low, exact.rows.percentiles[p]);
+    testEquals(full.rowPercentiles[p].high, exact.rows.percentiles[p]);
+  }
+  testEquals(full.numEmptyRows.estimate, exact.rows.numEmpty);
+  testEquals(full.numEmptyRows.low, full.numEmptyRows.high);
+  testEquals(full.numDiagonal.estimate, exact.diagonal.numNonZeros);
+  testEquals(full.numDiagonal.low, full.numDiagonal.high);
+  testEquals(full.meanRowSize.estimate, exact.rows.mean);
+  testLessThanOrEqual(std::abs(full.symmetricFraction.estimate - \
+      exactFraction), 1e-12);
+  testEquals(full.symmetricFraction.low, full.symmetricFraction.high);
+
+  // a smaller sample brackets the exact values
+  Stats::estimate_stats_struct const part = Stats::estimate(&sampled, 400, \
+      3);
+  testEquals(part.numSampledRows, 400);
+  testLessThanOrEqual(part.numSampledNonZeros, 400);
+  auto const testBrackets = [](Stats::interval_struct const & interval, \
+      double const value) {
+    testLessThanOrEqual(interval.low, interval.estimate);
+    testLessThanOrEqual(interval.estimate, interval.high);
+    testLessThanOrEqual(interval.low, value);
+    testLessThanOrEqual(value, interval.high);
+  };
+  testBrackets(part.rowPercentiles[Matrix::NUM_PERCENTILES/2], \
+      exact.rows.percentiles[Matrix::NUM_PERCENTILES/2]);
+  testBrackets(part.numEmptyRows, exact.rows.numEmpty);
+  testBrackets(part.numDiagonal, exact.diagonal.numNonZeros);
+  testBrackets(part.symmetricFraction, exactFraction);
+  testTrue(part.numDiagonal.low < part.numDiagonal.high);
+
+  // half storage is symmetric, and its mean row size follows the diagonal
+  Stats::estimate_stats_struct const halfEstimate = Stats::estimate(&square, \
+      10, 3);
+  testTrue(halfEstimate.rowsEstimated);
+  testEquals(halfEstimate.symmetricFraction.estimate, 1.0);
+  testEquals(halfEstimate.meanRowSize.estimate, 1.0);
+  testEquals(halfEstimate.rowPercentiles[0].estimate, 1.0);
+
+  // the rows of half storage include their mirrored entries, so sampling
+  // every row is exact
+  CSRMatrix symmetric = Test::randomSymmetricMatrix(n, 1500, 23, 3);
+  Stats::matrix_stats_struct const symmetricExact = \
+      Stats::compute(&symmetric);
+  testTrue(symmetricExact.rows.numEmpty > 0);
+  symmetric.convertToHalfStorage();
+  Stats::estimate_stats_struct const halfFull = Stats::estimate(&symmetric, \
+      n, 5);
+  testTrue(halfFull.rowsEstimated);
+  for (int p = 0; p < Matrix::NUM_PERCENTILES; ++p) {
+    testEquals(halfFull.rowPercentiles[p].estimate, \
+        symmetricExact.rows.percentiles[p]);
+    testEquals(halfFull.rowPercentiles[p].low, \
+        halfFull.rowPercentiles[p].high);
+  }
+  testEquals(halfFull.numEmptyRows.estimate, symmetricExact.rows.numEmpty);
+  testEquals(halfFull.numEmptyRows.low, halfFull.numEmptyRows.high);
+
+  Stats::estimate_stats_struct const halfPart = Stats::estimate(&symmetric, \
+      400, 5);
+  testBrackets(halfPart.rowPercentiles[Matrix::NUM_PERCENTILES/2], \
+      symmetricExact.rows.percentiles[Matrix::NUM_PERCENTILES/2]);
+  testBrackets(halfPart.numEmptyRows, symmetricExact.rows.numEmpty);
 }
 
 
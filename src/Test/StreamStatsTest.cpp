@@ -0,0 +1,217 @@
+/**
+ * @file StreamStatsTest.cpp
+ * @brief Unit tests for the StreamStats class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Data/DataStorage.hpp"
+#include "Operations/StreamStats.hpp"
+#include "Utility/Random.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+namespace
+{
+
+
+void testDegrees(
+    Matrix::degree_stats_struct const & a,
+    Matrix::degree_stats_struct const & b)
+{
+  testEquals(a.min, b.min);
+  testEquals(a.max, b.max);
+  testEquals(a.mean, b.mean);
+  testEquals(a.numEmpty, b.numEmpty);
+  for (int p = 0; p < Matrix::NUM_PERCENTILES; ++p) {
+    testEquals(a.percentiles[p], b.percentiles[p]);
+  }
+}
+
+
+/**
+* @brief Check that streaming a file gives the same statistics as loading it.
+*/
+StreamStats::stream_stats_struct testFile(
+    std::string const & path,
+    HeatMap * const heatmap,
+    dim_type const maxHeatMapSize)
+{
+  double progress = 0;
+  StreamStats::stream_stats_struct const stream = StreamStats::compute( \
+      path.c_str(), heatmap, maxHeatMapSize, &progress);
+  testTrue(progress > 0.99 && progress < 1.01);
+
+  DataStorage storage;
+  storage.loadDataset(path.c_str(), DataStorage::load_options_struct{ \
+      DataStorage::LOAD_THRESHOLD_ROWS, 0, 0, false, 0, 0, NULL_DIM}, \
+      nullptr);
+  Matrix const * const mat = storage.getMatrix();
+  Stats::matrix_stats_struct const stats = Stats::compute(mat);
+
+  testEquals(stream.numRows, mat->getNumRows());
+  testEquals(stream.numCols, mat->getNumColumns());
+
+  testDegrees(stream.stats.rows, stats.rows);
+  testDegrees(stream.stats.columns, stats.columns);
+
+  testEquals(stream.stats.diagonal.numNonZeros, stats.diagonal.numNonZeros);
+  testEquals(stream.stats.diagonal.numZeros, stats.diagonal.numZeros);
+  testEquals(stream.stats.diagonal.bandwidth, stats.diagonal.bandwidth);
+
+  // half storage holds fewer non-zeros than the matrix has
+  testEquals(stream.numNonZeros, stats.values.numValues);
+  testEquals(stream.stats.values.numValues, stats.values.numValues);
+  testEquals(stream.stats.values.min, stats.values.min);
+  testEquals(stream.stats.values.max, stats.values.max);
+  testEquals(stream.stats.values.sum, stats.values.sum);
+  testEquals(stream.stats.values.numZeros, stats.values.numZeros);
+  testEquals(stream.stats.values.numNegative, stats.values.numNegative);
+  for (int bin = 0; bin < Matrix::NUM_MAGNITUDE_BINS; ++bin) {
+    testEquals(stream.stats.values.magnitudes[bin], \
+        stats.values.magnitudes[bin]);
+  }
+
+  testEquals(stream.stats.structurallySymmetric, stats.structurallySymmetric);
+
+  if (heatmap != nullptr) {
+    double sum = 0;
+    for (value_type const count : *heatmap->getValues()) {
+      sum += count;
+    }
+    testEquals(sum, static_cast<double>(stream.numNonZeros));
+  }
+
+  std::remove(path.c_str());
+
+  return stream;
+}
+
+
+}
+
+
+TEST
+{
+  // a general matrix, with explicit zeros and only some entries mirrored
+  {
+    std::string const path("StreamStatsTest_general.mtx");
+    dim_type const n = 30;
+    Random rng(5);
+    std::vector<std::vector<char>> present(n, std::vector<char>(n, 0));
+    std::vector<std::string> lines;
+    for (dim_type col = 0; col < n; ++col) {
+      for (dim_type row = 0; row < n; ++row) {
+        if (rng.uniform() < 0.2) {
+          present[row][col] = 1;
+          int const value = (row + col) % 7 == 0 ? 0 : \
+              static_cast<int>(row) - static_cast<int>(col);
+          lines.push_back(std::to_string(row+1) + " " + \
+              std::to_string(col+1) + " " + std::to_string(value));
+        }
+      }
+    }
+
+    index_type numOffDiagonal = 0;
+    index_type numMirrored = 0;
+    for (dim_type row = 0; row < n; ++row) {
+      for (dim_type col = 0; col < n; ++col) {
+        if (row != col && present[row][col]) {
+          ++numOffDiagonal;
+          if (present[col][row]) {
+            ++numMirrored;
+          }
+        }
+      }
+    }
+
+    std::ofstream file(path);
+    file << "%%MatrixMarket matrix coordinate integer general" << std::endl;
+    file << n << " " << n << " " << lines.size() << std::endl;
+    for (std::string const & line : lines) {
+      file << line << std::endl;
+    }
+    file.close();
+
+    HeatMap heatmap;
+    StreamStats::stream_stats_struct const stream = testFile(path, &heatmap, \
+        8);
+    testEquals(heatmap.getWidth(), 8);
+    testEquals(heatmap.getHeight(), 8);
+    testTrue(!stream.declaredSymmetric);
+    testTrue(!stream.stats.structurallySymmetric);
+
+    // the sketch holds every position of a small matrix, so is exact
+    testEquals(stream.symmetricFraction, \
+        static_cast<double>(numMirrored) / numOffDiagonal);
+  }
+
+  // a symmetric matrix, which implies the upper triangle
+  {
+    std::string const path("StreamStatsTest_symmetric.mtx");
+    std::ofstream file(path);
+    file << "%%MatrixMarket matrix coordinate real symmetric" << std::endl;
+    file << "4 4 5" << std::endl;
+    file << "1 1 2.0" << std::endl;
+    file << "3 1 -1.5" << std::endl;
+    file << "4 2 0.25" << std::endl;
+    file << "3 3 0" << std::endl;
+    file << "4 3 8.0" << std::endl;
+    file.close();
+
+    StreamStats::stream_stats_struct const stream = testFile(path, nullptr, \
+        0);
+    testEquals(stream.numNonZeros, 8);
+    testTrue(stream.declaredSymmetric);
+    testTrue(stream.stats.structurallySymmetric);
+    testEquals(stream.symmetricFraction, 1.0);
+  }
+
+  // an edge list declares no dimensions, so the heat map has to shrink
+  {
+    std::string const path("StreamStatsTest.snap");
+    std::ofstream file(path);
+    file << "# Undirected graph" << std::endl;
+    file << "0\t1" << std::endl;
+    file << "1\t0" << std::endl;
+    file << "2\t3" << std::endl;
+    file << "19\t4" << std::endl;
+    file << "4\t19" << std::endl;
+    file << "7\t7" << std::endl;
+    file.close();
+
+    HeatMap heatmap;
+    StreamStats::stream_stats_struct const stream = testFile(path, &heatmap, \
+        4);
+    testEquals(stream.numRows, 20);
+    testEquals(stream.numCols, 20);
+    // blocks of 8 cover the 20 rows and columns
+    testEquals(heatmap.getWidth(), 3);
+    testEquals(heatmap.getHeight(), 3);
+    testTrue(!stream.stats.structurallySymmetric);
+    testEquals(stream.symmetricFraction, 4.0 / 5.0);
+  }
+}
+
+
+
+}
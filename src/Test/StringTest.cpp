@@ -32,6 +32,10 @@ TEST
   std::string str = String::addThousandsSeparators(x);
 
   testStringEquals(str,"9,000,000");
+
+  testTrue(String::endsWith("stats.json",".json"));
+  testTrue(!String::endsWith("stats.csv",".json"));
+  testTrue(!String::endsWith("json","stats.json"));
 }
 
 
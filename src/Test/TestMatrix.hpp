@@ -0,0 +1,149 @@
+/**
+ * @file TestMatrix.hpp
+ * @brief Matrices shared by the unit tests.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef TEST_TESTMATRIX_HPP
+#define TEST_TESTMATRIX_HPP
+
+
+
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include "Data/CSRMatrix.hpp"
+#include "Utility/Random.hpp"
+
+
+
+
+namespace Test
+{
+
+
+/**
+* @brief The non-zeros of a matrix, by row and then column.
+*/
+typedef std::map<std::pair<MatrixInspector::dim_type, \
+    MatrixInspector::dim_type>, MatrixInspector::value_type> entry_map_type;
+
+
+/**
+* @brief Build a matrix in full storage from its non-zeros, and determine
+* whether it is symmetric.
+*
+* @param numRows The number of rows.
+* @param numCols The number of columns.
+* @param entries The non-zeros.
+*
+* @return The matrix.
+*/
+inline MatrixInspector::CSRMatrix buildMatrix(
+    MatrixInspector::dim_type const numRows,
+    MatrixInspector::dim_type const numCols,
+    entry_map_type const & entries)
+{
+  using namespace MatrixInspector;
+
+  CSRMatrix mat(numRows, numCols, entries.size());
+  index_type * const offsets = mat.getOffsets();
+  dim_type * const columns = mat.getColumns();
+  value_type * const values = mat.getValues();
+
+  std::fill(offsets, offsets+numRows+1, 0);
+  index_type idx = 0;
+  for (entry_map_type::value_type const & entry : entries) {
+    offsets[entry.first.first+1] = idx+1;
+    columns[idx] = entry.first.second;
+    values[idx] = entry.second;
+    ++idx;
+  }
+  // carry the ends over empty rows
+  for (dim_type row = 0; row < numRows; ++row) {
+    offsets[row+1] = std::max(offsets[row+1], offsets[row]);
+  }
+
+  mat.computeSymmetry();
+
+  return mat;
+}
+
+
+/**
+* @brief Generate the non-zeros of a random symmetric matrix: every so many
+* entries of the diagonal, and pairs of mirrored entries at random positions.
+* Values are drawn from the same generator as the positions, after them.
+*
+* @tparam F The type of function drawing a value.
+* @param n The number of rows and columns.
+* @param numEdges The number of off-diagonal pairs.
+* @param seed The seed of the positions and values.
+* @param diagonalStride The distance between the entries of the diagonal.
+* @param getValue The function which, given the generator, draws a value.
+*
+* @return The non-zeros.
+*/
+template<typename F>
+entry_map_type randomSymmetricEntries(
+    MatrixInspector::dim_type const n,
+    MatrixInspector::index_type const numEdges,
+    uint64_t const seed,
+    MatrixInspector::dim_type const diagonalStride,
+    F getValue)
+{
+  using namespace MatrixInspector;
+
+  Random rng(seed);
+  entry_map_type entries;
+  for (dim_type v = 0; v < n; v += diagonalStride) {
+    entries[std::make_pair(v, v)] = getValue(rng);
+  }
+  for (index_type e = 0; e < numEdges; ++e) {
+    dim_type const u = rng.inRange<dim_type>(0, n-1);
+    dim_type const v = rng.inRange<dim_type>(0, n-1);
+    value_type const value = getValue(rng);
+    entries[std::make_pair(u, v)] = value;
+    entries[std::make_pair(v, u)] = value;
+  }
+
+  return entries;
+}
+
+
+/**
+* @brief Build a random symmetric matrix of ones in full storage.
+*
+* @param n The number of rows and columns.
+* @param numEdges The number of off-diagonal pairs.
+* @param seed The seed of the positions.
+* @param diagonalStride The distance between the entries of the diagonal.
+*
+* @return The matrix.
+*/
+inline MatrixInspector::CSRMatrix randomSymmetricMatrix(
+    MatrixInspector::dim_type const n,
+    MatrixInspector::index_type const numEdges,
+    uint64_t const seed,
+    MatrixInspector::dim_type const diagonalStride)
+{
+  return buildMatrix(n, n, randomSymmetricEntries(n, numEdges, seed, \
+      diagonalStride, [](MatrixInspector::Random &) {
+        return 1.0f;
+      }));
+}
+
+
+}
+
+
+
+
+#endif
@@ -0,0 +1,160 @@
+/**
+* @file ValueArrayTest.cpp
+* @brief Unit tests for the ValueArray class.
+* @author Dominique LaSalle <dominique@solidlake.com>
+* Copyright 2018
+* @version 1
+*/
+
+
+
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Data/ValueArray.hpp"
+#include "Data/CSRMatrix.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+TEST
+{
+  // half precision conversions
+  testEquals(ValueArray::floatToHalf(1.0f), 0x3C00);
+  testEquals(ValueArray::floatToHalf(-2.0f), 0xC000);
+  testEquals(ValueArray::floatToHalf(65504.0f), 0x7BFF);
+  testEquals(ValueArray::floatToHalf(1.0e6f), 0x7C00);
+  testEquals(ValueArray::floatToHalf(std::ldexp(1.0f,-24)), 0x0001);
+  // ties round to even
+  testEquals(ValueArray::floatToHalf(1.0f + std::ldexp(1.0f,-11)), 0x3C00);
+  testEquals(ValueArray::floatToHalf(1.0f + 3.0f*std::ldexp(1.0f,-11)), \
+      0x3C02);
+  testEquals(ValueArray::halfToFloat(0x3555), 0.333251953125f);
+  testEquals(ValueArray::halfToFloat(0x0001), std::ldexp(1.0f,-24));
+  testTrue(std::isinf(ValueArray::halfToFloat(0xFC00)));
+  testTrue(std::isnan(ValueArray::halfToFloat( \
+      ValueArray::floatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+
+  // bfloat16 conversions
+  testEquals(ValueArray::bfloat16ToFloat(ValueArray::floatToBFloat16(3.0f)), \
+      3.0f);
+  testEquals(ValueArray::floatToBFloat16(1.0f + std::ldexp(1.0f,-8)), 0x3F80);
+  testEquals(ValueArray::floatToBFloat16(1.0f + 3.0f*std::ldexp(1.0f,-8)), \
+      0x3F82);
+
+  // logarithmic quantization
+  testEquals(ValueArray::log8ToFloat(ValueArray::floatToLog8(0.0f)), 0.0f);
+  testEquals(ValueArray::log8ToFloat(ValueArray::floatToLog8(4.0f)), 4.0f);
+  testEquals(ValueArray::log8ToFloat(ValueArray::floatToLog8(-0.5f)), -0.5f);
+  testEquals(ValueArray::log8ToFloat(ValueArray::floatToLog8(1.0e30f)), \
+      std::pow(2.0f,31.5f));
+
+  // bulk conversions through each precision
+  std::vector<value_type> input(19);
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<value_type>(i) - 9.0f;
+  }
+
+  ValueArray::precision_type const precisions[] = {
+    ValueArray::HALF_PRECISION,
+    ValueArray::BFLOAT16_PRECISION,
+    ValueArray::LOG8_PRECISION
+  };
+  for (ValueArray::precision_type const precision : precisions) {
+    ValueArray values(input.size());
+    values.encode(0, input.size(), input.data());
+    values.setPrecision(precision);
+    testEquals(values.size(), input.size());
+
+    std::vector<value_type> output(input.size());
+    values.decode(0, input.size(), output.data());
+    for (size_t i = 0; i < input.size(); ++i) {
+      testEquals(output[i], values.get(i));
+      if (precision == ValueArray::LOG8_PRECISION) {
+        testLessThanOrEqual(std::abs(output[i] - input[i]), \
+            std::abs(input[i])*0.2f);
+      } else {
+        // small integers are exact
+        testEquals(output[i], input[i]);
+      }
+    }
+  }
+
+  // matrix operations keep working at reduced precision
+  CSRMatrix mat(2,2,3);
+  mat.getOffsets()[0] = 0;
+  mat.getOffsets()[1] = 2;
+  mat.getOffsets()[2] = 3;
+  mat.getColumns()[0] = 0;
+  mat.getColumns()[1] = 1;
+  mat.getColumns()[2] = 1;
+  mat.getValues()[0] = 1.0f;
+  mat.getValues()[1] = 2.0f;
+  mat.getValues()[2] = 3.0f;
+
+  mat.setValuePrecision(ValueArray::HALF_PRECISION);
+  mat.transpose();
+
+  ValueArray const & values = mat.getValueArray();
+  testEquals(values.getPrecision(), ValueArray::HALF_PRECISION);
+  testEquals(values.get(0), 1.0f);
+  testEquals(values.get(1), 2.0f);
+  testEquals(values.get(2), 3.0f);
+  testEquals(mat.getColumns()[1], 0);
+
+  // rounding keeps a matrix in half storage symmetric, so reordering it
+  // keeps it in half storage
+  CSRMatrix sym(2,2,4);
+  sym.getOffsets()[0] = 0;
+  sym.getOffsets()[1] = 2;
+  sym.getOffsets()[2] = 4;
+  sym.getColumns()[0] = 0;
+  sym.getColumns()[1] = 1;
+  sym.getColumns()[2] = 0;
+  sym.getColumns()[3] = 1;
+  sym.getValues()[0] = 1.0f;
+  sym.getValues()[1] = 2.0f;
+  sym.getValues()[2] = 2.0f;
+  sym.getValues()[3] = 3.0f;
+  sym.computeSymmetry();
+  sym.convertToHalfStorage();
+
+  sym.setValuePrecision(ValueArray::LOG8_PRECISION);
+  testTrue(sym.isSymmetrySet());
+  testTrue(sym.isSymmetric());
+  dim_type const swap[] = {1, 0};
+  sym.reorder(swap, swap, nullptr, 1.0);
+  testTrue(sym.isHalfStorage());
+
+  // mirrored values which only differ before rounding leave the structure
+  // symmetric
+  CSRMatrix near(2,2,2);
+  near.getOffsets()[0] = 0;
+  near.getOffsets()[1] = 1;
+  near.getOffsets()[2] = 2;
+  near.getColumns()[0] = 1;
+  near.getColumns()[1] = 0;
+  near.getValues()[0] = 2.0f;
+  near.getValues()[1] = 2.0001f;
+  near.computeSymmetry();
+  testTrue(!near.isSymmetric());
+  near.setValuePrecision(ValueArray::HALF_PRECISION);
+  testTrue(!near.isSymmetrySet());
+  testTrue(near.isStructurallySymmetric());
+}
+
+
+
+
+}
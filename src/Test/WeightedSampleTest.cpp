@@ -0,0 +1,121 @@
+/**
+ * @file WeightedSampleTest.cpp
+ * @brief Unit tests for the WeightedSample class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Utility/WeightedSample.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+namespace
+{
+
+
+/**
+* @brief Check how often each index is in samples of two, against the
+* probabilities of drawing them one at a time without replacement.
+*
+* @param weights The weights.
+*/
+void testInclusion(
+    std::vector<double> const & weights)
+{
+  double sum = 0;
+  for (double const weight : weights) {
+    sum += weight;
+  }
+
+  int const numTrials = 20000;
+  std::vector<int> counts(weights.size(), 0);
+  std::vector<uint32_t> sample(2);
+  for (int trial = 0; trial < numTrials; ++trial) {
+    WeightedSample::sortedSample(weights.data(), weights.size(), \
+        sample.data(), sample.size(), trial);
+    testLessThan(sample[0], sample[1]);
+    ++counts[sample[0]];
+    ++counts[sample[1]];
+  }
+
+  for (size_t i = 0; i < weights.size(); ++i) {
+    double expected = weights[i] / sum;
+    for (size_t j = 0; j < weights.size(); ++j) {
+      if (j != i) {
+        expected += (weights[j] / sum) * (weights[i] / (sum - weights[j]));
+      }
+    }
+    double const actual = static_cast<double>(counts[i]) / numTrials;
+    testGreaterThan(actual, expected - 0.015);
+    testLessThan(actual, expected + 0.015);
+  }
+}
+
+
+}
+
+
+TEST
+{
+  // a heavy sample is selected by keys
+  testInclusion({1, 2, 3, 4});
+
+  // and a light one by rejection
+  std::vector<double> light(60, 1.0);
+  light[30] = 10.0;
+  testInclusion(light);
+
+  // large samples are reproducible, and never take zero weights
+  {
+    std::vector<float> weights(100000);
+    for (size_t i = 0; i < weights.size(); ++i) {
+      weights[i] = static_cast<float>(i % 7);
+    }
+    for (size_t const size : {100, 30000, 85714}) {
+      std::vector<uint32_t> a(size);
+      std::vector<uint32_t> b(size);
+      WeightedSample::sortedSample(weights.data(), weights.size(), a.data(), \
+          size, 11);
+      WeightedSample::sortedSample(weights.data(), weights.size(), b.data(), \
+          size, 11);
+      testTrue(a == b);
+      for (size_t i = 0; i < size; ++i) {
+        testTrue(weights[a[i]] > 0);
+        testTrue(i == 0 || a[i] > a[i-1]);
+      }
+    }
+
+    // there are not enough positive weights
+    bool thrown = false;
+    try {
+      std::vector<uint32_t> sample(85715);
+      WeightedSample::sortedSample(weights.data(), weights.size(), \
+          sample.data(), sample.size(), 11);
+    } catch (std::runtime_error const &) {
+      thrown = true;
+    }
+    testTrue(thrown);
+  }
+}
+
+
+
+}
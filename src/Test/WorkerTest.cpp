@@ -0,0 +1,94 @@
+/**
+ * @file WorkerTest.cpp
+ * @brief Unit tests for the Worker class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "Test/UnitTest.hpp"
+#include "Utility/Worker.hpp"
+
+
+
+
+using namespace MatrixInspector;
+
+
+
+
+namespace Test
+{
+
+
+TEST
+{
+  std::vector<int> order;
+  std::atomic<bool> release(false);
+  std::atomic<bool> started(false);
+  {
+    Worker worker;
+
+    // jobs run in order, past one which throws
+    for (int i = 0; i < 10; ++i) {
+      worker.post([&order, i]() {
+        if (i == 5) {
+          throw std::runtime_error("failed job");
+        }
+        order.emplace_back(i);
+      });
+    }
+    worker.wait();
+    testEquals(order.size(), 9);
+    for (int i = 0; i < 9; ++i) {
+      int const expected = i < 5 ? i : i + 1;
+      testEquals(order[i], expected);
+    }
+
+    // jobs which have not started are dropped, while the running one
+    // finishes
+    worker.post([&]() {
+      started = true;
+      while (!release) {
+        std::this_thread::yield();
+      }
+      order.emplace_back(100);
+    });
+    while (!started) {
+      std::this_thread::yield();
+    }
+    worker.post([&order]() {
+      order.emplace_back(200);
+    });
+    worker.clear();
+    release = true;
+    worker.wait();
+    testEquals(order.size(), 10);
+    testEquals(order.back(), 100);
+
+    // the running job is finished when destroyed
+    started = false;
+    worker.post([&]() {
+      started = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      order.emplace_back(300);
+    });
+    while (!started) {
+      std::this_thread::yield();
+    }
+  }
+  testEquals(order.size(), 11);
+  testEquals(order.back(), 300);
+}
+
+
+
+}
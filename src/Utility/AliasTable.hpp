@@ -0,0 +1,250 @@
+/**
+ * @file AliasTable.hpp
+ * @brief The AliasTable class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_UTILITY_ALIASTABLE_HPP
+#define MATRIXINSPECTOR_UTILITY_ALIASTABLE_HPP
+
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "Utility/Parallel.hpp"
+#include "Utility/Random.hpp"
+#include "Utility/Debug.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/**
+ * @brief A table for drawing indices with probability proportional to their
+ * weights in constant time, by Walker's alias method. The indices are split
+ * into fixed size chunks, each with its own alias table, and built in
+ * parallel. A draw first picks a chunk from an alias table of the chunk
+ * weights, and then an index within it, so still takes constant time. As the
+ * chunks do not depend on the number of threads, neither does the table.
+ */
+class AliasTable
+{
+  public:
+    /**
+     * @brief Build a new table.
+     *
+     * @tparam W The weight type.
+     * @param weights The non-negative weights, of which at least one must be
+     * positive.
+     * @param len The number of weights.
+     */
+    template<typename W>
+    AliasTable(
+        W const * const weights,
+        size_t const len) :
+      m_size(len),
+      m_probabilities(len),
+      m_aliases(len),
+      m_chunkProbabilities(),
+      m_chunkAliases()
+    {
+      size_t const numChunks = (len + CHUNK_SIZE - 1) / CHUNK_SIZE;
+      std::vector<double> sums(numChunks, 0);
+
+      unsigned const numThreads = Parallel::getNumThreads(len);
+      Parallel::run(numThreads, [&](unsigned const tid) {
+        std::vector<uint32_t> small;
+        std::vector<uint32_t> large;
+        for (size_t chunk = tid; chunk < numChunks; chunk += numThreads) {
+          size_t const start = chunk*CHUNK_SIZE;
+          size_t const end = std::min(start+CHUNK_SIZE, len);
+          sums[chunk] = build(weights+start, end-start, \
+              m_probabilities.data()+start, m_aliases.data()+start, \
+              &small, &large);
+        }
+      });
+
+      // the weights are checked on this thread, as exceptions cannot leave
+      // the others
+      double total = 0;
+      for (double const sum : sums) {
+        if (!(sum >= 0)) {
+          throw std::runtime_error("Weights must be finite and " \
+              "non-negative.");
+        }
+        total += sum;
+      }
+      if (!(total > 0)) {
+        throw std::runtime_error("At least one weight must be positive.");
+      }
+
+      // the chunk table is small, so is built serially
+      if (numChunks > 1) {
+        std::vector<uint32_t> small;
+        std::vector<uint32_t> large;
+        m_chunkProbabilities.resize(numChunks);
+        m_chunkAliases.resize(numChunks);
+        build(sums.data(), numChunks, m_chunkProbabilities.data(), \
+            m_chunkAliases.data(), &small, &large);
+      }
+    }
+
+
+    /**
+     * @brief Get the number of indices in the table.
+     *
+     * @return The number of indices.
+     */
+    size_t size() const noexcept
+    {
+      return m_size;
+    }
+
+
+    /**
+     * @brief Draw an index.
+     *
+     * @param rng The random number generator to use.
+     *
+     * @return The index.
+     */
+    size_t draw(
+        Random & rng) const noexcept
+    {
+      size_t chunk = 0;
+      if (!m_chunkProbabilities.empty()) {
+        chunk = pick(m_chunkProbabilities.data(), m_chunkAliases.data(), \
+            m_chunkProbabilities.size(), rng);
+      }
+
+      size_t const start = chunk*CHUNK_SIZE;
+      size_t const end = std::min(start+CHUNK_SIZE, m_size);
+
+      return start + pick(m_probabilities.data()+start, \
+          m_aliases.data()+start, end-start, rng);
+    }
+
+
+  private:
+    // the number of indices in each chunk, which must fit in the aliases
+    static constexpr size_t CHUNK_SIZE = 1 << 16;
+
+
+    size_t m_size;
+    std::vector<double> m_probabilities;
+    std::vector<uint32_t> m_aliases;
+    std::vector<double> m_chunkProbabilities;
+    std::vector<uint32_t> m_chunkAliases;
+
+
+    /**
+     * @brief Build the alias table of a set of weights, by Vose's method.
+     *
+     * @tparam W The weight type.
+     * @param weights The weights.
+     * @param len The number of weights.
+     * @param probabilities The probability of keeping each index (output).
+     * @param aliases The alias of each index (output).
+     * @param small The buffer for the indices with less than the mean weight.
+     * @param large The buffer for the rest.
+     *
+     * @return The sum of the weights, or -1 if any are negative or not
+     * finite.
+     */
+    template<typename W>
+    static double build(
+        W const * const weights,
+        size_t const len,
+        double * const probabilities,
+        uint32_t * const aliases,
+        std::vector<uint32_t> * const small,
+        std::vector<uint32_t> * const large)
+    {
+      double sum = 0;
+      for (size_t i = 0; i < len; ++i) {
+        double const weight = static_cast<double>(weights[i]);
+        if (!(weight >= 0) || std::isinf(weight)) {
+          return -1.0;
+        }
+        sum += weight;
+      }
+
+      // the scaled weights are kept in the probabilities as they are paired
+      small->clear();
+      large->clear();
+      double const scale = sum > 0 ? len / sum : 0;
+      for (size_t i = 0; i < len; ++i) {
+        probabilities[i] = weights[i] * scale;
+        aliases[i] = static_cast<uint32_t>(i);
+        if (probabilities[i] < 1.0) {
+          small->emplace_back(static_cast<uint32_t>(i));
+        } else {
+          large->emplace_back(static_cast<uint32_t>(i));
+        }
+      }
+
+      // fill each small index up to the mean with a large one
+      while (!small->empty() && !large->empty()) {
+        uint32_t const less = small->back();
+        small->pop_back();
+        uint32_t const more = large->back();
+
+        aliases[less] = more;
+        probabilities[more] -= 1.0 - probabilities[less];
+        if (probabilities[more] < 1.0) {
+          large->pop_back();
+          small->emplace_back(more);
+        }
+      }
+
+      // what remains is the mean, but for rounding (or a chunk of zeros,
+      // which is never picked)
+      for (uint32_t const i : *large) {
+        probabilities[i] = 1.0;
+      }
+      for (uint32_t const i : *small) {
+        probabilities[i] = 1.0;
+      }
+
+      return sum;
+    }
+
+
+    static size_t pick(
+        double const * const probabilities,
+        uint32_t const * const aliases,
+        size_t const len,
+        Random & rng) noexcept
+    {
+      ASSERT_GREATER(len,0);
+      size_t const i = rng.inRange<size_t>(0, len-1);
+      return rng.uniform() < probabilities[i] ? i : aliases[i];
+    }
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
@@ -0,0 +1,217 @@
+/**
+ * @file FeistelPermutation.hpp
+ * @brief The FeistelPermutation class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_UTILITY_FEISTELPERMUTATION_HPP
+#define MATRIXINSPECTOR_UTILITY_FEISTELPERMUTATION_HPP
+
+
+
+
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+#include "Utility/Random.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/**
+ * @brief A pseudo-random permutation of [0, n), computed on demand rather
+ * than stored. A Feistel network shuffles the bits of indices over the
+ * smallest power of two which covers n, and cycle-walking re-applies it until
+ * the result falls back within [0, n). The domain is less than twice n, so
+ * this takes fewer than two steps on average. When the number of bits is odd,
+ * the two halves differ by a bit and swap widths every round.
+ */
+class FeistelPermutation
+{
+  public:
+    /**
+     * @brief Create a new permutation.
+     *
+     * @param size The size of the permutation.
+     * @param seed The seed.
+     * @param stream The stream, for creating different permutations from the
+     * same seed.
+     */
+    FeistelPermutation(
+        uint64_t const size,
+        uint64_t const seed,
+        uint32_t const stream = 0) noexcept :
+      m_size(size),
+      m_leftBits(0),
+      m_rightBits(0),
+      m_keys()
+    {
+      unsigned bits = 0;
+      while (bits < 64 && (1ULL << bits) < size) {
+        ++bits;
+      }
+      m_leftBits = bits / 2;
+      m_rightBits = bits - m_leftBits;
+
+      Random rng(seed, stream);
+      for (uint64_t & key : m_keys) {
+        key = rng.next64();
+      }
+    }
+
+
+    /**
+     * @brief Get the size of the permutation.
+     *
+     * @return The size.
+     */
+    uint64_t size() const noexcept
+    {
+      return m_size;
+    }
+
+
+    /**
+     * @brief Get the index mapped to by an index.
+     *
+     * @param index The index (less than the size).
+     *
+     * @return The mapped index.
+     */
+    uint64_t operator()(
+        uint64_t const index) const noexcept
+    {
+      ASSERT_LESS(index,m_size);
+      uint64_t mapped = encrypt(index);
+      while (mapped >= m_size) {
+        mapped = encrypt(mapped);
+      }
+      return mapped;
+    }
+
+
+    /**
+     * @brief Get the index which maps to an index, such that
+     * inverse(perm(i)) == i.
+     *
+     * @param index The mapped index (less than the size).
+     *
+     * @return The index.
+     */
+    uint64_t inverse(
+        uint64_t const index) const noexcept
+    {
+      ASSERT_LESS(index,m_size);
+      uint64_t original = decrypt(index);
+      while (original >= m_size) {
+        original = decrypt(original);
+      }
+      return original;
+    }
+
+
+    /**
+     * @brief Check if two permutations are the same.
+     *
+     * @param rhs The other permutation.
+     *
+     * @return True if they map every index to the same index.
+     */
+    bool operator==(
+        FeistelPermutation const & rhs) const noexcept
+    {
+      return m_size == rhs.m_size && \
+          std::equal(m_keys, m_keys+NUM_ROUNDS, rhs.m_keys);
+    }
+
+
+  private:
+    // an even number, so the halves end up with the widths they started with
+    static constexpr int NUM_ROUNDS = 4;
+
+    uint64_t m_size;
+    unsigned m_leftBits;
+    unsigned m_rightBits;
+    uint64_t m_keys[NUM_ROUNDS];
+
+
+    /**
+     * @brief The round function, mixing half of the bits of an index with
+     * the round's key. The high bits of a product depend on all of the bits
+     * of its operands, so two multiplies mix well enough.
+     *
+     * @param half The half of the index.
+     * @param round The round.
+     * @param bits The width of the output.
+     *
+     * @return The mixed bits.
+     */
+    uint64_t mix(
+        uint64_t const half,
+        int const round,
+        unsigned const bits) const noexcept
+    {
+      uint64_t x = (half + m_keys[round]) * 0x9E3779B97F4A7C15ULL;
+      x ^= x >> 32;
+      x *= 0xD6E8FEB86659FD93ULL;
+      // the halves are at most 32 bits
+      return (x >> 32) & ((1ULL << bits) - 1);
+    }
+
+
+    uint64_t encrypt(
+        uint64_t const index) const noexcept
+    {
+      unsigned leftBits = m_leftBits;
+      unsigned rightBits = m_rightBits;
+      uint64_t left = index >> rightBits;
+      uint64_t right = index & ((1ULL << rightBits) - 1);
+      for (int round = 0; round < NUM_ROUNDS; ++round) {
+        uint64_t const next = left ^ mix(right, round, leftBits);
+        left = right;
+        right = next;
+        std::swap(leftBits, rightBits);
+      }
+      return (left << rightBits) | right;
+    }
+
+
+    uint64_t decrypt(
+        uint64_t const index) const noexcept
+    {
+      unsigned leftBits = m_leftBits;
+      unsigned rightBits = m_rightBits;
+      uint64_t left = index >> rightBits;
+      uint64_t right = index & ((1ULL << rightBits) - 1);
+      for (int round = NUM_ROUNDS-1; round >= 0; --round) {
+        std::swap(leftBits, rightBits);
+        uint64_t const prev = right ^ mix(left, round, leftBits);
+        right = left;
+        left = prev;
+      }
+      return (left << rightBits) | right;
+    }
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
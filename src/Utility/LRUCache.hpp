@@ -0,0 +1,201 @@
+/**
+ * @file LRUCache.hpp
+ * @brief The LRUCache class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_UTILITY_LRUCACHE_HPP
+#define MATRIXINSPECTOR_UTILITY_LRUCACHE_HPP
+
+
+
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/**
+ * @brief A cache bounded by the total cost of its entries, such as the bytes
+ * they take, which evicts the least recently used entries to make room for
+ * new ones.
+ *
+ * @tparam K The key type.
+ * @tparam V The value type.
+ */
+template<typename K, typename V>
+class LRUCache
+{
+  public:
+    /**
+     * @brief Create a new empty cache.
+     *
+     * @param capacity The largest total cost of the entries.
+     * @param evict The function to call with each value as it is evicted or
+     * cleared, to release what it holds.
+     */
+    LRUCache(
+        size_t const capacity,
+        std::function<void (V &)> evict) :
+      m_capacity(capacity),
+      m_cost(0),
+      m_evict(std::move(evict)),
+      m_entries(),
+      m_index()
+    {
+      // do nothing
+    }
+
+
+    /**
+     * @brief Evict all of the entries.
+     */
+    ~LRUCache()
+    {
+      clear();
+    }
+
+
+    /**
+     * @brief Find an entry, and mark it as the most recently used.
+     *
+     * @param key The key of the entry.
+     *
+     * @return The value, or null if it is not in the cache.
+     */
+    V * get(
+        K const & key)
+    {
+      auto const it = m_index.find(key);
+      if (it == m_index.end()) {
+        return nullptr;
+      }
+
+      m_entries.splice(m_entries.begin(), m_entries, it->second);
+      return &(it->second->value);
+    }
+
+
+    /**
+     * @brief Add an entry as the most recently used, replacing any with the
+     * same key, and evict the least recently used entries until the cost is
+     * within the capacity. An entry costing more than the capacity is kept
+     * until the next one is added.
+     *
+     * @param key The key of the entry.
+     * @param value The value of the entry.
+     * @param cost The cost of the entry.
+     */
+    void put(
+        K const & key,
+        V value,
+        size_t const cost)
+    {
+      auto const it = m_index.find(key);
+      if (it != m_index.end()) {
+        remove(it->second);
+      }
+
+      m_entries.push_front(entry_struct{key, std::move(value), cost});
+      m_index[key] = m_entries.begin();
+      m_cost += cost;
+
+      while (m_cost > m_capacity && m_entries.size() > 1) {
+        remove(std::prev(m_entries.end()));
+      }
+    }
+
+
+    /**
+     * @brief Evict all of the entries.
+     */
+    void clear()
+    {
+      while (!m_entries.empty()) {
+        remove(m_entries.begin());
+      }
+    }
+
+
+    /**
+     * @brief Get the number of entries.
+     *
+     * @return The number of entries.
+     */
+    size_t size() const noexcept
+    {
+      return m_entries.size();
+    }
+
+
+    /**
+     * @brief Get the total cost of the entries.
+     *
+     * @return The cost.
+     */
+    size_t getCost() const noexcept
+    {
+      return m_cost;
+    }
+
+
+  private:
+    struct entry_struct
+    {
+      K key;
+      V value;
+      size_t cost;
+    };
+
+
+    size_t m_capacity;
+    size_t m_cost;
+    std::function<void (V &)> m_evict;
+    // the most recently used entry first
+    std::list<entry_struct> m_entries;
+    std::unordered_map<K, typename std::list<entry_struct>::iterator> m_index;
+
+
+    void remove(
+        typename std::list<entry_struct>::iterator const it)
+    {
+      m_evict(it->value);
+      m_cost -= it->cost;
+      m_index.erase(it->key);
+      m_entries.erase(it);
+    }
+
+
+    // disable copying
+    LRUCache(
+        LRUCache const & rhs);
+    LRUCache & operator=(
+        LRUCache const & rhs);
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
@@ -0,0 +1,160 @@
+/**
+ * @file PNGWriter.cpp
+ * @brief Implementation of the PNGWriter class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <csetjmp>
+#include <stdexcept>
+#include "PNGWriter.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/******************************************************************************
+* CONSTANTS *******************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+// the fastest compression, as images of matrices are mostly long runs of the
+// same color, which compress well regardless, and about twice as fast when
+// the rows are not filtered first
+int const COMPRESSION_LEVEL = 1;
+
+}
+
+
+
+
+/******************************************************************************
+* CONSTRUCTORS / DESTRUCTOR ***************************************************
+******************************************************************************/
+
+
+PNGWriter::PNGWriter(
+    std::string const & path,
+    uint32_t const width,
+    uint32_t const height) :
+  m_path(path),
+  m_file(std::fopen(path.c_str(), "wb")),
+  m_png(nullptr),
+  m_info(nullptr),
+  m_width(width),
+  m_height(height),
+  m_row(0)
+{
+  if (m_file == nullptr) {
+    throw std::runtime_error("Unable to open '" + m_path + "' for writing.");
+  }
+
+  m_png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, \
+      nullptr);
+  if (m_png != nullptr) {
+    m_info = png_create_info_struct(m_png);
+  }
+  if (m_info == nullptr) {
+    close();
+    throw std::runtime_error("Unable to start writing '" + m_path + "'.");
+  }
+
+  // libpng reports errors by jumping back here
+  if (setjmp(png_jmpbuf(m_png))) {
+    close();
+    throw std::runtime_error("Unable to write '" + m_path + "'.");
+  }
+
+  png_init_io(m_png, m_file);
+  png_set_compression_level(m_png, COMPRESSION_LEVEL);
+  png_set_filter(m_png, 0, PNG_FILTER_NONE);
+  png_set_IHDR(m_png, m_info, m_width, m_height, 8, PNG_COLOR_TYPE_RGB, \
+      PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, \
+      PNG_FILTER_TYPE_DEFAULT);
+  png_write_info(m_png, m_info);
+
+  // the pixels are red, green and blue bytes, followed by one to skip
+  png_set_filler(m_png, 0, PNG_FILLER_AFTER);
+}
+
+
+PNGWriter::~PNGWriter()
+{
+  close();
+}
+
+
+
+
+/******************************************************************************
+* PUBLIC FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+void PNGWriter::write(
+    uint32_t const * const pixels,
+    uint32_t const numRows)
+{
+  if (m_png == nullptr || numRows > m_height - m_row) {
+    throw std::runtime_error("Too many rows written to '" + m_path + "'.");
+  }
+
+  if (setjmp(png_jmpbuf(m_png))) {
+    close();
+    throw std::runtime_error("Unable to write '" + m_path + "'.");
+  }
+
+  for (uint32_t i = 0; i < numRows; ++i) {
+    // older versions of libpng take the row as mutable
+    png_write_row(m_png, reinterpret_cast<png_bytep>(const_cast<uint32_t *>( \
+        pixels + (static_cast<size_t>(i) * m_width))));
+  }
+  m_row += numRows;
+
+  if (m_row == m_height) {
+    png_write_end(m_png, nullptr);
+    if (!close()) {
+      throw std::runtime_error("Unable to finish writing '" + m_path + "'.");
+    }
+  }
+}
+
+
+
+
+/******************************************************************************
+* PRIVATE FUNCTIONS ***********************************************************
+******************************************************************************/
+
+
+bool PNGWriter::close()
+{
+  if (m_png != nullptr) {
+    png_destroy_write_struct(&m_png, m_info != nullptr ? &m_info : nullptr);
+    m_png = nullptr;
+    m_info = nullptr;
+  }
+
+  bool closed = true;
+  if (m_file != nullptr) {
+    closed = std::fclose(m_file) == 0;
+    m_file = nullptr;
+  }
+
+  return closed;
+}
+
+
+
+
+}
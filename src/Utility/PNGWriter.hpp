@@ -0,0 +1,112 @@
+/**
+ * @file PNGWriter.hpp
+ * @brief The PNGWriter class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_UTILITY_PNGWRITER_HPP
+#define MATRIXINSPECTOR_UTILITY_PNGWRITER_HPP
+
+
+
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <png.h>
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/**
+ * @brief Writes an image to a PNG file a band of rows at a time, so that
+ * images too large to hold in memory can be written as they are drawn.
+ */
+class PNGWriter
+{
+  public:
+    /**
+     * @brief Create the file and write its header.
+     *
+     * @param path The path of the file.
+     * @param width The width of the image.
+     * @param height The height of the image.
+     *
+     * @throws std::runtime_error If the file cannot be written.
+     */
+    PNGWriter(
+        std::string const & path,
+        uint32_t width,
+        uint32_t height);
+
+
+    /**
+     * @brief Close the file, which is left incomplete if not all of the rows
+     * were written.
+     */
+    ~PNGWriter();
+
+
+    /**
+     * @brief Write the next rows of the image, and finish the file after the
+     * last of them.
+     *
+     * @param pixels The pixels of the rows, in the format of
+     * HeatMap::floatToRGBA(), whose fourth byte is ignored.
+     * @param numRows The number of rows.
+     *
+     * @throws std::runtime_error If the rows cannot be written, or there are
+     * more than are left in the image.
+     */
+    void write(
+        uint32_t const * pixels,
+        uint32_t numRows);
+
+
+  private:
+    std::string m_path;
+    std::FILE * m_file;
+    png_structp m_png;
+    png_infop m_info;
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_row;
+
+
+    /**
+     * @brief Release libpng and close the file.
+     *
+     * @return Whether the file closed without error.
+     */
+    bool close();
+
+
+    // disable copying
+    PNGWriter(
+        PNGWriter const & rhs);
+    PNGWriter & operator=(
+        PNGWriter const & rhs);
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
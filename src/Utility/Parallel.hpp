@@ -0,0 +1,183 @@
+/**
+ * @file Parallel.hpp
+ * @brief The Parallel class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_UTILITY_PARALLEL_HPP
+#define MATRIXINSPECTOR_UTILITY_PARALLEL_HPP
+
+
+
+
+#include <cstddef>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+
+
+
+namespace MatrixInspector
+{
+
+
+class Parallel
+{
+  public:
+    /**
+     * @brief Get the number of threads to use for parallel operations.
+     *
+     * @return The number of threads.
+     */
+    static unsigned getNumThreads() noexcept
+    {
+      unsigned const num = std::thread::hardware_concurrency();
+      return num > 0 ? num : 1;
+    }
+
+
+    /**
+     * @brief Get the number of threads to split a range over, such that
+     * tiny ranges do not spawn threads.
+     *
+     * @param n The length of the range.
+     *
+     * @return The number of threads.
+     */
+    static unsigned getNumThreads(
+        size_t const n) noexcept
+    {
+      return static_cast<unsigned>(std::max<size_t>(1, \
+          std::min<size_t>(getNumThreads(), n / MIN_CHUNK_SIZE)));
+    }
+
+
+    /**
+     * @brief Execute a function on each of a number of threads. The calling
+     * thread executes as thread 0.
+     *
+     * @tparam F The function type.
+     * @param numThreads The number of threads.
+     * @param func The function to call with each thread's id.
+     */
+    template<typename F>
+    static void run(
+        unsigned const numThreads,
+        F func)
+    {
+      std::vector<std::thread> threads;
+      threads.reserve(numThreads);
+      for (unsigned tid = 1; tid < numThreads; ++tid) {
+        threads.emplace_back(func, tid);
+      }
+
+      func(0U);
+
+      for (std::thread & thread : threads) {
+        thread.join();
+      }
+    }
+
+
+    /**
+     * @brief Get the start of a part of a range split evenly. The end of the
+     * part is the start of the next part.
+     *
+     * @param n The length of the range.
+     * @param numParts The number of parts.
+     * @param part The part.
+     *
+     * @return The starting index.
+     */
+    static size_t getChunkStart(
+        size_t const n,
+        unsigned const numParts,
+        unsigned const part) noexcept
+    {
+      return static_cast<size_t>( \
+          (static_cast<unsigned long long>(n) * part) / numParts);
+    }
+
+
+    /**
+     * @brief Get the first row of a part of a set of rows split such that each
+     * part has approximately the same number of non-zeros.
+     *
+     * @tparam I The index type.
+     * @tparam D The dimension type.
+     * @param offsets The row offsets (of length numRows+1).
+     * @param numRows The number of rows.
+     * @param numParts The number of parts.
+     * @param part The part.
+     *
+     * @return The first row.
+     */
+    template<typename I, typename D>
+    static D getRowChunkStart(
+        I const * const offsets,
+        D const numRows,
+        unsigned const numParts,
+        unsigned const part) noexcept
+    {
+      if (part >= numParts) {
+        return numRows;
+      }
+
+      I const target = offsets[0] + static_cast<I>(getChunkStart( \
+          offsets[numRows] - offsets[0], numParts, part));
+
+      return static_cast<D>(std::lower_bound(offsets, offsets+numRows, \
+          target) - offsets);
+    }
+
+
+    /**
+     * @brief Execute a function over a range, split evenly into contiguous
+     * chunks, one per thread.
+     *
+     * @tparam F The function type.
+     * @param n The length of the range.
+     * @param func The function to call with the thread id, and the start and
+     * end of the thread's chunk.
+     *
+     * @return The number of threads used.
+     */
+    template<typename F>
+    static unsigned forRange(
+        size_t const n,
+        F func)
+    {
+      unsigned const numThreads = getNumThreads(n);
+
+      run(numThreads, [&](unsigned const tid) {
+        func(tid, getChunkStart(n, numThreads, tid), \
+            getChunkStart(n, numThreads, tid+1));
+      });
+
+      return numThreads;
+    }
+
+
+  private:
+    static constexpr size_t MIN_CHUNK_SIZE = 4096;
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
@@ -15,10 +15,16 @@
 
 
 
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <algorithm>
-#include <ctime>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <type_traits>
 #include "Utility/Debug.hpp"
+#include "Utility/Parallel.hpp"
 
 
 
@@ -27,23 +33,123 @@ namespace MatrixInspector
 {
 
 
+/**
+ * @brief A counter-based random number generator (Philox4x32-10). Each
+ * number is a function of the seed, the stream, and its position in the
+ * stream, so any number of generators with different streams can be used
+ * in parallel, and give the same numbers regardless of which thread uses
+ * them.
+ */
 class Random
 {
   public:
     /**
-     * @brief Set the seed for random number generation.
+     * @brief Create a new generator.
      *
      * @param seed The seed.
+     * @param stream The stream of numbers to generate for the seed.
+     */
+    Random(
+        uint64_t const seed,
+        uint64_t const stream = 0) noexcept :
+      m_key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)},
+      m_stream(stream),
+      m_counter(0),
+      m_block{0, 0, 0, 0},
+      m_next(BLOCK_SIZE)
+    {
+      // do nothing
+    }
+
+
+    /**
+     * @brief Get a seed which differs between runs.
+     *
+     * @return The seed.
      */
-    static void setSeed(
-        unsigned int const seed = \
-            static_cast<unsigned int>(std::time(nullptr)))
+    static uint64_t randomSeed()
     {
-      std::srand(seed);
+      std::random_device device;
+      uint64_t const time = static_cast<uint64_t>( \
+          std::chrono::high_resolution_clock::now().time_since_epoch().count());
+      return (static_cast<uint64_t>(device()) << 32) ^ device() ^ time;
     }
 
+
+    /**
+     * @brief Compute a block of the Philox4x32-10 function.
+     *
+     * @param key The key (seed).
+     * @param counter The counter. Overwritten with the output.
+     */
+    static void philox(
+        uint32_t const * const key,
+        uint32_t * const counter) noexcept
+    {
+      uint32_t k0 = key[0];
+      uint32_t k1 = key[1];
+      for (int round = 0; round < NUM_ROUNDS; ++round) {
+        uint64_t const p0 = static_cast<uint64_t>(PHILOX_M0) * counter[0];
+        uint64_t const p1 = static_cast<uint64_t>(PHILOX_M1) * counter[2];
+        uint32_t const c1 = counter[1];
+        uint32_t const c3 = counter[3];
+        counter[0] = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        counter[1] = static_cast<uint32_t>(p1);
+        counter[2] = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        counter[3] = static_cast<uint32_t>(p0);
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+      }
+    }
+
+
     /**
-     * @brief Generate a random number in a specified range.
+     * @brief Generate 32 random bits.
+     *
+     * @return The random bits.
+     */
+    uint32_t next32() noexcept
+    {
+      if (m_next == BLOCK_SIZE) {
+        m_block[0] = static_cast<uint32_t>(m_counter);
+        m_block[1] = static_cast<uint32_t>(m_counter >> 32);
+        m_block[2] = static_cast<uint32_t>(m_stream);
+        m_block[3] = static_cast<uint32_t>(m_stream >> 32);
+        philox(m_key, m_block);
+        ++m_counter;
+        m_next = 0;
+      }
+      return m_block[m_next++];
+    }
+
+
+    /**
+     * @brief Generate 64 random bits.
+     *
+     * @return The random bits.
+     */
+    uint64_t next64() noexcept
+    {
+      uint64_t const high = next32();
+      return (high << 32) | next32();
+    }
+
+
+    /**
+     * @brief Generate a random number uniformly in [0, 1).
+     *
+     * @return The generated number.
+     */
+    double uniform() noexcept
+    {
+      return static_cast<double>(next64() >> 11) * (1.0 / (1ULL << 53));
+    }
+
+
+    /**
+     * @brief Generate a random number uniformly in a specified range. Draws
+     * which would favor the low end of the range are rejected, so the
+     * result is unbiased for ranges of any size.
      *
      * @tparam T The type of number to generate.
      * @param min The lower bound on the range (inclusive).
@@ -52,19 +158,27 @@ class Random
      * @return The generated number.
      */
     template<typename T>
-    static T inRange(
+    T inRange(
         T const min,
-        T const max)
+        T const max) noexcept
     {
+      static_assert(std::is_integral<T>::value && sizeof(T) <= 8, \
+          "Random ranges must be of integers of up to 64 bits.");
       ASSERT_LESSEQUAL(min,max);
+
+      typedef typename std::make_unsigned<T>::type U;
+      U const span = static_cast<U>(static_cast<U>(max) - static_cast<U>(min));
+
       T val;
-      T upper = max - min;
-      if (upper == 0) {
-        val = min;
-      } else if (upper + 1 == 0) {
-        val = min + std::rand();
+      if (static_cast<uint64_t>(span) <= \
+          std::numeric_limits<uint32_t>::max()) {
+        val = static_cast<T>(static_cast<U>(min) + static_cast<U>( \
+            bounded(static_cast<uint32_t>(span), [this]() { \
+              return next32(); })));
       } else {
-        val =  min + (std::rand() % (upper+1));
+        val = static_cast<T>(static_cast<U>(min) + static_cast<U>( \
+            bounded(static_cast<uint64_t>(span), [this]() { \
+              return next64(); })));
       }
       ASSERT_GREATEREQUAL(val,min);
       ASSERT_LESSEQUAL(val,max);
@@ -73,70 +187,375 @@ class Random
     }
 
 
+    /**
+     * @brief Move a random subset of a set to its front, in random order.
+     *
+     * @tparam T The type of element.
+     * @param set The set.
+     * @param len The size of the set.
+     * @param sampleLen The size of the subset.
+     */
+    template<typename T>
+    void sample(
+        T * const set,
+        size_t const len,
+        size_t const sampleLen) noexcept
+    {
+      ASSERT_LESSEQUAL(sampleLen,len);
+
+      // TODO: add optimization such that if sampleLen > len/2, we remove
+      // elements rather than add
+
+      for (size_t i = 0; i < sampleLen; ++i) {
+        size_t const j = inRange(i,len-1);
+        std::swap(set[i],set[j]);
+      }
+    }
+
+
+    /**
+     * @brief Select a uniformly random subset of [0, len), in ascending
+     * order, using Vitter's Algorithm D: the number of elements to skip
+     * before each selected one is drawn directly, so this takes time and
+     * memory proportional to the size of the subset rather than the set.
+     *
+     * @tparam T The type of element.
+     * @param subset The subset to fill (of length sampleLen).
+     * @param len The size of the set.
+     * @param sampleLen The size of the subset.
+     */
+    template<typename T>
+    void sortedSample(
+        T * const subset,
+        size_t const len,
+        size_t const sampleLen) noexcept
+    {
+      ASSERT_LESSEQUAL(sampleLen,len);
+
+      if (sampleLen == 0) {
+        return;
+      }
+
+      // the number of remaining elements to select, and to select from
+      size_t n = sampleLen;
+      size_t N = len;
+      double nReal = static_cast<double>(n);
+      double NReal = static_cast<double>(N);
+      double nInv = 1.0 / nReal;
+      double vPrime = std::exp(std::log(openUniform()) * nInv);
+      size_t qu1 = N - n + 1;
+      double qu1Real = static_cast<double>(qu1);
+      // once fewer than this many elements remain per selection, it is
+      // cheaper to step through them (Algorithm A)
+      size_t threshold = SKIP_THRESHOLD * n;
+      size_t next = 0;
+      size_t out = 0;
+
+      while (n > 1 && threshold < N) {
+        double const nMin1Inv = 1.0 / (nReal - 1.0);
+        size_t skip;
+        while (true) {
+          // draw a skip from an approximate distribution, and accept it
+          // with the ratio of the true distribution
+          double x;
+          while (true) {
+            x = NReal * (1.0 - vPrime);
+            skip = static_cast<size_t>(x);
+            if (skip < qu1) {
+              break;
+            }
+            vPrime = std::exp(std::log(openUniform()) * nInv);
+          }
+          double const u = openUniform();
+          double const negSkip = -static_cast<double>(skip);
+          double const y1 = std::exp(std::log(u * NReal / qu1Real) * nMin1Inv);
+          vPrime = y1 * (-x / NReal + 1.0) * (qu1Real / (negSkip + qu1Real));
+          if (vPrime <= 1.0) {
+            // quick acceptance
+            break;
+          }
+
+          double y2 = 1.0;
+          double top = NReal - 1.0;
+          double bottom;
+          size_t limit;
+          if (n - 1 > skip) {
+            bottom = NReal - nReal;
+            limit = N - skip;
+          } else {
+            bottom = negSkip + NReal - 1.0;
+            limit = qu1;
+          }
+          for (size_t t = N - 1; t >= limit; --t) {
+            y2 = (y2 * top) / bottom;
+            top -= 1.0;
+            bottom -= 1.0;
+          }
+          if (NReal / (NReal - x) >= y1 * std::exp(std::log(y2) * nMin1Inv)) {
+            vPrime = std::exp(std::log(openUniform()) * nMin1Inv);
+            break;
+          }
+          vPrime = std::exp(std::log(openUniform()) * nInv);
+        }
+
+        next += skip;
+        subset[out++] = static_cast<T>(next++);
+
+        N -= skip + 1;
+        NReal = static_cast<double>(N);
+        --n;
+        nReal -= 1.0;
+        nInv = nMin1Inv;
+        qu1 -= skip;
+        qu1Real = static_cast<double>(qu1);
+        threshold -= SKIP_THRESHOLD;
+      }
+
+      if (n > 1) {
+        // Algorithm A: step through the skips
+        size_t top = N - n;
+        while (n > 1) {
+          double const v = uniform();
+          size_t skip = 0;
+          double quot = static_cast<double>(top) / NReal;
+          while (quot > v) {
+            ++skip;
+            --top;
+            NReal -= 1.0;
+            quot = (quot * static_cast<double>(top)) / NReal;
+          }
+          next += skip;
+          subset[out++] = static_cast<T>(next++);
+          NReal -= 1.0;
+          --n;
+        }
+        N = static_cast<size_t>(NReal);
+        vPrime = uniform();
+      }
+
+      // the last element is uniform over those remaining
+      size_t const skip = std::min(N - 1, \
+          static_cast<size_t>(static_cast<double>(N) * vPrime));
+      subset[out++] = static_cast<T>(next + skip);
+      ASSERT_EQUAL(out,sampleLen);
+    }
+
+
+    /**
+     * @brief Generate a uniformly random permutation in parallel, using
+     * MergeShuffle (Bacher et al.): fixed size blocks are shuffled
+     * independently, and then pairs of shuffled blocks are merged by random
+     * bits, level by level. Each block and merge has its own stream, so
+     * the permutation only depends on the seed and the stream, and not on
+     * the number of threads.
+     *
+     * @tparam T The type of element.
+     * @param perm The permutation to generate (of length len).
+     * @param len The length of the permutation.
+     * @param seed The seed.
+     * @param stream The stream, for generating different permutations from
+     * the same seed.
+     */
     template<typename T>
     static void permutation(
         T * const perm,
-        size_t const len)
+        size_t const len,
+        uint64_t const seed,
+        uint32_t const stream = 0)
     {
       if (len == 0) {
         return;
       }
 
-      // fill the array
-      for (size_t i = 0; i < len; ++i) {
-        perm[i] = i;
+      // the blocks only depend on the length
+      size_t numBlocks = 1;
+      while (numBlocks * SHUFFLE_BLOCK_SIZE < len) {
+        numBlocks *= 2;
       }
-
-      // TODO: compare speeds
-      #if 0
-      // shuffle array
-      if (len < 100) {
-        for (size_t i = 0; i < len; ++i) {
-          u = size_rand_r(0,n,seed);
-          v = size_rand_r(0,n,seed);
-          size_t const u = inRange(0,len-1);
-          size_t const v = inRange(0,len-1);
-          std::swap(ptr[u],ptr[v]);
-        }
-      } else {
-        size_t const nshuffles = len / 8;
-        size_t const r = ((len-3) / (double)nshuffles);
-        size_t d = 0;
-        for (size_t i=0; i < nshuffles; ++i) {
-          size_t const u = (size_t)d;
-          size_t const v = inRange(0,len-4);
-          std::swap(perm[u],perm[v+1]);
-          std::swap(perm[u+1],perm[v+3]);
-          std::swap(perm[u+2],perm[v+0]);
-          std::swap(perm[u+3],perm[v+2]);
-          d += r;
+      ASSERT_LESS(numBlocks*2,1ULL << 32);
+
+      // merges are numbered as the nodes of a binary tree over the blocks,
+      // from 1 at the root, and the blocks follow
+      uint64_t const streamBase = static_cast<uint64_t>(stream) << 32;
+
+      unsigned const numThreads = static_cast<unsigned>(std::min<size_t>( \
+          Parallel::getNumThreads(len), numBlocks));
+
+      Parallel::run(numThreads, [&](unsigned const tid) {
+        size_t const first = Parallel::getChunkStart(numBlocks, numThreads, \
+            tid);
+        size_t const last = Parallel::getChunkStart(numBlocks, numThreads, \
+            tid+1);
+        for (size_t block = first; block < last; ++block) {
+          size_t const start = Parallel::getChunkStart(len, \
+              static_cast<unsigned>(numBlocks), static_cast<unsigned>(block));
+          size_t const end = Parallel::getChunkStart(len, \
+              static_cast<unsigned>(numBlocks), \
+              static_cast<unsigned>(block+1));
+          for (size_t i = start; i < end; ++i) {
+            perm[i] = static_cast<T>(i);
+          }
+          Random rng(seed, streamBase | (numBlocks + block));
+          rng.shuffle(perm+start, end-start);
         }
+      });
+
+      // merge pairs of blocks, halving the number of blocks each level
+      for (size_t width = 1; width < numBlocks; width *= 2) {
+        size_t const numMerges = numBlocks / (width*2);
+        unsigned const mergeThreads = static_cast<unsigned>( \
+            std::min<size_t>(numThreads, numMerges));
+        Parallel::run(mergeThreads, [&](unsigned const tid) {
+          size_t const first = Parallel::getChunkStart(numMerges, \
+              mergeThreads, tid);
+          size_t const last = Parallel::getChunkStart(numMerges, \
+              mergeThreads, tid+1);
+          for (size_t merge = first; merge < last; ++merge) {
+            size_t const start = Parallel::getChunkStart(len, \
+                static_cast<unsigned>(numBlocks), \
+                static_cast<unsigned>(merge*width*2));
+            size_t const mid = Parallel::getChunkStart(len, \
+                static_cast<unsigned>(numBlocks), \
+                static_cast<unsigned>(merge*width*2 + width));
+            size_t const end = Parallel::getChunkStart(len, \
+                static_cast<unsigned>(numBlocks), \
+                static_cast<unsigned>((merge+1)*width*2));
+            Random rng(seed, streamBase | (numMerges + merge));
+            rng.merge(perm+start, mid-start, end-start);
+          }
+        });
+      }
+    }
+
+
+  private:
+    static constexpr int NUM_ROUNDS = 10;
+    static constexpr uint32_t PHILOX_M0 = 0xD2511F53;
+    static constexpr uint32_t PHILOX_M1 = 0xCD9E8D57;
+    static constexpr uint32_t PHILOX_W0 = 0x9E3779B9;
+    static constexpr uint32_t PHILOX_W1 = 0xBB67AE85;
+    static constexpr unsigned BLOCK_SIZE = 4;
+    static constexpr size_t SKIP_THRESHOLD = 13;
+    // small enough for a block to be shuffled in cache
+    static constexpr size_t SHUFFLE_BLOCK_SIZE = 1 << 16;
+
+    uint32_t m_key[2];
+    uint64_t m_stream;
+    uint64_t m_counter;
+    uint32_t m_block[BLOCK_SIZE];
+    unsigned m_next;
+
+
+    /**
+     * @brief Generate a number uniformly in [0, span], rejecting the draws
+     * in the incomplete final copy of the range.
+     *
+     * @tparam U The unsigned type of the draws.
+     * @tparam F The type of the draw function.
+     * @param span The largest number to generate.
+     * @param draw The function generating uniform values of type U.
+     *
+     * @return The generated number.
+     */
+    template<typename U, typename F>
+    static U bounded(
+        U const span,
+        F draw) noexcept
+    {
+      if (span == std::numeric_limits<U>::max()) {
+        return draw();
       }
-      #else
-      std::random_shuffle(perm,perm+len);
-      #endif
+
+      U const range = span + 1;
+      // the number of values before the first complete copy of the range
+      U const skip = static_cast<U>(-range) % range;
+      U value;
+      do {
+        value = draw();
+      } while (value < skip);
+
+      return value % range;
     }
 
 
+    /**
+     * @brief Generate a random number uniformly in (0, 1), for taking its
+     * logarithm.
+     *
+     * @return The generated number.
+     */
+    double openUniform() noexcept
+    {
+      return (static_cast<double>(next64() >> 11) + 0.5) * (1.0 / (1ULL << 53));
+    }
+
+
+    /**
+     * @brief Shuffle a set with Fisher-Yates.
+     *
+     * @tparam T The type of element.
+     * @param set The set.
+     * @param len The size of the set.
+     */
     template<typename T>
-    static void sample(
+    void shuffle(
         T * const set,
-        size_t const len,
-        size_t const sampleLen)
+        size_t const len) noexcept
     {
-      ASSERT_LESSEQUAL(sampleLen,len);
-
-      // do nothing for empty sample lenths of sets
-      if (len == 0 || sampleLen == 0) {
-        return;
+      for (size_t i = len; i > 1; --i) {
+        size_t const j = inRange<size_t>(0, i-1);
+        std::swap(set[i-1], set[j]);
       }
+    }
 
-      // TODO: add optimization such that if sampleLen > len/2, we remove
-      // elements rather than add
 
-      for (size_t i = 0; i < sampleLen; ++i) {
-        size_t const j = inRange(i,len-1);
-        std::swap(set[i],set[j]);
+    /**
+     * @brief Merge two adjacent shuffled sets into one shuffled set. Random
+     * bits pick which set supplies the next element until one runs out, and
+     * the rest are inserted at random positions.
+     *
+     * @tparam T The type of element.
+     * @param set The sets.
+     * @param mid The size of the first set.
+     * @param len The size of both sets.
+     */
+    template<typename T>
+    void merge(
+        T * const set,
+        size_t const mid,
+        size_t const len) noexcept
+    {
+      size_t i = 0;
+      size_t j = mid;
+      uint32_t bits = 0;
+      int numBits = 0;
+      while (true) {
+        if (numBits == 0) {
+          bits = next32();
+          numBits = 32;
+        }
+        size_t const bit = bits & 1;
+        bits >>= 1;
+        --numBits;
+
+        // the bits are unpredictable, so rather than branch on them, they
+        // select the end to stop at and the element to swap with (the
+        // element from the first set is swapped with itself)
+        size_t const mask = static_cast<size_t>(0) - bit;
+        if (j == (i ^ ((i ^ len) & mask))) {
+          break;
+        }
+        size_t const k = i + ((j - i) & mask);
+        T const tmp = set[i];
+        set[i] = set[k];
+        set[k] = tmp;
+        j += bit;
+        ++i;
+      }
+
+      for (; i < len; ++i) {
+        size_t const k = inRange<size_t>(0, i);
+        std::swap(set[i], set[k]);
       }
     }
 
@@ -15,9 +15,12 @@
 
 
 
+#include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <type_traits>
 #include <vector>
-#include "Utility/PrefixSum.hpp"
+#include "Utility/Parallel.hpp"
 
 
 
@@ -29,6 +32,18 @@ namespace MatrixInspector
 class Sort
 {
   public:
+    /**
+     * @brief Stably sort a set of values by their keys, using a parallel
+     * least significant digit radix sort. The keys may be integers or
+     * floating point numbers of up to 64 bits, and are left unmodified.
+     *
+     * @tparam K The key type.
+     * @tparam V The value type.
+     * @param keys The keys.
+     * @param values The values to sort.
+     * @param len The number of keys and values.
+     * @param ascending Whether to sort in ascending or descending order.
+     */
     template<typename K, typename V>
     static void keyValue(
         K const * const keys,
@@ -36,148 +51,264 @@ class Sort
         size_t const len,
         bool ascending = true)
     {
+      static_assert(std::is_arithmetic<K>::value && sizeof(K) <= 8, \
+          "Sort keys must be integers or floats of up to 64 bits.");
+
+      typedef typename radix_struct<K>::type U;
+
       // don't process empty things
       if (len == 0) {
         return;
       }
 
-      // find the range of keys
-      K max = keys[0];
-      K min = keys[0];
-      for (size_t i = 1; i < len; ++i) {
-        if (keys[i] > max) {
-          max = keys[i];
-        } else if (keys[i] < min) {
-          min = keys[i];
+      unsigned const numThreads = Parallel::getNumThreads(len);
+
+      // map the keys to unsigned integers with the same order, and find
+      // which bits vary between them
+      std::vector<U> radixKeys(len);
+      std::vector<U> diffs(numThreads, 0);
+      Parallel::run(numThreads, [&](unsigned const tid) {
+        size_t const start = Parallel::getChunkStart(len, numThreads, tid);
+        size_t const end = Parallel::getChunkStart(len, numThreads, tid+1);
+        U const first = toRadix(keys[0], ascending);
+        U diff = 0;
+        for (size_t i = start; i < end; ++i) {
+          U const radix = toRadix(keys[i], ascending);
+          radixKeys[i] = radix;
+          diff |= radix ^ first;
         }
+        diffs[tid] = diff;
+      });
+
+      U diff = 0;
+      for (U const threadDiff : diffs) {
+        diff |= threadDiff;
       }
 
-      // add one to get the actual range
-      size_t const size = (max - min)+1;
+      // only digits which vary need a pass
+      std::vector<unsigned> shifts;
+      for (unsigned shift = 0; shift < sizeof(U)*8; shift += RADIX_BITS) {
+        if (((diff >> shift) & RADIX_MASK) != 0) {
+          shifts.push_back(shift);
+        }
+      }
 
-      if (std::is_floating_point<K>::value || size > len) {
-        keyValueSmallInteger(keys,values,len,min,max,ascending);
-      } else {
-        keyValueGeneric(keys,values,len,ascending);
+      if (shifts.empty()) {
+        // all keys are equal, so the values are already in order
+        return;
       }
-    }
 
+      std::vector<U> keySwap(len);
+      std::vector<V> valueSwap(len);
+
+      U * srcKeys = radixKeys.data();
+      U * dstKeys = keySwap.data();
+      V * srcValues = values;
+      V * dstValues = valueSwap.data();
+
+      std::vector<size_t> counts(numThreads*NUM_BUCKETS);
+      for (size_t pass = 0; pass < shifts.size(); ++pass) {
+        unsigned const shift = shifts[pass];
+        bool const last = pass+1 == shifts.size();
+
+        Parallel::run(numThreads, [&](unsigned const tid) {
+          size_t const start = Parallel::getChunkStart(len, numThreads, tid);
+          size_t const end = Parallel::getChunkStart(len, numThreads, tid+1);
+          size_t * const myCounts = counts.data() + tid*NUM_BUCKETS;
+          std::fill(myCounts, myCounts+NUM_BUCKETS, 0);
+          for (size_t i = start; i < end; ++i) {
+            ++myCounts[(srcKeys[i] >> shift) & RADIX_MASK];
+          }
+        });
+
+        // each thread's share of a bucket follows the previous thread's,
+        // which keeps the sort stable
+        size_t offset = 0;
+        for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+          for (unsigned tid = 0; tid < numThreads; ++tid) {
+            size_t const count = counts[tid*NUM_BUCKETS+bucket];
+            counts[tid*NUM_BUCKETS+bucket] = offset;
+            offset += count;
+          }
+        }
 
-  private:
-    template <typename K, typename V>
-    struct kv_struct
-    {
-      K k;
-      V v;
+        Parallel::run(numThreads, [&](unsigned const tid) {
+          size_t const start = Parallel::getChunkStart(len, numThreads, tid);
+          size_t const end = Parallel::getChunkStart(len, numThreads, tid+1);
+          scatter(srcKeys, srcValues, start, end, shift, \
+              counts.data() + tid*NUM_BUCKETS, last ? nullptr : dstKeys, \
+              dstValues);
+        });
 
-      bool operator<(
-          const kv_struct & rhs) {
-        return k < rhs.k;
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcValues, dstValues);
       }
-    };
 
-
-    template <typename T>
-    struct compareAscending
-    {
-      bool operator()(
-          T const & lhs,
-          T const & rhs)
-      {
-        return lhs.k < rhs.k;
+      // after an odd number of passes the values are in the swap buffer
+      if (srcValues != values) {
+        Parallel::run(numThreads, [&](unsigned const tid) {
+          size_t const start = Parallel::getChunkStart(len, numThreads, tid);
+          size_t const end = Parallel::getChunkStart(len, numThreads, tid+1);
+          std::copy(srcValues+start, srcValues+end, values+start);
+        });
       }
-    };
+    }
 
 
-    template <typename T>
-    struct compareDescending
+  private:
+    static constexpr unsigned RADIX_BITS = 8;
+    static constexpr size_t NUM_BUCKETS = 1 << RADIX_BITS;
+    static constexpr unsigned RADIX_MASK = NUM_BUCKETS-1;
+    // the size of the per-bucket buffers used to write whole cache lines
+    static constexpr size_t WRITE_COMBINE_BYTES = 64;
+
+
+    /**
+     * @brief The unsigned integer type keys are sorted as.
+     *
+     * @tparam K The key type.
+     */
+    template<typename K>
+    struct radix_struct
     {
-      bool operator()(
-          T const & lhs,
-          T const & rhs)
-      {
-        return lhs.k > rhs.k;
-      }
+      typedef typename std::conditional<sizeof(K) <= 4, uint32_t, \
+          uint64_t>::type type;
     };
 
 
-    template<typename K, typename V>
-    static void keyValueSmallInteger(
-        K const * const keys,
-        V * const values,
-        size_t const len,
-        K const min,
-        K const max,
-        bool ascending)
+    /**
+     * @brief Map a key to an unsigned integer, such that the integers are in
+     * the same order as the keys (or the reverse order if descending).
+     *
+     * @tparam K The key type.
+     * @param key The key.
+     * @param ascending Whether the order is ascending.
+     *
+     * @return The unsigned integer.
+     */
+    template<typename K>
+    static typename radix_struct<K>::type toRadix(
+        K const key,
+        bool const ascending) noexcept
     {
-      K const range = max - min + 1;
+      typedef typename radix_struct<K>::type U;
 
-      // allocate an extra space for prefixsum
-      std::vector<size_t> counts(range+1,0);
+      U const radix = toRadix(key, std::is_floating_point<K>());
 
-      // allocate values swap vector
-      std::vector<V> swap(values,values+len);
-
-      if (ascending) {
-        // avoid having to do offsets in each iteration
-        size_t * const start = counts.data() - static_cast<ptrdiff_t>(min);
+      return ascending ? radix : ~radix;
+    }
 
-        for (size_t i = 0; i < len; ++i) {
-          size_t const bucket = keys[i];
-          ++start[bucket];
-        }
 
-        // find out where our keys and values will go (start)
-        PrefixSum::exclusive(counts.data(),range+1);
+    template<typename K>
+    static typename radix_struct<K>::type toRadix(
+        K const key,
+        std::false_type) noexcept
+    {
+      typedef typename radix_struct<K>::type U;
+      U const sign = static_cast<U>(1) << (sizeof(U)*8-1);
 
-        for (size_t i = 0; i < len; ++i) {
-          size_t const bucket = keys[i];
-          values[start[bucket]++] = swap[i];
-        }
-      } else {
-        for (size_t i = 0; i < len; ++i) {
-          size_t const bucket = max - keys[i];
-          ++counts[bucket];
-        }
+      // signed keys are sign-extended, so flipping the sign bit places the
+      // negative keys before the positive ones
+      U const radix = static_cast<U>(key);
+      return std::is_signed<K>::value ? radix ^ sign : radix;
+    }
 
-        // find out where our keys and values will go (start)
-        PrefixSum::exclusive(counts.data(),range+1);
 
-        for (size_t i = 0; i < len; ++i) {
-          size_t const bucket = max - keys[i];
-          values[counts[bucket]++] = swap[i];
-        }
-      }
+    template<typename K>
+    static typename radix_struct<K>::type toRadix(
+        K const key,
+        std::true_type) noexcept
+    {
+      typedef typename radix_struct<K>::type U;
+      static_assert(sizeof(K) == sizeof(U), \
+          "Floating point keys must be 32 or 64 bits.");
+      U const sign = static_cast<U>(1) << (sizeof(U)*8-1);
+
+      // sort -0 with 0, so that equal keys keep their order
+      K const value = key == 0 ? static_cast<K>(0) : key;
+      U bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+
+      // negative numbers are ordered by decreasing magnitude
+      return (bits & sign) ? ~bits : bits | sign;
     }
 
 
-    template<typename K, typename V>
-    static void keyValueGeneric(
-        K const * const keys,
-        V * const values,
-        size_t const len,
-        bool ascending)
+    /**
+     * @brief Move one thread's chunk of keys and values to their buckets.
+     * Each bucket is staged in a small buffer and written out a cache line at
+     * a time, rather than each element touching a different line.
+     *
+     * @tparam U The radix type.
+     * @tparam V The value type.
+     * @param srcKeys The keys to move.
+     * @param srcValues The values to move.
+     * @param start The start of the chunk.
+     * @param end The end of the chunk.
+     * @param shift The shift of the digit to bucket by.
+     * @param offsets The next position of each of the thread's buckets.
+     * @param dstKeys The destination of the keys (nullptr if they are no
+     * longer needed).
+     * @param dstValues The destination of the values.
+     */
+    template<typename U, typename V>
+    static void scatter(
+        U const * const srcKeys,
+        V const * const srcValues,
+        size_t const start,
+        size_t const end,
+        unsigned const shift,
+        size_t * const offsets,
+        U * const dstKeys,
+        V * const dstValues)
     {
-      std::vector<kv_struct<K,V>> kvs(len);
-
-      // create KVs
-      for (size_t i = 0; i < len; ++i) {
-        kvs[i].k = keys[i];
-        kvs[i].v = values[i];
+      size_t const width = std::max<size_t>(1, \
+          WRITE_COMBINE_BYTES / std::max(sizeof(U), sizeof(V)));
+
+      std::vector<U> keyBuffer(dstKeys != nullptr ? NUM_BUCKETS*width : 0);
+      std::vector<V> valueBuffer(NUM_BUCKETS*width);
+      std::vector<size_t> fill(NUM_BUCKETS, 0);
+
+      for (size_t i = start; i < end; ++i) {
+        size_t const bucket = (srcKeys[i] >> shift) & RADIX_MASK;
+        size_t const slot = bucket*width + fill[bucket];
+        if (dstKeys != nullptr) {
+          keyBuffer[slot] = srcKeys[i];
+        }
+        valueBuffer[slot] = srcValues[i];
+        if (++fill[bucket] == width) {
+          flush(keyBuffer, valueBuffer, bucket, width, offsets, dstKeys, \
+              dstValues);
+          fill[bucket] = 0;
+        }
       }
 
-      if (ascending) {
-        compareAscending<kv_struct<K,V>> comp;
-        std::sort(kvs.begin(),kvs.end(),comp);
-      } else {
-        compareDescending<kv_struct<K,V>> comp;
-        std::sort(kvs.begin(),kvs.end(),comp);
+      for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+        flush(keyBuffer, valueBuffer, bucket, fill[bucket], offsets, \
+            dstKeys, dstValues);
       }
+    }
 
-      // save sorting
-      for (size_t i = 0; i < len; ++i) {
-        values[i] = kvs[i].v;
+
+    template<typename U, typename V>
+    static void flush(
+        std::vector<U> const & keyBuffer,
+        std::vector<V> const & valueBuffer,
+        size_t const bucket,
+        size_t const num,
+        size_t * const offsets,
+        U * const dstKeys,
+        V * const dstValues)
+    {
+      size_t const width = valueBuffer.size() / NUM_BUCKETS;
+      size_t const offset = offsets[bucket];
+      if (dstKeys != nullptr) {
+        std::copy(keyBuffer.begin() + bucket*width, \
+            keyBuffer.begin() + bucket*width + num, dstKeys + offset);
       }
+      std::copy(valueBuffer.begin() + bucket*width, \
+          valueBuffer.begin() + bucket*width + num, dstValues + offset);
+      offsets[bucket] += num;
     }
 
 
@@ -81,6 +81,16 @@ size_t String::count(
 }
 
 
+bool String::endsWith(
+    std::string const & str,
+    std::string const & suffix) noexcept
+{
+  return str.length() >= suffix.length() && \
+      str.compare(str.length() - suffix.length(), suffix.length(), \
+      suffix) == 0;
+}
+
+
 std::string String::toLower(
     std::string const * const str) noexcept
 {
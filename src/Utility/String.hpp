@@ -69,6 +69,19 @@ class String
         std::string const & substr) noexcept;
 
 
+    /**
+     * @brief Check if a string ends with the suffix.
+     *
+     * @param str The string.
+     * @param suffix The suffix.
+     *
+     * @return True if the string ends with the suffix.
+     */
+    static bool endsWith(
+        std::string const & str,
+        std::string const & suffix) noexcept;
+
+
     /**
      * @brief Convert a string to lowercase.
      *
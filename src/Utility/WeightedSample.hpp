@@ -0,0 +1,226 @@
+/**
+ * @file WeightedSample.hpp
+ * @brief The WeightedSample class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_UTILITY_WEIGHTEDSAMPLE_HPP
+#define MATRIXINSPECTOR_UTILITY_WEIGHTEDSAMPLE_HPP
+
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Utility/AliasTable.hpp"
+#include "Utility/Parallel.hpp"
+#include "Utility/Random.hpp"
+#include "Utility/Debug.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/**
+ * @brief Samples of indices drawn with probability proportional to their
+ * weights, such as rows by their number of non-zeros.
+ */
+class WeightedSample
+{
+  public:
+    /**
+     * @brief Draw a sample without replacement, where each draw picks one of
+     * the remaining indices with probability proportional to its weight. The
+     * same seed gives the same sample regardless of the number of threads.
+     *
+     * When the sample is light, such that it takes at most half of the total
+     * weight however it is drawn, indices are drawn from an alias table and
+     * those already drawn are rejected, which takes O(k) draws. Otherwise
+     * each index is given the key -ln(u)/w for a uniform u, and the indices
+     * with the smallest keys are taken (Efraimidis and Spirakis), which gives
+     * the same distribution in a parallel pass.
+     *
+     * @tparam W The weight type.
+     * @tparam T The index type.
+     * @param weights The non-negative weights.
+     * @param len The number of weights.
+     * @param sample The sample (output), in ascending order.
+     * @param sampleLen The size of the sample, which may not be more than the
+     * number of positive weights.
+     * @param seed The seed.
+     */
+    template<typename W, typename T>
+    static void sortedSample(
+        W const * const weights,
+        size_t const len,
+        T * const sample,
+        size_t const sampleLen,
+        uint64_t const seed)
+    {
+      ASSERT_LESSEQUAL(sampleLen,len);
+
+      if (sampleLen == 0) {
+        return;
+      }
+
+      double sum = 0;
+      double max = 0;
+      size_t numPositive = 0;
+      for (size_t i = 0; i < len; ++i) {
+        double const weight = static_cast<double>(weights[i]);
+        if (!(weight >= 0) || std::isinf(weight)) {
+          throw std::runtime_error("Weights must be finite and " \
+              "non-negative.");
+        }
+        sum += weight;
+        max = std::max(max, weight);
+        if (weight > 0) {
+          ++numPositive;
+        }
+      }
+
+      if (numPositive < sampleLen) {
+        throw std::runtime_error("Cannot sample " + \
+            std::to_string(sampleLen) + " with weights, as only " + \
+            std::to_string(numPositive) + " have a positive weight.");
+      }
+
+      if (sampleLen * max <= sum * MAX_REJECTION_WEIGHT) {
+        drawSample(weights, len, sample, sampleLen, seed);
+      } else {
+        keySample(weights, len, sample, sampleLen, seed);
+      }
+    }
+
+
+  private:
+    // the most of the total weight a sample may take to be drawn by rejection
+    static constexpr double MAX_REJECTION_WEIGHT = 0.5;
+
+    // the number of weights given keys from each stream of random numbers
+    static constexpr size_t KEY_BLOCK_SIZE = 1 << 12;
+
+
+    template<typename W, typename T>
+    static void drawSample(
+        W const * const weights,
+        size_t const len,
+        T * const sample,
+        size_t const sampleLen,
+        uint64_t const seed)
+    {
+      AliasTable const table(weights, len);
+      Random rng(seed);
+
+      std::vector<bool> drawn(len, false);
+      size_t numDrawn = 0;
+      while (numDrawn < sampleLen) {
+        size_t const i = table.draw(rng);
+        if (!drawn[i]) {
+          drawn[i] = true;
+          sample[numDrawn++] = static_cast<T>(i);
+        }
+      }
+
+      std::sort(sample, sample+sampleLen);
+    }
+
+
+    template<typename W, typename T>
+    static void keySample(
+        W const * const weights,
+        size_t const len,
+        T * const sample,
+        size_t const sampleLen,
+        uint64_t const seed)
+    {
+      typedef std::pair<double,size_t> key_type;
+
+      // each thread keeps the smallest keys of its blocks, trimming them
+      // whenever it has twice as many as it needs
+      size_t const numBlocks = (len + KEY_BLOCK_SIZE - 1) / KEY_BLOCK_SIZE;
+      unsigned const numThreads = Parallel::getNumThreads(len);
+      std::vector<std::vector<key_type>> smallest(numThreads);
+      Parallel::run(numThreads, [&](unsigned const tid) {
+        std::vector<key_type> & keys = smallest[tid];
+        size_t const limit = 2*sampleLen > KEY_BLOCK_SIZE ? 2*sampleLen : \
+            KEY_BLOCK_SIZE;
+        keys.reserve(limit + KEY_BLOCK_SIZE);
+
+        size_t const first = Parallel::getChunkStart(numBlocks, numThreads, \
+            tid);
+        size_t const last = Parallel::getChunkStart(numBlocks, numThreads, \
+            tid+1);
+        for (size_t block = first; block < last; ++block) {
+          Random rng(seed, block+1);
+          size_t const start = block*KEY_BLOCK_SIZE;
+          size_t const end = std::min(start+KEY_BLOCK_SIZE, len);
+          for (size_t i = start; i < end; ++i) {
+            // every index uses a number, so the rest of the block does not
+            // depend on the weights
+            double const u = rng.uniform();
+            if (weights[i] > 0) {
+              keys.emplace_back(-std::log1p(-u) / weights[i], i);
+            }
+          }
+
+          if (keys.size() > limit) {
+            trim(&keys, sampleLen);
+          }
+        }
+        trim(&keys, sampleLen);
+      });
+
+      std::vector<key_type> keys;
+      for (std::vector<key_type> const & part : smallest) {
+        keys.insert(keys.end(), part.begin(), part.end());
+      }
+      trim(&keys, sampleLen);
+
+      for (size_t i = 0; i < sampleLen; ++i) {
+        sample[i] = static_cast<T>(keys[i].second);
+      }
+      std::sort(sample, sample+sampleLen);
+    }
+
+
+    template<typename K>
+    static void trim(
+        std::vector<K> * const keys,
+        size_t const size)
+    {
+      if (keys->size() > size) {
+        std::nth_element(keys->begin(), keys->begin()+size, keys->end());
+        keys->resize(size);
+      }
+    }
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file Worker.cpp
+ * @brief Implementation of the Worker class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#include <utility>
+#include "Worker.hpp"
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/******************************************************************************
+* CONSTRUCTORS / DESTRUCTOR ***************************************************
+******************************************************************************/
+
+
+Worker::Worker() :
+  m_mutex(),
+  m_posted(),
+  m_idle(),
+  m_jobs(),
+  m_running(false),
+  m_stopping(false),
+  m_thread()
+{
+  // start the thread once everything it uses is ready
+  m_thread = std::thread(&Worker::run, this);
+}
+
+
+Worker::~Worker()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.clear();
+    m_stopping = true;
+  }
+  m_posted.notify_one();
+
+  m_thread.join();
+}
+
+
+
+
+/******************************************************************************
+* PUBLIC FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+void Worker::post(
+    std::function<void ()> job)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.emplace_back(std::move(job));
+  }
+  m_posted.notify_one();
+}
+
+
+void Worker::clear()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.clear();
+  }
+  m_idle.notify_all();
+}
+
+
+void Worker::wait()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle.wait(lock, [this]() {
+    return !m_running && m_jobs.empty();
+  });
+}
+
+
+
+
+/******************************************************************************
+* PRIVATE FUNCTIONS ***********************************************************
+******************************************************************************/
+
+
+void Worker::run()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_posted.wait(lock, [this]() {
+      return m_stopping || !m_jobs.empty();
+    });
+    if (m_stopping) {
+      break;
+    }
+
+    std::function<void ()> job(std::move(m_jobs.front()));
+    m_jobs.pop_front();
+    m_running = true;
+
+    lock.unlock();
+    try {
+      job();
+    } catch (...) {
+      // the job failed, but those after it may not
+    }
+    lock.lock();
+
+    m_running = false;
+    m_idle.notify_all();
+  }
+
+  m_idle.notify_all();
+}
+
+
+
+
+}
@@ -0,0 +1,106 @@
+/**
+ * @file Worker.hpp
+ * @brief The Worker class.
+ * @author Dominique LaSalle <dominique@solidlake.com>
+ * Copyright 2018
+ * @version 1
+ */
+
+
+
+
+#ifndef MATRIXINSPECTOR_UTILITY_WORKER_HPP
+#define MATRIXINSPECTOR_UTILITY_WORKER_HPP
+
+
+
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+
+
+namespace MatrixInspector
+{
+
+
+/**
+ * @brief A background thread which runs jobs one at a time in the order they
+ * are posted. Jobs which have not started can be dropped when newer ones make
+ * them stale, while a running job must watch for its own cancellation.
+ */
+class Worker
+{
+  public:
+    /**
+     * @brief Start the thread.
+     */
+    Worker();
+
+
+    /**
+     * @brief Drop the jobs which have not started, and wait for the running
+     * one to finish before stopping the thread.
+     */
+    ~Worker();
+
+
+    /**
+     * @brief Add a job to run after those already posted. An exception thrown
+     * by a job is discarded, so that the jobs after it still run.
+     *
+     * @param job The job.
+     */
+    void post(
+        std::function<void ()> job);
+
+
+    /**
+     * @brief Drop the jobs which have not started.
+     */
+    void clear();
+
+
+    /**
+     * @brief Wait until no job is running and none are left to start.
+     */
+    void wait();
+
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_posted;
+    std::condition_variable m_idle;
+    std::deque<std::function<void ()>> m_jobs;
+    bool m_running;
+    bool m_stopping;
+    std::thread m_thread;
+
+
+    void run();
+
+
+    // disable copying
+    Worker(
+        Worker const & rhs);
+    Worker & operator=(
+        Worker const & rhs);
+
+
+
+
+};
+
+
+
+
+}
+
+
+
+
+#endif
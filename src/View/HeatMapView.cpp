@@ -9,10 +9,16 @@
 
 
 
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
 #include <GL/gl.h>
-#include <GL/glu.h>
 #include "HeatMapView.hpp"
 #include "Data/CSRMatrix.hpp"
+#include "Operations/Raster.hpp"
 #include "Utility/Debug.hpp"
 
 
@@ -36,6 +42,65 @@ GLuint const NULL_TEXTURE = static_cast<GLuint>(-1);
 
 double const MIN_ZOOM = 0.8f;
 
+// the width and height of each tile in pixels
+dim_type const TILE_SIZE = 256;
+
+size_t const TILE_BYTES = TILE_SIZE * TILE_SIZE * sizeof(uint32_t);
+
+// the most texture memory kept for tiles which have been drawn
+size_t const MAX_TILE_BYTES = 256 * 1024 * 1024;
+
+// the deepest level of tiles, where each pixel covers 2^level rows and
+// columns
+unsigned const MAX_LEVEL = 31;
+
+// about the number of non-zeros counted for the first, rough heat map
+index_type const FIRST_SAMPLE_NONZEROS = 1 << 22;
+
+// how much denser each sample of rows is than the last
+dim_type const REFINE_FACTOR = 4;
+
+// the field of the status bar of the main window left for the view
+int const STATUS_FIELD = 2;
+
+}
+
+
+
+
+/******************************************************************************
+* HELPER FUNCTIONS ************************************************************
+******************************************************************************/
+
+
+namespace
+{
+
+
+/**
+* @brief Get the stride of the rows of the first sample of a matrix, which
+* has about a fixed number of non-zeros, but skips no more rows than there are
+* in a pixel row, so that each pixel row has a sampled row.
+*
+* @param matrix The matrix.
+* @param scale The number of pixels per row.
+*
+* @return The stride.
+*/
+dim_type getFirstStride(
+    CSRMatrix const & matrix,
+    float const scale)
+{
+  uint64_t stride = 1;
+  while ((stride * REFINE_FACTOR) * scale <= 1.0f && \
+      matrix.getNumNonZeros() / stride > FIRST_SAMPLE_NONZEROS) {
+    stride *= REFINE_FACTOR;
+  }
+
+  return static_cast<dim_type>(stride);
+}
+
+
 }
 
 
@@ -45,6 +110,8 @@ double const MIN_ZOOM = 0.8f;
 ******************************************************************************/
 
 wxBEGIN_EVENT_TABLE(HeatMapView, View)
+  EVT_LEFT_DOWN(HeatMapView::onMouseDown)
+  EVT_LEFT_UP(HeatMapView::onMouseUp)
   EVT_MOTION(HeatMapView::onMouseMove)
   EVT_MOUSEWHEEL(HeatMapView::onWheel)
   EVT_CHAR(HeatMapView::onKey)
@@ -58,12 +125,35 @@ wxEND_EVENT_TABLE()
 HeatMapView::HeatMapView(
     wxFrame * const parent) :
   View(parent),
-  m_heatmap(),
+  m_frame(parent),
+  m_levels(std::make_shared<std::vector<HeatMap> const>(1)),
+  m_colorMap(),
+  m_pooling(HeatMap::SUM_POOL),
+  m_mode(HeatMap::COUNT_MODE),
   m_glTexture(NULL_TEXTURE),
+  m_overviewScale(0),
+  m_overviewStride(0),
+  m_regions(),
+  m_suspended(false),
+  m_suspendedRows(0),
+  m_suspendedCols(0),
+  m_selecting(false),
+  m_selected(false),
+  m_selectStart(0,0),
+  m_selectEnd(0,0),
+  m_tiles(MAX_TILE_BYTES, [](GLuint & texture) {
+    glDeleteTextures(1, &texture);
+  }),
+  m_pendingTiles(),
+  m_epoch(0),
+  m_tileEpoch(0),
+  m_cancel(std::make_shared<std::atomic<bool>>(false)),
+  m_cancelTiles(std::make_shared<std::atomic<bool>>(false)),
   m_mousePos(0,0),
   m_zoom(1.0f),
   m_originX(0),
-  m_originY(0)
+  m_originY(0),
+  m_worker()
 {
   // do nothing
 }
@@ -72,6 +162,9 @@ HeatMapView::HeatMapView(
 
 HeatMapView::~HeatMapView()
 {
+  // the matrix may already be gone, so is not suspended on
+  stopJobs();
+  m_worker.wait();
   releaseTexture();
 }
 
@@ -89,73 +182,89 @@ void HeatMapView::refresh()
   m_zoom = 1.0;
   m_originX = 0;
   m_originY = 0;
+  m_selecting = false;
+  m_selected = false;
 
-  Matrix const * matrix = getMatrix();
-
-  if (matrix == nullptr) {
-    // nothing to refresh
-    return;
-  }
+  count();
+}
 
-  dim_type const hPixels = std::sqrt( \
-      TARGET_PIXELS * \
-      (static_cast<float>(matrix->getNumRows()) / \
-      static_cast<float>(matrix->getNumColumns())));
-  dim_type const wPixels = std::ceil(TARGET_PIXELS / hPixels);
 
-  float const conv = static_cast<float>(hPixels) / \
-      static_cast<float>(matrix->getNumRows());
+void HeatMapView::cancel()
+{
+  stopJobs();
+  m_worker.wait();
 
-  m_heatmap.resize(wPixels, hPixels);
+  Matrix const * const matrix = getMatrix();
+  if (!m_suspended && matrix != nullptr) {
+    m_suspendedRows = matrix->getNumRows();
+    m_suspendedCols = matrix->getNumColumns();
+  }
+  m_suspended = true;
+
+  // nothing more is taken from the matrix until it is counted again
+  m_tiles.clear();
+  m_overviewScale = 0;
+  m_overviewStride = 0;
+  m_regions.reset();
+  m_selecting = false;
+  m_selected = false;
+}
 
-  ASSERT_LESSEQUAL(static_cast<dim_type>(matrix->getNumRows()*conv),hPixels);
-  ASSERT_LESSEQUAL(static_cast<dim_type>(matrix->getNumColumns()*conv), \
-      wPixels);
 
-  CSRMatrix const * csrPtr;
+void HeatMapView::setColorMap(
+    ColorMap const & colorMap)
+{
+  m_colorMap = colorMap;
+
+  // tiles of the old colors are stale
+  ++m_tileEpoch;
+  m_cancelTiles->store(true);
+  m_cancelTiles = std::make_shared<std::atomic<bool>>(false);
+  m_pendingTiles.clear();
+  m_tiles.clear();
+
+  // an overview still being counted is colored again when it arrives
+  if (getMatrix() != nullptr && m_overviewScale > 0) {
+    updateTexture(Raster::colorLevels(*m_levels, getColors()));
+    render();
+  }
+}
 
-  // fill heat map
-  if ((csrPtr = dynamic_cast<CSRMatrix const *>(matrix)) != nullptr) {
-    dim_type const numRows = csrPtr->getNumRows();
 
-    index_type const * const offsets = csrPtr->getOffsets();
-    dim_type const * const columns = csrPtr->getColumns();
+void HeatMapView::setPooling(
+    HeatMap::pool_type const pooling)
+{
+  m_pooling = pooling;
 
-    for (dim_type row = 0; row < numRows; ++row) {
-      for (index_type idx = offsets[row]; idx < offsets[row+1]; ++idx) {
-        dim_type const column = columns[idx];
-        dim_type const x = column * conv;
-        ASSERT_LESS(x, wPixels);
-        dim_type const y = row * conv;
-        ASSERT_LESS(y, hPixels);
+  // an overview still being counted is pooled again when it arrives
+  if (getMatrix() != nullptr && m_overviewScale > 0) {
+    std::shared_ptr<std::vector<HeatMap>> const levels = \
+        std::make_shared<std::vector<HeatMap>>(1, m_levels->front());
+    Raster::buildLevels(levels.get(), m_pooling);
+    m_levels = levels;
 
-        m_heatmap.add(x,y);
-      }
-    }
-  }
-  m_heatmap.normalize();
-
-  // generate texture
-  std::vector<uint32_t> pixels(m_heatmap.getWidth()*m_heatmap.getHeight());
-  size_t const numPixels = m_heatmap.getValues()->size();
-  value_type const * const values = m_heatmap.getValues()->data(); 
-  for (size_t i = 0; i < numPixels; ++i) {
-    pixels[i] = HeatMap::floatToRGBA(values[i]);
+    updateTexture(Raster::colorLevels(*m_levels, getColors()));
+    render();
   }
+}
 
-  // setup opengl texture
-  glGenTextures(1,&m_glTexture);
-  glBindTexture(GL_TEXTURE_2D,m_glTexture);
 
-  glTexImage2D(GL_TEXTURE_2D, 0, 4, m_heatmap.getWidth(),
-      m_heatmap.getHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+void HeatMapView::setMode(
+    HeatMap::mode_type const mode)
+{
+  if (mode == m_mode) {
+    return;
+  }
+  m_mode = mode;
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, \
-			GL_NEAREST_MIPMAP_LINEAR);
-	//glGenerateMipmap(GL_TEXTURE_2D); on 3.0
-	gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGBA, m_heatmap.getWidth(), \
-			m_heatmap.getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+  if (m_suspended) {
+    // counted in the new mode once the view is refreshed
+    return;
+  }
+
+  // the old heat map is shown, where it is zoomed to, until the first sample
+  // of the new one arrives
+  count();
 }
 
 
@@ -167,54 +276,68 @@ void HeatMapView::refresh()
 
 void HeatMapView::draw()
 {
-  Matrix const * matrix = getMatrix();
-
-  if (matrix != nullptr) {
-    dim_type const maxDim = std::max(
-        matrix->getNumRows(),
-        matrix->getNumColumns());
-
-    float const width = matrix->getNumColumns() / static_cast<float>(maxDim);
-    float const height = matrix->getNumRows() / static_cast<float>(maxDim);
-
-    glPushMatrix();
+  if (m_suspended) {
+    // the matrix is being changed, so only the overview of it is drawn
+    if (m_glTexture != NULL_TEXTURE && m_suspendedRows > 0) {
+      drawRect(m_glTexture, 0, 0, m_suspendedCols, m_suspendedRows, 1.0f, \
+          1.0f);
+    }
+    return;
+  }
 
-    glScalef(m_zoom,m_zoom,1.0f);
+  Matrix const * matrix = getMatrix();
 
-    float const xTrans = m_originX *getGLWidth() / GetSize().x;
-    float const yTrans = -m_originY *getGLHeight() / GetSize().y;
+  if (matrix != nullptr && m_glTexture != NULL_TEXTURE) {
+    drawRect(m_glTexture, 0, 0, matrix->getNumColumns(), \
+        matrix->getNumRows(), 1.0f, 1.0f);
 
-    glTranslatef(xTrans,yTrans,0.0f);
+    CSRMatrix const * csrPtr;
+    if ((csrPtr = dynamic_cast<CSRMatrix const *>(matrix)) != nullptr) {
+      drawTiles(*csrPtr);
+    }
 
-    glBindTexture(GL_TEXTURE_2D,m_glTexture);
+    if (m_selecting || m_selected) {
+      drawSelection();
+    }
+  }
+}
 
-    glBegin(GL_TRIANGLES);
 
-    glTexCoord2f(0.0f,1.0f);
-    glVertex3f(-0.5f*width,-0.5f*height,0.0f);
-    glTexCoord2f(1.0f,1.0f);
-    glVertex3f(0.5f*width,-0.5f*height,0.0f);
-    glTexCoord2f(1.0f,0.0f);
-    glVertex3f(0.5f*width,0.5f*height,0.0f);
 
-    glTexCoord2f(0.0f,1.0f);
-    glVertex3f(-0.5f*width,-0.5f*height,0.0f);
-    glTexCoord2f(1.0f,0.0f);
-    glVertex3f(0.5f*width,0.5f*height,0.0f);
-    glTexCoord2f(0.0f,0.0f);
-    glVertex3f(-0.5f*width,0.5f*height,0.0f);
+/******************************************************************************
+* PRIVATE FUNCTIONS ***********************************************************
+******************************************************************************/
 
-    glEnd();
 
-    glPopMatrix();
+void HeatMapView::onMouseDown(
+    wxMouseEvent& event)
+{
+  // dragging with shift held selects a region rather than moving the view
+  if (event.ShiftDown() && !m_suspended && getMatrix() != nullptr) {
+    m_selecting = true;
+    m_selected = false;
+    m_selectStart = wxRealPoint(getCol(event.GetX()), getRow(event.GetY()));
+    m_selectEnd = m_selectStart;
+    showSelection(false);
+    render();
   }
+
+  event.Skip();
 }
 
 
+void HeatMapView::onMouseUp(
+    wxMouseEvent& event)
+{
+  if (m_selecting) {
+    m_selecting = false;
+    m_selected = true;
+    showSelection(true);
+    render();
+  }
 
-/******************************************************************************
-* PRIVATE FUNCTIONS ***********************************************************
-******************************************************************************/
+  event.Skip();
+}
 
 
 void HeatMapView::onMouseMove(
@@ -222,9 +345,13 @@ void HeatMapView::onMouseMove(
 {
   wxPoint const newPos = event.GetPosition();
 
-  if (event.Dragging()) {
-    float const deltaX = newPos.x - m_mousePos.x;
-    float const deltaY = newPos.y - m_mousePos.y;
+  if (m_selecting && event.Dragging()) {
+    m_selectEnd = wxRealPoint(getCol(newPos.x), getRow(newPos.y));
+    showSelection(false);
+    render();
+  } else if (event.Dragging()) {
+    double const deltaX = newPos.x - m_mousePos.x;
+    double const deltaY = newPos.y - m_mousePos.y;
 
     m_originX += (deltaX/m_zoom);
     m_originY += (deltaY/m_zoom);
@@ -255,7 +382,7 @@ void HeatMapView::onWheel(
     wxMouseEvent& event)
 {
   m_zoom = std::max(MIN_ZOOM, \
-      m_zoom * (1.0 + (static_cast<float>(event.GetWheelRotation())/1000.0)));
+      m_zoom * (1.0 + (static_cast<double>(event.GetWheelRotation())/1000.0)));
 
   render();
 }
@@ -271,4 +398,558 @@ void HeatMapView::releaseTexture()
 }
 
 
+void HeatMapView::updateTexture(
+    std::vector<std::vector<uint32_t>> const & pixels)
+{
+  releaseTexture();
+
+  // setup opengl texture
+  glGenTextures(1,&m_glTexture);
+  glBindTexture(GL_TEXTURE_2D,m_glTexture);
+
+  // each level was pooled and colored by the worker, rather than scaled to
+  // powers of two and averaged in color
+  for (size_t level = 0; level < pixels.size(); ++level) {
+    HeatMap const & heatmap = (*m_levels)[level];
+    glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), 4, \
+        heatmap.getWidth(), heatmap.getHeight(), 0, GL_RGBA, \
+        GL_UNSIGNED_BYTE, pixels[level].data());
+  }
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  // blending between levels would average their colors
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, \
+			GL_NEAREST_MIPMAP_NEAREST);
+}
+
+
+void HeatMapView::stopJobs()
+{
+  ++m_epoch;
+  ++m_tileEpoch;
+  m_cancel->store(true);
+  m_cancel = std::make_shared<std::atomic<bool>>(false);
+  m_cancelTiles->store(true);
+  m_cancelTiles = std::make_shared<std::atomic<bool>>(false);
+  m_pendingTiles.clear();
+  m_worker.clear();
+}
+
+
+ColorMap HeatMapView::getColors() const
+{
+  return Raster::getColorMap(m_colorMap, m_mode);
+}
+
+
+void HeatMapView::count()
+{
+  // the work for the old matrix is stale, but need not be waited on, as it
+  // is only read
+  stopJobs();
+  m_suspended = false;
+  m_tiles.clear();
+  m_overviewScale = 0;
+  m_overviewStride = 0;
+  m_regions.reset();
+  m_frame->SetStatusText("", STATUS_FIELD);
+
+  Matrix const * matrix = getMatrix();
+
+  if (matrix == nullptr) {
+    // nothing to refresh
+    return;
+  }
+
+  Raster::size_struct const size = Raster::fitArea(matrix->getNumRows(), \
+      matrix->getNumColumns(), TARGET_PIXELS);
+  dim_type const hPixels = size.height;
+  dim_type const wPixels = size.width;
+  float const conv = size.scale;
+
+  ASSERT_LESSEQUAL(static_cast<dim_type>(matrix->getNumRows()*conv),hPixels);
+  ASSERT_LESSEQUAL(static_cast<dim_type>(matrix->getNumColumns()*conv), \
+      wPixels);
+
+  CSRMatrix const * const csrPtr = dynamic_cast<CSRMatrix const *>(matrix);
+
+  // fill and color the heat map in the background from progressively denser
+  // samples of the rows, and hand the pixels of each back to this thread to
+  // be uploaded
+  uint64_t const epoch = m_epoch;
+  std::shared_ptr<std::atomic<bool>> const cancel = m_cancel;
+  ColorMap const colorMap = getColors();
+  HeatMap::pool_type const pooling = m_pooling;
+  HeatMap::mode_type const mode = m_mode;
+  m_worker.post([this, csrPtr, wPixels, hPixels, conv, epoch, cancel, \
+      colorMap, pooling, mode]() {
+    HeatMap::sample_struct sample{};
+    dim_type stride = csrPtr != nullptr ? getFirstStride(*csrPtr, conv) : 1;
+    while (true) {
+      std::shared_ptr<std::vector<HeatMap>> const levels = \
+          std::make_shared<std::vector<HeatMap>>();
+      levels->emplace_back(wPixels, hPixels);
+      levels->front().setMode(mode);
+      if (csrPtr != nullptr) {
+        levels->front().countNonZeros(*csrPtr, conv, stride, &sample, \
+            cancel.get());
+      }
+      if (cancel->load()) {
+        return;
+      }
+
+      Raster::buildLevels(levels.get(), pooling);
+      std::shared_ptr<std::vector<std::vector<uint32_t>>> const pixels = \
+          std::make_shared<std::vector<std::vector<uint32_t>>>( \
+          Raster::colorLevels(*levels, colorMap));
+
+      CallAfter([this, epoch, levels, conv, stride, pooling, colorMap, \
+          pixels]() {
+        setOverview(epoch, levels, conv, stride, pooling, colorMap, *pixels);
+      });
+
+      if (stride == 1) {
+        break;
+      }
+      stride /= REFINE_FACTOR;
+    }
+
+    // sum the regions of the exact overview, so that selections can be
+    // counted as they are dragged
+    if (csrPtr != nullptr) {
+      std::shared_ptr<RegionTable> const regions = \
+          std::make_shared<RegionTable>();
+      if (!regions->build(*csrPtr, conv, wPixels, hPixels, cancel.get())) {
+        return;
+      }
+
+      CallAfter([this, epoch, regions]() {
+        setRegions(epoch, regions);
+      });
+    }
+  });
+}
+
+
+void HeatMapView::setOverview(
+    uint64_t const epoch,
+    std::shared_ptr<std::vector<HeatMap> const> const & levels,
+    float const scale,
+    dim_type const stride,
+    HeatMap::pool_type const pooling,
+    ColorMap const & colorMap,
+    std::vector<std::vector<uint32_t>> const & pixels)
+{
+  if (epoch != m_epoch) {
+    // the matrix has changed since
+    return;
+  }
+
+  m_levels = levels;
+  m_overviewScale = scale;
+  m_overviewStride = stride;
+
+  if (stride > 1) {
+    std::ostringstream status;
+    status << "Heat map of " << std::setprecision(3) << (100.0 / stride) << \
+        "% of rows";
+    m_frame->SetStatusText(status.str(), STATUS_FIELD);
+  } else {
+    m_frame->SetStatusText("", STATUS_FIELD);
+  }
+
+  // the pooling or colors may have changed since
+  if (pooling != m_pooling) {
+    setPooling(m_pooling);
+  } else if (colorMap.getType() != getColors().getType() || \
+      colorMap.getScale() != getColors().getScale()) {
+    updateTexture(Raster::colorLevels(*m_levels, getColors()));
+    render();
+  } else {
+    updateTexture(pixels);
+    render();
+  }
+}
+
+
+void HeatMapView::setRegions(
+    uint64_t const epoch,
+    std::shared_ptr<RegionTable const> const & regions)
+{
+  if (epoch != m_epoch) {
+    // the matrix has changed since
+    return;
+  }
+
+  m_regions = regions;
+
+  if (m_selecting || m_selected) {
+    showSelection(!m_selecting);
+  }
+}
+
+
+HeatMapView::selection_struct HeatMapView::getSelection(
+    Matrix const & matrix) const
+{
+  double const numRows = matrix.getNumRows();
+  double const numCols = matrix.getNumColumns();
+
+  // the rows and columns any part of which is selected
+  double const firstRow = std::min(m_selectStart.y, m_selectEnd.y);
+  double const lastRow = std::max(m_selectStart.y, m_selectEnd.y);
+  double const firstCol = std::min(m_selectStart.x, m_selectEnd.x);
+  double const lastCol = std::max(m_selectStart.x, m_selectEnd.x);
+
+  return selection_struct{ \
+      static_cast<dim_type>(std::min(numRows, std::max(0.0, \
+          std::floor(firstRow)))), \
+      static_cast<dim_type>(std::min(numCols, std::max(0.0, \
+          std::floor(firstCol)))), \
+      static_cast<dim_type>(std::min(numRows, std::max(0.0, \
+          std::ceil(lastRow)))), \
+      static_cast<dim_type>(std::min(numCols, std::max(0.0, \
+          std::ceil(lastCol))))};
+}
+
+
+void HeatMapView::showSelection(
+    bool const exact)
+{
+  if (m_suspended) {
+    return;
+  }
+
+  Matrix const * const matrix = getMatrix();
+  selection_struct const selection = getSelection(*matrix);
+  dim_type const numRows = selection.rowEnd - selection.rowStart;
+  dim_type const numCols = selection.colEnd - selection.colStart;
+
+  std::ostringstream status;
+  status << "Selected " << numRows << " x " << numCols;
+
+  CSRMatrix const * const csrPtr = dynamic_cast<CSRMatrix const *>(matrix);
+  if (m_regions != nullptr && csrPtr != nullptr && numRows > 0 && \
+      numCols > 0) {
+    RegionTable::region_struct region;
+    if (exact) {
+      region = m_regions->query(*csrPtr, selection.rowStart, \
+          selection.colStart, selection.rowEnd, selection.colEnd);
+    } else {
+      // the pixels which any part of the selection falls in
+      float const scale = m_regions->getScale();
+      region = m_regions->queryPixels( \
+          static_cast<dim_type>(selection.rowStart * scale), \
+          static_cast<dim_type>(selection.colStart * scale), \
+          static_cast<dim_type>((selection.rowEnd - 1) * scale) + 1, \
+          static_cast<dim_type>((selection.colEnd - 1) * scale) + 1);
+      status << " (about)";
+    }
+
+    double const area = static_cast<double>(numRows) * numCols;
+    status << ": " << region.count << " non-zeros, density " << \
+        std::setprecision(3) << (region.count / area) << ", sum " << \
+        std::setprecision(6) << region.sum;
+  }
+
+  m_frame->SetStatusText(status.str(), STATUS_FIELD);
+}
+
+
+void HeatMapView::drawSelection()
+{
+  selection_struct const selection = getSelection(*getMatrix());
+  double const left = getX(selection.colStart);
+  double const right = getX(selection.colEnd);
+  double const top = getY(selection.rowStart);
+  double const bottom = getY(selection.rowEnd);
+
+  glDisable(GL_TEXTURE_2D);
+  glColor3f(0.0f, 1.0f, 1.0f);
+
+  glBegin(GL_LINE_LOOP);
+  glVertex2d(left,top);
+  glVertex2d(right,top);
+  glVertex2d(right,bottom);
+  glVertex2d(left,bottom);
+  glEnd();
+
+  // textures are modulated by the color
+  glColor3f(1.0f, 1.0f, 1.0f);
+  glEnable(GL_TEXTURE_2D);
+}
+
+
+double HeatMapView::getCol(
+    int const x) const
+{
+  Matrix const * matrix = getMatrix();
+  double const maxDim = std::max(matrix->getNumRows(), \
+      matrix->getNumColumns());
+  double const xTrans = m_originX * getGLWidth() / GetSize().x;
+  double const glX = ((static_cast<double>(x) / GetSize().x) - 0.5) * \
+      getGLWidth();
+
+  return (((glX / m_zoom) - xTrans) * maxDim) + (0.5 * matrix->getNumColumns());
+}
+
+
+double HeatMapView::getRow(
+    int const y) const
+{
+  Matrix const * matrix = getMatrix();
+  double const maxDim = std::max(matrix->getNumRows(), \
+      matrix->getNumColumns());
+  double const yTrans = -m_originY * getGLHeight() / GetSize().y;
+  double const glY = (0.5 - (static_cast<double>(y) / GetSize().y)) * \
+      getGLHeight();
+
+  return (0.5 * matrix->getNumRows()) - (((glY / m_zoom) - yTrans) * maxDim);
+}
+
+
+double HeatMapView::getX(
+    double const col) const
+{
+  Matrix const * matrix = getMatrix();
+  double const maxDim = std::max(matrix->getNumRows(), \
+      matrix->getNumColumns());
+  double const xTrans = m_originX * getGLWidth() / GetSize().x;
+
+  return m_zoom * (((col - (0.5 * matrix->getNumColumns())) / maxDim) + \
+      xTrans);
+}
+
+
+double HeatMapView::getY(
+    double const row) const
+{
+  Matrix const * matrix = getMatrix();
+  double const maxDim = std::max(matrix->getNumRows(), \
+      matrix->getNumColumns());
+  double const yTrans = -m_originY * getGLHeight() / GetSize().y;
+
+  return m_zoom * ((((0.5 * matrix->getNumRows()) - row) / maxDim) + yTrans);
+}
+
+
+void HeatMapView::drawRect(
+    GLuint const texture,
+    double const firstCol,
+    double const firstRow,
+    double const lastCol,
+    double const lastRow,
+    float const texWidth,
+    float const texHeight)
+{
+  // positions are found in double precision, as deep zooms would lose the
+  // edges of tiles to rounding in the float transforms of opengl
+  double const left = getX(firstCol);
+  double const right = getX(lastCol);
+  double const top = getY(firstRow);
+  double const bottom = getY(lastRow);
+
+  glBindTexture(GL_TEXTURE_2D,texture);
+
+  glBegin(GL_TRIANGLES);
+
+  glTexCoord2f(0.0f,texHeight);
+  glVertex2d(left,bottom);
+  glTexCoord2f(texWidth,texHeight);
+  glVertex2d(right,bottom);
+  glTexCoord2f(texWidth,0.0f);
+  glVertex2d(right,top);
+
+  glTexCoord2f(0.0f,texHeight);
+  glVertex2d(left,bottom);
+  glTexCoord2f(texWidth,0.0f);
+  glVertex2d(right,top);
+  glTexCoord2f(0.0f,0.0f);
+  glVertex2d(left,top);
+
+  glEnd();
+}
+
+
+void HeatMapView::drawTiles(
+    CSRMatrix const & matrix)
+{
+  // the overview has a pixel for every row and column of small matrices, and
+  // tiles are colored on its scale, so must wait for it to be exact
+  if (m_suspended || m_overviewScale >= 1.0f || m_overviewStride != 1) {
+    return;
+  }
+
+  dim_type const numRows = matrix.getNumRows();
+  dim_type const numCols = matrix.getNumColumns();
+  double const maxDim = std::max(numRows, numCols);
+
+  // the overview is enough until one of its pixels covers more than one of
+  // the screen
+  double const perPixel = (getGLWidth() / GetSize().x) * maxDim / m_zoom;
+  if (perPixel * m_overviewScale >= 1.0) {
+    return;
+  }
+
+  // use the coarsest tiles with at least one pixel per screen pixel
+  unsigned level = 0;
+  while (level < MAX_LEVEL && static_cast<double>(2ULL << level) <= perPixel) {
+    ++level;
+  }
+  uint64_t const span = static_cast<uint64_t>(TILE_SIZE) << level;
+
+  // find the rows and columns on the screen
+  double const xTrans = m_originX * getGLWidth() / GetSize().x;
+  double const yTrans = -m_originY * getGLHeight() / GetSize().y;
+  double const halfWidth = getGLWidth() / (2.0 * m_zoom);
+  double const halfHeight = getGLHeight() / (2.0 * m_zoom);
+
+  double const firstCol = std::max(0.0, \
+      ((-halfWidth - xTrans) * maxDim) + (0.5 * numCols));
+  double const lastCol = std::min(static_cast<double>(numCols), \
+      ((halfWidth - xTrans) * maxDim) + (0.5 * numCols));
+  double const firstRow = std::max(0.0, \
+      (0.5 * numRows) - ((halfHeight - yTrans) * maxDim));
+  double const lastRow = std::min(static_cast<double>(numRows), \
+      (0.5 * numRows) - ((-halfHeight - yTrans) * maxDim));
+
+  if (firstCol >= lastCol || firstRow >= lastRow) {
+    return;
+  }
+
+  uint64_t const firstTileRow = static_cast<uint64_t>(firstRow) / span;
+  uint64_t const lastTileRow = static_cast<uint64_t>(std::ceil(lastRow));
+  uint64_t const firstTileCol = static_cast<uint64_t>(firstCol) / span;
+  uint64_t const lastTileCol = static_cast<uint64_t>(std::ceil(lastCol));
+
+  std::vector<tile_struct> missing;
+  bool requested = true;
+  for (uint64_t tileRow = firstTileRow; tileRow * span < lastTileRow; \
+      ++tileRow) {
+    for (uint64_t tileCol = firstTileCol; tileCol * span < lastTileCol; \
+        ++tileCol) {
+      uint64_t const rowStart = tileRow * span;
+      uint64_t const colStart = tileCol * span;
+
+      // tiles start on multiples of their span, so at most 24 bits of each
+      // index remain
+      tile_struct const tile{(static_cast<uint64_t>(level) << 58) | \
+          (tileRow << 29) | tileCol, static_cast<dim_type>(rowStart), \
+          static_cast<dim_type>(colStart)};
+
+      GLuint const * const texture = m_tiles.get(tile.key);
+      if (texture == nullptr) {
+        // the overview shows through until the tile arrives
+        missing.emplace_back(tile);
+        requested = requested && m_pendingTiles.count(tile.key) > 0;
+        continue;
+      }
+
+      // tiles past the edges of the matrix are cut off at them
+      uint64_t const rowEnd = std::min(rowStart + span, \
+          static_cast<uint64_t>(numRows));
+      uint64_t const colEnd = std::min(colStart + span, \
+          static_cast<uint64_t>(numCols));
+
+      drawRect(*texture, colStart, rowStart, colEnd, rowEnd, \
+          static_cast<float>(colEnd - colStart) / span, \
+          static_cast<float>(rowEnd - rowStart) / span);
+    }
+  }
+
+  if (!requested) {
+    requestTiles(matrix, level, missing);
+  }
+}
+
+
+void HeatMapView::requestTiles(
+    CSRMatrix const & matrix,
+    unsigned const level,
+    std::vector<tile_struct> const & tiles)
+{
+  if (m_suspended) {
+    // the matrix is being changed
+    return;
+  }
+
+  // the tiles which were requested before and are still being rasterized
+  // are no longer on the screen
+  m_cancelTiles->store(true);
+  m_cancelTiles = std::make_shared<std::atomic<bool>>(false);
+  m_pendingTiles.clear();
+
+  // only tile jobs can be waiting, as the overview has arrived
+  m_worker.clear();
+
+  for (tile_struct const & tile : tiles) {
+    m_pendingTiles.emplace(tile.key);
+  }
+
+  // color the tiles on the scale of the overview, by the density of the
+  // non-zeros, so that they match the pixels around them
+  HeatMap const & overview = m_levels->front();
+  value_type const max = Raster::getRegionMax(std::max( \
+      std::fabs(overview.getMin()), std::fabs(overview.getMax())), \
+      m_overviewScale, level, m_mode);
+
+  CSRMatrix const * const csrPtr = &matrix;
+  uint64_t const epoch = m_tileEpoch;
+  std::shared_ptr<std::atomic<bool>> const cancel = m_cancelTiles;
+  ColorMap const colorMap = getColors();
+  HeatMap::mode_type const mode = m_mode;
+  m_worker.post([this, csrPtr, level, tiles, max, epoch, cancel, \
+      colorMap, mode]() {
+    for (tile_struct const & tile : tiles) {
+      if (cancel->load()) {
+        return;
+      }
+
+      HeatMap heatmap(TILE_SIZE, TILE_SIZE);
+      heatmap.setMode(mode);
+      heatmap.countNonZeros(*csrPtr, tile.firstRow, tile.firstCol, level);
+
+      std::shared_ptr<std::vector<uint32_t>> const pixels = \
+          std::make_shared<std::vector<uint32_t>>(heatmap.getValues()->size());
+      colorMap.apply(heatmap.getValues()->data(), pixels->size(), 0, max, \
+          pixels->data());
+
+      uint64_t const key = tile.key;
+      CallAfter([this, epoch, key, pixels]() {
+        addTile(epoch, key, *pixels);
+      });
+    }
+  });
+}
+
+
+void HeatMapView::addTile(
+    uint64_t const epoch,
+    uint64_t const key,
+    std::vector<uint32_t> const & pixels)
+{
+  if (epoch != m_tileEpoch) {
+    // the matrix or colors have changed since
+    return;
+  }
+
+  m_pendingTiles.erase(key);
+
+  GLuint texture;
+  glGenTextures(1,&texture);
+  glBindTexture(GL_TEXTURE_2D,texture);
+
+  glTexImage2D(GL_TEXTURE_2D, 0, 4, TILE_SIZE, TILE_SIZE, 0, GL_RGBA, \
+      GL_UNSIGNED_BYTE, pixels.data());
+
+  // the pixels of tiles are never smaller than those of the screen
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+  m_tiles.put(key, texture, TILE_BYTES);
+
+  render();
+}
+
+
 }
@@ -16,8 +16,16 @@
 
 
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_set>
+#include <vector>
 #include "View.hpp"
 #include "HeatMap.hpp"
+#include "RegionTable.hpp"
+#include "Utility/LRUCache.hpp"
+#include "Utility/Worker.hpp"
 
 
 
@@ -26,6 +34,9 @@ namespace MatrixInspector
 {
 
 
+class CSRMatrix;
+
+
 class HeatMapView :
   public View
 {
@@ -40,16 +51,108 @@ class HeatMapView :
     void draw() override;
 
 
+    /**
+    * @brief Start drawing the heat map of the matrix in the background, from
+    * progressively denser samples of its rows, each of which is shown as it
+    * is done. The previous heat map is shown until the first is.
+    */
     void refresh() override;
 
 
+    /**
+    * @brief Stop the work on the heat map, and suspend the view until it is
+    * refreshed. Meanwhile, the overview is still drawn, but no tiles,
+    * selections, or further work are started from the matrix.
+    */
+    void cancel() override;
+
+
+    void setColorMap(
+        ColorMap const & colorMap) override;
+
+
+    void setPooling(
+        HeatMap::pool_type pooling) override;
+
+
+    void setMode(
+        HeatMap::mode_type mode) override;
+
+
   private:
-    HeatMap m_heatmap;
+    struct tile_struct
+    {
+      uint64_t key;
+      dim_type firstRow;
+      dim_type firstCol;
+    };
+
+
+    /**
+    * @brief The rows and columns of a selected region of the matrix.
+    */
+    struct selection_struct
+    {
+      dim_type rowStart;
+      dim_type colStart;
+      dim_type rowEnd;
+      dim_type colEnd;
+    };
+
+
+    wxFrame * m_frame;
+    // the counts of the overview and of each level of its mip chain, which
+    // the worker may still be coloring
+    std::shared_ptr<std::vector<HeatMap> const> m_levels;
+    ColorMap m_colorMap;
+    HeatMap::pool_type m_pooling;
+    HeatMap::mode_type m_mode;
     GLuint m_glTexture;
+    // the number of pixels of the overview per row and column
+    float m_overviewScale;
+    // the stride of the rows the overview was sampled from, which is one
+    // once it is exact, and zero before it arrives
+    dim_type m_overviewStride;
+    // the non-zeros of the regions of the exact overview, which is null
+    // until they are summed
+    std::shared_ptr<RegionTable const> m_regions;
+    // set while the matrix is being changed, along with the size it had, so
+    // that the overview can be drawn without reading it
+    bool m_suspended;
+    dim_type m_suspendedRows;
+    dim_type m_suspendedCols;
+    // the corners of the selected region, in fractional columns and rows,
+    // which is being dragged out, or has been, or neither
+    bool m_selecting;
+    bool m_selected;
+    wxRealPoint m_selectStart;
+    wxRealPoint m_selectEnd;
+    // the textures of tiles drawn when zoomed past the overview, by level and
+    // position
+    LRUCache<uint64_t, GLuint> m_tiles;
+    // the tiles the worker has been asked for which have not arrived
+    std::unordered_set<uint64_t> m_pendingTiles;
+    // incremented when the matrix changes, and when it or the colors change,
+    // so that results of older requests are dropped as they arrive
+    uint64_t m_epoch;
+    uint64_t m_tileEpoch;
+    // set to stop the running work on the overview, and on the tiles
+    std::shared_ptr<std::atomic<bool>> m_cancel;
+    std::shared_ptr<std::atomic<bool>> m_cancelTiles;
     wxPoint m_mousePos;
-    float m_zoom;
-    float m_originX;
-    float m_originY;
+    double m_zoom;
+    double m_originX;
+    double m_originY;
+    // last, so that its job is finished before the rest is destroyed
+    Worker m_worker;
+
+
+    void onMouseDown(
+        wxMouseEvent& event);
+
+
+    void onMouseUp(
+        wxMouseEvent& event);
 
 
     void onMouseMove(
@@ -67,6 +170,207 @@ class HeatMapView :
     void releaseTexture();
 
 
+    /**
+    * @brief Upload the texture of the overview, with each level of its mip
+    * chain.
+    *
+    * @param pixels The colors of each level.
+    */
+    void updateTexture(
+        std::vector<std::vector<uint32_t>> const & pixels);
+
+
+    /**
+    * @brief Cancel the running job and drop the waiting ones, without
+    * waiting for the running job to stop.
+    */
+    void stopJobs();
+
+
+    /**
+    * @brief Get the colors the heat map is drawn in, which are diverging for
+    * signed values.
+    *
+    * @return The colors.
+    */
+    ColorMap getColors() const;
+
+
+    /**
+    * @brief Drop the heat map's tiles and start counting it again in the
+    * background, without moving the view.
+    */
+    void count();
+
+
+    /**
+    * @brief Show an overview finished by the worker, and the fraction of rows
+    * it was sampled from, unless the matrix has changed since it was
+    * requested.
+    *
+    * @param epoch The epoch of the request.
+    * @param levels The counts of each level of the mip chain.
+    * @param scale The number of pixels per row and column.
+    * @param stride The stride of the rows the heat map was sampled from.
+    * @param pooling How the levels were pooled.
+    * @param colorMap The colors the pixels are in.
+    * @param pixels The colors of each level.
+    */
+    void setOverview(
+        uint64_t epoch,
+        std::shared_ptr<std::vector<HeatMap> const> const & levels,
+        float scale,
+        dim_type stride,
+        HeatMap::pool_type pooling,
+        ColorMap const & colorMap,
+        std::vector<std::vector<uint32_t>> const & pixels);
+
+
+    /**
+    * @brief Use the table of regions summed by the worker, unless the matrix
+    * has changed since it was requested, and show the exact non-zeros of the
+    * selection.
+    *
+    * @param epoch The epoch of the request.
+    * @param regions The table.
+    */
+    void setRegions(
+        uint64_t epoch,
+        std::shared_ptr<RegionTable const> const & regions);
+
+
+    /**
+    * @brief Get the rows and columns of the selection, cut to the matrix.
+    *
+    * @param matrix The matrix.
+    *
+    * @return The selection.
+    */
+    selection_struct getSelection(
+        Matrix const & matrix) const;
+
+
+    /**
+    * @brief Show the non-zeros of the selection in the status bar. While it
+    * is being dragged, they are those of the pixels of the overview it
+    * touches, which take constant time to find, and once dropped they are
+    * exact.
+    *
+    * @param exact Whether to show the exact non-zeros.
+    */
+    void showSelection(
+        bool exact);
+
+
+    /**
+    * @brief Draw the outline of the selection.
+    */
+    void drawSelection();
+
+
+    /**
+    * @brief Get the column under a horizontal position on the screen.
+    *
+    * @param x The position in pixels.
+    *
+    * @return The column, which may be fractional.
+    */
+    double getCol(
+        int x) const;
+
+
+    /**
+    * @brief Get the row under a vertical position on the screen.
+    *
+    * @param y The position in pixels.
+    *
+    * @return The row, which may be fractional.
+    */
+    double getRow(
+        int y) const;
+
+
+    /**
+    * @brief Get the horizontal position on the screen of a column.
+    *
+    * @param col The column, which may be fractional.
+    *
+    * @return The position.
+    */
+    double getX(
+        double col) const;
+
+
+    /**
+    * @brief Get the vertical position on the screen of a row.
+    *
+    * @param row The row, which may be fractional.
+    *
+    * @return The position.
+    */
+    double getY(
+        double row) const;
+
+
+    /**
+    * @brief Draw a texture over a rectangle of the matrix.
+    *
+    * @param texture The texture.
+    * @param firstCol The left of the rectangle.
+    * @param firstRow The top of the rectangle.
+    * @param lastCol The right of the rectangle.
+    * @param lastRow The bottom of the rectangle.
+    * @param texWidth The fraction of the width of the texture to use.
+    * @param texHeight The fraction of the height of the texture to use.
+    */
+    void drawRect(
+        GLuint texture,
+        double firstCol,
+        double firstRow,
+        double lastCol,
+        double lastRow,
+        float texWidth,
+        float texHeight);
+
+
+    /**
+    * @brief Draw the tiles on the screen over the overview, when zoomed in
+    * far enough that its pixels are larger than those of the screen. Tiles
+    * which are not cached are requested from the worker.
+    *
+    * @param matrix The matrix.
+    */
+    void drawTiles(
+        CSRMatrix const & matrix);
+
+
+    /**
+    * @brief Ask the worker for tiles in place of those asked for before.
+    *
+    * @param matrix The matrix.
+    * @param level The base two logarithm of the rows and columns per pixel.
+    * @param tiles The tiles.
+    */
+    void requestTiles(
+        CSRMatrix const & matrix,
+        unsigned level,
+        std::vector<tile_struct> const & tiles);
+
+
+    /**
+    * @brief Cache a tile finished by the worker, unless the matrix or colors
+    * have changed since it was requested.
+    *
+    * @param epoch The tile epoch of the request.
+    * @param key The tile.
+    * @param pixels The colors of the tile.
+    */
+    void addTile(
+        uint64_t epoch,
+        uint64_t key,
+        std::vector<uint32_t> const & pixels);
+
+
     // disable copying
     HeatMapView(
         HeatMapView const & rhs);
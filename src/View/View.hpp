@@ -18,6 +18,8 @@
 #include <wx/wx.h>
 #include <wx/glcanvas.h>
 #include "Data/Matrix.hpp"
+#include "Data/ColorMap.hpp"
+#include "Data/HeatMap.hpp"
 
 
 
@@ -56,6 +58,43 @@ class View :
     virtual void refresh() = 0;
 
 
+    /**
+    * @brief Stop the work being done on the matrix in the background, and
+    * wait for it, so that the matrix can be changed. The matrix is not read
+    * again until the view is refreshed.
+    */
+    virtual void cancel() = 0;
+
+
+    /**
+    * @brief Change the colors the matrix is drawn with.
+    *
+    * @param colorMap The new colors.
+    */
+    virtual void setColorMap(
+        ColorMap const & colorMap) = 0;
+
+
+    /**
+    * @brief Change how the pixels of the matrix are combined when zoomed
+    * out.
+    *
+    * @param pooling How the pixels are combined.
+    */
+    virtual void setPooling(
+        HeatMap::pool_type pooling) = 0;
+
+
+    /**
+    * @brief Change what each pixel of the matrix is made of the non-zeros in
+    * it, which counts them again.
+    *
+    * @param mode What each pixel is made of.
+    */
+    virtual void setMode(
+        HeatMap::mode_type mode) = 0;
+
+
   protected:
     virtual void draw() = 0;
 